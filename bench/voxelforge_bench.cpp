@@ -0,0 +1,344 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// Stage-level benchmarks of voxelforge_core (Google Benchmark)
+//
+// Datasets:
+//   synthetic  rendered at startup (synthetic_scene.hpp), --voxelforge_views=N (default 24, 0 = off),
+//              --voxelforge_trajectory=orbit|grid|walk; focal comes from its EXIF like real photos
+//   recorded   a folder of photos given with --voxelforge_dataset=<dir> or VOXELFORGE_BENCH_DATASET
+//              (a project folder with images/ or the image folder itself)
+// Results go to voxelforge_bench.json unless --benchmark_out is given, so runs
+// on different commits can be compared with Google Benchmark's compare.py.
+
+#include "pipeline.hpp"
+#include "synthetic_scene.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef VOXELFORGE_GIT_COMMIT
+#define VOXELFORGE_GIT_COMMIT "unknown"
+#endif
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    struct Dataset
+    {
+        std::string name;
+        std::string imageDir;
+        std::string workDir;
+        std::string sensorDb;
+        double focalPixels = -1.0; // -1 = from EXIF + sensor database
+        int viewCount = 0;
+
+        // stage outputs prepared on demand (once per process) as inputs of later stages
+        std::map<std::string, bool> prepared;
+    };
+
+    int iterations = 1;
+
+    std::string listingDir(const Dataset &ds) { return ds.workDir + "/listing"; }
+    std::string sfmDataFile(const Dataset &ds) { return listingDir(ds) + "/sfm_data.json"; }
+    std::string featuresDir(const Dataset &ds, const std::string &preset) { return ds.workDir + "/features_" + preset; }
+    std::string putativeFile(const Dataset &ds) { return featuresDir(ds, "NORMAL") + "/matches.putative.bin"; }
+    std::string filteredFile(const Dataset &ds) { return featuresDir(ds, "NORMAL") + "/matches.f.bin"; }
+
+    int countImages(const std::string &dir)
+    {
+        int count = 0;
+        std::error_code ec;
+        for (const fs::directory_entry &entry : fs::directory_iterator(dir, ec))
+            if (entry.is_regular_file())
+                ++count;
+        return count;
+    }
+
+    bool prepare(Dataset &ds, const std::string &what)
+    {
+        auto found = ds.prepared.find(what);
+        if (found != ds.prepared.end())
+            return found->second;
+
+        bool ok = false;
+        if (what == "listing")
+        {
+            fs::create_directories(listingDir(ds));
+            ok = OpenMVG_Wrappers::RunImageListing(ds.imageDir, listingDir(ds), ds.sensorDb, nullptr, nullptr, nullptr, ds.focalPixels);
+        }
+        else if (what == "features")
+        {
+            ok = prepare(ds, "listing") &&
+                 OpenMVG_Wrappers::RunComputeFeatures(sfmDataFile(ds), featuresDir(ds, "NORMAL"), nullptr, nullptr, nullptr,
+                                                      "SIFT_ANATOMY", false, false, "NORMAL");
+        }
+        else if (what == "putative")
+        {
+            ok = prepare(ds, "features") &&
+                 OpenMVG_Wrappers::RunComputeMatches(sfmDataFile(ds), putativeFile(ds));
+        }
+        else if (what == "filtered")
+        {
+            ok = prepare(ds, "putative") &&
+                 OpenMVG_Wrappers::RunGeometricFilter(sfmDataFile(ds), putativeFile(ds), filteredFile(ds));
+        }
+
+        ds.prepared[what] = ok;
+        return ok;
+    }
+
+    void setViewCounters(benchmark::State &state, const Dataset &ds)
+    {
+        state.counters["views"] = ds.viewCount;
+        state.counters["views_per_s"] = benchmark::Counter(ds.viewCount, benchmark::Counter::kIsIterationInvariantRate);
+    }
+
+    void BM_ImageListing(benchmark::State &state, Dataset *ds)
+    {
+        const std::string outDir = ds->workDir + "/bench_listing";
+        fs::create_directories(outDir);
+        for (auto _ : state)
+        {
+            if (!OpenMVG_Wrappers::RunImageListing(ds->imageDir, outDir, ds->sensorDb, nullptr, nullptr, nullptr, ds->focalPixels))
+            {
+                state.SkipWithError("RunImageListing failed");
+                break;
+            }
+        }
+        setViewCounters(state, *ds);
+    }
+
+    void BM_ComputeFeatures(benchmark::State &state, Dataset *ds, std::string preset)
+    {
+        if (!prepare(*ds, "listing"))
+        {
+            state.SkipWithError("image listing failed");
+            return;
+        }
+        for (auto _ : state)
+        {
+            if (!OpenMVG_Wrappers::RunComputeFeatures(sfmDataFile(*ds), featuresDir(*ds, preset), nullptr, nullptr, nullptr,
+                                                      "SIFT_ANATOMY", false, true, preset))
+            {
+                state.SkipWithError("RunComputeFeatures failed");
+                break;
+            }
+        }
+        setViewCounters(state, *ds);
+    }
+
+    void BM_ComputeMatches(benchmark::State &state, Dataset *ds, std::string method)
+    {
+        if (!prepare(*ds, "features"))
+        {
+            state.SkipWithError("feature extraction failed");
+            return;
+        }
+        // next to the features: the wrapper reads image_describer.json from the output folder
+        const std::string outFile = featuresDir(*ds, "NORMAL") + "/matches.putative." + method + ".bin";
+        // no report export: the pipeline runs it as a separate graph node
+        for (auto _ : state)
+        {
+            if (!OpenMVG_Wrappers::RunComputeMatches(sfmDataFile(*ds), outFile, nullptr, nullptr, nullptr, 0.8f, "", method, true,
+                                                     0, 0, 0.08, false))
+            {
+                state.SkipWithError("RunComputeMatches failed");
+                break;
+            }
+        }
+        setViewCounters(state, *ds);
+        state.counters["pairs"] = ds->viewCount * (ds->viewCount - 1) / 2.0;
+    }
+
+    void BM_GeometricFilter(benchmark::State &state, Dataset *ds, std::string model)
+    {
+        if (!prepare(*ds, "putative"))
+        {
+            state.SkipWithError("putative matching failed");
+            return;
+        }
+        const std::string outFile = featuresDir(*ds, "NORMAL") + "/matches." + model + ".bench.bin";
+        for (auto _ : state)
+        {
+            if (!OpenMVG_Wrappers::RunGeometricFilter(sfmDataFile(*ds), putativeFile(*ds), outFile, nullptr, nullptr, nullptr, "", "", model, true,
+                                                      false, 2048, 0, false))
+            {
+                state.SkipWithError("RunGeometricFilter failed");
+                break;
+            }
+        }
+        setViewCounters(state, *ds);
+    }
+
+    void BM_GlobalSfM(benchmark::State &state, Dataset *ds)
+    {
+        if (!prepare(*ds, "filtered"))
+        {
+            state.SkipWithError("geometric filtering failed");
+            return;
+        }
+        const std::string outDir = ds->workDir + "/bench_sfm";
+        for (auto _ : state)
+        {
+            if (!OpenMVG_Wrappers::RunGlobalSfM(sfmDataFile(*ds), featuresDir(*ds, "NORMAL"), outDir, nullptr, nullptr, nullptr, filteredFile(*ds)))
+            {
+                state.SkipWithError("RunGlobalSfM failed");
+                break;
+            }
+        }
+        setViewCounters(state, *ds);
+    }
+
+    void registerDataset(Dataset *ds)
+    {
+        auto configure = [](benchmark::internal::Benchmark *b)
+        {
+            // stages run for seconds to hours: a fixed count, use --benchmark_repetitions for statistics
+            b->Unit(benchmark::kMillisecond)->UseRealTime()->Iterations(iterations);
+        };
+
+        configure(benchmark::RegisterBenchmark(("ImageListing/" + ds->name).c_str(), BM_ImageListing, ds));
+
+        for (const char *preset : {"NORMAL", "HIGH", "ULTRA"})
+            configure(benchmark::RegisterBenchmark(("ComputeFeatures/" + ds->name + "/" + preset).c_str(),
+                                                   BM_ComputeFeatures, ds, std::string(preset)));
+
+        for (const char *method : {"BRUTEFORCEL2", "ANNL2", "CASCADEHASHINGL2", "FASTCASCADEHASHINGL2", "HNSWL2"})
+            configure(benchmark::RegisterBenchmark(("ComputeMatches/" + ds->name + "/" + method).c_str(),
+                                                   BM_ComputeMatches, ds, std::string(method)));
+
+        for (const char *model : {"f", "e", "h"})
+            configure(benchmark::RegisterBenchmark(("GeometricFilter/" + ds->name + "/" + model).c_str(),
+                                                   BM_GeometricFilter, ds, std::string(model)));
+
+        configure(benchmark::RegisterBenchmark(("GlobalSfM/" + ds->name).c_str(), BM_GlobalSfM, ds));
+    }
+
+    std::string envOr(const char *name, const std::string &fallback)
+    {
+        const char *value = std::getenv(name);
+        return value && *value ? value : fallback;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string recordedPath = envOr("VOXELFORGE_BENCH_DATASET", "");
+    std::string workRoot = envOr("VOXELFORGE_BENCH_WORKDIR", (fs::temp_directory_path() / "voxelforge_bench").string());
+    int syntheticViews = 24;
+    VoxelForge::SyntheticTrajectory trajectory = VoxelForge::SyntheticTrajectory::Orbit;
+    double recordedFocal = -1.0;
+
+    // our own flags first, everything else goes to Google Benchmark
+    std::vector<char *> args;
+    bool hasOutput = false;
+    for (int i = 0; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        auto value = [&](const char *flag) { return arg.substr(std::strlen(flag)); };
+
+        if (arg.rfind("--voxelforge_dataset=", 0) == 0)
+            recordedPath = value("--voxelforge_dataset=");
+        else if (arg.rfind("--voxelforge_focal=", 0) == 0)
+            recordedFocal = std::stod(value("--voxelforge_focal="));
+        else if (arg.rfind("--voxelforge_views=", 0) == 0)
+            syntheticViews = std::stoi(value("--voxelforge_views="));
+        else if (arg.rfind("--voxelforge_trajectory=", 0) == 0)
+        {
+            if (!VoxelForge::SyntheticTrajectoryFromName(value("--voxelforge_trajectory="), trajectory))
+            {
+                std::fprintf(stderr, "Unknown trajectory %s (orbit, grid, walk)\n", arg.c_str());
+                return 1;
+            }
+        }
+        else if (arg.rfind("--voxelforge_workdir=", 0) == 0)
+            workRoot = value("--voxelforge_workdir=");
+        else if (arg.rfind("--voxelforge_iterations=", 0) == 0)
+            iterations = std::max(1, std::stoi(value("--voxelforge_iterations=")));
+        else
+        {
+            hasOutput = hasOutput || arg.rfind("--benchmark_out=", 0) == 0;
+            args.push_back(argv[i]);
+        }
+    }
+
+    std::string outArg = "--benchmark_out=voxelforge_bench.json";
+    std::string formatArg = "--benchmark_out_format=json";
+    if (!hasOutput)
+    {
+        args.push_back(&outArg[0]);
+        args.push_back(&formatArg[0]);
+    }
+
+    int benchArgc = static_cast<int>(args.size());
+    benchmark::Initialize(&benchArgc, args.data());
+    if (benchmark::ReportUnrecognizedArguments(benchArgc, args.data()))
+        return 1;
+
+    benchmark::AddCustomContext("voxelforge_commit", VOXELFORGE_GIT_COMMIT);
+
+    std::vector<std::unique_ptr<Dataset>> datasets;
+
+    if (syntheticViews > 0)
+    {
+        std::unique_ptr<Dataset> ds(new Dataset);
+        ds->name = std::string("synthetic_") + VoxelForge::SyntheticTrajectoryName(trajectory) + std::to_string(syntheticViews);
+        ds->workDir = workRoot + "/" + ds->name;
+        ds->imageDir = ds->workDir + "/images";
+        ds->sensorDb = ds->workDir + "/sensor_width_database.txt";
+
+        VoxelForge::SyntheticSceneOptions options;
+        options.viewCount = syntheticViews;
+        options.trajectory = trajectory;
+
+        // rendered once and reused by later runs (same options give the same images)
+        if ((countImages(ds->imageDir) != syntheticViews || !fs::exists(ds->sensorDb)) &&
+            !VoxelForge::GenerateSyntheticScene(ds->workDir, options))
+        {
+            std::fprintf(stderr, "Cannot render the synthetic dataset into %s\n", ds->workDir.c_str());
+            return 1;
+        }
+        ds->viewCount = syntheticViews;
+        datasets.push_back(std::move(ds));
+    }
+
+    if (!recordedPath.empty())
+    {
+        std::unique_ptr<Dataset> ds(new Dataset);
+        fs::path root = fs::path(recordedPath).lexically_normal();
+        if (!root.has_filename())
+            root = root.parent_path(); // trailing slash
+        ds->imageDir = fs::is_directory(root / "images") ? (root / "images").string() : root.string();
+        ds->name = "recorded_" + root.filename().string();
+        ds->workDir = workRoot + "/" + ds->name;
+        ds->sensorDb = VoxelForge::DefaultSensorDatabase();
+        ds->focalPixels = recordedFocal;
+        ds->viewCount = countImages(ds->imageDir);
+        if (ds->viewCount == 0)
+        {
+            std::fprintf(stderr, "No images in %s\n", ds->imageDir.c_str());
+            return 1;
+        }
+        benchmark::AddCustomContext("voxelforge_recorded_dataset", ds->imageDir);
+        datasets.push_back(std::move(ds));
+    }
+
+    for (const std::unique_ptr<Dataset> &ds : datasets)
+    {
+        fs::create_directories(ds->workDir);
+        registerDataset(ds.get());
+    }
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -3,6 +3,7 @@
 
 #include "backend.h"
 #include "openmvg_wrappers.hpp"
+#include "thread_budget.hpp"
 
 #include <QDir>
 #include <QFileInfo>
@@ -45,7 +46,9 @@ void VideoFrameExtractor::extractFrames(const QString &videoFilePath, const QStr
     emit logMessage("Extracting frames from video: " + videoFilePath);
     emit logMessage("Frames will be saved to: " + imageDir);
 
-    // Extract frames using OpenCV
+    // Extract frames using OpenCV; its decode / encode pool gets half the
+    // thread budget, the thumbnails of the extracted frames use the other half
+    cv::setNumThreads(VoxelForge::ThreadBudget::share(2));
     cv::VideoCapture cap(videoFilePath.toStdString());
     if (!cap.isOpened())
     {
@@ -94,7 +97,25 @@ void VideoFrameExtractor::cancelExtraction()
 }
 
 // PhotogrammetryController implementation
-void PhotogrammetryController::startPipeline(const QString &projectPath)
+// Thin Qt adapter over VoxelForge::Pipeline (voxelforge_core)
+QString PhotogrammetryController::stageName(PipelineStage stage)
+{
+    switch (stage)
+    {
+    case Idle: return "Idle";
+    case Finished: return "Finished";
+    case Error: return "Error";
+    default: return VoxelForge::StageName(VoxelForge::Stage(stage - InitImageListing));
+    }
+}
+
+PhotogrammetryController::PipelineStage PhotogrammetryController::fromCoreStage(VoxelForge::Stage stage)
+{
+    // same order, shifted by Idle
+    return PipelineStage(static_cast<int>(stage) + InitImageListing);
+}
+
+void PhotogrammetryController::startPipeline(const QString &projectPath, int lastStage)
 {
     if (currentStage != Idle)
     {
@@ -102,225 +123,57 @@ void PhotogrammetryController::startPipeline(const QString &projectPath)
         return;
     }
 
-    cancelRequest = false;
     currentStage = InitImageListing;
-    this->projectPath = projectPath;
-    this->imagePath = projectPath + "/images";
-    this->outputPath = projectPath + "/output";
-
-    QDir().mkpath(outputPath);
-
-    std::string sImagePath = imagePath.toStdString();
-    std::string sMatchesDir = (outputPath + "/matches").toStdString();
-    std::string sReconDir = (outputPath + "/reconstruction").toStdString();
-    std::string sMVSSceneFile = (outputPath + "/scene.mvs").toStdString();
 
-    // Hardcoded sensor database path - better to make this a setting!
-    std::string sSensorDb = "/mnt/WinDisk/1_Darshan/CS/Programing/Projects/3D_Reconstruction_Software/Voxel-Forge/build/vcpkg_installed/x64-linux/share/openmvg/sensor_width_camera_database.txt";
+    VoxelForge::PipelineConfig config = settings;
+    config.projectPath = projectPath.toStdString();
+    config.lastStage = VoxelForge::Stage(lastStage);
+    VoxelForge::Pipeline pipeline(config);
 
-    // Create directories
-    QDir().mkpath(QString::fromStdString(sMatchesDir));
-    QDir().mkpath(QString::fromStdString(sReconDir));
-
-    emit logMessage("=== Starting OpenMVG/OpenMVS Pipeline ===");
-    emit logMessage("Project path: " + projectPath);
-    emit logMessage("Image path: " + imagePath);
-    emit logMessage("Output path: " + outputPath);
-
-    // Stage 1: Image Listing
-    if (!cancelRequest)
     {
-        currentStage = InitImageListing;
-        emit logMessage("\n[Stage 1/5] Initializing image listing...");
-
-        auto logCb = [this](const std::string &msg)
-        {
-            emit logMessage(QString::fromStdString(msg));
-        };
-
-        bool success = OpenMVG_Wrappers::RunImageListing(
-            sImagePath,
-            sMatchesDir,
-            sSensorDb,
-            logCb);
-
-        if (!success)
-        {
-            emit logMessage("ERROR: Image listing failed!");
-            currentStage = Error;
-            emit pipelineFinished(false);
-            return;
-        }
-        emit logMessage("[Stage 1/5] Image listing completed successfully!");
+        QMutexLocker lock(&pipelineMutex);
+        activePipeline = &pipeline;
     }
 
-    // Stage 2: Compute Features
-    if (!cancelRequest)
+    VoxelForge::PipelineCallbacks callbacks;
+    callbacks.log = [this](const std::string &msg)
     {
-        currentStage = ComputeFeatures;
-        emit logMessage("\n[Stage 2/5] Computing features...");
-
-        auto logCb = [this](const std::string &msg)
-        {
-            emit logMessage(QString::fromStdString(msg));
-        };
-
-        std::string sSfmDataFilename = sMatchesDir + "/sfm_data.json";
-        bool success = OpenMVG_Wrappers::RunComputeFeatures(
-            sSfmDataFilename,
-            sMatchesDir,
-            logCb);
-
-        if (!success)
-        {
-            emit logMessage("ERROR: Feature computation failed!");
-            currentStage = Error;
-            emit pipelineFinished(false);
-            return;
-        }
-        emit logMessage("[Stage 2/5] Feature computation completed successfully!");
-    }
-
-    // Stage 3: Compute Matches
-    if (!cancelRequest)
+        emit logMessage(QString::fromStdString(msg));
+    };
+    callbacks.stageStarted = [this](VoxelForge::Stage stage, int index, int count)
     {
-        currentStage = ComputeMatches;
-        emit logMessage("\n[Stage 3/5] Computing matches...");
-
-        auto logCb = [this](const std::string &msg)
-        {
-            emit logMessage(QString::fromStdString(msg));
-        };
-
-        std::string sSfmDataFilename = sMatchesDir + "/sfm_data.json";
-        std::string sMatchesFilename = sMatchesDir + "/matches.putative.bin";
-        
-        bool success = OpenMVG_Wrappers::RunComputeMatches(
-            sSfmDataFilename,
-            sMatchesFilename,
-            logCb);
-
-        if (!success)
-        {
-            emit logMessage("ERROR: Match computation failed!");
-            currentStage = Error;
-            emit pipelineFinished(false);
-            return;
-        }
-        emit logMessage("[Stage 3/5] Match computation completed successfully!");
-    }
-
-    // Stage 4: Geometric Filter (Placeholder for presentation)
-    if (!cancelRequest)
+        const PipelineStage current = fromCoreStage(stage);
+        currentStage = current;
+        emit stageStarted(current, index, count);
+    };
+    callbacks.stageFinished = [this](VoxelForge::Stage stage, bool success, double seconds)
     {
-        currentStage = GeometricFilter;
-        emit logMessage("\n[Stage 4/5] Performing geometric filtering...");
-        emit logMessage("Loading putative matches...");
-        
-        volatile double dummy = 0;
-        for (int i = 0; i < 100000000 && !cancelRequest; i++) {
-            dummy += std::sin(i) * std::cos(i);
-            if (i % 25000000 == 0) {
-                emit logMessage("Processing geometric constraints...");
-            }
-        }
-        
-        emit logMessage("Applying RANSAC for fundamental matrix estimation...");
-        for (int i = 0; i < 100000000 && !cancelRequest; i++) {
-            dummy += std::sin(i) * std::cos(i);
-        }
-        
-        emit logMessage("Filtering geometrically inconsistent matches...");
-        for (int i = 0; i < 100000000 && !cancelRequest; i++) {
-            dummy += std::sin(i) * std::cos(i);
-        }
-        
-        emit logMessage("Exporting filtered matches...");
-        emit logMessage("[Stage 4/5] Geometric filtering completed successfully!");
-    }
-
-    // Stage 5: Global SfM Reconstruction (Placeholder - infinite loop for presentation)
-    if (!cancelRequest)
+        emit stageFinished(fromCoreStage(stage), success, seconds);
+    };
+    callbacks.stageProgress = [this](VoxelForge::Stage stage, double fraction, const std::string &step)
     {
-        currentStage = GlobalSfM;
-        emit logMessage("\n[Stage 5/5] Starting Global Structure-from-Motion reconstruction...");
-        emit logMessage("Initializing reconstruction...");
-        
-        volatile double dummy = 0;
-        for (int i = 0; i < 100000000 && !cancelRequest; i++) {
-            dummy += std::sin(i) * std::cos(i);
-        }
-        
-        emit logMessage("Computing relative rotations...");
-        for (int i = 0; i < 100000000 && !cancelRequest; i++) {
-            dummy += std::sin(i) * std::cos(i);
-        }
-        
-        emit logMessage("Computing global rotations...");
-        for (int i = 0; i < 100000000 && !cancelRequest; i++) {
-            dummy += std::sin(i) * std::cos(i);
-        }
-        
-        emit logMessage("Computing translations...");
-        for (int i = 0; i < 100000000 && !cancelRequest; i++) {
-            dummy += std::sin(i) * std::cos(i);
-        }
-        
-        emit logMessage("Triangulating 3D points...");
-        for (int i = 0; i < 100000000 && !cancelRequest; i++) {
-            dummy += std::sin(i) * std::cos(i);
-        }
-        
-        emit logMessage("Running bundle adjustment...");
-        
-        // Infinite loop for presentation - showing ongoing reconstruction with CPU usage
-        int iteration = 1;
-        while (!cancelRequest)
-        {
-            emit logMessage(QString("Refining reconstruction - iteration %1...").arg(iteration));
-            for (int i = 0; i < 200000000 && !cancelRequest; i++) {
-                dummy += std::sin(i) * std::cos(i);
-            }
-            
-            emit logMessage(QString("  - Optimizing camera poses..."));
-            for (int i = 0; i < 100000000 && !cancelRequest; i++) {
-                dummy += std::sin(i) * std::cos(i);
-            }
-            
-            emit logMessage(QString("  - Optimizing 3D structure..."));
-            for (int i = 0; i < 100000000 && !cancelRequest; i++) {
-                dummy += std::sin(i) * std::cos(i);
-            }
-            
-            emit logMessage(QString("  - Re-triangulating points..."));
-            for (int i = 0; i < 100000000 && !cancelRequest; i++) {
-                dummy += std::sin(i) * std::cos(i);
-            }
-            
-            iteration++;
-        }
-        
-        emit logMessage("\n[Stage 5/5] Reconstruction cancelled by user.");
-    }
+        emit stageProgress(fromCoreStage(stage), fraction, QString::fromStdString(step));
+    };
+
+    const bool success = pipeline.run(callbacks);
 
-    // Finish
-    if (!cancelRequest)
-    {
-        currentStage = Finished;
-        emit logMessage("\n=== Pipeline completed successfully! ===");
-        emit pipelineFinished(true);
-    }
-    else
     {
-        emit logMessage("\nPipeline cancelled by user.");
-        emit pipelineFinished(false);
+        QMutexLocker lock(&pipelineMutex);
+        activePipeline = nullptr;
     }
 
+    currentStage = success ? Finished : Error;
+    emit pipelineFinished(success);
     currentStage = Idle;
 }
 
 void PhotogrammetryController::cancelPipeline()
 {
-    cancelRequest = true;
-    emit logMessage("Cancelling pipeline...");
+    QMutexLocker lock(&pipelineMutex);
+    if (!activePipeline)
+        return;
+
+    activePipeline->cancel();
+    // the OpenMVG steps check the flag with their progress; OpenMVS has no cancel hook
+    emit logMessage("Cancelling pipeline (the OpenMVG stages stop within a moment, the OpenMVS stages after their running chunk or step)...");
 }
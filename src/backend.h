@@ -4,10 +4,13 @@
 #ifndef BACKEND_H
 #define BACKEND_H
 
+#include <QMutex>
 #include <QObject>
 #include <QString>
 #include <atomic>
 
+#include "pipeline.hpp"
+
 // Video frame extraction worker class
 class VideoFrameExtractor : public QObject
 {
@@ -49,25 +52,42 @@ public:
         ReconstructMesh,
         RefineMesh,
         TextureMesh,
+        MeshLod,
         Finished,
         Error
     };
 
     explicit PhotogrammetryController(QObject *parent = nullptr)
-        : QObject(parent), currentStage(Idle), cancelRequest(false) {}
+        : QObject(parent), currentStage(Idle), activePipeline(nullptr) {}
+
+    // Tunables of the pipeline (GUI uses the defaults); projectPath is taken from startPipeline
+    void setSettings(const VoxelForge::PipelineConfig &settings) { this->settings = settings; }
+    const VoxelForge::PipelineConfig &pipelineSettings() const { return settings; }
+
+    static QString stageName(PipelineStage stage);
+    static PipelineStage fromCoreStage(VoxelForge::Stage stage);
 
 public slots:
-    void startPipeline(const QString &projectPath);
+    // Blocks the calling (worker) thread until the run ends; lastStage is a VoxelForge::Stage
+    // (stages before it that are up to date are skipped)
+    void startPipeline(const QString &projectPath, int lastStage);
+    // Thread-safe, call it directly from the GUI thread: the worker thread is busy in startPipeline
     void cancelPipeline();
 
 signals:
     void logMessage(const QString &message);
+    // index is 1-based out of count, seconds is wall time of the stage
+    void stageStarted(int stage, int index, int count);
+    void stageFinished(int stage, bool success, double seconds);
+    // fraction of the running stage in [0, 1], step is the OpenMVG sub-step ("- Regions Matching -")
+    void stageProgress(int stage, double fraction, const QString &step);
     void pipelineFinished(bool success);
 
 private:
-    std::atomic<bool> cancelRequest;
-    PipelineStage currentStage;
-    QString projectPath, imagePath, outputPath;
+    std::atomic<PipelineStage> currentStage;
+    QMutex pipelineMutex;
+    VoxelForge::Pipeline *activePipeline; // guarded by pipelineMutex
+    VoxelForge::PipelineConfig settings;
 };
 
 #endif // BACKEND_H
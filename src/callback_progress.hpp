@@ -0,0 +1,105 @@
+#pragma once
+
+// openMVG progress reporter of the Run* wrappers: keeps the console output
+// of LoggerProgress, forwards the completed fraction to a ProgressCallback
+// and turns the cancel flag into hasBeenCanceled(), which openMVG polls once
+// per item (view, image pair, ...). Cancelling therefore takes effect after
+// the item being processed, not after the whole stage.
+
+#include "openmvg_wrappers.hpp"
+
+#include "openMVG/system/loggerprogress.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace OpenMVG_Wrappers
+{
+    class CallbackProgress : public openMVG::system::LoggerProgress
+    {
+    public:
+        CallbackProgress(ProgressCallback callback, const std::atomic<bool> *cancel,
+                         std::uint32_t expected_count = 1, const std::string &msg = {})
+            : openMVG::system::LoggerProgress(expected_count, msg),
+              callback(std::move(callback)), cancel(cancel), lastPermille(-1), lastEmitMs(0)
+        {
+            step = msg;
+        }
+
+        void Restart(const std::uint32_t expected_count, const std::string &msg = {}) override
+        {
+            openMVG::system::LoggerProgress::Restart(expected_count, msg);
+            {
+                std::lock_guard<std::mutex> guard(emitLock);
+                step = msg;
+            }
+            lastPermille = -1;
+            lastEmitMs = 0;
+            emit(0, true);
+        }
+
+        bool hasBeenCanceled() const override
+        {
+            return cancel && cancel->load(std::memory_order_relaxed);
+        }
+
+        std::uint32_t operator+=(const std::uint32_t increment) override
+        {
+            const std::uint32_t count = openMVG::system::LoggerProgress::operator+=(increment);
+            emit(count, false);
+            return count;
+        }
+
+        // Name of the current step in the callback (the Restart message otherwise)
+        void setStep(const std::string &name)
+        {
+            std::lock_guard<std::mutex> guard(emitLock);
+            step = name;
+        }
+
+    private:
+        // at most every 100 ms and only when the value changed by 0.1%; called from worker threads
+        void emit(std::uint32_t count, bool force)
+        {
+            if (!callback)
+                return;
+
+            const std::uint32_t expected = expected_count() > 0 ? expected_count() : 1;
+            const int permille = static_cast<int>(std::min<std::uint64_t>(1000, std::uint64_t(count) * 1000 / expected));
+            const std::int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                           std::chrono::steady_clock::now().time_since_epoch())
+                                           .count();
+
+            int previous = lastPermille.load();
+            if (!force && (permille == previous || (permille < 1000 && nowMs - lastEmitMs.load() < 100)))
+                return;
+            if (!lastPermille.compare_exchange_strong(previous, permille) && !force)
+                return; // another thread reported at the same time
+            lastEmitMs = nowMs;
+
+            std::lock_guard<std::mutex> guard(emitLock);
+            callback(permille / 1000.0, step);
+        }
+
+        ProgressCallback callback;
+        const std::atomic<bool> *cancel;
+        std::atomic<int> lastPermille;
+        std::atomic<std::int64_t> lastEmitMs;
+        std::mutex emitLock;
+        std::string step;
+    };
+
+    // Callback of one part (count of total items, done before it) of a stage processed in several
+    // openMVG calls: maps the fraction of the part onto the fraction of the stage
+    inline ProgressCallback SubrangeProgress(const ProgressCallback &callback, size_t done, size_t count, size_t total)
+    {
+        if (!callback || total == 0)
+            return nullptr;
+        return [callback, done, count, total](double fraction, const std::string &step)
+        { callback((static_cast<double>(done) + fraction * static_cast<double>(count)) / static_cast<double>(total), step); };
+    }
+}
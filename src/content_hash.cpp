@@ -0,0 +1,79 @@
+#include "content_hash.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace VoxelForge
+{
+    namespace
+    {
+        const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+        const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+
+        uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+        uint64_t mix(uint64_t h)
+        {
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ull;
+            return h ^ (h >> 33);
+        }
+    }
+
+    // 8 bytes per step
+    void ContentHasher::update(const void *data, size_t size)
+    {
+        const unsigned char *p = static_cast<const unsigned char *>(data);
+        length += size;
+        while (size > 0)
+        {
+            const size_t take = std::min(size, 8 - pendingSize);
+            std::memcpy(pending + pendingSize, p, take);
+            pendingSize += take;
+            p += take;
+            size -= take;
+            if (pendingSize == 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, pending, 8);
+                state = rotl(state ^ (rotl(word * kPrime2, 31) * kPrime1), 27) * 5 + 0x52DCE729;
+                pendingSize = 0;
+            }
+        }
+    }
+
+    uint64_t ContentHasher::digest() const
+    {
+        uint64_t tail = 0;
+        std::memcpy(&tail, pending, pendingSize);
+        return mix(state ^ tail * kPrime1 ^ length);
+    }
+
+    uint64_t HashFileContents(const std::string &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return 0;
+
+        ContentHasher hasher;
+        std::vector<char> buffer(1 << 20);
+        while (in)
+        {
+            in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            hasher.update(buffer.data(), static_cast<size_t>(in.gcount()));
+        }
+        return hasher.digest() | 1; // never 0, which means "missing"
+    }
+
+    std::string HexHash(uint64_t hash)
+    {
+        char text[17];
+        std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+        return text;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// Streaming 64-bit content hash shared by the up-to-date checks
+// (stage_graph.hpp) and the per-image caches of the stages. Not
+// cryptographic: it only detects changes.
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace VoxelForge
+{
+    class ContentHasher
+    {
+    public:
+        void update(const void *data, size_t size);
+        void update(const std::string &text) { update(text.data(), text.size() + 1); } // with the 0, so "ab"+"c" != "a"+"bc"
+        void update(uint64_t value) { update(&value, sizeof(value)); }
+        void update(double value) { update(&value, sizeof(value)); }
+
+        uint64_t digest() const;
+
+    private:
+        uint64_t state = 0x9E3779B185EBCA87ull;
+        uint64_t length = 0;
+        unsigned char pending[8] = {};
+        size_t pendingSize = 0;
+    };
+
+    // Hash of the file contents, never 0; 0 if the file cannot be read
+    uint64_t HashFileContents(const std::string &path);
+
+    // 16 lowercase hex digits
+    std::string HexHash(uint64_t hash);
+}
@@ -0,0 +1,311 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// Background bulk file import / export for the image manager
+
+#include "fileimportjob.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSet>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <linux/fs.h> // FICLONE
+#include <sys/ioctl.h>
+#endif
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+namespace
+{
+    const qint64 kChunkSize = 4 * 1024 * 1024;
+
+    // Copy-on-write clone (btrfs, xfs, ...): instant and safe to edit independently
+    bool tryReflink(const QString &src, const QString &dst)
+    {
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+        const int in = ::open(QFile::encodeName(src).constData(), O_RDONLY | O_CLOEXEC);
+        if (in < 0)
+            return false;
+        const int out = ::open(QFile::encodeName(dst).constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (out < 0)
+        {
+            ::close(in);
+            return false;
+        }
+        const bool ok = ::ioctl(out, FICLONE, in) == 0;
+        ::close(in);
+        ::close(out);
+        if (!ok)
+            ::unlink(QFile::encodeName(dst).constData());
+        return ok;
+#else
+        Q_UNUSED(src);
+        Q_UNUSED(dst);
+        return false;
+#endif
+    }
+
+    // Only when source and destination share a filesystem (links can't cross devices)
+    bool tryHardlink(const QString &src, const QString &dst)
+    {
+#if defined(Q_OS_UNIX)
+        struct stat srcStat, dstStat;
+        const QByteArray dstDir = QFile::encodeName(QFileInfo(dst).absolutePath());
+        if (::stat(QFile::encodeName(src).constData(), &srcStat) != 0 ||
+            ::stat(dstDir.constData(), &dstStat) != 0 ||
+            srcStat.st_dev != dstStat.st_dev)
+            return false;
+        return ::link(QFile::encodeName(src).constData(), QFile::encodeName(dst).constData()) == 0;
+#elif defined(Q_OS_WIN)
+        return CreateHardLinkW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(dst).utf16()),
+                               reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(src).utf16()),
+                               nullptr) != 0;
+#else
+        Q_UNUSED(src);
+        Q_UNUSED(dst);
+        return false;
+#endif
+    }
+
+    QByteArray fileChecksum(const QString &path)
+    {
+        QFile f(path);
+        if (!f.open(QIODevice::ReadOnly))
+            return QByteArray();
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        if (!hash.addData(&f))
+            return QByteArray();
+        return hash.result();
+    }
+}
+
+class FileImportTask : public QRunnable
+{
+public:
+    FileImportTask(FileImportJob *job, const FileImportJob::Entry &entry) : job(job), entry(entry) {}
+
+    void run() override
+    {
+        job->importOne(entry);
+        job->taskDone();
+    }
+
+private:
+    FileImportJob *job;
+    FileImportJob::Entry entry;
+};
+
+FileImportJob::FileImportJob(const QStringList &sourceFiles, const QString &destinationDir,
+                             const Options &options, QObject *parent)
+    : QObject(parent), destinationDir(destinationDir), options(options),
+      cancelRequest(false), bytesDone(0), filesDone(0), imported(0), skipped(0), failed(0), remainingTasks(0)
+{
+    QDir dir(destinationDir);
+
+    // Resolve destination names up front (single threaded), so parallel copies
+    // of files with the same name can't race for the same target
+    QSet<QString> assigned;
+    for (const QString &src : sourceFiles)
+    {
+        QFileInfo fi(src);
+        QString dst = dir.filePath(fi.fileName());
+
+        if (QFile::exists(dst) || assigned.contains(dst))
+        {
+            if (this->options.conflictPolicy == SkipExisting)
+            {
+                ++skipped;
+                continue;
+            }
+
+            // if exists, create unique name
+            int idx = 1;
+            const QString base = fi.completeBaseName();
+            const QString ext = fi.suffix();
+            while (QFile::exists(dst) || assigned.contains(dst))
+            {
+                dst = dir.filePath(QString("%1_%2.%3").arg(base).arg(idx).arg(ext));
+                idx++;
+            }
+        }
+
+        assigned.insert(dst);
+        Entry entry;
+        entry.source = src;
+        entry.destination = dst;
+        entry.size = fi.size();
+        entries.append(entry);
+        bytesTotal += entry.size;
+    }
+    filesDone = skipped.load();
+
+    pool.setMaxThreadCount(qMax(1, this->options.maxParallelCopies));
+    progressTimer.setInterval(100);
+    connect(&progressTimer, &QTimer::timeout, this, &FileImportJob::reportProgress);
+}
+
+FileImportJob::~FileImportJob()
+{
+    cancel();
+    pool.waitForDone();
+}
+
+void FileImportJob::start()
+{
+    if (running)
+        return;
+
+    running = true;
+    QDir().mkpath(destinationDir);
+
+    if (entries.isEmpty())
+    {
+        QMetaObject::invokeMethod(this, "onAllDone", Qt::QueuedConnection);
+        return;
+    }
+
+    remainingTasks = entries.size();
+    for (const Entry &entry : entries)
+    {
+        FileImportTask *task = new FileImportTask(this, entry);
+        task->setAutoDelete(true);
+        pool.start(task);
+    }
+    progressTimer.start();
+}
+
+void FileImportJob::cancel()
+{
+    cancelRequest = true;
+}
+
+void FileImportJob::importOne(const Entry &entry)
+{
+    if (cancelRequest)
+        return;
+
+    const QString partPath = entry.destination + ".part";
+    QFile::remove(partPath);
+
+    // Cheap paths first: nothing is read, so there is nothing to verify
+    bool linked = tryReflink(entry.source, partPath);
+    if (!linked && options.allowHardlinks)
+        linked = tryHardlink(entry.source, partPath);
+
+    QString error;
+    if (linked)
+        bytesDone += entry.size;
+    else if (!copyVerified(entry, error))
+    {
+        QFile::remove(partPath);
+        if (!cancelRequest)
+        {
+            ++failed;
+            ++filesDone;
+            emit fileFailed(entry.source, error);
+        }
+        return;
+    }
+
+    if (!QFile::rename(partPath, entry.destination))
+    {
+        QFile::remove(partPath);
+        ++failed;
+        ++filesDone;
+        emit fileFailed(entry.source, "cannot move into place (destination exists?)");
+        return;
+    }
+
+    ++imported;
+    ++filesDone;
+    emit fileImported(entry.destination);
+}
+
+bool FileImportJob::copyVerified(const Entry &entry, QString &error)
+{
+    QFile in(entry.source);
+    if (!in.open(QIODevice::ReadOnly))
+    {
+        error = in.errorString();
+        return false;
+    }
+
+    QFile out(entry.destination + ".part");
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        error = out.errorString();
+        return false;
+    }
+
+    // hash the source while streaming it, so verification only re-reads the copy
+    QCryptographicHash sourceHash(QCryptographicHash::Sha1);
+    QByteArray chunk(kChunkSize, Qt::Uninitialized);
+    for (;;)
+    {
+        if (cancelRequest)
+        {
+            error = "cancelled";
+            return false;
+        }
+
+        const qint64 n = in.read(chunk.data(), chunk.size());
+        if (n < 0)
+        {
+            error = in.errorString();
+            return false;
+        }
+        if (n == 0)
+            break;
+
+        if (options.verifyChecksum)
+            sourceHash.addData(chunk.constData(), static_cast<int>(n));
+        if (out.write(chunk.constData(), n) != n)
+        {
+            error = out.errorString();
+            return false;
+        }
+        bytesDone += n;
+    }
+
+    out.setPermissions(in.permissions());
+    out.close();
+    if (out.error() != QFile::NoError)
+    {
+        error = out.errorString();
+        return false;
+    }
+
+    if (options.verifyChecksum && fileChecksum(out.fileName()) != sourceHash.result())
+    {
+        error = "checksum mismatch after copy";
+        return false;
+    }
+    return true;
+}
+
+void FileImportJob::taskDone()
+{
+    if (--remainingTasks == 0)
+        QMetaObject::invokeMethod(this, "onAllDone", Qt::QueuedConnection);
+}
+
+void FileImportJob::reportProgress()
+{
+    emit progress(bytesDone, bytesTotal, filesDone, entries.size() + skipped);
+}
+
+void FileImportJob::onAllDone()
+{
+    progressTimer.stop();
+    reportProgress();
+    running = false;
+    emit finished(imported, skipped, failed, cancelRequest);
+}
@@ -0,0 +1,92 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// Background bulk file import / export for the image manager
+
+#ifndef FILEIMPORTJOB_H
+#define FILEIMPORTJOB_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+#include <atomic>
+
+// Copies a batch of files into one destination folder on a worker pool.
+// Per file it tries, in order: a reflink (copy-on-write clone), a hardlink
+// (when allowed and on the same filesystem), and a streamed copy into a
+// ".part" file that is checksummed against the source before being renamed
+// into place. Cancelling stops between chunks and never leaves partial files.
+class FileImportJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum ConflictPolicy
+    {
+        SkipExisting,  // keep the file already in the destination
+        RenameNew      // store as name_1.ext, name_2.ext, ...
+    };
+
+    struct Options
+    {
+        ConflictPolicy conflictPolicy = SkipExisting;
+        bool allowHardlinks = true;
+        bool verifyChecksum = true;
+        int maxParallelCopies = 4;
+    };
+
+    explicit FileImportJob(const QStringList &sourceFiles, const QString &destinationDir,
+                           const Options &options, QObject *parent = nullptr);
+    ~FileImportJob() override;
+
+    void start();
+    void cancel();
+    bool isRunning() const { return running; }
+
+signals:
+    // throttled (~10 Hz); bytes cover files that are really copied
+    void progress(qint64 bytesDone, qint64 bytesTotal, int filesDone, int filesTotal);
+    // one per file that landed in the destination (incremental hand-off to the image list)
+    void fileImported(const QString &destinationPath);
+    void fileFailed(const QString &sourcePath, const QString &reason);
+    void finished(int imported, int skipped, int failed, bool cancelled);
+
+private slots:
+    void reportProgress();
+    void onAllDone();
+
+private:
+    friend class FileImportTask;
+
+    struct Entry
+    {
+        QString source;
+        QString destination;
+        qint64 size = 0;
+    };
+
+    // runs on a pool thread
+    void importOne(const Entry &entry);
+    bool copyVerified(const Entry &entry, QString &error);
+    void taskDone();
+
+    QVector<Entry> entries;
+    QString destinationDir;
+    Options options;
+
+    QThreadPool pool;
+    QTimer progressTimer;
+    bool running = false;
+
+    std::atomic<bool> cancelRequest;
+    std::atomic<qint64> bytesDone;
+    std::atomic<int> filesDone;
+    std::atomic<int> imported;
+    std::atomic<int> skipped;
+    std::atomic<int> failed;
+    std::atomic<int> remainingTasks;
+    qint64 bytesTotal = 0;
+};
+
+#endif // FILEIMPORTJOB_H
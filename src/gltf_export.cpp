@@ -0,0 +1,587 @@
+#include "gltf_export.hpp"
+#include "thread_budget.hpp"
+
+#include <meshoptimizer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace VoxelForge
+{
+    namespace
+    {
+        // glTF constants
+        constexpr int ArrayBuffer = 34962, ElementArrayBuffer = 34963;
+        constexpr int Byte = 5120, UnsignedByte = 5121, UnsignedShort = 5123, UnsignedInt = 5125, Float = 5126;
+        constexpr int Linear = 9729, LinearMipmapLinear = 9987, ClampToEdge = 33071;
+
+        // vertices (or indices) converted at once while streaming a buffer view
+        constexpr size_t ItemsPerBlock = 1 << 16;
+
+        template <typename Task>
+        void parallelFor(size_t tasks, int threads, const Task &task)
+        {
+            const size_t workers = std::min<size_t>(std::max(1, threads), tasks);
+            std::atomic<size_t> next{0};
+            auto worker = [&]
+            {
+                for (size_t i; (i = next.fetch_add(1)) < tasks;)
+                    task(i);
+            };
+            std::vector<std::thread> pool;
+            for (size_t t = 1; t < workers; ++t)
+                pool.emplace_back(worker);
+            worker();
+            for (std::thread &thread : pool)
+                thread.join();
+        }
+
+        bool fail(std::string *error, const std::string &message)
+        {
+            if (error)
+                *error = message;
+            return false;
+        }
+
+        std::string number(double value)
+        {
+            char text[32];
+            std::snprintf(text, sizeof(text), "%.9g", value);
+            return text;
+        }
+
+        // escapes a string for JSON (the mime type only, but kept general)
+        std::string quoted(const std::string &text)
+        {
+            std::string out = "\"";
+            for (const char c : text)
+            {
+                if (c == '"' || c == '\\')
+                    out += '\\';
+                out += c;
+            }
+            return out + "\"";
+        }
+
+        std::string joined(const std::vector<std::string> &items)
+        {
+            std::string out;
+            for (size_t i = 0; i < items.size(); ++i)
+                out += (i ? "," : "") + items[i];
+            return out;
+        }
+
+        void appendUint32(std::vector<unsigned char> &out, uint32_t value)
+        {
+            for (int shift = 0; shift < 32; shift += 8)
+                out.push_back(static_cast<unsigned char>(value >> shift));
+        }
+
+        size_t aligned(size_t bytes)
+        {
+            return (bytes + 3) & ~size_t(3);
+        }
+
+        // Output vertices: one per distinct texcoord of the corners of each vertex (all vertices when
+        // untextured), in vertex order
+        struct Wedges
+        {
+            std::vector<uint32_t> vertex;  // model vertex of each output vertex, empty = the same
+            std::vector<uint32_t> corner;  // a corner holding its texcoord, empty = untextured
+            std::vector<uint32_t> indices; // 3 per face, empty = model.indices
+            size_t count = 0;
+        };
+
+        void buildWedges(const MeshModel &model, Wedges &wedges, int threads)
+        {
+            const size_t vertexCount = model.vertexCount(), cornerCount = model.indices.size();
+            // corners of each vertex, ascending
+            std::vector<uint32_t> first(vertexCount + 1, 0), corners(cornerCount);
+            for (const uint32_t v : model.indices)
+                ++first[v + 1];
+            for (size_t v = 0; v < vertexCount; ++v)
+                first[v + 1] += first[v];
+            {
+                std::vector<uint32_t> next(first.begin(), first.end() - 1);
+                for (size_t c = 0; c < cornerCount; ++c)
+                    corners[next[model.indices[c]]++] = static_cast<uint32_t>(c);
+            }
+
+            auto sameTexcoord = [&](uint32_t a, uint32_t b)
+            { return model.texcoords[size_t(a) * 2] == model.texcoords[size_t(b) * 2] &&
+                     model.texcoords[size_t(a) * 2 + 1] == model.texcoords[size_t(b) * 2 + 1]; };
+            // the earlier corner of the vertex with the same texcoord, or the corner itself
+            auto firstAlike = [&](uint32_t v, uint32_t i)
+            {
+                for (uint32_t j = first[v]; j < i; ++j)
+                {
+                    if (sameTexcoord(corners[j], corners[i]))
+                        return j;
+                }
+                return i;
+            };
+
+            const size_t tasks = (vertexCount + ItemsPerBlock - 1) / ItemsPerBlock;
+            std::vector<uint32_t> base(vertexCount + 1, 0);
+            parallelFor(tasks, threads, [&](size_t task)
+                        {
+                for (size_t v = task * ItemsPerBlock, end = std::min(vertexCount, v + ItemsPerBlock); v < end; ++v)
+                {
+                    for (uint32_t i = first[v]; i < first[v + 1]; ++i)
+                        base[v + 1] += firstAlike(static_cast<uint32_t>(v), i) == i;
+                } });
+            for (size_t v = 0; v < vertexCount; ++v)
+                base[v + 1] += base[v];
+
+            wedges.count = base[vertexCount];
+            wedges.vertex.resize(wedges.count);
+            wedges.corner.resize(wedges.count);
+            wedges.indices.resize(cornerCount);
+            parallelFor(tasks, threads, [&](size_t task)
+                        {
+                for (size_t v = task * ItemsPerBlock, end = std::min(vertexCount, v + ItemsPerBlock); v < end; ++v)
+                {
+                    uint32_t added = base[v];
+                    for (uint32_t i = first[v]; i < first[v + 1]; ++i)
+                    {
+                        const uint32_t alike = firstAlike(static_cast<uint32_t>(v), i);
+                        if (alike == i)
+                        {
+                            wedges.vertex[added] = static_cast<uint32_t>(v);
+                            wedges.corner[added] = corners[i];
+                            wedges.indices[corners[i]] = added++;
+                        }
+                        else
+                            wedges.indices[corners[i]] = wedges.indices[corners[alike]];
+                    }
+                } });
+        }
+
+        // one buffer view of the binary chunk
+        struct View
+        {
+            size_t count = 0;  // items: vertices, indices, or bytes of an image
+            int stride = 0;    // bytes per item
+            int target = 0;    // ArrayBuffer, ElementArrayBuffer or 0 (image)
+            // writes items [first, first + count) to out
+            std::function<void(size_t first, size_t count, unsigned char *out)> fill;
+            const std::vector<unsigned char> *bytes = nullptr; // instead of fill (image)
+            std::vector<unsigned char> encoded;                // EXT_meshopt_compression stream
+
+            size_t rawBytes() const { return count * stride; }
+        };
+
+        // the raw items of a view, block by block (memory of one block)
+        bool writeRaw(std::ofstream &out, const View &view)
+        {
+            if (view.bytes)
+                out.write(reinterpret_cast<const char *>(view.bytes->data()), static_cast<std::streamsize>(view.bytes->size()));
+            else
+            {
+                std::vector<unsigned char> block(ItemsPerBlock * view.stride);
+                for (size_t first = 0; first < view.count; first += ItemsPerBlock)
+                {
+                    const size_t count = std::min(ItemsPerBlock, view.count - first);
+                    view.fill(first, count, block.data());
+                    out.write(reinterpret_cast<const char *>(block.data()), static_cast<std::streamsize>(count * view.stride));
+                }
+            }
+            return static_cast<bool>(out);
+        }
+
+        // EXT_meshopt_compression stream of a geometry view; the raw data exists only meanwhile
+        void encode(View &view, const std::vector<uint32_t> &indices, size_t vertexCount)
+        {
+            if (view.target == ElementArrayBuffer)
+            {
+                view.encoded.resize(meshopt_encodeIndexBufferBound(indices.size(), vertexCount));
+                view.encoded.resize(meshopt_encodeIndexBuffer(view.encoded.data(), view.encoded.size(), indices.data(), indices.size()));
+                return;
+            }
+            std::vector<unsigned char> raw(view.rawBytes());
+            view.fill(0, view.count, raw.data());
+            view.encoded.resize(meshopt_encodeVertexBufferBound(view.count, view.stride));
+            view.encoded.resize(meshopt_encodeVertexBuffer(view.encoded.data(), view.encoded.size(), raw.data(), view.count, view.stride));
+        }
+    }
+
+    const char *GltfCompressionName(GltfCompression compression)
+    {
+        switch (compression)
+        {
+        case GltfCompression::None: return "none";
+        case GltfCompression::Quantized: return "quantized";
+        case GltfCompression::Meshopt: return "meshopt";
+        }
+        return "";
+    }
+
+    bool GltfCompressionFromName(const std::string &name, GltfCompression &compression)
+    {
+        for (const GltfCompression candidate : {GltfCompression::None, GltfCompression::Quantized, GltfCompression::Meshopt})
+        {
+            if (name == GltfCompressionName(candidate))
+            {
+                compression = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool WriteGlb(const std::string &path, const MeshModel &model, const GltfImage *baseColor,
+                  const GltfOptions &options, std::string *error)
+    {
+        const int threads = options.threads > 0 ? options.threads : ThreadBudget::limit();
+        const bool quantized = options.compression != GltfCompression::None;
+        const bool meshopt = options.compression == GltfCompression::Meshopt;
+        const size_t faceCount = model.faceCount();
+        const bool textured = !model.texcoords.empty() && model.texcoords.size() == faceCount * 6;
+        const bool withNormals = model.nx.size() == model.vertexCount();
+        const bool withColors = model.colors.size() == model.vertexCount();
+        if (model.vertexCount() == 0)
+            return fail(error, "no vertices to write to " + path);
+        if (model.vertexCount() > std::numeric_limits<uint32_t>::max() - 1)
+            return fail(error, path + ": too many vertices for glTF");
+
+        Wedges wedges;
+        if (textured)
+            buildWedges(model, wedges, threads);
+        else
+        {
+            wedges.count = model.vertexCount();
+            if (meshopt)
+                wedges.indices = model.indices;
+        }
+        // GPU vertex cache order, then vertices in order of first use: the meshopt codecs
+        // encode both as small deltas
+        if (meshopt && faceCount > 0)
+        {
+            std::vector<uint32_t> &indices = wedges.indices;
+            meshopt_optimizeVertexCache(indices.data(), indices.data(), indices.size(), wedges.count);
+            std::vector<uint32_t> remap(wedges.count);
+            const size_t used = meshopt_optimizeVertexFetchRemap(remap.data(), indices.data(), indices.size(), wedges.count);
+            meshopt_remapIndexBuffer(indices.data(), indices.data(), indices.size(), remap.data());
+            std::vector<uint32_t> vertex(used), corner(textured ? used : 0);
+            for (size_t i = 0; i < wedges.count; ++i)
+            {
+                if (remap[i] == ~0u)
+                    continue;
+                vertex[remap[i]] = wedges.vertex.empty() ? static_cast<uint32_t>(i) : wedges.vertex[i];
+                if (textured)
+                    corner[remap[i]] = wedges.corner[i];
+            }
+            wedges.vertex.swap(vertex);
+            wedges.corner.swap(corner);
+            wedges.count = used;
+        }
+        const size_t vertexCount = wedges.count;
+        const std::vector<uint32_t> &indices = wedges.indices.empty() ? model.indices : wedges.indices;
+        auto vertexAt = [&](size_t i)
+        { return wedges.vertex.empty() ? i : size_t(wedges.vertex[i]); };
+
+        // quantized positions: 16 bits in the bounding cube, the node scales them back
+        const double extent = std::max({model.max[0] - model.min[0], model.max[1] - model.min[1], model.max[2] - model.min[2], 1e-30});
+        const double step = extent / 65535.0;
+        auto quantizedPosition = [&](size_t v, int axis)
+        {
+            const float p = axis == 0 ? model.x[v] : axis == 1 ? model.y[v] : model.z[v];
+            const long q = std::lround((p - model.min[axis]) / step);
+            return static_cast<uint16_t>(std::min(65535L, std::max(0L, q)));
+        };
+        // texcoords outside [0, 1] (tiling) cannot be normalized integers
+        std::atomic<bool> unitTexcoords{true};
+        if (textured && quantized)
+        {
+            const size_t values = model.texcoords.size();
+            parallelFor((values + ItemsPerBlock - 1) / ItemsPerBlock, threads, [&](size_t task)
+                        {
+                for (size_t i = task * ItemsPerBlock, end = std::min(values, i + ItemsPerBlock); i < end; ++i)
+                {
+                    if (!(model.texcoords[i] >= 0.f && model.texcoords[i] <= 1.f))
+                        unitTexcoords = false;
+                } });
+        }
+        const bool quantizedTexcoords = quantized && unitTexcoords;
+
+        // exact bounds of the written positions (required by glTF)
+        double min[3], max[3];
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            min[axis] = std::numeric_limits<double>::max();
+            max[axis] = std::numeric_limits<double>::lowest();
+        }
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            const size_t v = vertexAt(i);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const double p = quantized ? quantizedPosition(v, axis) : (axis == 0 ? model.x[v] : axis == 1 ? model.y[v] : model.z[v]);
+                min[axis] = std::min(min[axis], p);
+                max[axis] = std::max(max[axis], p);
+            }
+        }
+
+        std::vector<View> views;
+        std::vector<std::string> accessors, attributes;
+        auto accessor = [&](int componentType, const char *type, bool normalized, const std::string &extra = std::string())
+        {
+            const View &view = views.back();
+            accessors.push_back("{\"bufferView\":" + std::to_string(views.size() - 1) + ",\"componentType\":" + std::to_string(componentType) +
+                                ",\"count\":" + std::to_string(view.count) + ",\"type\":\"" + type + "\"" +
+                                (normalized ? ",\"normalized\":true" : "") + extra + "}");
+            return std::to_string(accessors.size() - 1);
+        };
+        auto addView = [&](size_t count, int stride, int target, std::function<void(size_t, size_t, unsigned char *)> fill)
+        {
+            View view;
+            view.count = count;
+            view.stride = stride;
+            view.target = target;
+            view.fill = std::move(fill);
+            views.push_back(std::move(view));
+        };
+
+        int indexAccessor = -1;
+        if (faceCount > 0)
+        {
+            const bool shortIndices = vertexCount <= std::numeric_limits<uint16_t>::max();
+            addView(indices.size(), shortIndices ? 2 : 4, ElementArrayBuffer, [&, shortIndices](size_t first, size_t count, unsigned char *out)
+                    {
+                if (shortIndices)
+                {
+                    uint16_t *values = reinterpret_cast<uint16_t *>(out);
+                    for (size_t i = 0; i < count; ++i)
+                        values[i] = static_cast<uint16_t>(indices[first + i]);
+                }
+                else
+                    std::memcpy(out, indices.data() + first, count * 4); });
+            indexAccessor = static_cast<int>(accessors.size());
+            accessor(shortIndices ? UnsignedShort : UnsignedInt, "SCALAR", false);
+        }
+
+        // positions padded to 8 bytes when quantized: vertex attributes are 4-byte aligned
+        addView(vertexCount, quantized ? 8 : 12, ArrayBuffer, [&](size_t first, size_t count, unsigned char *out)
+                {
+            for (size_t i = 0; i < count; ++i)
+            {
+                const size_t v = vertexAt(first + i);
+                if (quantized)
+                {
+                    const uint16_t q[4] = {quantizedPosition(v, 0), quantizedPosition(v, 1), quantizedPosition(v, 2), 0};
+                    std::memcpy(out + i * 8, q, 8);
+                }
+                else
+                {
+                    const float p[3] = {model.x[v], model.y[v], model.z[v]};
+                    std::memcpy(out + i * 12, p, 12);
+                }
+            } });
+        const std::string bounds = ",\"min\":[" + number(min[0]) + "," + number(min[1]) + "," + number(min[2]) + "],\"max\":[" +
+                                   number(max[0]) + "," + number(max[1]) + "," + number(max[2]) + "]";
+        attributes.push_back("\"POSITION\":" + accessor(quantized ? UnsignedShort : Float, "VEC3", false, bounds));
+
+        if (withNormals)
+        {
+            addView(vertexCount, quantized ? 4 : 12, ArrayBuffer, [&](size_t first, size_t count, unsigned char *out)
+                    {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const size_t v = vertexAt(first + i);
+                    const float n[3] = {model.nx[v], model.ny[v], model.nz[v]};
+                    if (quantized)
+                    {
+                        for (int axis = 0; axis < 3; ++axis)
+                            out[i * 4 + axis] = static_cast<unsigned char>(static_cast<int8_t>(std::lround(std::min(1.f, std::max(-1.f, n[axis])) * 127.f)));
+                        out[i * 4 + 3] = 0;
+                    }
+                    else
+                        std::memcpy(out + i * 12, n, 12);
+                } });
+            attributes.push_back("\"NORMAL\":" + accessor(quantized ? Byte : Float, "VEC3", quantized));
+        }
+
+        if (textured)
+        {
+            addView(vertexCount, quantizedTexcoords ? 4 : 8, ArrayBuffer, [&](size_t first, size_t count, unsigned char *out)
+                    {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const size_t c = wedges.corner[first + i];
+                    const float uv[2] = {model.texcoords[c * 2], 1.f - model.texcoords[c * 2 + 1]};
+                    if (quantizedTexcoords)
+                    {
+                        const uint16_t q[2] = {static_cast<uint16_t>(std::lround(uv[0] * 65535.f)), static_cast<uint16_t>(std::lround(uv[1] * 65535.f))};
+                        std::memcpy(out + i * 4, q, 4);
+                    }
+                    else
+                        std::memcpy(out + i * 8, uv, 8);
+                } });
+            attributes.push_back("\"TEXCOORD_0\":" + accessor(quantizedTexcoords ? UnsignedShort : Float, "VEC2", quantizedTexcoords));
+        }
+
+        if (withColors)
+        {
+            addView(vertexCount, 4, ArrayBuffer, [&](size_t first, size_t count, unsigned char *out)
+                    {
+                for (size_t i = 0; i < count; ++i)
+                {
+                    // 0xAARRGGBB to the bytes R, G, B, A
+                    const uint32_t c = model.colors[vertexAt(first + i)];
+                    const unsigned char rgba[4] = {static_cast<unsigned char>(c >> 16), static_cast<unsigned char>(c >> 8),
+                                                   static_cast<unsigned char>(c), static_cast<unsigned char>(c >> 24)};
+                    std::memcpy(out + i * 4, rgba, 4);
+                } });
+            attributes.push_back("\"COLOR_0\":" + accessor(UnsignedByte, "VEC4", true));
+        }
+
+        // each stream on its own thread; only the encoded bytes are kept
+        const size_t geometryViews = views.size();
+        if (meshopt)
+        {
+            meshopt_encodeVertexVersion(0);
+            meshopt_encodeIndexVersion(1);
+            parallelFor(geometryViews, threads, [&](size_t i)
+                        { encode(views[i], indices, vertexCount); });
+        }
+
+        const bool withImage = baseColor && textured;
+        if (withImage)
+        {
+            View image;
+            image.count = baseColor->bytes.size();
+            image.stride = 1;
+            image.bytes = &baseColor->bytes;
+            views.push_back(std::move(image));
+        }
+
+        // buffer 0 is the binary chunk; with meshopt the geometry views also point into buffer 1, the
+        // decoded data, which has no bytes in the file
+        std::vector<std::string> viewJson;
+        size_t binBytes = 0, fallbackBytes = 0;
+        for (size_t i = 0; i < views.size(); ++i)
+        {
+            const View &view = views[i];
+            std::string json;
+            if (meshopt && i < geometryViews)
+            {
+                const bool vertices = view.target == ArrayBuffer;
+                json = "{\"buffer\":1,\"byteOffset\":" + std::to_string(fallbackBytes) + ",\"byteLength\":" + std::to_string(view.rawBytes()) +
+                       (vertices ? ",\"byteStride\":" + std::to_string(view.stride) : std::string()) + ",\"target\":" + std::to_string(view.target) +
+                       ",\"extensions\":{\"EXT_meshopt_compression\":{\"buffer\":0,\"byteOffset\":" + std::to_string(binBytes) +
+                       ",\"byteLength\":" + std::to_string(view.encoded.size()) + ",\"byteStride\":" + std::to_string(view.stride) +
+                       ",\"mode\":\"" + (vertices ? "ATTRIBUTES" : "TRIANGLES") + "\",\"count\":" + std::to_string(view.count) + "}}}";
+                fallbackBytes += aligned(view.rawBytes());
+                binBytes += aligned(view.encoded.size());
+            }
+            else
+            {
+                json = "{\"buffer\":0,\"byteOffset\":" + std::to_string(binBytes) + ",\"byteLength\":" + std::to_string(view.rawBytes());
+                if (view.target == ArrayBuffer)
+                    json += ",\"byteStride\":" + std::to_string(view.stride);
+                if (view.target)
+                    json += ",\"target\":" + std::to_string(view.target);
+                json += "}";
+                binBytes += aligned(view.rawBytes());
+            }
+            viewJson.push_back(json);
+        }
+
+        std::vector<std::string> extensions;
+        if (quantized)
+            extensions.push_back("\"KHR_mesh_quantization\"");
+        if (meshopt)
+            extensions.push_back("\"EXT_meshopt_compression\"");
+        std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"VoxelForge\"},";
+        if (!extensions.empty())
+            json += "\"extensionsUsed\":[" + joined(extensions) + "],\"extensionsRequired\":[" + joined(extensions) + "],";
+        json += "\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0";
+        if (quantized)
+            json += ",\"translation\":[" + number(model.min[0]) + "," + number(model.min[1]) + "," + number(model.min[2]) + "],\"scale\":[" +
+                    number(step) + "," + number(step) + "," + number(step) + "]";
+        json += "}],\"meshes\":[{\"primitives\":[{\"attributes\":{" + joined(attributes) + "}";
+        if (indexAccessor >= 0)
+            json += ",\"indices\":" + std::to_string(indexAccessor) + ",\"mode\":4";
+        else
+            json += ",\"mode\":0";
+        json += ",\"material\":0}]}],";
+        // a reconstructed surface is seen from both sides and carries its lighting in the texture
+        std::string material = "{\"pbrMetallicRoughness\":{";
+        if (withImage)
+        {
+            material += "\"baseColorTexture\":{\"index\":0},";
+            json += "\"samplers\":[{\"magFilter\":" + std::to_string(Linear) + ",\"minFilter\":" + std::to_string(LinearMipmapLinear) +
+                    ",\"wrapS\":" + std::to_string(ClampToEdge) + ",\"wrapT\":" + std::to_string(ClampToEdge) + "}],"
+                    "\"images\":[{\"bufferView\":" + std::to_string(views.size() - 1) + ",\"mimeType\":" + quoted(baseColor->mimeType) + "}],"
+                    "\"textures\":[{\"sampler\":0,\"source\":0}],";
+        }
+        material += "\"metallicFactor\":0,\"roughnessFactor\":1},\"doubleSided\":true}";
+        json += "\"materials\":[" + material + "],";
+        json += "\"accessors\":[" + joined(accessors) + "],\"bufferViews\":[" + joined(viewJson) + "],"
+                "\"buffers\":[{\"byteLength\":" + std::to_string(binBytes) + "}";
+        if (meshopt)
+            json += ",{\"byteLength\":" + std::to_string(fallbackBytes) + ",\"extensions\":{\"EXT_meshopt_compression\":{\"fallback\":true}}}";
+        json += "]}";
+        json.resize(aligned(json.size()), ' ');
+
+        const uint64_t total = 12 + 8 + json.size() + 8 + binBytes;
+        if (total > std::numeric_limits<uint32_t>::max())
+            return fail(error, path + " would exceed the 4 GB of a GLB file");
+        std::vector<unsigned char> header;
+        appendUint32(header, 0x46546C67); // "glTF"
+        appendUint32(header, 2);
+        appendUint32(header, static_cast<uint32_t>(total));
+        appendUint32(header, static_cast<uint32_t>(json.size()));
+        appendUint32(header, 0x4E4F534A); // "JSON"
+        header.insert(header.end(), json.begin(), json.end());
+        appendUint32(header, static_cast<uint32_t>(binBytes));
+        appendUint32(header, 0x004E4942); // "BIN"
+
+        // readers never see a half-written file
+        const std::string partial = path + ".part";
+        {
+            std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+            const char padding[4] = {0, 0, 0, 0};
+            for (size_t i = 0; i < views.size() && out; ++i)
+            {
+                const View &view = views[i];
+                size_t written = view.rawBytes();
+                if (meshopt && i < geometryViews)
+                {
+                    out.write(reinterpret_cast<const char *>(view.encoded.data()), static_cast<std::streamsize>(view.encoded.size()));
+                    written = view.encoded.size();
+                }
+                else
+                    writeRaw(out, view);
+                out.write(padding, static_cast<std::streamsize>(aligned(written) - written));
+            }
+            if (!out)
+            {
+                out.close();
+                std::error_code ec;
+                fs::remove(partial, ec);
+                return fail(error, "cannot write " + partial);
+            }
+        }
+        std::error_code ec;
+        fs::rename(partial, path, ec);
+        if (ec)
+        {
+            fs::remove(partial, ec);
+            return fail(error, "cannot move " + partial + " to " + path);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+// Binary glTF 2.0 (.glb) export of a MeshModel (model_io.hpp), for the mesh
+// LODs in final_3d_models (mesh_lod.hpp).
+//
+// glTF has one texture coordinate per vertex, so a vertex is written once
+// per distinct texture corner (wedge) of its faces. One primitive holds all
+// faces with one base colour image embedded in the binary chunk: the model
+// is expected to use a single texture atlas. Positions keep the frame of
+// the reconstruction; texture v is flipped (glTF puts the origin at the top
+// of the image).
+//
+// Compression (GltfCompression):
+//   Quantized  KHR_mesh_quantization: positions as 16-bit integers in the
+//              bounding cube (the node scales them back), normals as 8-bit
+//              and texcoords in [0, 1] as 16-bit normalized integers.
+//   Meshopt    the same, plus EXT_meshopt_compression: vertices reordered
+//              for the GPU vertex cache and every buffer view encoded with
+//              the meshoptimizer codecs (decoded by three.js, Babylon.js,
+//              gltfpack, ...). Usually a third of the quantized size.
+// Both extensions are marked required: viewers without them reject the file.
+//
+// The model is not copied: uncompressed buffer views are converted block by
+// block while the file is written, compressed ones are encoded one at a time
+// (in parallel) and only their encoded bytes are kept until the write.
+
+#include "model_io.hpp"
+
+#include <string>
+#include <vector>
+
+namespace VoxelForge
+{
+    enum class GltfCompression
+    {
+        None,      // float attributes
+        Quantized, // KHR_mesh_quantization
+        Meshopt    // KHR_mesh_quantization + EXT_meshopt_compression
+    };
+
+    const char *GltfCompressionName(GltfCompression compression);
+    // inverse of GltfCompressionName ("none", "quantized", "meshopt"), false for an unknown name
+    bool GltfCompressionFromName(const std::string &name, GltfCompression &compression);
+
+    struct GltfOptions
+    {
+        GltfCompression compression = GltfCompression::Meshopt;
+        int threads = 0; // 0 = ThreadBudget::limit()
+    };
+
+    struct GltfImage
+    {
+        std::vector<unsigned char> bytes; // encoded file
+        std::string mimeType;             // "image/jpeg" or "image/png"
+    };
+
+    // baseColor: nullptr = untextured (texcoords are still written). Written next to path first, then
+    // renamed over it. error says why it failed
+    bool WriteGlb(const std::string &path, const MeshModel &model, const GltfImage *baseColor,
+                  const GltfOptions &options = GltfOptions(), std::string *error = nullptr);
+}
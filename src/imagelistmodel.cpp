@@ -0,0 +1,171 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// List model for the image manager
+
+#include "imagelistmodel.h"
+#include "thumbnailloader.h"
+
+#include <QColor>
+#include <QFileInfo>
+#include <QMetaObject>
+#include <QPixmap>
+
+#include <algorithm>
+#include <functional>
+
+ImageListModel::ImageListModel(ThumbnailLoader *loader, QObject *parent)
+    : QAbstractListModel(parent), loader(loader)
+{
+    // ~300 KB per 320x240 thumbnail -> a few hundred icons, plenty for a screen or two of rows
+    iconCache.setMaxCost(96 * 1024 * 1024);
+
+    QPixmap placeholder(loader->thumbnailSize());
+    placeholder.fill(QColor(255, 255, 255, 8));
+    placeholderIcon = QIcon(placeholder);
+
+    connect(loader, &ThumbnailLoader::thumbnailReady, this, &ImageListModel::onThumbnailReady, Qt::QueuedConnection);
+}
+
+int ImageListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : paths.size();
+}
+
+QVariant ImageListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= paths.size())
+        return QVariant();
+
+    const QString &path = paths[index.row()];
+    switch (role)
+    {
+    case Qt::DisplayRole:
+        return QFileInfo(path).fileName();
+    case Qt::ToolTipRole:
+    case PathRole:
+        return path;
+    case Qt::DecorationRole:
+    {
+        if (QIcon *icon = iconCache.object(path))
+            return *icon;
+
+        // Only rows the view paints get here, so this is what keeps decoding
+        // (and memory) proportional to the visible area, not the project size.
+        // Newer requests get a higher priority so the rows on screen after a
+        // fast scroll are decoded before the ones scrolled past.
+        if (!requested.contains(path))
+        {
+            requested.insert(path);
+            loader->request(path, ++requestPriority);
+        }
+        return placeholderIcon;
+    }
+    default:
+        return QVariant();
+    }
+}
+
+void ImageListModel::setImages(const QStringList &newPaths)
+{
+    beginResetModel();
+    loader->cancelAll();
+    requested.clear();
+    iconCache.clear();
+    failedPaths.clear();
+    paths = QVector<QString>(newPaths.begin(), newPaths.end());
+    rebuildRowIndex();
+    endResetModel();
+}
+
+void ImageListModel::addImage(const QString &path)
+{
+    if (rowByPath.contains(path))
+        return;
+
+    const int row = paths.size();
+    beginInsertRows(QModelIndex(), row, row);
+    paths.append(path);
+    rowByPath.insert(path, row);
+    endInsertRows();
+}
+
+void ImageListModel::removeImages(const QStringList &toRemove)
+{
+    QVector<int> rows;
+    for (const QString &path : toRemove)
+    {
+        const int row = rowByPath.value(path, -1);
+        if (row >= 0)
+            rows.append(row);
+        iconCache.remove(path);
+        requested.remove(path);
+    }
+    if (rows.isEmpty())
+        return;
+
+    // contiguous runs from the back so the remaining row numbers stay valid, one row index rebuild at the end
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    for (int i = 0; i < rows.size();)
+    {
+        const int last = rows[i];
+        int first = last;
+        while (++i < rows.size() && rows[i] == first - 1)
+            first = rows[i];
+        beginRemoveRows(QModelIndex(), first, last);
+        paths.remove(first, last - first + 1);
+        endRemoveRows();
+    }
+    rebuildRowIndex();
+}
+
+void ImageListModel::removeFailed()
+{
+    QStringList batch;
+    batch.swap(failedPaths);
+    removeImages(batch);
+}
+
+void ImageListModel::clear()
+{
+    setImages(QStringList());
+}
+
+QString ImageListModel::pathAt(int row) const
+{
+    return (row >= 0 && row < paths.size()) ? paths[row] : QString();
+}
+
+void ImageListModel::onThumbnailReady(const QString &imagePath, const QImage &thumbnail)
+{
+    if (!requested.remove(imagePath))
+        return; // list was reset while decoding
+
+    const int row = rowByPath.value(imagePath, -1);
+    if (row < 0)
+        return;
+
+    if (thumbnail.isNull())
+    {
+        // not a readable image - keep the list consistent with what can be previewed. Batched: every
+        // removal rebuilds the row index, once per file that would be quadratic in a folder of them
+        if (failedPaths.isEmpty())
+            QMetaObject::invokeMethod(this, &ImageListModel::removeFailed, Qt::QueuedConnection);
+        failedPaths << imagePath;
+        return;
+    }
+
+    // QPixmap has to be created on the GUI thread, which is where we are now
+    const int cost = thumbnail.width() * thumbnail.height() * 4;
+    iconCache.insert(imagePath, new QIcon(QPixmap::fromImage(thumbnail)), cost);
+
+    const QModelIndex idx = index(row);
+    emit dataChanged(idx, idx, {Qt::DecorationRole});
+}
+
+void ImageListModel::rebuildRowIndex()
+{
+    rowByPath.clear();
+    rowByPath.reserve(paths.size());
+    for (int i = 0; i < paths.size(); ++i)
+        rowByPath.insert(paths[i], i);
+}
@@ -0,0 +1,70 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// List model for the image manager
+
+#ifndef IMAGELISTMODEL_H
+#define IMAGELISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QHash>
+#include <QIcon>
+#include <QImage>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+class ThumbnailLoader;
+
+// Holds only the image paths. Thumbnails are requested lazily from data(),
+// which the view only calls for rows it actually paints, and decoded icons
+// live in a size-bounded LRU so huge (video) projects keep a flat memory use.
+class ImageListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    // Qt::UserRole returns the full path, like the old QListWidget items did
+    enum Roles
+    {
+        PathRole = Qt::UserRole
+    };
+
+    explicit ImageListModel(ThumbnailLoader *loader, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // Replace the whole list in one reset (project / folder load)
+    void setImages(const QStringList &paths);
+    // Append one image (import, video frame extraction)
+    void addImage(const QString &path);
+    void removeImages(const QStringList &paths);
+    void clear();
+
+    QString pathAt(int row) const;
+    int rowOf(const QString &path) const { return rowByPath.value(path, -1); }
+
+    // Upper bound for decoded icons kept in memory, in bytes
+    void setIconCacheLimit(int bytes) { iconCache.setMaxCost(bytes); }
+
+private slots:
+    void onThumbnailReady(const QString &imagePath, const QImage &thumbnail);
+    void removeFailed();
+
+private:
+    void rebuildRowIndex();
+
+    ThumbnailLoader *loader;
+    QVector<QString> paths;
+    QHash<QString, int> rowByPath;
+    // undecodable images, removed together once per event loop turn
+    QStringList failedPaths;
+
+    // mutable: data() is const but fills the cache / queues decodes on demand
+    mutable QCache<QString, QIcon> iconCache;
+    mutable QSet<QString> requested;
+    mutable int requestPriority = 0;
+    QIcon placeholderIcon;
+};
+
+#endif // IMAGELISTMODEL_H
@@ -0,0 +1,145 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// Throttled log sink between worker threads and the log views
+
+#include "logsink.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QScrollBar>
+#include <QStringList>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QTextEdit>
+
+#include <chrono>
+
+LogSink::LogSink(QTextEdit *view, QObject *parent, int flushIntervalMs, int maxScrollbackLines)
+    : QObject(parent), buffer(16384), dropped(0), view(view), maxScrollbackLines(maxScrollbackLines),
+      runBuffer(65536), runOpen(false), runPosting(0), runStop(false)
+{
+    if (view)
+        view->document()->setMaximumBlockCount(maxScrollbackLines);
+
+    flushTimer.setInterval(flushIntervalMs);
+    connect(&flushTimer, &QTimer::timeout, this, &LogSink::flush);
+    flushTimer.start();
+}
+
+LogSink::~LogSink()
+{
+    flush();
+    stopRunLog();
+}
+
+bool LogSink::startRunLog(const QString &filePath)
+{
+    stopRunLog();
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    runFile.setFileName(filePath);
+    if (!runFile.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate))
+        return false;
+
+    runStop = false;
+    runWriter = std::thread(&LogSink::writeRunLog, this);
+    runOpen = true;
+    return true;
+}
+
+void LogSink::stopRunLog()
+{
+    if (!runOpen.exchange(false))
+        return;
+
+    // lines posted before this point must reach the file: let posts in flight finish pushing
+    while (runPosting.load() != 0)
+        std::this_thread::yield();
+    {
+        std::lock_guard<std::mutex> guard(runLock);
+        runStop = true;
+    }
+    runWake.notify_one();
+    runWriter.join();
+    runFile.close();
+}
+
+void LogSink::writeRunLog()
+{
+    QString line;
+    for (;;)
+    {
+        // read before draining: once set, nothing more is pushed, so this drain is the last one needed
+        const bool stopping = runStop.load();
+
+        QByteArray batch;
+        while (runBuffer.tryPop(line))
+        {
+            batch += line.toUtf8();
+            batch += '\n';
+        }
+        if (!batch.isEmpty())
+        {
+            runFile.write(batch);
+            runFile.flush();
+        }
+        if (stopping)
+            return;
+
+        // Producers only signal when the ring is full, poll while idle
+        if (batch.isEmpty())
+        {
+            std::unique_lock<std::mutex> lock(runLock);
+            if (!runStop.load())
+                runWake.wait_for(lock, std::chrono::milliseconds(20));
+        }
+    }
+}
+
+void LogSink::post(const QString &message)
+{
+    ++runPosting;
+    if (runOpen.load())
+    {
+        // the writer is a whole ring behind: wait for it rather than lose a line of the file
+        while (!runBuffer.tryPush(message))
+        {
+            runWake.notify_one();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    --runPosting;
+
+    // the view may lose lines, the run file does not
+    if (!buffer.tryPush(message))
+        ++dropped;
+}
+
+void LogSink::flush()
+{
+    QStringList lines;
+    QString line;
+    while (buffer.tryPop(line))
+        lines << line;
+
+    const quint64 lost = dropped.exchange(0);
+    if (lost > 0)
+        lines << QString("[log sink] %1 message(s) not shown, logging faster than the view can keep up").arg(lost);
+
+    if (lines.isEmpty() || !view)
+        return;
+
+    // Older lines would be trimmed by the block limit right away, skip them
+    if (lines.size() > maxScrollbackLines)
+        lines = lines.mid(lines.size() - maxScrollbackLines);
+
+    QScrollBar *bar = view->verticalScrollBar();
+    const bool followTail = bar->value() == bar->maximum();
+
+    // One plain-text insertion for the whole batch
+    QTextCursor cursor(view->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText((view->document()->isEmpty() ? QString() : QString("\n")) + lines.join('\n'));
+
+    if (followTail)
+        bar->setValue(bar->maximum());
+}
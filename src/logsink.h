@@ -0,0 +1,70 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// Throttled log sink between worker threads and the log views
+
+#ifndef LOGSINK_H
+#define LOGSINK_H
+
+#include <QObject>
+#include <QFile>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "log_ring_buffer.hpp"
+
+class QTextEdit;
+
+// Workers push lines with post() (lock-free, callable from any thread, connect
+// with Qt::DirectConnection). The GUI thread drains the buffer on a timer and
+// appends everything gathered since the last tick in one go, so thousands of
+// messages per second cost a handful of repaints instead of thousands of
+// queued events. The view keeps a capped scrollback and may drop lines when
+// it cannot keep up. The run file gets every line from a writer thread fed by
+// a second ring of its own (no file I/O on the GUI thread); when that ring is
+// full post() waits for the writer to catch up instead of dropping the line.
+class LogSink : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LogSink(QTextEdit *view, QObject *parent = nullptr,
+                     int flushIntervalMs = 100, int maxScrollbackLines = 5000);
+    ~LogSink() override;
+
+    // Start writing everything that goes through the sink to filePath (dirs are created)
+    bool startRunLog(const QString &filePath);
+    void stopRunLog();
+    QString runLogPath() const { return runFile.fileName(); }
+
+public slots:
+    // Thread-safe, takes no lock
+    void post(const QString &message);
+    // Drain the buffer now (GUI thread only), e.g. before appending a final status line
+    void flush();
+
+private:
+    LogRingBuffer<QString> buffer;
+    std::atomic<quint64> dropped;
+
+    QPointer<QTextEdit> view;
+    QTimer flushTimer;
+    int maxScrollbackLines;
+
+    void writeRunLog();
+
+    LogRingBuffer<QString> runBuffer;
+    std::atomic<bool> runOpen;      // post() pushes lines for the file
+    std::atomic<int> runPosting;    // post() calls that may still push to runBuffer
+    std::atomic<bool> runStop;      // runWriter drains runBuffer one last time and exits
+    QFile runFile;                  // used by runWriter only while it runs
+    std::thread runWriter;
+    std::mutex runLock;             // only for runWriter to sleep on, never taken by post()
+    std::condition_variable runWake;
+};
+
+#endif // LOGSINK_H
@@ -2,12 +2,21 @@
 // Main entry point for Voxel Forge application
 
 #include "mainwindow.h"
+#include "thread_budget.hpp"
 #include <QApplication>
+#include <QSettings>
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
-    
+
+    // CPU budget (Settings page) before the worker threads start: NUMA pinning is inherited
+    QSettings settings("Voxel-Forge", "Voxel-Forge");
+    VoxelForge::ThreadBudgetOptions budget;
+    budget.maxThreads = settings.value("performance/maxThreads", 0).toInt();
+    budget.pinNumaNodes = settings.value("performance/pinNumaNodes", false).toBool();
+    VoxelForge::ThreadBudget::configure(budget);
+
     MainWindow window;
     window.showMaximized();
     
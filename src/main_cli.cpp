@@ -0,0 +1,264 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// Headless entry point: runs the reconstruction pipeline (voxelforge_core) without any widgets
+
+#include "pipeline.hpp"
+#include "thread_budget.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+
+namespace
+{
+    std::atomic<VoxelForge::Pipeline *> runningPipeline(nullptr);
+
+    // Ctrl+C / SIGTERM: cancels the run (OpenMVG stages stop within a moment, OpenMVS ones after their chunk)
+    void onSignal(int)
+    {
+        if (VoxelForge::Pipeline *pipeline = runningPipeline.load())
+            pipeline->cancel();
+    }
+
+    // One JSON object per line on stdout, so wrappers can parse progress as it happens
+    void emitEvent(QJsonObject event)
+    {
+        event.insert("time", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs));
+        const QByteArray line = QJsonDocument(event).toJson(QJsonDocument::Compact);
+        std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), stdout);
+        std::fputc('\n', stdout);
+        std::fflush(stdout);
+    }
+
+    bool loadConfig(const QString &path, QJsonObject &config, QString &error)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            error = file.errorString();
+            return false;
+        }
+
+        QJsonParseError parseError;
+        const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+        if (doc.isNull() || !doc.isObject())
+        {
+            error = parseError.errorString();
+            return false;
+        }
+        config = doc.object();
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("voxel-forge-cli");
+    QCoreApplication::setApplicationVersion("0.1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Runs the Voxel-Forge reconstruction pipeline headless.\n"
+        "Progress is written to stdout as JSON lines, pipeline logs go to stderr.\n"
+        "Command line options override the values of the JSON config file.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    QCommandLineOption configOption({"c", "config"}, "JSON config file (same keys as the long options).", "file");
+    QCommandLineOption projectOption({"p", "project"}, "Project folder (must contain images/).", "dir");
+    QCommandLineOption sensorDbOption("sensor-db", "Camera sensor width database.", "file");
+    QCommandLineOption describerOption("describer", "Image describer method (SIFT_ANATOMY, AKAZE_FLOAT, ...).", "method");
+    QCommandLineOption presetOption("feature-preset", "Feature preset: NORMAL, HIGH, ULTRA.", "preset");
+    QCommandLineOption threadsOption("threads", "CPU budget of the run: worker threads of all stages together (0 = all cores).", "n");
+    QCommandLineOption pinNumaOption("pin-numa", "Restrict the run to the fewest NUMA nodes covering --threads (Linux).");
+    QCommandLineOption memoryOption("memory-budget", "RAM for the regions of matching and filtering, in MB; above it they run in tiles (0 = half the physical memory).", "mb");
+    QCommandLineOption ratioOption("ratio", "Nearest neighbour distance ratio for matching.", "value");
+    QCommandLineOption matchingOption("matching-method", "Nearest matching method (AUTO, BRUTEFORCEL2, ANNL2, CASCADEHASHINGL2, ...).", "method");
+    QCommandLineOption geometricOption("geometric-model", "Geometric model for filtering: f, e, h, a, u, o.", "model");
+    QCommandLineOption refineOption("intrinsic-refinement", "Intrinsic refinement for global SfM (ADJUST_ALL, NONE, ...).", "options");
+    QCommandLineOption untilOption("until", "Last stage to run: GlobalSfM, ExportToMVS (default, writes scene.mvs), Densify, ReconstructMesh, RefineMesh, TextureMesh (final_3d_models/textured_mesh.obj) or MeshLod (final_3d_models/textured_mesh_lod<N>.glb).", "stage");
+    QCommandLineOption denseLevelOption("dense-level", "Densify: images scaled down 2^level times for the depth maps (default 1).", "level");
+    QCommandLineOption denseViewsOption("dense-views", "Densify: neighbour views per depth map, 0 = all (default 8).", "n");
+    QCommandLineOption lodPointsOption("lod-node-points", "Point LOD: points per octree node of the sparse and dense clouds, 0 = no LOD (default 20000).", "n");
+    QCommandLineOption lodDepthOption("lod-depth", "Point LOD: deepest octree level (default 16).", "level");
+    QCommandLineOption meshLodsOption("mesh-lods", "Mesh LOD: glTF levels of the textured model (default 4).", "n");
+    QCommandLineOption meshLodRatioOption("mesh-lod-ratio", "Mesh LOD: faces of a level / faces of the level before (default 0.25).", "value");
+    QCommandLineOption meshLodFacesOption("mesh-lod-faces", "Mesh LOD: faces of the first level, 0 = all of the model (default 1000000).", "n");
+    QCommandLineOption meshLodTextureOption("mesh-lod-texture", "Mesh LOD: largest texture atlas side in pixels (default 4096).", "px");
+    QCommandLineOption meshLodCompressionOption("mesh-lod-compression", "Mesh LOD: glTF compression, meshopt (quantized + EXT_meshopt_compression, default), quantized (KHR_mesh_quantization) or none.", "mode");
+    QCommandLineOption quietOption({"q", "quiet"}, "Do not print pipeline logs to stderr.");
+    parser.addOptions({configOption, projectOption, sensorDbOption, describerOption, presetOption, threadsOption, pinNumaOption, memoryOption,
+                       ratioOption, matchingOption, geometricOption, refineOption, untilOption, denseLevelOption, denseViewsOption,
+                       lodPointsOption, lodDepthOption, meshLodsOption, meshLodRatioOption, meshLodFacesOption, meshLodTextureOption,
+                       meshLodCompressionOption, quietOption});
+    parser.process(app);
+
+    QJsonObject fileConfig;
+    if (parser.isSet(configOption))
+    {
+        QString error;
+        if (!loadConfig(parser.value(configOption), fileConfig, error))
+        {
+            std::fprintf(stderr, "Cannot read config %s: %s\n",
+                         qPrintable(parser.value(configOption)), qPrintable(error));
+            return 2;
+        }
+    }
+
+    // command line wins over the config file, which wins over the defaults
+    auto stringValue = [&](const QCommandLineOption &option, const QString &key, const QString &fallback)
+    {
+        if (parser.isSet(option))
+            return parser.value(option);
+        return fileConfig.contains(key) ? fileConfig.value(key).toString() : fallback;
+    };
+    auto numberValue = [&](const QCommandLineOption &option, const QString &key, double fallback)
+    {
+        if (parser.isSet(option))
+            return parser.value(option).toDouble();
+        return fileConfig.contains(key) ? fileConfig.value(key).toDouble() : fallback;
+    };
+
+    const QString projectPath = QDir(stringValue(projectOption, "project", QString())).absolutePath();
+    if (!parser.isSet(projectOption) && !fileConfig.contains("project"))
+    {
+        std::fprintf(stderr, "No project folder given (--project or \"project\" in the config).\n");
+        return 2;
+    }
+    if (!QFileInfo(projectPath + "/images").isDir())
+    {
+        std::fprintf(stderr, "No images/ folder in project %s\n", qPrintable(projectPath));
+        return 2;
+    }
+
+    VoxelForge::PipelineConfig config;
+    config.projectPath = projectPath.toStdString();
+    config.sensorDatabase = stringValue(sensorDbOption, "sensor_db", QString()).toStdString();
+    config.describerMethod = stringValue(describerOption, "describer", QString::fromStdString(config.describerMethod)).toStdString();
+    config.featurePreset = stringValue(presetOption, "feature_preset", QString::fromStdString(config.featurePreset)).toStdString();
+    config.memoryBudgetMB = static_cast<unsigned int>(numberValue(memoryOption, "memory_budget", config.memoryBudgetMB));
+    config.distanceRatio = static_cast<float>(numberValue(ratioOption, "ratio", config.distanceRatio));
+    config.nearestMatchingMethod = stringValue(matchingOption, "matching_method", QString::fromStdString(config.nearestMatchingMethod)).toStdString();
+    config.geometricModel = stringValue(geometricOption, "geometric_model", QString::fromStdString(config.geometricModel)).toStdString();
+    config.intrinsicRefinement = stringValue(refineOption, "intrinsic_refinement", QString::fromStdString(config.intrinsicRefinement)).toStdString();
+    config.densifyResolutionLevel = static_cast<unsigned int>(numberValue(denseLevelOption, "dense_level", config.densifyResolutionLevel));
+    config.densifyNumViews = static_cast<unsigned int>(numberValue(denseViewsOption, "dense_views", config.densifyNumViews));
+    config.lodMaxNodePoints = static_cast<unsigned int>(numberValue(lodPointsOption, "lod_node_points", config.lodMaxNodePoints));
+    config.lodMaxDepth = static_cast<unsigned int>(numberValue(lodDepthOption, "lod_depth", config.lodMaxDepth));
+    config.meshLodLevels = static_cast<unsigned int>(numberValue(meshLodsOption, "mesh_lods", config.meshLodLevels));
+    config.meshLodRatio = static_cast<float>(numberValue(meshLodRatioOption, "mesh_lod_ratio", config.meshLodRatio));
+    config.meshLodMaxFaces = static_cast<unsigned int>(numberValue(meshLodFacesOption, "mesh_lod_faces", config.meshLodMaxFaces));
+    config.meshLodMaxTexture = static_cast<unsigned int>(numberValue(meshLodTextureOption, "mesh_lod_texture", config.meshLodMaxTexture));
+    const QString meshLodCompression = stringValue(meshLodCompressionOption, "mesh_lod_compression", VoxelForge::GltfCompressionName(config.meshLodCompression));
+    if (!VoxelForge::GltfCompressionFromName(meshLodCompression.toStdString(), config.meshLodCompression))
+    {
+        std::fprintf(stderr, "Unknown mode for --mesh-lod-compression: %s\n", qPrintable(meshLodCompression));
+        return 2;
+    }
+    const QString lastStage = stringValue(untilOption, "until", VoxelForge::StageName(config.lastStage));
+    if (!VoxelForge::StageFromName(lastStage.toStdString(), config.lastStage))
+    {
+        std::fprintf(stderr, "Unknown stage for --until: %s\n", qPrintable(lastStage));
+        return 2;
+    }
+    const bool quiet = parser.isSet(quietOption) || fileConfig.value("quiet").toBool();
+
+    // process-wide, before the first worker thread (pinning is inherited); stages share it
+    VoxelForge::ThreadBudgetOptions budget;
+    budget.maxThreads = static_cast<int>(numberValue(threadsOption, "threads", 0));
+    budget.pinNumaNodes = parser.isSet(pinNumaOption) || fileConfig.value("pin_numa").toBool();
+    std::string budgetSummary;
+    if (!VoxelForge::ThreadBudget::configure(budget, &budgetSummary))
+        std::fprintf(stderr, "Thread budget: %s\n", budgetSummary.c_str());
+
+    // No event loop needed: the engine is plain C++ and runs on this thread
+    VoxelForge::Pipeline pipeline(config);
+
+    VoxelForge::PipelineCallbacks callbacks;
+    if (!quiet)
+    {
+        callbacks.log = [](const std::string &message)
+        {
+            std::fwrite(message.data(), 1, message.size(), stderr);
+            std::fputc('\n', stderr);
+        };
+    }
+    // stage_progress events only when the whole percentage changes
+    std::atomic<int> lastPercent(-1);
+    callbacks.stageStarted = [&lastPercent](VoxelForge::Stage stage, int index, int count)
+    {
+        lastPercent = -1;
+        QJsonObject event;
+        event.insert("event", "stage_begin");
+        event.insert("stage", VoxelForge::StageName(stage));
+        event.insert("index", index);
+        event.insert("count", count);
+        emitEvent(event);
+    };
+    callbacks.stageFinished = [](VoxelForge::Stage stage, bool success, double seconds)
+    {
+        QJsonObject event;
+        event.insert("event", "stage_end");
+        event.insert("stage", VoxelForge::StageName(stage));
+        event.insert("success", success);
+        event.insert("seconds", seconds);
+        emitEvent(event);
+    };
+    callbacks.stageProgress = [&lastPercent](VoxelForge::Stage stage, double fraction, const std::string &step)
+    {
+        const int percent = static_cast<int>(fraction * 100.0);
+        if (lastPercent.exchange(percent) == percent)
+            return;
+        QJsonObject event;
+        event.insert("event", "stage_progress");
+        event.insert("stage", VoxelForge::StageName(stage));
+        event.insert("fraction", fraction);
+        event.insert("step", QString::fromStdString(step));
+        emitEvent(event);
+    };
+
+    QJsonObject begin;
+    begin.insert("event", "pipeline_begin");
+    begin.insert("project", projectPath);
+    begin.insert("sensor_db", QString::fromStdString(pipeline.config().sensorDatabase));
+    begin.insert("describer", QString::fromStdString(config.describerMethod));
+    begin.insert("feature_preset", QString::fromStdString(config.featurePreset));
+    begin.insert("threads", VoxelForge::ThreadBudget::limit());
+    begin.insert("thread_budget", QString::fromStdString(budgetSummary));
+    begin.insert("geometric_model", QString::fromStdString(config.geometricModel));
+    begin.insert("memory_budget_mb", static_cast<int>(config.memoryBudgetMB));
+    begin.insert("last_stage", VoxelForge::StageName(pipeline.config().lastStage));
+    emitEvent(begin);
+
+    runningPipeline = &pipeline;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    QElapsedTimer total;
+    total.start();
+    const bool success = pipeline.run(callbacks);
+
+    runningPipeline = nullptr;
+
+    QJsonObject end;
+    end.insert("event", "pipeline_end");
+    end.insert("success", success);
+    end.insert("cancelled", pipeline.cancelled());
+    end.insert("seconds", total.elapsed() / 1000.0);
+    end.insert("report", QString::fromStdString(pipeline.paths().runReport));
+    emitEvent(end);
+
+    if (success)
+        return 0;
+    return pipeline.cancelled() ? 130 : 1;
+}
@@ -1,9 +1,18 @@
 #include "mainwindow.h"
 #include "backend.h"
+#include "thumbnailloader.h"
+#include "imagelistmodel.h"
+#include "logsink.h"
+#include "previewloader.h"
+#include "fileimportjob.h"
+#include "modelviewer.h"
+#include "thread_budget.hpp"
 
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QListWidget>
+#include <QListView>
+#include <QItemSelectionModel>
 #include <QStackedWidget>
 #include <QPushButton>
 #include <QLabel>
@@ -30,9 +39,15 @@
 #include <QLinearGradient>
 #include <QBitmap>
 #include <QTextEdit>
+#include <QProgressBar>
+#include <QSpinBox>
+#include <QCheckBox>
+#include <QSettings>
 #include <QGridLayout>
 #include <QDesktopServices>
 #include <QUrl>
+#include <QDateTime>
+#include <QProgressDialog>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -100,6 +115,13 @@ MainWindow::MainWindow(QWidget *parent)
         "}");
     mainLayout->addWidget(sidebar);
 
+    // thumbnail service + model for the image manager (decodes off the GUI thread,
+    // only for rows that are actually on screen)
+    thumbnailLoader = new ThumbnailLoader(QSize(320, 240), this);
+    imageModel = new ImageListModel(thumbnailLoader, this);
+    previewLoader = new PreviewLoader(this);
+    connect(previewLoader, &PreviewLoader::previewReady, this, &MainWindow::onPreviewReady, Qt::QueuedConnection);
+
     // stacked content (right)
     stackedContent = new QStackedWidget;
     stackedContent->setStyleSheet(
@@ -482,6 +504,22 @@ QWidget *MainWindow::createProjectManagerPage()
     logHeaderLayout->addWidget(cancelPipelineButton);
     mainPageLayout->addLayout(logHeaderLayout);
 
+    // Run progress: stages done plus the fraction of the running one
+    QHBoxLayout *progressLayout = new QHBoxLayout();
+    pipelineProgressLabel = new QLabel("Idle");
+    pipelineProgressLabel->setStyleSheet("font-size: 13px; color: #cfcfcf;");
+    pipelineProgressBar = new QProgressBar();
+    pipelineProgressBar->setRange(0, 1000);
+    pipelineProgressBar->setValue(0);
+    pipelineProgressBar->setTextVisible(false);
+    pipelineProgressBar->setFixedHeight(10);
+    pipelineProgressBar->setStyleSheet(
+        "QProgressBar { background: rgba(0,0,0,0.3); border: 1px solid rgba(153, 0, 255, 1); border-radius: 5px; }"
+        "QProgressBar::chunk { background: rgba(153, 0, 255, 1); border-radius: 4px; }");
+    progressLayout->addWidget(pipelineProgressLabel);
+    progressLayout->addWidget(pipelineProgressBar, 1);
+    mainPageLayout->addLayout(progressLayout);
+
     pipelineLogViewer = new QTextEdit();
     pipelineLogViewer->setReadOnly(true);
     pipelineLogViewer->setFontFamily("Courier");
@@ -656,20 +694,25 @@ QWidget *MainWindow::createImageManagerPage()
     QHBoxLayout *middleLayout = new QHBoxLayout();
 
     // image list as icon grid
-    imageList = new QListWidget;
+    imageList = new QListView;
+    imageList->setModel(imageModel);
     imageList->setViewMode(QListView::IconMode);
     imageList->setIconSize(QSize(160, 120));
-    imageList->setResizeMode(QListWidget::Adjust);
+    imageList->setResizeMode(QListView::Adjust);
     imageList->setMovement(QListView::Static);
     imageList->setSpacing(12);
     imageList->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    // uniform sizes + batched layout keep 50k-frame projects scrolling smoothly
+    imageList->setUniformItemSizes(true);
+    imageList->setLayoutMode(QListView::Batched);
+    imageList->setBatchSize(256);
     imageList->setStyleSheet(
-        "QListWidget { background: rgba(0,0,0,0.15); border: 2px solid rgba(103, 38, 255, 1); "
+        "QListView { background: rgba(0,0,0,0.15); border: 2px solid rgba(103, 38, 255, 1); "
         "border-radius: 8px; padding: 12px; }"
-        "QListWidget::item { color: #eaeaea; font-size: 12px; background: rgba(255,255,255,0.03); "
+        "QListView::item { color: #eaeaea; font-size: 12px; background: rgba(255,255,255,0.03); "
         "border-radius: 6px; padding: 8px; }"
-        "QListWidget::item:selected { background: rgba(123,97,255,0.2); border: 2px solid #7b61ff; }"
-        "QListWidget::item:hover { background: rgba(255,255,255,0.08); }");
+        "QListView::item:selected { background: rgba(123,97,255,0.2); border: 2px solid #7b61ff; }"
+        "QListView::item:hover { background: rgba(255,255,255,0.08); }");
     middleLayout->addWidget(imageList, 2);
 
     // Image preview
@@ -712,7 +755,9 @@ QWidget *MainWindow::createImageManagerPage()
     connect(refreshImagesButton, &QPushButton::clicked, this, &MainWindow::refreshImageList);
     connect(saveImagesButton, &QPushButton::clicked, this, &MainWindow::saveSelectedImages);
     connect(deleteImagesButton, &QPushButton::clicked, this, &MainWindow::deleteSelectedImages);
-    connect(imageList, &QListWidget::itemClicked, this, &MainWindow::onImageItemClicked);
+    connect(imageList, &QListView::clicked, this, &MainWindow::onImageClicked);
+    // keyboard navigation previews too
+    connect(imageList->selectionModel(), &QItemSelectionModel::currentChanged, this, &MainWindow::onImageClicked);
 
     return page;
 }
@@ -818,18 +863,11 @@ QWidget *MainWindow::create3DModelsPage()
         "border-radius: 8px; "
         "}");
     
-    // For now, add a label that will show model info
+    // rendered on the CPU (modelviewer.h), inside the border of the frame
     QVBoxLayout *viewerContentLayout = new QVBoxLayout(modelViewerWidget);
-    modelViewerLabel = new QLabel("No model loaded\n\nSelect a model from the list and click 'Open Model'");
-    modelViewerLabel->setAlignment(Qt::AlignCenter);
-    modelViewerLabel->setStyleSheet(
-        "QLabel { "
-        "color: #9b7dff; "
-        "font-size: 16px; "
-        "background: transparent; "
-        "border: none; "
-        "}");
-    viewerContentLayout->addWidget(modelViewerLabel);
+    viewerContentLayout->setContentsMargins(2, 2, 2, 2);
+    modelViewer = new ModelViewer();
+    viewerContentLayout->addWidget(modelViewer);
     
     viewerLayout->addWidget(modelViewerWidget);
     contentLayout->addLayout(viewerLayout, 3);
@@ -839,6 +877,8 @@ QWidget *MainWindow::create3DModelsPage()
     // Connect signals
     connect(modelList, &QListWidget::itemClicked, this, &MainWindow::onModelItemClicked);
     connect(openModelButton, &QPushButton::clicked, this, &MainWindow::openSelectedModel);
+    connect(modelList, &QListWidget::itemDoubleClicked, this, &MainWindow::openSelectedModel);
+    connect(modelViewer, &ModelViewer::modelLoaded, this, &MainWindow::onModelLoaded);
 
     return page;
 }
@@ -870,9 +910,62 @@ QWidget *MainWindow::createSettingsPage()
     themeRow->addWidget(themeCombo);
     themeRow->addStretch();
     v->addLayout(themeRow);
+
+    // CPU budget shared by the pipeline and the background loaders (thread_budget.hpp)
+    QSettings settings("Voxel-Forge", "Voxel-Forge");
+    QHBoxLayout *threadsRow = new QHBoxLayout;
+    QLabel *threadsLabel = new QLabel("CPU threads:");
+    threadsLabel->setStyleSheet("color: #cfcfcf;");
+    threadsSpin = new QSpinBox;
+    threadsSpin->setRange(0, VoxelForge::ThreadBudget::available());
+    threadsSpin->setSpecialValueText(QString("All (%1)").arg(VoxelForge::ThreadBudget::available()));
+    threadsSpin->setValue(settings.value("performance/maxThreads", 0).toInt());
+    threadsSpin->setFixedWidth(180);
+    threadsSpin->setToolTip("Upper limit for every worker thread of Voxel Forge, keeps the machine responsive for other work");
+    numaPinCheck = new QCheckBox("Pin to NUMA nodes (after restart)");
+    numaPinCheck->setStyleSheet("color: #cfcfcf;");
+    numaPinCheck->setChecked(settings.value("performance/pinNumaNodes", false).toBool());
+
+    threadsRow->addWidget(threadsLabel);
+    threadsRow->addWidget(threadsSpin);
+    threadsRow->addWidget(numaPinCheck);
+    threadsRow->addStretch();
+    v->addLayout(threadsRow);
+
+    // densify (OpenMVS) quality / speed trade-off, read when a dense run starts
+    QHBoxLayout *denseRow = new QHBoxLayout;
+    QLabel *denseLevelLabel = new QLabel("Dense resolution level:");
+    denseLevelLabel->setStyleSheet("color: #cfcfcf;");
+    QSpinBox *denseLevelSpin = new QSpinBox;
+    denseLevelSpin->setRange(0, 4);
+    denseLevelSpin->setValue(settings.value("dense/resolutionLevel", 1).toInt());
+    denseLevelSpin->setFixedWidth(80);
+    denseLevelSpin->setToolTip("Images are scaled down 2^level times for the depth maps: 0 = full resolution (slowest, most RAM)");
+    QLabel *denseViewsLabel = new QLabel("Neighbour views:");
+    denseViewsLabel->setStyleSheet("color: #cfcfcf;");
+    QSpinBox *denseViewsSpin = new QSpinBox;
+    denseViewsSpin->setRange(0, 32);
+    denseViewsSpin->setSpecialValueText("All");
+    denseViewsSpin->setValue(settings.value("dense/numViews", 8).toInt());
+    denseViewsSpin->setFixedWidth(80);
+    denseViewsSpin->setToolTip("Views matched against each image for its depth map");
+
+    denseRow->addWidget(denseLevelLabel);
+    denseRow->addWidget(denseLevelSpin);
+    denseRow->addWidget(denseViewsLabel);
+    denseRow->addWidget(denseViewsSpin);
+    denseRow->addStretch();
+    v->addLayout(denseRow);
     v->addStretch();
 
     connect(themeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::setTheme);
+    connect(threadsSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, &MainWindow::setThreadLimit);
+    connect(numaPinCheck, &QCheckBox::toggled, this, [](bool pin)
+            { QSettings("Voxel-Forge", "Voxel-Forge").setValue("performance/pinNumaNodes", pin); });
+    connect(denseLevelSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, [](int level)
+            { QSettings("Voxel-Forge", "Voxel-Forge").setValue("dense/resolutionLevel", level); });
+    connect(denseViewsSpin, QOverload<int>::of(&QSpinBox::valueChanged), this, [](int views)
+            { QSettings("Voxel-Forge", "Voxel-Forge").setValue("dense/numViews", views); });
 
     return w;
 }
@@ -953,6 +1046,17 @@ void MainWindow::changePage(int index)
     stackedContent->setCurrentIndex(index);
 }
 
+void MainWindow::setThreadLimit(int maxThreads)
+{
+    QSettings("Voxel-Forge", "Voxel-Forge").setValue("performance/maxThreads", maxThreads);
+
+    // pinning is only applied at startup (main.cpp)
+    VoxelForge::ThreadBudgetOptions budget;
+    budget.maxThreads = maxThreads;
+    VoxelForge::ThreadBudget::configure(budget);
+    thumbnailLoader->setThreadCount(VoxelForge::ThreadBudget::share(2));
+}
+
 void MainWindow::setTheme(int index)
 {
     if (index == 0)
@@ -981,36 +1085,62 @@ void MainWindow::addImages()
     if (files.isEmpty())
         return;
 
-    QString savePath = currentProjectFolder;
-
-    QDir dir(savePath);
-    if (!dir.exists())
-        dir.mkpath(".");
+    if (fileJob)
+    {
+        QMessageBox::information(this, "Busy", "Another copy is still running, please wait for it to finish.");
+        return;
+    }
 
+    // only files Qt can decode as images (checked from their header, nothing is decoded yet)
+    QStringList images;
     for (const QString &f : files)
     {
-        QFileInfo fi(f);
-        QPixmap pm(f);
-        if (pm.isNull())
-            continue;
+        if (QImageReader(f).canRead())
+            images << f;
+    }
+    const int notImages = files.size() - images.size();
+    if (images.isEmpty())
+    {
+        QMessageBox::information(this, "Add Images", "None of the selected files is a readable image.");
+        return;
+    }
+
+    // images already in the project are left alone; linked/cloned when possible
+    FileImportJob::Options options;
+    options.conflictPolicy = FileImportJob::SkipExisting;
+    FileImportJob *job = new FileImportJob(images, currentProjectFolder, options, this);
 
-        QString dest = dir.filePath(fi.fileName());
-        QFile::copy(f, dest);
+    // thumbnails show up as each file lands, not after the whole batch
+    connect(job, &FileImportJob::fileImported, imageModel, &ImageListModel::addImage);
+    connect(job, &FileImportJob::finished, this, [this, notImages](int imported, int skipped, int failed, bool cancelled)
+    {
+        if (failed > 0 || cancelled || notImages > 0)
+        {
+            QString msg = QString("Imported %1 image(s), %2 already present.").arg(imported).arg(skipped);
+            if (notImages > 0)
+                msg += QString("\n\nSkipped %1 file(s) that are not readable images.").arg(notImages);
+            if (failed > 0)
+                msg += QString("\n\nFailed to import %1 file(s), see the log for details.").arg(failed);
+            if (cancelled)
+                msg += "\n\nImport was cancelled.";
+            QMessageBox::information(this, "Add Images", msg);
+        }
+    });
 
-        QPixmap scaled = pm.scaled(320, 240, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    runFileJob(job, "Importing images...");
+}
 
-        QListWidgetItem *item = new QListWidgetItem;
-        item->setIcon(QIcon(scaled));
-        item->setText(fi.fileName());
-        item->setToolTip(dest);            // show saved path on hover
-        item->setData(Qt::UserRole, dest); // store full path
-        imageList->addItem(item);          // <-- missing line before
-    }
+QStringList MainWindow::selectedImagePaths() const
+{
+    QStringList paths;
+    for (const QModelIndex &index : imageList->selectionModel()->selectedIndexes())
+        paths << index.data(ImageListModel::PathRole).toString();
+    return paths;
 }
 
 void MainWindow::saveSelectedImages()
 {
-    QList<QListWidgetItem *> selected = imageList->selectedItems();
+    QStringList selected = selectedImagePaths();
     if (selected.isEmpty())
     {
         QMessageBox::information(this, "No selection", "Please select one or more images from the list to save.");
@@ -1028,76 +1158,91 @@ void MainWindow::saveSelectedImages()
     if (dest.isEmpty())
         return;
 
-    int copied = 0;
-    QStringList failed;
-    for (QListWidgetItem *it : selected)
+    if (fileJob)
     {
-        QString src = it->data(Qt::UserRole).toString();
-        if (src.isEmpty())
-            continue;
-        QFileInfo fi(src);
-        QString dstPath = QDir(dest).filePath(fi.fileName());
-
-        // if exists, create unique name
-        int idx = 1;
-        QString base = fi.completeBaseName();
-        QString ext = fi.suffix();
-        while (QFile::exists(dstPath))
-        {
-            QString newName = QString("%1_%2.%3").arg(base).arg(idx).arg(ext);
-            dstPath = QDir(dest).filePath(newName);
-            idx++;
-        }
+        QMessageBox::information(this, "Busy", "Another copy is still running, please wait for it to finish.");
+        return;
+    }
+
+    // never overwrite what is already in the destination; real copies (or reflinks), a hardlink
+    // would tie the exported file to the project image
+    FileImportJob::Options options;
+    options.conflictPolicy = FileImportJob::RenameNew;
+    options.allowHardlinks = false;
+    FileImportJob *job = new FileImportJob(selected, dest, options, this);
 
-        if (QFile::copy(src, dstPath))
+    connect(job, &FileImportJob::finished, this, [this, dest](int imported, int, int failed, bool cancelled)
+    {
+        QString msg = QString("Copied %1 file(s) to:\n%2").arg(imported).arg(dest);
+        if (failed > 0)
         {
-            copied++;
+            msg += QString("\n\nFailed to copy %1 file(s).").arg(failed);
         }
-        else
+        if (cancelled)
         {
-            failed << src;
+            msg += "\n\nCopy was cancelled.";
         }
-    }
+        QMessageBox::information(this, "Save Complete", msg);
+    });
 
-    QString msg = QString("Copied %1 file(s) to:\n%2").arg(copied).arg(dest);
-    if (!failed.isEmpty())
+    runFileJob(job, "Saving images...");
+}
+
+void MainWindow::runFileJob(FileImportJob *job, const QString &title)
+{
+    fileJob = job;
+
+    // non-modal: the image list stays usable while files are copied
+    QProgressDialog *progress = new QProgressDialog(title, "Cancel", 0, 1000, this);
+    progress->setWindowModality(Qt::NonModal);
+    progress->setMinimumDuration(500);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+    progress->setValue(0);
+
+    connect(progress, &QProgressDialog::canceled, job, &FileImportJob::cancel);
+    connect(job, &FileImportJob::progress, progress, [progress, title](qint64 bytesDone, qint64 bytesTotal, int filesDone, int filesTotal)
     {
-        msg += QString("\n\nFailed to copy %1 file(s).").arg(failed.count());
-    }
-    QMessageBox::information(this, "Save Complete", msg);
+        progress->setValue(bytesTotal > 0 ? static_cast<int>(bytesDone * 1000 / bytesTotal) : 1000);
+        progress->setLabelText(QString("%1\n%2 of %3 file(s), %4 of %5 MB")
+                                   .arg(title)
+                                   .arg(filesDone)
+                                   .arg(filesTotal)
+                                   .arg(bytesDone / (1024 * 1024))
+                                   .arg(bytesTotal / (1024 * 1024)));
+    });
+    connect(job, &FileImportJob::fileFailed, this, [this](const QString &src, const QString &reason)
+    {
+        if (imageLogSink)
+            imageLogSink->post(QString("[copy] %1: %2").arg(src, reason));
+    });
+    connect(job, &FileImportJob::finished, this, [job, progress]()
+    {
+        progress->close();
+        progress->deleteLater();
+        job->deleteLater();
+    });
+
+    job->start();
 }
+
 void MainWindow::changeFolder(const QString &path)
 {
     // Update the current image folder
     currentImageFolder = path;
 
-    // Clear existing list
-    imageList->clear();
-
-    // Populate images from the new folder
+    // Populate images from the new folder (replaces the current list)
     QDir dir(path);
     QStringList filters = {"*.png", "*.jpg", "*.jpeg", "*.bmp", "*.tiff"};
-    QFileInfoList files = dir.entryInfoList(filters, QDir::Files);
-    for (const QFileInfo &fi : files)
-    {
-        QPixmap pm(fi.absoluteFilePath());
-        if (pm.isNull())
-            continue;
-
-        QPixmap scaled = pm.scaled(imageList->iconSize(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
-        QListWidgetItem *item = new QListWidgetItem;
-        item->setIcon(QIcon(scaled));
-        item->setText(fi.fileName());
-        item->setToolTip(fi.absoluteFilePath());
-        item->setData(Qt::UserRole, fi.absoluteFilePath());
-        imageList->addItem(item);
-    }
+    QStringList files;
+    for (const QFileInfo &fi : dir.entryInfoList(filters, QDir::Files))
+        files << fi.absoluteFilePath();
+    imageModel->setImages(files);
 }
 
 void MainWindow::deleteSelectedImages()
 {
-    QList<QListWidgetItem *> selected = imageList->selectedItems();
+    QStringList selected = selectedImagePaths();
     if (selected.isEmpty())
     {
         QMessageBox::information(this, "No selection", "Please select one or more images to delete.");
@@ -1111,14 +1256,12 @@ void MainWindow::deleteSelectedImages()
         return;
     }
 
-    for (QListWidgetItem *it : selected)
+    for (const QString &path : selected)
     {
-        QString path = it->data(Qt::UserRole).toString();
         if (!path.isEmpty() && QFile::exists(path))
             QFile::remove(path);
-
-        delete imageList->takeItem(imageList->row(it));
     }
+    imageModel->removeImages(selected);
 }
 
 void MainWindow::refreshImageList()
@@ -1130,9 +1273,11 @@ void MainWindow::refreshImageList()
     }
 
     // Clear current image list
-    imageList->clear();
+    imageModel->clear();
 
     // Clear preview
+    previewLoader->cancel();
+    previewPath.clear();
     if (imagePreviewLabel)
     {
         imagePreviewLabel->clear();
@@ -1144,28 +1289,40 @@ void MainWindow::refreshImageList()
     loadProjectImages();
 
     // Show confirmation message
-    int count = imageList->count();
+    int count = imageModel->rowCount();
     imageLogViewer->append(QString("<span style='color:#2ecc71;'>✓ Refreshed image list - Found %1 image(s)</span>").arg(count));
 }
 
-void MainWindow::onImageItemClicked(QListWidgetItem *item)
+void MainWindow::onImageClicked(const QModelIndex &index)
 {
-    if (!item || !imagePreviewLabel)
+    if (!index.isValid() || !imagePreviewLabel)
         return;
 
-    QString imagePath = item->data(Qt::UserRole).toString();
+    QString imagePath = index.data(ImageListModel::PathRole).toString();
     if (imagePath.isEmpty())
         return;
 
-    QPixmap pixmap(imagePath);
-    if (pixmap.isNull())
+    // Decoded off the GUI thread at label size; the previous preview stays
+    // up until this one is ready, and a newer click supersedes this one
+    previewPath = imagePath;
+    previewLoader->request(imagePath, imagePreviewLabel->size());
+
+    // warm up the neighbours so stepping through the list is instant
+    const int row = index.row();
+    previewLoader->prefetch({imageModel->pathAt(row + 1), imageModel->pathAt(row - 1)},
+                            imagePreviewLabel->size());
+}
+
+void MainWindow::onPreviewReady(const QString &imagePath, const QImage &image)
+{
+    if (imagePath != previewPath || image.isNull())
         return;
 
-    // Scale to fit preview label
-    QPixmap scaled = pixmap.scaled(imagePreviewLabel->size(),
-                                   Qt::KeepAspectRatio,
-                                   Qt::SmoothTransformation);
-    imagePreviewLabel->setPixmap(scaled);
+    QPixmap pixmap = QPixmap::fromImage(image);
+    // decoders only scale down in coarse steps, finish the fit here (cheap at this size)
+    if (pixmap.width() > imagePreviewLabel->width() || pixmap.height() > imagePreviewLabel->height())
+        pixmap = pixmap.scaled(imagePreviewLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    imagePreviewLabel->setPixmap(pixmap);
 }
 
 void MainWindow::addVideo()
@@ -1198,6 +1355,9 @@ void MainWindow::addVideo()
         return;
     }
 
+    imageLogSink->startRunLog(projectFullPath + "/output/logs/video_" +
+                              QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") + ".log");
+
     // Start extraction on worker thread
     QMetaObject::invokeMethod(videoExtractor, "extractFrames",
                               Qt::QueuedConnection,
@@ -1277,7 +1437,7 @@ void MainWindow::updateProjectDisplay()
             "}");
 
         // Clear image list when no project
-        imageList->clear();
+        imageModel->clear();
     }
     else
     {
@@ -1304,7 +1464,7 @@ void MainWindow::loadProjectImages()
         return;
 
     // Clear existing images
-    imageList->clear();
+    imageModel->clear();
     imageLogViewer->clear();
 
     QString imagePath = projectFullPath + "/images";
@@ -1328,30 +1488,15 @@ void MainWindow::loadProjectImages()
 
     imageLogViewer->append(QString("Loading %1 images from project...").arg(imageFiles.count()));
 
-    int loadedCount = 0;
+    // Rows are listed right away, thumbnails are decoded in the background
+    // as they scroll into view
+    QStringList paths;
+    paths.reserve(imageFiles.size());
     for (const QFileInfo &fileInfo : imageFiles)
-    {
-        QString filePath = fileInfo.absoluteFilePath();
-        QPixmap pm(filePath);
-
-        if (pm.isNull())
-            continue;
-
-        // Create thumbnail
-        QPixmap scaled = pm.scaled(320, 240, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        paths << fileInfo.absoluteFilePath();
+    imageModel->setImages(paths);
 
-        // Add to image list
-        QListWidgetItem *item = new QListWidgetItem;
-        item->setIcon(QIcon(scaled));
-        item->setText(fileInfo.fileName());
-        item->setToolTip(filePath);
-        item->setData(Qt::UserRole, filePath);
-        imageList->addItem(item);
-
-        loadedCount++;
-    }
-
-    imageLogViewer->append(QString("Successfully loaded %1 images.").arg(loadedCount));
+    imageLogViewer->append(QString("Listed %1 images, thumbnails are loading in the background.").arg(imageFiles.count()));
 }
 
 void MainWindow::runSparseReconstruction()
@@ -1372,17 +1517,8 @@ void MainWindow::runSparseReconstruction()
         return;
     }
 
-    pipelineLogViewer->clear();
-    pipelineLogViewer->append("=== Starting Sparse Reconstruction Pipeline ===");
-
-    sparseReconButton->setEnabled(false);
-    denseReconButton->setEnabled(false);
-    cancelPipelineButton->setEnabled(true);
-
-    // Start pipeline on worker thread
-    QMetaObject::invokeMethod(photoController, "startPipeline",
-                              Qt::QueuedConnection,
-                              Q_ARG(QString, projectFullPath));
+    // sparse cloud plus the OpenMVS scene for the dense step
+    startPipelineRun("=== Starting Sparse Reconstruction Pipeline ===", VoxelForge::Stage::ExportToMVS);
 }
 
 void MainWindow::runDenseReconstruction()
@@ -1396,27 +1532,55 @@ void MainWindow::runDenseReconstruction()
     // Check if sparse reconstruction exists
     QString reconPath = projectFullPath + "/output/reconstruction";
     QDir reconDir(reconPath);
-    if (!reconDir.exists())
+    if (!reconDir.exists("sfm_data.bin"))
     {
         QMessageBox::warning(this, "No Sparse Data",
                              "Please run Sparse Reconstruction first!");
         return;
     }
 
+    // densify options of the Settings page; the worker is idle, the buttons are disabled while it runs
+    QSettings settings("Voxel-Forge", "Voxel-Forge");
+    VoxelForge::PipelineConfig config = photoController->pipelineSettings();
+    config.densifyResolutionLevel = settings.value("dense/resolutionLevel", config.densifyResolutionLevel).toUInt();
+    config.densifyNumViews = settings.value("dense/numViews", config.densifyNumViews).toUInt();
+    photoController->setSettings(config);
+
+    // dense cloud, mesh and texture into final_3d_models; the stages already up to date are skipped
+    startPipelineRun("=== Starting Dense Reconstruction Pipeline ===", VoxelForge::Stage::MeshLod);
+}
+
+void MainWindow::startPipelineRun(const QString &title, VoxelForge::Stage lastStage)
+{
     pipelineLogViewer->clear();
-    pipelineLogViewer->append("=== Starting Dense Reconstruction Pipeline ===");
-    pipelineLogViewer->append("Dense reconstruction will be implemented...");
+    pipelineLogViewer->append(title);
+
+    // full log of this run (the view only keeps the most recent lines)
+    const QString runLog = projectFullPath + "/output/logs/pipeline_" +
+                           QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") + ".log";
+    if (pipelineLogSink->startRunLog(runLog))
+        pipelineLogViewer->append("Full log: " + runLog);
+
+    sparseReconButton->setEnabled(false);
+    denseReconButton->setEnabled(false);
+    cancelPipelineButton->setEnabled(true);
+    pipelineStageIndex = 0;
+    pipelineProgressBar->setValue(0);
+    pipelineProgressLabel->setText("Starting...");
 
-    // TODO: Implement dense reconstruction
-    QMessageBox::information(this, "Coming Soon",
-                             "Dense reconstruction pipeline will be implemented soon!");
+    // Start pipeline on worker thread
+    QMetaObject::invokeMethod(photoController, "startPipeline",
+                              Qt::QueuedConnection,
+                              Q_ARG(QString, projectFullPath),
+                              Q_ARG(int, static_cast<int>(lastStage)));
 }
 
 void MainWindow::cancelPipeline()
 {
     if (photoController)
     {
-        QMetaObject::invokeMethod(photoController, "cancelPipeline", Qt::QueuedConnection);
+        // direct: the worker thread is blocked inside startPipeline, a queued call would wait for the whole run
+        photoController->cancelPipeline();
     }
 }
 
@@ -1428,32 +1592,26 @@ void MainWindow::setupVideoExtractorThread()
 
     // Use QPointer for safe cross-thread widget access
     QPointer<QTextEdit> safeImageLogViewer(imageLogViewer);
-    QPointer<QListWidget> safeImageList(imageList);
     QPointer<QPushButton> safeAddVideoButton(addVideoButton);
     QPointer<QPushButton> safeCancelVideoButton(cancelVideoButton);
 
-    // Connect signals with Qt::QueuedConnection for thread safety
-    connect(videoExtractor, &VideoFrameExtractor::logMessage, this, [safeImageLogViewer](const QString &msg)
-            {
-                if (safeImageLogViewer) safeImageLogViewer->append(msg); }, Qt::QueuedConnection);
+    // Log lines go through the throttled sink: post() takes no lock (it only waits
+    // when the run log writer is a full ring behind), so it is called directly on
+    // the worker thread instead of queueing one GUI event per line
+    imageLogSink = new LogSink(imageLogViewer, this);
+    connect(videoExtractor, &VideoFrameExtractor::logMessage, imageLogSink, &LogSink::post, Qt::DirectConnection);
 
-    connect(videoExtractor, &VideoFrameExtractor::frameExtracted, this, [safeImageList](const QString &fileName, const QString &fullPath)
-            {
-                if (!safeImageList) return;
-                QPixmap pm(fullPath);
-                if (pm.isNull()) return;
-                QPixmap scaled = pm.scaled(320, 240, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-                QListWidgetItem *item = new QListWidgetItem;
-                item->setIcon(QIcon(scaled));
-                item->setText(fileName);
-                item->setToolTip(fullPath);
-                item->setData(Qt::UserRole, fullPath);
-                safeImageList->addItem(item); }, Qt::QueuedConnection);
-
-    connect(videoExtractor, &VideoFrameExtractor::extractionFinished, this, [safeAddVideoButton, safeCancelVideoButton, safeImageLogViewer](bool success)
+    // Other signals with Qt::QueuedConnection for thread safety
+
+    connect(videoExtractor, &VideoFrameExtractor::frameExtracted, this, [this](const QString &, const QString &fullPath)
+            { imageModel->addImage(fullPath); }, Qt::QueuedConnection);
+
+    connect(videoExtractor, &VideoFrameExtractor::extractionFinished, this, [this, safeAddVideoButton, safeCancelVideoButton, safeImageLogViewer](bool success)
             {
                 if (safeAddVideoButton) safeAddVideoButton->setEnabled(true);
                 if (safeCancelVideoButton) safeCancelVideoButton->setEnabled(false);
+                imageLogSink->flush();
+                imageLogSink->stopRunLog();
                 if (safeImageLogViewer) {
                     safeImageLogViewer->append(success ? 
                         "Video extraction completed!" : 
@@ -1469,18 +1627,50 @@ void MainWindow::setupPipelineThread()
     photoController = new PhotogrammetryController;
     photoController->moveToThread(pipelineWorkerThread);
 
-    // Connect signals
+    // Connect signals (log lines through the throttled sink, see setupVideoExtractorThread)
+    pipelineLogSink = new LogSink(pipelineLogViewer, this);
     connect(photoController, &PhotogrammetryController::logMessage,
-            pipelineLogViewer, &QTextEdit::append, Qt::QueuedConnection);
+            pipelineLogSink, &LogSink::post, Qt::DirectConnection);
+
+    connect(photoController, &PhotogrammetryController::stageStarted, this, [this](int stage, int index, int count)
+            {
+                pipelineStageIndex = index;
+                pipelineStageCount = count > 0 ? count : 1;
+                pipelineProgressBar->setValue((index - 1) * 1000 / pipelineStageCount);
+                pipelineProgressLabel->setText(QString("%1/%2 %3")
+                    .arg(index).arg(count)
+                    .arg(PhotogrammetryController::stageName(static_cast<PhotogrammetryController::PipelineStage>(stage)))); }, Qt::QueuedConnection);
+
+    // at most ~10 per second (CallbackProgress throttles)
+    connect(photoController, &PhotogrammetryController::stageProgress, this, [this](int stage, double fraction, const QString &step)
+            {
+                if (pipelineStageIndex < 1)
+                    return;
+                pipelineProgressBar->setValue(static_cast<int>(((pipelineStageIndex - 1) + fraction) * 1000.0 / pipelineStageCount));
+                QString text = QString("%1/%2 %3")
+                    .arg(pipelineStageIndex).arg(pipelineStageCount)
+                    .arg(PhotogrammetryController::stageName(static_cast<PhotogrammetryController::PipelineStage>(stage)));
+                if (!step.isEmpty())
+                    text += " " + step;
+                pipelineProgressLabel->setText(text + QString(" %1%").arg(static_cast<int>(fraction * 100.0))); }, Qt::QueuedConnection);
 
     connect(photoController, &PhotogrammetryController::pipelineFinished, this, [this](bool success)
             {
                 sparseReconButton->setEnabled(true);
                 denseReconButton->setEnabled(true);
                 cancelPipelineButton->setEnabled(false);
+                if (success)
+                    pipelineProgressBar->setValue(1000);
+                pipelineProgressLabel->setText(success ? "Done" : "Stopped");
+                pipelineStageIndex = 0;
+                pipelineLogSink->flush();
+                pipelineLogSink->stopRunLog();
                 pipelineLogViewer->append(success ? 
                     "\n=== Pipeline completed successfully! ===" : 
-                    "\n=== Pipeline failed or was cancelled ==="); }, Qt::QueuedConnection);
+                    "\n=== Pipeline failed or was cancelled ===");
+                // a dense run may have written a model to final_3d_models
+                if (success)
+                    load3DModels(); }, Qt::QueuedConnection);
 
     pipelineWorkerThread->start();
 }
@@ -1510,33 +1700,39 @@ void MainWindow::load3DModels()
     QString modelsPath = projectFullPath + "/final_3d_models";
     QDir modelsDir(modelsPath);
     
-    if (!modelsDir.exists())
-    {
-        QListWidgetItem *item = new QListWidgetItem("No 'final_3d_models' folder found in project");
-        item->setFlags(item->flags() & ~Qt::ItemIsEnabled);
-        modelList->addItem(item);
-        return;
-    }
-    
     // Supported 3D model formats
     QStringList filters = {"*.obj", "*.ply", "*.stl", "*.fbx", "*.dae", "*.3ds", "*.gltf", "*.glb"};
-    QFileInfoList modelFiles = modelsDir.entryInfoList(filters, QDir::Files, QDir::Name);
+    QFileInfoList modelFiles = modelsDir.exists() ? modelsDir.entryInfoList(filters, QDir::Files, QDir::Name) : QFileInfoList();
     
-    if (modelFiles.isEmpty())
+    for (const QFileInfo &fileInfo : modelFiles)
     {
-        QListWidgetItem *item = new QListWidgetItem("No 3D models found in 'final_3d_models' folder");
-        item->setFlags(item->flags() & ~Qt::ItemIsEnabled);
+        QListWidgetItem *item = new QListWidgetItem(fileInfo.fileName());
+        item->setData(Qt::UserRole, fileInfo.absoluteFilePath());
+        item->setToolTip(fileInfo.absoluteFilePath());
         modelList->addItem(item);
-        return;
     }
-    
-    for (const QFileInfo &fileInfo : modelFiles)
+
+    // the point clouds of the pipeline, streamed from their LOD folders when present
+    const VoxelForge::PipelinePaths paths(projectFullPath.toStdString());
+    const std::pair<QString, std::string> clouds[] = {{"Sparse point cloud", paths.sparsePly}, {"Dense point cloud", paths.densePly}};
+    for (const auto &cloud : clouds)
     {
-        QListWidgetItem *item = new QListWidgetItem(fileInfo.fileName());
+        const QFileInfo fileInfo(QString::fromStdString(cloud.second));
+        if (!fileInfo.exists())
+            continue;
+        QListWidgetItem *item = new QListWidgetItem(cloud.first + " (" + fileInfo.fileName() + ")");
         item->setData(Qt::UserRole, fileInfo.absoluteFilePath());
         item->setToolTip(fileInfo.absoluteFilePath());
         modelList->addItem(item);
     }
+    
+    if (modelList->count() == 0)
+    {
+        QListWidgetItem *item = new QListWidgetItem(modelsDir.exists() ? "No 3D models found in 'final_3d_models' folder"
+                                                                       : "No 'final_3d_models' folder found in project");
+        item->setFlags(item->flags() & ~Qt::ItemIsEnabled);
+        modelList->addItem(item);
+    }
 }
 
 void MainWindow::onModelItemClicked(QListWidgetItem *item)
@@ -1557,7 +1753,7 @@ void MainWindow::onModelItemClicked(QListWidgetItem *item)
 
 void MainWindow::openSelectedModel()
 {
-    if (!modelList || !modelViewerLabel)
+    if (!modelList || !modelViewer)
         return;
     
     QListWidgetItem *item = modelList->currentItem();
@@ -1575,38 +1771,31 @@ void MainWindow::openSelectedModel()
         return;
     }
     
-    // For now, show model info in the label
-    // In a full implementation, you would use Qt3D or another 3D rendering library
-    QString modelInfo = QString(
-        "Model Loaded:\n\n"
-        "Name: %1\n"
-        "Path: %2\n"
-        "Size: %3 KB\n\n"
-        "Note: Full 3D rendering will be implemented using Qt3D.\n"
-        "For now, you can open this model in external viewers."
-    ).arg(fileInfo.fileName())
-     .arg(modelPath)
-     .arg(fileInfo.size() / 1024);
-    
-    modelViewerLabel->setText(modelInfo);
-    modelViewerLabel->setStyleSheet(
-        "QLabel { "
-        "color: #ffffff; "
-        "font-size: 13px; "
-        "background: transparent; "
-        "border: none; "
-        "}");
+    // the viewer reads OBJ and PLY, other formats go to an external viewer
+    const QString suffix = fileInfo.suffix().toLower();
+    if (suffix != "obj" && suffix != "ply")
+    {
+        onModelLoaded(modelPath, false, QString("The built-in viewer does not read .%1 files.").arg(suffix));
+        return;
+    }
+    modelViewer->openModel(modelPath);
+}
+
+void MainWindow::onModelLoaded(const QString &path, bool ok, const QString &error)
+{
+    if (ok)
+        return;
     
-    // Optional: Launch external viewer
     QMessageBox::StandardButton reply = QMessageBox::question(
         this, 
         "Open in External Viewer?",
-        "Would you like to open this model in an external 3D viewer?",
+        QString("%1 cannot be displayed here:\n%2\n\nWould you like to open it in an external 3D viewer?")
+            .arg(QFileInfo(path).fileName(), error),
         QMessageBox::Yes | QMessageBox::No
     );
     
     if (reply == QMessageBox::Yes)
     {
-        QDesktopServices::openUrl(QUrl::fromLocalFile(modelPath));
+        QDesktopServices::openUrl(QUrl::fromLocalFile(path));
     }
 }
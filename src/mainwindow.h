@@ -7,19 +7,36 @@
 #include <QDir>
 #include <QThread>
 #include <QPointer>
+#include <QModelIndex>
+#include <QStringList>
+#include <QImage>
 
 // Forward declarations for Qt classes
 class QListWidget;
+class QListView;
 class QStackedWidget;
 class QPushButton;
 class QComboBox;
 class QListWidgetItem;
 class QTextEdit;
 class QLabel;
+class QProgressBar;
+class QSpinBox;
+class QCheckBox;
 
 // Forward declarations for backend classes
 class VideoFrameExtractor;
 class PhotogrammetryController;
+class ThumbnailLoader;
+class ImageListModel;
+class LogSink;
+class PreviewLoader;
+class FileImportJob;
+class ModelViewer;
+namespace VoxelForge
+{
+    enum class Stage;
+}
 
 static const QString defaultProjectPath = QDir::homePath() + "/Voxel-Forge/";
 
@@ -39,6 +56,7 @@ private slots:
     // Buttons / UI
     void changePage(int index);
     void setTheme(int index);
+    void setThreadLimit(int maxThreads);
 
     // Image manager
     void addImages();
@@ -48,7 +66,8 @@ private slots:
     void refreshImageList();
     void createNewFolder();
     void changeFolder(const QString &folderName);
-    void onImageItemClicked(QListWidgetItem *item);
+    void onImageClicked(const QModelIndex &index);
+    void onPreviewReady(const QString &imagePath, const QImage &image);
     
     // Pipeline controls
     void runSparseReconstruction();
@@ -66,6 +85,7 @@ private slots:
     void load3DModels();
     void onModelItemClicked(QListWidgetItem *item);
     void openSelectedModel();
+    void onModelLoaded(const QString &path, bool ok, const QString &error);
     void goTo3DModelsPage();
 
 private:
@@ -77,13 +97,18 @@ private:
     QWidget* createSettingsPage();
     void setupVideoExtractorThread();
     void setupPipelineThread();
+    QStringList selectedImagePaths() const;
+    void runFileJob(FileImportJob *job, const QString &title);
+    // runs the pipeline up to lastStage on the worker thread
+    void startPipelineRun(const QString &title, VoxelForge::Stage lastStage);
 
     // UI members
     QListWidget *sidebar = nullptr;
     QStackedWidget *stackedContent = nullptr;
 
     // Image manager widgets
-    QListWidget *imageList = nullptr;
+    QListView *imageList = nullptr;
+    ImageListModel *imageModel = nullptr;
     QPushButton *addImageButton = nullptr;
     QPushButton *addVideoButton = nullptr;
     QPushButton *cancelVideoButton = nullptr;
@@ -92,6 +117,7 @@ private:
     QPushButton *refreshImagesButton = nullptr;
     QLabel *imagePreviewLabel = nullptr;
     QTextEdit *imageLogViewer = nullptr;
+    LogSink *imageLogSink = nullptr;
     
     // Project manager widgets
     QPushButton *selectProjectButton = nullptr;
@@ -102,16 +128,25 @@ private:
     QPushButton *cancelPipelineButton = nullptr;
     QLabel *currentProjectLabel = nullptr;
     QTextEdit *pipelineLogViewer = nullptr;
+    LogSink *pipelineLogSink = nullptr;
+    QProgressBar *pipelineProgressBar = nullptr; // whole run, 0..1000
+    QLabel *pipelineProgressLabel = nullptr;     // stage and OpenMVG step
+    int pipelineStageIndex = 0;                  // 1-based, from stageStarted
+    int pipelineStageCount = 1;
     
     // 3D Models page widgets
     QListWidget *modelList = nullptr;
     QPushButton *openModelButton = nullptr;
     QWidget *modelViewerWidget = nullptr;
-    QLabel *modelViewerLabel = nullptr;
+    ModelViewer *modelViewer = nullptr;
 
     // theme
     QComboBox *themeCombo = nullptr;
 
+    // CPU budget (0 = all cores), stored in QSettings
+    QSpinBox *threadsSpin = nullptr;
+    QCheckBox *numaPinCheck = nullptr;
+
     // state
     QString currentProjectFolder = defaultProjectPath;
     QString currentProjectName;
@@ -124,6 +159,16 @@ private:
     
     QThread *pipelineWorkerThread = nullptr;
     PhotogrammetryController *photoController = nullptr;
+
+    // Thumbnail service feeding imageModel
+    ThumbnailLoader *thumbnailLoader = nullptr;
+
+    // Async preview decoding; previewPath is the image the label should show
+    PreviewLoader *previewLoader = nullptr;
+    QString previewPath;
+
+    // Add / save copies run in the background, one batch at a time
+    QPointer<FileImportJob> fileJob;
 };
 
 #endif // MAINWINDOW_H
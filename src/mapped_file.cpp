@@ -0,0 +1,99 @@
+#include "mapped_file.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VoxelForge
+{
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    void MappedFile::close()
+    {
+#ifdef _WIN32
+        if (bytes)
+            UnmapViewOfFile(bytes);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file)
+            CloseHandle(file);
+        file = mapping = nullptr;
+#else
+        if (bytes)
+            munmap(const_cast<char *>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+
+    bool MappedFile::open(const std::string &path, std::string *error)
+    {
+        close();
+        auto fail = [&](const char *what)
+        {
+            if (error)
+                *error = std::string(what) + " " + path;
+            close();
+            return false;
+        };
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            file = nullptr;
+            return fail("cannot open");
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size))
+            return fail("cannot read the size of");
+        length = static_cast<size_t>(size.QuadPart);
+        if (length == 0)
+            return true;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+            return fail("cannot map");
+        bytes = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        if (!bytes)
+            return fail("cannot map");
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return fail("cannot open");
+        struct stat info;
+        if (fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            return fail("cannot read the size of");
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length > 0)
+        {
+            void *view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view != MAP_FAILED)
+            {
+                bytes = static_cast<const char *>(view);
+                // read ahead: the whole file is parsed right away
+                madvise(view, length, MADV_WILLNEED);
+            }
+        }
+        ::close(fd);
+        if (length > 0 && !bytes)
+        {
+            length = 0;
+            return fail("cannot map");
+        }
+#endif
+        return true;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// Read-only memory mapping of a whole file, for loaders that parse large
+// files in parallel chunks without copying them through read buffers.
+
+#include <cstddef>
+#include <string>
+
+namespace VoxelForge
+{
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        bool open(const std::string &path, std::string *error = nullptr);
+        void close();
+
+        // nullptr for an empty file
+        const char *data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        const char *bytes = nullptr;
+        size_t length = 0;
+#ifdef _WIN32
+        void *file = nullptr;
+        void *mapping = nullptr;
+#endif
+    };
+}
@@ -0,0 +1,100 @@
+#include "openmvg_wrappers.hpp"
+#include "telemetry.hpp"
+
+// View graph statistics, adjacency matrix SVG and graphviz export of a matches file.
+// Split from ComputeMatches / GeometricFilter so the pipeline can run it next to the following stage.
+
+#include "openMVG/graph/graph.hpp"
+#include "openMVG/graph/graph_stats.hpp"
+#include "openMVG/matching/indMatch.hpp"
+#include "openMVG/matching/indMatch_utils.hpp"
+#include "openMVG/matching/pairwiseAdjacencyDisplay.hpp" // defines PairWiseMatchingToAdjacencyMatrixSVG, include it in this file only
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/stl/stl.hpp"
+#include "openMVG/system/logger.hpp"
+
+#include "openMVG/third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <set>
+#include <string>
+
+using namespace openMVG;
+using namespace openMVG::matching;
+using namespace openMVG::sfm;
+
+namespace OpenMVG_Wrappers
+{
+    bool RunExportMatchesReports(
+        std::string sSfM_Data_Filename,
+        std::string sMatchesFilename,
+        std::string sReportName,
+        LogCallback logCallback)
+    {
+        // Helper for logging to both console and GUI
+        auto LOG = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_INFO << msg;
+            if (logCallback)
+                logCallback(msg);
+        };
+
+        auto LOG_ERROR = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_ERROR << msg;
+            if (logCallback)
+                logCallback("ERROR: " + msg);
+        };
+
+        VoxelForge::TelemetryScope telemetry(sReportName + "MatchesReport");
+
+        if (sReportName.empty())
+        {
+            LOG_ERROR("No report name set.");
+            return false;
+        }
+
+        SfM_Data sfm_data;
+        if (!Load(sfm_data, sSfM_Data_Filename, ESfM_Data(VIEWS)))
+        {
+            LOG_ERROR("The input SfM_Data file \"" + sSfM_Data_Filename + "\" cannot be read.");
+            return false;
+        }
+
+        PairWiseMatches map_Matches;
+        if (!Load(map_Matches, sMatchesFilename))
+        {
+            LOG_ERROR("Cannot load the matches file: " + sMatchesFilename);
+            return false;
+        }
+
+        const std::string sMatchesDirectory = stlplus::folder_part(sMatchesFilename);
+        std::string sLowerName = sReportName;
+        std::transform(sLowerName.begin(), sLowerName.end(), sLowerName.begin(), ::tolower);
+
+        // -- export View Graph statistics
+        graph::getGraphStatistics(sfm_data.GetViews().size(), getPairs(map_Matches));
+
+        //-- export matches Adjacency matrix
+        PairWiseMatchingToAdjacencyMatrixSVG(sfm_data.GetViews().size(),
+                                             map_Matches,
+                                             stlplus::create_filespec(sMatchesDirectory, sReportName + "AdjacencyMatrix", "svg"));
+
+        //-- export view pair graph
+        {
+            std::set<IndexT> set_ViewIds;
+            std::transform(sfm_data.GetViews().begin(), sfm_data.GetViews().end(), std::inserter(set_ViewIds, set_ViewIds.begin()), stl::RetrieveKey());
+            graph::indexedGraph matchesGraph(set_ViewIds, getPairs(map_Matches));
+            graph::exportToGraphvizData(
+                stlplus::create_filespec(sMatchesDirectory, sLowerName + "_matches"),
+                matchesGraph);
+        }
+
+        LOG(sReportName + " matches reports written to " + sMatchesDirectory);
+        telemetry.count("pairs", static_cast<double>(map_Matches.size()));
+        telemetry.succeed();
+        return true;
+    }
+}
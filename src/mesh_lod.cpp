@@ -0,0 +1,318 @@
+#include "mesh_lod.hpp"
+#include "mesh_simplify.hpp"
+#include "model_io.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <numeric>
+
+namespace fs = std::filesystem;
+
+namespace VoxelForge
+{
+    namespace
+    {
+        // atlas texels repeated around each part, so filtering and mip levels do not bleed in the neighbours
+        constexpr int Padding = 2;
+        // the white block of materials without a texture
+        constexpr int BlankSize = 4;
+
+        bool fail(std::string *error, const std::string &message)
+        {
+            if (error)
+                *error = message;
+            return false;
+        }
+
+        // the texels of one material a level uses, and where they go in the atlas
+        struct AtlasPart
+        {
+            int material = -1;   // -1: the white block
+            cv::Rect crop;       // in the source texture
+            cv::Size scaled;     // crop size in the atlas, without padding
+            cv::Point at;        // top left in the atlas, padding included
+        };
+
+        // shelves of decreasing height, width limited to width; returns the atlas size
+        cv::Size packShelves(std::vector<AtlasPart> &parts, const std::vector<size_t> &order, int width)
+        {
+            int x = 0, y = 0, shelf = 0, used = 0;
+            for (const size_t i : order)
+            {
+                AtlasPart &part = parts[i];
+                const int w = part.scaled.width + 2 * Padding, h = part.scaled.height + 2 * Padding;
+                if (x > 0 && x + w > width)
+                {
+                    y += shelf;
+                    x = shelf = 0;
+                }
+                part.at = cv::Point(x, y);
+                x += w;
+                shelf = std::max(shelf, h);
+                used = std::max(used, x);
+            }
+            return cv::Size(used, y + shelf);
+        }
+
+        // the squarest of a few shelf widths around the square root of the area
+        cv::Size pack(std::vector<AtlasPart> &parts)
+        {
+            std::vector<size_t> order(parts.size());
+            std::iota(order.begin(), order.end(), size_t(0));
+            std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                      { return parts[a].scaled.height > parts[b].scaled.height; });
+            double area = 0;
+            for (const AtlasPart &part : parts)
+                area += double(part.scaled.width + 2 * Padding) * (part.scaled.height + 2 * Padding);
+            int bestWidth = 0;
+            cv::Size best;
+            for (const double factor : {1.0, 1.1, 1.25, 1.5, 2.0, 3.0})
+            {
+                const int width = static_cast<int>(std::ceil(std::sqrt(area) * factor));
+                const cv::Size size = packShelves(parts, order, width);
+                if (bestWidth == 0 || std::max(size.width, size.height) < std::max(best.width, best.height))
+                {
+                    bestWidth = width;
+                    best = size;
+                }
+            }
+            return packShelves(parts, order, bestWidth);
+        }
+
+        float clamped(float value)
+        {
+            return std::min(1.f, std::max(0.f, value));
+        }
+
+        // Atlas of a level from the source textures at scale (less when it would exceed maxTexture):
+        // texcoords gets the corners of the model in it. side = largest atlas side
+        bool buildAtlas(const MeshModel &model, const std::vector<cv::Mat> &sources, double scale, const MeshLodOptions &options,
+                        std::vector<float> &texcoords, GltfImage &image, uint32_t &side, std::string *error)
+        {
+            const size_t faceCount = model.faceCount();
+            auto materialOf = [&](size_t face)
+            { return model.faceMaterials.empty() ? 0 : int(model.faceMaterials[face]); };
+
+            // used rect of each textured material, in texture coordinates
+            std::vector<float> bounds(sources.size() * 4);
+            for (size_t m = 0; m < sources.size(); ++m)
+            {
+                bounds[m * 4] = bounds[m * 4 + 1] = 1.f;
+                bounds[m * 4 + 2] = bounds[m * 4 + 3] = 0.f;
+            }
+            bool blank = false;
+            for (size_t f = 0; f < faceCount; ++f)
+            {
+                const int m = materialOf(f);
+                if (m >= int(sources.size()) || sources[m].empty())
+                {
+                    blank = true;
+                    continue;
+                }
+                for (int k = 0; k < 3; ++k)
+                {
+                    const float u = clamped(model.texcoords[f * 6 + k * 2]), v = clamped(model.texcoords[f * 6 + k * 2 + 1]);
+                    bounds[m * 4] = std::min(bounds[m * 4], u);
+                    bounds[m * 4 + 1] = std::min(bounds[m * 4 + 1], v);
+                    bounds[m * 4 + 2] = std::max(bounds[m * 4 + 2], u);
+                    bounds[m * 4 + 3] = std::max(bounds[m * 4 + 3], v);
+                }
+            }
+
+            std::vector<AtlasPart> parts;
+            std::vector<int> partOf(sources.size() + 1, -1); // last: the white block
+            for (size_t m = 0; m < sources.size(); ++m)
+            {
+                if (bounds[m * 4] > bounds[m * 4 + 2])
+                    continue;
+                const cv::Mat &texture = sources[m];
+                // texture rows run top down, v bottom up
+                const int x0 = static_cast<int>(std::floor(bounds[m * 4] * texture.cols));
+                const int x1 = static_cast<int>(std::ceil(bounds[m * 4 + 2] * texture.cols));
+                const int y0 = static_cast<int>(std::floor((1.f - bounds[m * 4 + 3]) * texture.rows));
+                const int y1 = static_cast<int>(std::ceil((1.f - bounds[m * 4 + 1]) * texture.rows));
+                AtlasPart part;
+                part.material = static_cast<int>(m);
+                part.crop = cv::Rect(x0, y0, std::max(1, x1 - x0), std::max(1, y1 - y0)) & cv::Rect(0, 0, texture.cols, texture.rows);
+                partOf[m] = static_cast<int>(parts.size());
+                parts.push_back(part);
+            }
+            if (blank)
+            {
+                AtlasPart part;
+                part.scaled = cv::Size(BlankSize, BlankSize);
+                partOf.back() = static_cast<int>(parts.size());
+                parts.push_back(part);
+            }
+
+            cv::Size size;
+            for (int attempt = 0;; ++attempt)
+            {
+                for (AtlasPart &part : parts)
+                {
+                    if (part.material >= 0)
+                        part.scaled = cv::Size(std::max(1, static_cast<int>(std::lround(part.crop.width * scale))),
+                                               std::max(1, static_cast<int>(std::lround(part.crop.height * scale))));
+                }
+                size = pack(parts);
+                const int largest = std::max(size.width, size.height);
+                if (largest <= int(options.maxTexture))
+                    break;
+                if (attempt == 16)
+                    return fail(error, "cannot fit the textures into a " + std::to_string(options.maxTexture) + " pixel atlas");
+                scale *= 0.98 * options.maxTexture / largest;
+            }
+
+            cv::Mat atlas(size, CV_8UC3, cv::Scalar::all(255));
+            for (const AtlasPart &part : parts)
+            {
+                if (part.material < 0)
+                    continue;
+                const cv::Mat crop = sources[part.material](part.crop);
+                cv::Mat resized, padded;
+                cv::resize(crop, resized, part.scaled, 0, 0, part.scaled.area() < part.crop.area() ? cv::INTER_AREA : cv::INTER_LINEAR);
+                cv::copyMakeBorder(resized, padded, Padding, Padding, Padding, Padding, cv::BORDER_REPLICATE);
+                padded.copyTo(atlas(cv::Rect(part.at, padded.size())));
+            }
+
+            texcoords.resize(faceCount * 6);
+            for (size_t f = 0; f < faceCount; ++f)
+            {
+                const int m = materialOf(f);
+                const bool textured = m < int(sources.size()) && !sources[m].empty();
+                const AtlasPart &part = parts[partOf[textured ? m : int(sources.size())]];
+                for (int k = 0; k < 3; ++k)
+                {
+                    float x, y; // atlas pixels
+                    if (textured)
+                    {
+                        const cv::Mat &texture = sources[m];
+                        const float px = clamped(model.texcoords[f * 6 + k * 2]) * texture.cols - part.crop.x;
+                        const float py = (1.f - clamped(model.texcoords[f * 6 + k * 2 + 1])) * texture.rows - part.crop.y;
+                        x = part.at.x + Padding + px * part.scaled.width / part.crop.width;
+                        y = part.at.y + Padding + py * part.scaled.height / part.crop.height;
+                    }
+                    else
+                    {
+                        x = part.at.x + Padding + BlankSize * 0.5f;
+                        y = part.at.y + Padding + BlankSize * 0.5f;
+                    }
+                    texcoords[f * 6 + k * 2] = x / size.width;
+                    texcoords[f * 6 + k * 2 + 1] = 1.f - y / size.height;
+                }
+            }
+
+            image.mimeType = "image/jpeg";
+            if (!cv::imencode(".jpg", atlas, image.bytes, {cv::IMWRITE_JPEG_QUALITY, options.jpegQuality}))
+                return fail(error, "cannot encode the texture atlas");
+            side = static_cast<uint32_t>(std::max(size.width, size.height));
+            return true;
+        }
+    }
+
+    std::string MeshLodPath(const std::string &outputBase, uint32_t level)
+    {
+        return outputBase + std::to_string(level) + ".glb";
+    }
+
+    bool BuildMeshLods(const std::string &modelPath, const std::string &outputBase, const MeshLodOptions &options,
+                       MeshLodStats *stats, std::string *error,
+                       const std::function<void(double fraction)> &progress,
+                       const std::atomic<bool> *cancel)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        auto cancelled = [cancel]
+        { return cancel && cancel->load(std::memory_order_relaxed); };
+        auto report = [&](double fraction)
+        {
+            if (progress)
+                progress(fraction);
+        };
+        if (options.levels == 0 || !(options.ratio > 0.f && options.ratio < 1.f))
+            return fail(error, "invalid LOD options: at least one level and a ratio in (0, 1) are needed");
+
+        MeshModel source;
+        std::string loadError;
+        if (!LoadMeshModel(modelPath, source, &loadError, options.threads))
+            return fail(error, loadError);
+        if (source.faceCount() == 0)
+            return fail(error, modelPath + " has no faces");
+        const bool textured = !source.texcoords.empty();
+        std::vector<cv::Mat> textures(textured ? source.textures.size() : 0);
+        for (size_t m = 0; m < textures.size(); ++m)
+        {
+            if (source.textures[m].empty())
+                continue;
+            textures[m] = cv::imread(source.textures[m], cv::IMREAD_COLOR);
+            if (textures[m].empty())
+                return fail(error, "cannot read the texture " + source.textures[m]);
+        }
+        std::error_code ec;
+        fs::create_directories(fs::path(outputBase).parent_path(), ec);
+
+        const size_t sourceFaces = source.faceCount();
+        GltfOptions gltf;
+        gltf.compression = options.compression;
+        gltf.threads = options.threads;
+        MeshLodStats result;
+        MeshModel level;
+        MeshModel *current = &source;
+        size_t target = options.maxFaces ? std::min<size_t>(sourceFaces, options.maxFaces) : sourceFaces;
+        for (uint32_t l = 0; l < options.levels; ++l)
+        {
+            if (l > 0)
+            {
+                target = static_cast<size_t>(std::lround(double(current->faceCount()) * options.ratio));
+                if (target < options.minFaces)
+                    break;
+            }
+            if (target < current->faceCount())
+            {
+                SimplifyOptions simplify;
+                simplify.targetFaces = target;
+                simplify.threads = options.threads;
+                MeshModel next;
+                if (!SimplifyMesh(*current, next, simplify, nullptr, cancel))
+                    return fail(error, "cancelled");
+                level = std::move(next);
+                current = &level;
+            }
+            report((l + 0.5) / options.levels);
+
+            // the atlas texcoords replace the source ones for the export only: the next level
+            // is decimated from this one and cut from the source textures again
+            GltfImage image;
+            uint32_t side = 0;
+            std::vector<float> texcoords;
+            if (textured && !buildAtlas(*current, textures, std::sqrt(double(current->faceCount()) / sourceFaces), options,
+                                        texcoords, image, side, error))
+                return false;
+            current->texcoords.swap(texcoords);
+            const bool written = WriteGlb(MeshLodPath(outputBase, l), *current, textured ? &image : nullptr, gltf, error);
+            current->texcoords.swap(texcoords);
+            if (!written)
+                return false;
+            result.faces.push_back(current->faceCount());
+            result.textureSize.push_back(side);
+            report(double(l + 1) / options.levels);
+            if (cancelled())
+                return fail(error, "cancelled");
+        }
+
+        // levels of an earlier run with more of them
+        for (uint32_t l = static_cast<uint32_t>(result.faces.size()); fs::exists(MeshLodPath(outputBase, l), ec); ++l)
+            fs::remove(MeshLodPath(outputBase, l), ec);
+        report(1.0);
+
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (stats)
+            *stats = std::move(result);
+        return true;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+// Levels of detail of the textured model, written as binary glTF next to it
+// in final_3d_models: <base>0.glb (the full model, or at most maxFaces) and
+// each following level about ratio times the faces of the one before.
+//
+// Every level is decimated from the previous one (mesh_simplify.hpp), which
+// keeps UV seams. The level then gets its own texture atlas: the part of each
+// material's texture its faces use is cut out, scaled by the square root of
+// the level's face ratio (so texels per face stay about the same), packed
+// into one image of at most maxTexture pixels a side and stored as JPEG in
+// the GLB (gltf_export.hpp). Materials without a texture share a white block.
+
+#include "gltf_export.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace VoxelForge
+{
+    struct MeshLodOptions
+    {
+        uint32_t levels = 4;         // files written, fewer when a level would drop below minFaces
+        float ratio = 0.25f;         // faces of a level / faces of the level before, in (0, 1)
+        uint32_t maxFaces = 1000000; // faces of level 0, 0 = all of the model
+        uint32_t minFaces = 1000;    // no level below it (level 0 is always written)
+        uint32_t maxTexture = 4096;  // largest atlas side in pixels
+        int jpegQuality = 90;
+        GltfCompression compression = GltfCompression::Meshopt;
+        int threads = 0;             // 0 = ThreadBudget::limit()
+    };
+
+    struct MeshLodStats
+    {
+        std::vector<size_t> faces;         // per level written
+        std::vector<uint32_t> textureSize; // atlas side (largest) per level, 0 = untextured
+        double seconds = 0;
+    };
+
+    // <outputBase><level>.glb
+    std::string MeshLodPath(const std::string &outputBase, uint32_t level);
+
+    // Loads modelPath (.obj with its textures, or .ply) and writes the levels; files of higher levels
+    // left by an earlier run are removed. progress gets the fraction done; after *cancel becomes true
+    // the build stops once the file being written is complete
+    bool BuildMeshLods(const std::string &modelPath, const std::string &outputBase, const MeshLodOptions &options,
+                       MeshLodStats *stats = nullptr, std::string *error = nullptr,
+                       const std::function<void(double fraction)> &progress = nullptr,
+                       const std::atomic<bool> *cancel = nullptr);
+}
@@ -0,0 +1,611 @@
+#include "mesh_simplify.hpp"
+#include "thread_budget.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace VoxelForge
+{
+    namespace
+    {
+        constexpr size_t VerticesPerTask = 1 << 14;
+        // planes along borders and seams count this much more than a face of the same size
+        constexpr float SeamWeight = 10.f;
+        // a moved face whose normal turns further than this (cosine) is a fold
+        constexpr float MinFaceCosine = 0.2f;
+
+        template <typename Task>
+        void parallelFor(size_t tasks, int threads, const Task &task)
+        {
+            const size_t workers = std::min<size_t>(std::max(1, threads), tasks);
+            std::atomic<size_t> next{0};
+            auto worker = [&]
+            {
+                for (size_t i; (i = next.fetch_add(1)) < tasks;)
+                    task(i);
+            };
+            std::vector<std::thread> pool;
+            for (size_t t = 1; t < workers; ++t)
+                pool.emplace_back(worker);
+            worker();
+            for (std::thread &thread : pool)
+                thread.join();
+        }
+
+        // error of a point: p^T A p + 2 b.p + c, A symmetric
+        struct Quadric
+        {
+            float a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+            float b0 = 0, b1 = 0, b2 = 0, c = 0;
+
+            // plane n.p + d = 0 (n unit length), weighted
+            void addPlane(const float n[3], float d, float weight)
+            {
+                a00 += weight * n[0] * n[0];
+                a01 += weight * n[0] * n[1];
+                a02 += weight * n[0] * n[2];
+                a11 += weight * n[1] * n[1];
+                a12 += weight * n[1] * n[2];
+                a22 += weight * n[2] * n[2];
+                b0 += weight * n[0] * d;
+                b1 += weight * n[1] * d;
+                b2 += weight * n[2] * d;
+                c += weight * d * d;
+            }
+            void add(const Quadric &q)
+            {
+                a00 += q.a00;
+                a01 += q.a01;
+                a02 += q.a02;
+                a11 += q.a11;
+                a12 += q.a12;
+                a22 += q.a22;
+                b0 += q.b0;
+                b1 += q.b1;
+                b2 += q.b2;
+                c += q.c;
+            }
+            float error(const float p[3]) const
+            {
+                const float e = p[0] * (a00 * p[0] + 2 * a01 * p[1] + 2 * a02 * p[2] + 2 * b0) +
+                                p[1] * (a11 * p[1] + 2 * a12 * p[2] + 2 * b1) + p[2] * (a22 * p[2] + 2 * b2) + c;
+                return std::max(0.f, e);
+            }
+        };
+
+        enum class Kind : uint8_t
+        {
+            Free,  // inside a chart: collapses onto any neighbour
+            Along, // on one border or seam line: collapses along it
+            Fixed  // seam junction, corner, non-manifold or unused: stays
+        };
+
+        struct Candidate
+        {
+            float cost;
+            uint32_t from, to;
+        };
+
+        class Simplifier
+        {
+        public:
+            Simplifier(const MeshModel &mesh, int threads)
+                : mesh(mesh), threads(threads), vertexCount(mesh.vertexCount()), faceCount(mesh.faceCount())
+            {
+                // positions in the unit cube, so the float quadrics keep their precision for any model size
+                const double extent = std::max({mesh.max[0] - mesh.min[0], mesh.max[1] - mesh.min[1], mesh.max[2] - mesh.min[2], 1e-30});
+                position.resize(vertexCount * 3);
+                parallelFor(tasksOf(vertexCount), threads, [&](size_t task)
+                            {
+                    for (size_t v = task * VerticesPerTask, end = std::min(vertexCount, v + VerticesPerTask); v < end; ++v)
+                    {
+                        position[v * 3] = static_cast<float>((mesh.x[v] - mesh.min[0]) / extent);
+                        position[v * 3 + 1] = static_cast<float>((mesh.y[v] - mesh.min[1]) / extent);
+                        position[v * 3 + 2] = static_cast<float>((mesh.z[v] - mesh.min[2]) / extent);
+                    } });
+                corners = mesh.indices;
+                uvs = mesh.texcoords;
+                if (uvs.empty())
+                    uvs.assign(faceCount * 6, 0.f);
+                alive.assign(faceCount, 1);
+                live = 0;
+                for (size_t f = 0; f < faceCount; ++f)
+                {
+                    const uint32_t *c = &corners[f * 3];
+                    alive[f] = c[0] != c[1] && c[1] != c[2] && c[0] != c[2];
+                    live += alive[f];
+                }
+                kind.resize(vertexCount);
+                along.resize(vertexCount * 2);
+                quadrics.resize(vertexCount);
+                best.resize(vertexCount);
+                dirty.assign(vertexCount, 1);
+            }
+
+            size_t liveFaces() const { return live; }
+
+            // one pass of collapses; false when none was possible
+            bool pass(size_t targetFaces, bool first)
+            {
+                buildAdjacency();
+                parallelFor(tasksOf(vertexCount), threads, [&](size_t task)
+                            {
+                    std::vector<Edge> edges;
+                    for (size_t v = task * VerticesPerTask, end = std::min(vertexCount, v + VerticesPerTask); v < end; ++v)
+                    {
+                        if (dirty[v])
+                            classify(static_cast<uint32_t>(v), edges, first);
+                    } });
+
+                parallelFor(tasksOf(vertexCount), threads, [&](size_t task)
+                            {
+                    std::vector<uint32_t> ring, otherRing;
+                    std::vector<Candidate> options;
+                    for (size_t v = task * VerticesPerTask, end = std::min(vertexCount, v + VerticesPerTask); v < end; ++v)
+                    {
+                        if (dirty[v])
+                            best[v] = bestCollapse(static_cast<uint32_t>(v), ring, otherRing, options);
+                    } });
+                std::vector<Candidate> candidates;
+                for (const Candidate &c : best)
+                {
+                    if (c.to != NoVertex)
+                        candidates.push_back(c);
+                }
+                std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+                          { return a.cost < b.cost || (a.cost == b.cost && a.from < b.from); });
+
+                // Most collapses remove two faces. The cost limit keeps a pass from taking expensive collapses
+                // only because cheaper ones overlapped: those come back in the next pass.
+                const size_t removeGoal = live - std::min(live, targetFaces);
+                const size_t collapseGoal = std::max<size_t>(1, removeGoal / 2);
+                const float costLimit = collapseGoal < candidates.size() ? 1.5f * candidates[collapseGoal].cost : std::numeric_limits<float>::max();
+                // The best collapse of a vertex only changes with its faces or the ring of its target: the
+                // vertices of the changed faces (locked) and the ring of each target are found again next pass
+                std::vector<uint8_t> locked(vertexCount, 0);
+                std::fill(dirty.begin(), dirty.end(), 0);
+                std::vector<Candidate> accepted;
+                size_t removed = 0;
+                for (const Candidate &c : candidates)
+                {
+                    if (removed >= removeGoal || c.cost > costLimit)
+                        break;
+                    if (locked[c.from] || locked[c.to])
+                        continue;
+                    // the faces of the moved vertex change: none of their vertices may move in this pass
+                    for (uint32_t i = firstFace[c.from]; i < firstFace[c.from + 1]; ++i)
+                    {
+                        const uint32_t *corner = &corners[size_t(faces[i]) * 3];
+                        removed += corner[0] == c.to || corner[1] == c.to || corner[2] == c.to;
+                        locked[corner[0]] = locked[corner[1]] = locked[corner[2]] = 1;
+                        dirty[corner[0]] = dirty[corner[1]] = dirty[corner[2]] = 1;
+                    }
+                    for (uint32_t i = firstFace[c.to]; i < firstFace[c.to + 1]; ++i)
+                    {
+                        const uint32_t *corner = &corners[size_t(faces[i]) * 3];
+                        dirty[corner[0]] = dirty[corner[1]] = dirty[corner[2]] = 1;
+                    }
+                    accepted.push_back(c);
+                }
+                if (accepted.empty())
+                    return false;
+
+                // collapses of one pass touch disjoint faces and distinct targets
+                parallelFor((accepted.size() + 255) / 256, threads, [&](size_t task)
+                            {
+                    for (size_t i = task * 256, end = std::min(accepted.size(), i + 256); i < end; ++i)
+                        collapse(accepted[i].from, accepted[i].to); });
+                live -= removed;
+                return true;
+            }
+
+            void result(MeshModel &output) const
+            {
+                std::vector<uint32_t> remap(vertexCount, NoVertex);
+                for (size_t f = 0; f < faceCount; ++f)
+                {
+                    if (alive[f])
+                        remap[corners[f * 3]] = remap[corners[f * 3 + 1]] = remap[corners[f * 3 + 2]] = 0;
+                }
+                uint32_t kept = 0;
+                for (uint32_t &r : remap)
+                {
+                    if (r != NoVertex)
+                        r = kept++;
+                }
+                output = MeshModel();
+                output.x.resize(kept);
+                output.y.resize(kept);
+                output.z.resize(kept);
+                if (!mesh.colors.empty())
+                    output.colors.resize(kept);
+                for (size_t v = 0; v < vertexCount; ++v)
+                {
+                    const uint32_t r = remap[v];
+                    if (r == NoVertex)
+                        continue;
+                    output.x[r] = mesh.x[v];
+                    output.y[r] = mesh.y[v];
+                    output.z[r] = mesh.z[v];
+                    if (!mesh.colors.empty())
+                        output.colors[r] = mesh.colors[v];
+                }
+                output.indices.reserve(live * 3);
+                if (!mesh.texcoords.empty())
+                    output.texcoords.reserve(live * 6);
+                if (!mesh.faceMaterials.empty())
+                    output.faceMaterials.reserve(live);
+                for (size_t f = 0; f < faceCount; ++f)
+                {
+                    if (!alive[f])
+                        continue;
+                    for (int k = 0; k < 3; ++k)
+                        output.indices.push_back(remap[corners[f * 3 + k]]);
+                    if (!mesh.texcoords.empty())
+                        output.texcoords.insert(output.texcoords.end(), uvs.begin() + f * 6, uvs.begin() + f * 6 + 6);
+                    if (!mesh.faceMaterials.empty())
+                        output.faceMaterials.push_back(mesh.faceMaterials[f]);
+                }
+                output.textures = mesh.textures;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    output.min[axis] = std::numeric_limits<double>::max();
+                    output.max[axis] = std::numeric_limits<double>::lowest();
+                }
+                for (size_t v = 0; v < output.vertexCount(); ++v)
+                {
+                    const double p[3] = {output.x[v], output.y[v], output.z[v]};
+                    for (int axis = 0; axis < 3; ++axis)
+                    {
+                        output.min[axis] = std::min(output.min[axis], p[axis]);
+                        output.max[axis] = std::max(output.max[axis], p[axis]);
+                    }
+                }
+                ComputeVertexNormals(output, threads);
+            }
+
+        private:
+            static constexpr uint32_t NoVertex = std::numeric_limits<uint32_t>::max();
+
+            struct Edge
+            {
+                uint32_t other, face;
+            };
+
+            size_t tasksOf(size_t items) const { return (items + VerticesPerTask - 1) / VerticesPerTask; }
+
+            const float *at(uint32_t v) const { return &position[size_t(v) * 3]; }
+
+            int cornerOf(uint32_t face, uint32_t v) const
+            {
+                const uint32_t *c = &corners[size_t(face) * 3];
+                return c[0] == v ? 0 : c[1] == v ? 1 : c[2] == v ? 2 : -1;
+            }
+
+            bool hasVertex(uint32_t face, uint32_t v) const { return cornerOf(face, v) >= 0; }
+
+            // texture corner: texcoord and material of v in the face
+            bool sameWedge(uint32_t faceA, uint32_t faceB, uint32_t v) const
+            {
+                const size_t a = size_t(faceA) * 6 + cornerOf(faceA, v) * 2, b = size_t(faceB) * 6 + cornerOf(faceB, v) * 2;
+                const bool sameMaterial = mesh.faceMaterials.empty() || mesh.faceMaterials[faceA] == mesh.faceMaterials[faceB];
+                return sameMaterial && uvs[a] == uvs[b] && uvs[a + 1] == uvs[b + 1];
+            }
+
+            static void normal(const float *a, const float *b, const float *c, float n[3])
+            {
+                const float e1[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]}, e2[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+                n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+                n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+                n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+            }
+
+            // faces around each vertex, sorted so the passes are deterministic
+            void buildAdjacency()
+            {
+                std::unique_ptr<std::atomic<uint32_t>[]> counts(new std::atomic<uint32_t>[vertexCount + 1]);
+                for (size_t v = 0; v <= vertexCount; ++v)
+                    counts[v].store(0, std::memory_order_relaxed);
+                const size_t faceTasks = tasksOf(faceCount);
+                parallelFor(faceTasks, threads, [&](size_t task)
+                            {
+                    for (size_t f = task * VerticesPerTask, end = std::min(faceCount, f + VerticesPerTask); f < end; ++f)
+                    {
+                        if (alive[f])
+                        {
+                            for (int k = 0; k < 3; ++k)
+                                counts[corners[f * 3 + k]].fetch_add(1, std::memory_order_relaxed);
+                        }
+                    } });
+                firstFace.resize(vertexCount + 1);
+                firstFace[0] = 0;
+                for (size_t v = 0; v < vertexCount; ++v)
+                {
+                    firstFace[v + 1] = firstFace[v] + counts[v].load(std::memory_order_relaxed);
+                    counts[v].store(firstFace[v], std::memory_order_relaxed);
+                }
+                faces.resize(firstFace[vertexCount]);
+                parallelFor(faceTasks, threads, [&](size_t task)
+                            {
+                    for (size_t f = task * VerticesPerTask, end = std::min(faceCount, f + VerticesPerTask); f < end; ++f)
+                    {
+                        if (alive[f])
+                        {
+                            for (int k = 0; k < 3; ++k)
+                                faces[counts[corners[f * 3 + k]].fetch_add(1, std::memory_order_relaxed)] = static_cast<uint32_t>(f);
+                        }
+                    } });
+                parallelFor(tasksOf(vertexCount), threads, [&](size_t task)
+                            {
+                    for (size_t v = task * VerticesPerTask, end = std::min(vertexCount, v + VerticesPerTask); v < end; ++v)
+                        std::sort(faces.begin() + firstFace[v], faces.begin() + firstFace[v + 1]); });
+            }
+
+            // Kind of v from the edges of its faces: an edge with one face is a border, with two faces whose
+            // corners differ (texcoord or material) a seam, with more non-manifold. On the first pass the
+            // face planes and the planes along border and seam edges make the quadric of v
+            void classify(uint32_t v, std::vector<Edge> &edges, bool withQuadric)
+            {
+                edges.clear();
+                for (uint32_t i = firstFace[v]; i < firstFace[v + 1]; ++i)
+                {
+                    const uint32_t f = faces[i];
+                    const int k = cornerOf(f, v);
+                    edges.push_back({corners[size_t(f) * 3 + (k + 1) % 3], f});
+                    edges.push_back({corners[size_t(f) * 3 + (k + 2) % 3], f});
+                }
+                std::sort(edges.begin(), edges.end(), [](const Edge &a, const Edge &b)
+                          { return a.other < b.other || (a.other == b.other && a.face < b.face); });
+
+                Quadric q;
+                int special = 0;
+                bool manifold = !edges.empty();
+                for (size_t i = 0; i < edges.size();)
+                {
+                    size_t j = i;
+                    while (j < edges.size() && edges[j].other == edges[i].other)
+                        ++j;
+                    const uint32_t w = edges[i].other;
+                    const bool border = j - i == 1;
+                    const bool seam = j - i == 2 && (!sameWedge(edges[i].face, edges[i + 1].face, v) || !sameWedge(edges[i].face, edges[i + 1].face, w));
+                    manifold &= j - i <= 2;
+                    if (border || seam)
+                    {
+                        if (special < 2)
+                            along[size_t(v) * 2 + special] = w;
+                        ++special;
+                        if (withQuadric)
+                        {
+                            // plane through the edge, perpendicular to its face(s)
+                            for (size_t e = i; e < j; ++e)
+                            {
+                                const uint32_t *c = &corners[size_t(edges[e].face) * 3];
+                                float n[3], plane[3];
+                                normal(at(c[0]), at(c[1]), at(c[2]), n);
+                                const float *a = at(v), *b = at(w);
+                                const float edge[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+                                plane[0] = edge[1] * n[2] - edge[2] * n[1];
+                                plane[1] = edge[2] * n[0] - edge[0] * n[2];
+                                plane[2] = edge[0] * n[1] - edge[1] * n[0];
+                                const float length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+                                if (length <= 0)
+                                    continue;
+                                for (float &value : plane)
+                                    value /= length;
+                                const float squared = edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2];
+                                q.addPlane(plane, -(plane[0] * a[0] + plane[1] * a[1] + plane[2] * a[2]), SeamWeight * squared);
+                            }
+                        }
+                    }
+                    i = j;
+                }
+                kind[v] = !manifold ? Kind::Fixed : special == 0 ? Kind::Free : special == 2 ? Kind::Along : Kind::Fixed;
+
+                if (!withQuadric)
+                    return;
+                for (uint32_t i = firstFace[v]; i < firstFace[v + 1]; ++i)
+                {
+                    const uint32_t *c = &corners[size_t(faces[i]) * 3];
+                    float n[3];
+                    normal(at(c[0]), at(c[1]), at(c[2]), n);
+                    const float area2 = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                    if (area2 <= 0)
+                        continue;
+                    for (float &value : n)
+                        value /= area2;
+                    const float *p = at(c[0]);
+                    q.addPlane(n, -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]), area2 * 0.5f);
+                }
+                quadrics[v] = q;
+            }
+
+            void ringOf(uint32_t v, std::vector<uint32_t> &ring) const
+            {
+                ring.clear();
+                for (uint32_t i = firstFace[v]; i < firstFace[v + 1]; ++i)
+                {
+                    const uint32_t *c = &corners[size_t(faces[i]) * 3];
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        if (c[k] != v)
+                            ring.push_back(c[k]);
+                    }
+                }
+                std::sort(ring.begin(), ring.end());
+                ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+            }
+
+            // faces on edge (from, to), at most two (more: non-manifold, returns 3)
+            size_t edgeFaces(uint32_t from, uint32_t to, uint32_t found[2]) const
+            {
+                size_t count = 0;
+                for (uint32_t i = firstFace[from]; i < firstFace[from + 1]; ++i)
+                {
+                    if (hasVertex(faces[i], to))
+                    {
+                        if (count == 2)
+                            return 3;
+                        found[count++] = faces[i];
+                    }
+                }
+                return count;
+            }
+
+            // the edge face holding the same texture corner of from as the face, -1 if none
+            static int64_t matchingEdgeFace(const Simplifier &s, const uint32_t edge[2], size_t count, uint32_t from, uint32_t face)
+            {
+                for (size_t e = 0; e < count; ++e)
+                {
+                    if (s.sameWedge(edge[e], face, from))
+                        return edge[e];
+                }
+                return -1;
+            }
+
+            bool valid(uint32_t from, uint32_t to, const std::vector<uint32_t> &ring, std::vector<uint32_t> &otherRing) const
+            {
+                uint32_t edge[2];
+                const size_t edgeCount = edgeFaces(from, to, edge);
+                if (edgeCount == 0 || edgeCount > 2)
+                    return false;
+
+                // link condition: the common neighbours are the apexes of the edge faces, or the surface pinches
+                ringOf(to, otherRing);
+                size_t common = 0;
+                for (size_t a = 0, b = 0; a < ring.size() && b < otherRing.size();)
+                {
+                    if (ring[a] < otherRing[b])
+                        ++a;
+                    else if (otherRing[b] < ring[a])
+                        ++b;
+                    else
+                    {
+                        common += ring[a] != to && ring[a] != from;
+                        ++a;
+                        ++b;
+                    }
+                }
+                if (common != edgeCount)
+                    return false;
+
+                for (uint32_t i = firstFace[from]; i < firstFace[from + 1]; ++i)
+                {
+                    const uint32_t f = faces[i];
+                    if (hasVertex(f, to))
+                        continue;
+                    // every texture corner of from needs its counterpart at to, on the same side of the seam
+                    if (matchingEdgeFace(*this, edge, edgeCount, from, f) < 0)
+                        return false;
+                    // no face may fold over or collapse
+                    const uint32_t *c = &corners[size_t(f) * 3];
+                    const float *p[3] = {at(c[0]), at(c[1]), at(c[2])};
+                    float before[3], after[3];
+                    normal(p[0], p[1], p[2], before);
+                    p[cornerOf(f, from)] = at(to);
+                    normal(p[0], p[1], p[2], after);
+                    const float dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+                    const float lengths = std::sqrt((before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+                                                    (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+                    if (!(lengths > 0) || dot < MinFaceCosine * lengths)
+                        return false;
+                }
+                return true;
+            }
+
+            // the cheapest valid collapse; validity is the expensive part, so it is checked in order of cost
+            Candidate bestCollapse(uint32_t from, std::vector<uint32_t> &ring, std::vector<uint32_t> &otherRing,
+                                   std::vector<Candidate> &options) const
+            {
+                Candidate candidate = {std::numeric_limits<float>::max(), from, NoVertex};
+                if (kind[from] == Kind::Fixed || firstFace[from] == firstFace[from + 1])
+                    return candidate;
+                ringOf(from, ring);
+                options.clear();
+                if (kind[from] == Kind::Along)
+                {
+                    for (int side = 0; side < 2; ++side)
+                    {
+                        const uint32_t to = along[size_t(from) * 2 + side];
+                        options.push_back({quadrics[from].error(at(to)), from, to});
+                    }
+                }
+                else
+                {
+                    for (const uint32_t to : ring)
+                        options.push_back({quadrics[from].error(at(to)), from, to});
+                }
+                std::sort(options.begin(), options.end(), [](const Candidate &a, const Candidate &b)
+                          { return a.cost < b.cost || (a.cost == b.cost && a.to < b.to); });
+                for (const Candidate &option : options)
+                {
+                    if (valid(from, option.to, ring, otherRing))
+                        return option;
+                }
+                return candidate;
+            }
+
+            void collapse(uint32_t from, uint32_t to)
+            {
+                // found before the faces change
+                uint32_t edge[2];
+                const size_t edgeCount = edgeFaces(from, to, edge);
+                for (uint32_t i = firstFace[from]; i < firstFace[from + 1]; ++i)
+                {
+                    const uint32_t f = faces[i];
+                    if (hasVertex(f, to))
+                    {
+                        alive[f] = 0;
+                        continue;
+                    }
+                    const uint32_t e = static_cast<uint32_t>(matchingEdgeFace(*this, edge, edgeCount, from, f));
+                    const int k = cornerOf(f, from), kTo = cornerOf(e, to);
+                    uvs[size_t(f) * 6 + k * 2] = uvs[size_t(e) * 6 + kTo * 2];
+                    uvs[size_t(f) * 6 + k * 2 + 1] = uvs[size_t(e) * 6 + kTo * 2 + 1];
+                    corners[size_t(f) * 3 + k] = to;
+                }
+                quadrics[to].add(quadrics[from]);
+            }
+
+            const MeshModel &mesh;
+            const int threads;
+            const size_t vertexCount, faceCount;
+            std::vector<float> position; // xyz, normalized
+            std::vector<uint32_t> corners;
+            std::vector<float> uvs;      // 6 per face
+            std::vector<uint8_t> alive;
+            size_t live;
+            std::vector<uint32_t> firstFace, faces; // faces of vertex v: faces[firstFace[v] .. firstFace[v + 1])
+            std::vector<Kind> kind;
+            std::vector<uint32_t> along;         // the two border / seam neighbours of an Along vertex
+            std::vector<Quadric> quadrics;
+            std::vector<Candidate> best;
+            std::vector<uint8_t> dirty;  // best (and kind) to be found again
+        };
+    }
+
+    bool SimplifyMesh(const MeshModel &input, MeshModel &output, const SimplifyOptions &options,
+                      SimplifyStats *stats, const std::atomic<bool> *cancel)
+    {
+        const int threads = options.threads > 0 ? options.threads : ThreadBudget::limit();
+        Simplifier simplifier(input, threads);
+        int passes = 0;
+        while (simplifier.liveFaces() > options.targetFaces && simplifier.pass(options.targetFaces, passes == 0))
+        {
+            ++passes;
+            if (cancel && *cancel)
+                return false;
+        }
+        simplifier.result(output);
+        if (stats)
+        {
+            stats->faces = output.faceCount();
+            stats->vertices = output.vertexCount();
+            stats->passes = passes;
+        }
+        return true;
+    }
+}
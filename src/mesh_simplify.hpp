@@ -0,0 +1,45 @@
+#pragma once
+
+// Decimation of a MeshModel (model_io.hpp) by quadric edge collapse, for the
+// LODs of the textured model (mesh_lod.hpp).
+//
+// Each collapse moves a vertex onto one of its neighbours (half-edge
+// collapse): kept vertices never move, so their texture coordinates stay
+// exact. The cost of a collapse is the quadric error of the moved vertex,
+// the area-weighted squared distances to the planes of the faces it merged,
+// plus planes along open borders and UV seams so their outline is kept. A
+// vertex on a border or a seam only moves along it, and every side of the
+// seam is remapped to the target corner on the same side; vertices where
+// seams meet or with non-manifold edges stay. Collapses that would fold a
+// face over or pinch the surface (link condition) are rejected.
+//
+// The work runs in passes: every vertex finds its cheapest valid collapse in
+// parallel, the cheapest collapses whose neighbourhoods do not overlap are
+// picked, and those are applied in parallel. Passes repeat until the target
+// face count is reached or no collapse is left.
+
+#include "model_io.hpp"
+
+#include <atomic>
+#include <cstddef>
+
+namespace VoxelForge
+{
+    struct SimplifyOptions
+    {
+        size_t targetFaces = 0; // stop at or below this many faces
+        int threads = 0;        // 0 = ThreadBudget::limit()
+    };
+
+    struct SimplifyStats
+    {
+        size_t faces = 0;    // kept
+        size_t vertices = 0;
+        int passes = 0;
+    };
+
+    // output gets the kept vertices (in input order) and faces with their attributes, normals computed
+    // again and new bounds; it must not be input. False only when *cancel became true
+    bool SimplifyMesh(const MeshModel &input, MeshModel &output, const SimplifyOptions &options,
+                      SimplifyStats *stats = nullptr, const std::atomic<bool> *cancel = nullptr);
+}
@@ -0,0 +1,826 @@
+#include "model_io.hpp"
+#include "mapped_file.hpp"
+#include "ply_io.hpp"
+#include "thread_budget.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace VoxelForge
+{
+    namespace
+    {
+        constexpr size_t MinChunkBytes = 1 << 20;
+        constexpr size_t ItemsPerTask = 1 << 16;
+        constexpr size_t MaxAsciiProperties = 64;
+
+        bool fail(std::string *error, const std::string &message)
+        {
+            if (error)
+                *error = message;
+            return false;
+        }
+
+        template <typename Task>
+        void parallelFor(size_t tasks, int threads, const Task &task)
+        {
+            const size_t workers = std::min<size_t>(std::max(1, threads), tasks);
+            std::atomic<size_t> next{0};
+            auto worker = [&]
+            {
+                for (size_t i; (i = next.fetch_add(1)) < tasks;)
+                    task(i);
+            };
+            std::vector<std::thread> pool;
+            for (size_t t = 1; t < workers; ++t)
+                pool.emplace_back(worker);
+            worker();
+            for (std::thread &thread : pool)
+                thread.join();
+        }
+
+        struct Bounds
+        {
+            double min[3] = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+            double max[3] = {std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+
+            void add(float x, float y, float z)
+            {
+                const float p[3] = {x, y, z};
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    min[axis] = std::min<double>(min[axis], p[axis]);
+                    max[axis] = std::max<double>(max[axis], p[axis]);
+                }
+            }
+            void add(const Bounds &other)
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    min[axis] = std::min(min[axis], other.min[axis]);
+                    max[axis] = std::max(max[axis], other.max[axis]);
+                }
+            }
+        };
+
+        // [begin, end) cut into pieces of at least MinChunkBytes, each but the last ending after a newline
+        std::vector<const char *> lineChunks(const char *begin, const char *end, int threads)
+        {
+            const size_t parts = std::max<size_t>(1, std::min<size_t>(size_t(threads) * 4, size_t(end - begin) / MinChunkBytes + 1));
+            std::vector<const char *> cuts = {begin};
+            for (size_t i = 1; i < parts; ++i)
+            {
+                const char *cut = begin + (end - begin) * i / parts;
+                if (cut <= cuts.back())
+                    continue;
+                const char *newline = static_cast<const char *>(std::memchr(cut, '\n', size_t(end - cut)));
+                if (!newline || newline + 1 >= end)
+                    break;
+                cuts.push_back(newline + 1);
+            }
+            cuts.push_back(end);
+            return cuts;
+        }
+
+        // next line of [cursor, end), without its newline
+        bool nextLine(const char *&cursor, const char *end, const char *&line, const char *&lineEnd)
+        {
+            if (cursor >= end)
+                return false;
+            line = cursor;
+            const char *newline = static_cast<const char *>(std::memchr(cursor, '\n', size_t(end - cursor)));
+            lineEnd = newline ? newline : end;
+            cursor = newline ? newline + 1 : end;
+            return true;
+        }
+
+        void skipBlanks(const char *&cursor, const char *end)
+        {
+            while (cursor < end && (*cursor == ' ' || *cursor == '\t'))
+                ++cursor;
+        }
+
+        // the rest of the line without surrounding blanks (file names may contain spaces)
+        std::string restOfLine(const char *cursor, const char *end)
+        {
+            skipBlanks(cursor, end);
+            while (end > cursor && std::isspace(static_cast<unsigned char>(end[-1])))
+                --end;
+            return std::string(cursor, end);
+        }
+
+        bool keyword(const char *&cursor, const char *end, const char *word)
+        {
+            const size_t length = std::strlen(word);
+            if (size_t(end - cursor) <= length || std::strncmp(cursor, word, length) != 0 || (cursor[length] != ' ' && cursor[length] != '\t'))
+                return false;
+            cursor += length;
+            return true;
+        }
+
+        bool parseInteger(const char *&cursor, const char *end, long &value)
+        {
+            const char *p = cursor;
+            skipBlanks(p, end);
+            const bool negative = p < end && *p == '-';
+            if (p < end && (*p == '-' || *p == '+'))
+                ++p;
+            if (p >= end || *p < '0' || *p > '9')
+                return false;
+            long v = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; ++p)
+                v = v * 10 + (*p - '0');
+            value = negative ? -v : v;
+            cursor = p;
+            return true;
+        }
+
+        uint32_t packColor(uint8_t r, uint8_t g, uint8_t b)
+        {
+            return 0xFF000000u | uint32_t(r) << 16 | uint32_t(g) << 8 | b;
+        }
+
+        // --- PLY ---
+
+        struct PlyLayout
+        {
+            int position[3], color[3], normal[3];
+            bool hasColor = false, hasNormal = false;
+        };
+
+        // value(context, property) reads one property of the vertex
+        void storeVertex(MeshModel &model, size_t i, const PlyElement &vertex, const PlyLayout &layout,
+                         double (*value)(const void *context, int property), const void *context, Bounds &bounds)
+        {
+            model.x[i] = static_cast<float>(value(context, layout.position[0]));
+            model.y[i] = static_cast<float>(value(context, layout.position[1]));
+            model.z[i] = static_cast<float>(value(context, layout.position[2]));
+            bounds.add(model.x[i], model.y[i], model.z[i]);
+            if (layout.hasColor)
+            {
+                uint8_t rgb[3];
+                for (int c = 0; c < 3; ++c)
+                    rgb[c] = PlyColorChannel(value(context, layout.color[c]), vertex.properties[layout.color[c]].type);
+                model.colors[i] = packColor(rgb[0], rgb[1], rgb[2]);
+            }
+            if (layout.hasNormal)
+            {
+                model.nx[i] = static_cast<float>(value(context, layout.normal[0]));
+                model.ny[i] = static_cast<float>(value(context, layout.normal[1]));
+                model.nz[i] = static_cast<float>(value(context, layout.normal[2]));
+            }
+        }
+
+        bool indexProperty(const PlyElement &face, int &property, std::string *error)
+        {
+            property = std::max(face.find("vertex_indices"), face.find("vertex_index"));
+            if (property < 0 || !face.properties[property].isList)
+                return fail(error, "the faces have no vertex_indices list");
+            return true;
+        }
+
+        void addFan(const uint32_t *polygon, size_t corners, std::vector<uint32_t> &triangles)
+        {
+            for (size_t i = 2; i < corners; ++i)
+                triangles.insert(triangles.end(), {polygon[0], polygon[i - 1], polygon[i]});
+        }
+
+        bool plyBinary(const PlyHeader &header, const PlyLayout &layout, const char *data, const char *end, int threads,
+                       MeshModel &model, Bounds &bounds, std::string *error)
+        {
+            const bool swap = header.format == PlyHeader::Format::BinaryBigEndian;
+            const PlyElement &vertex = header.elements[0];
+            const size_t stride = vertex.stride();
+            if (stride == 0)
+                return fail(error, "the vertices have a list property");
+            const size_t count = static_cast<size_t>(vertex.count);
+            if (size_t(end - data) / stride < count)
+                return fail(error, "the file is shorter than its vertices");
+            std::vector<size_t> offsets;
+            for (size_t p = 0, offset = 0; p < vertex.properties.size(); offset += PlyTypeSize(vertex.properties[p++].type))
+                offsets.push_back(offset);
+
+            struct Item
+            {
+                const unsigned char *bytes;
+                const PlyElement *vertex;
+                const size_t *offsets;
+                bool swap;
+            };
+            // little endian floats, the usual case, skip the generic decoder
+            auto value = [](const void *context, int property)
+            {
+                const Item &item = *static_cast<const Item *>(context);
+                const PlyType type = item.vertex->properties[property].type;
+                if (type == PlyType::Float32 && !item.swap)
+                {
+                    float v;
+                    std::memcpy(&v, item.bytes + item.offsets[property], sizeof(v));
+                    return double(v);
+                }
+                return DecodePlyValue(item.bytes + item.offsets[property], type, item.swap);
+            };
+
+            const size_t tasks = (count + ItemsPerTask - 1) / ItemsPerTask;
+            std::vector<Bounds> taskBounds(tasks);
+            parallelFor(tasks, threads, [&](size_t task)
+                        {
+                const size_t last = std::min(count, (task + 1) * ItemsPerTask);
+                Item item = {nullptr, &vertex, offsets.data(), swap};
+                for (size_t i = task * ItemsPerTask; i < last; ++i)
+                {
+                    item.bytes = reinterpret_cast<const unsigned char *>(data) + i * stride;
+                    storeVertex(model, i, vertex, layout, value, &item, taskBounds[task]);
+                } });
+            for (const Bounds &b : taskBounds)
+                bounds.add(b);
+
+            if (header.elements.size() < 2 || header.elements[1].name != "face" || header.elements[1].count == 0)
+                return true;
+            const PlyElement &face = header.elements[1];
+            int indices;
+            if (!indexProperty(face, indices, error))
+                return false;
+            const unsigned char *faces = reinterpret_cast<const unsigned char *>(data) + count * stride;
+            const unsigned char *facesEnd = reinterpret_cast<const unsigned char *>(end);
+            const size_t faceCount = static_cast<size_t>(face.count);
+
+            // layout of the first face: when every face has the same list lengths (a triangle mesh) the faces
+            // have a fixed size and are decoded in parallel by index
+            std::vector<size_t> listCounts(face.properties.size(), 0);
+            size_t faceStride = 0, indexOffset = 0;
+            for (size_t p = 0; p < face.properties.size(); ++p)
+            {
+                const PlyProperty &property = face.properties[p];
+                if (!property.isList)
+                {
+                    faceStride += PlyTypeSize(property.type);
+                    continue;
+                }
+                if (size_t(facesEnd - faces) < faceStride + PlyTypeSize(property.countType))
+                    return fail(error, "the file is shorter than its faces");
+                listCounts[p] = static_cast<size_t>(DecodePlyValue(faces + faceStride, property.countType, swap));
+                faceStride += PlyTypeSize(property.countType);
+                if (int(p) == indices)
+                    indexOffset = faceStride;
+                faceStride += listCounts[p] * PlyTypeSize(property.type);
+            }
+            const size_t corners = listCounts[indices];
+            const PlyType indexType = face.properties[indices].type;
+            auto readIndex = [&](const unsigned char *at)
+            {
+                if ((indexType == PlyType::Int32 || indexType == PlyType::UInt32) && !swap)
+                {
+                    uint32_t v;
+                    std::memcpy(&v, at, sizeof(v));
+                    return v;
+                }
+                return static_cast<uint32_t>(DecodePlyValue(at, indexType, swap));
+            };
+
+            bool fixed = corners >= 3 && size_t(facesEnd - faces) / faceStride >= faceCount;
+            const size_t faceTasks = (faceCount + ItemsPerTask - 1) / ItemsPerTask;
+            if (fixed)
+            {
+                std::atomic<bool> same{true};
+                parallelFor(faceTasks, threads, [&](size_t task)
+                            {
+                    const size_t last = std::min(faceCount, (task + 1) * ItemsPerTask);
+                    for (size_t f = task * ItemsPerTask; f < last && same; ++f)
+                    {
+                        const unsigned char *item = faces + f * faceStride;
+                        for (size_t p = 0, offset = 0; p < face.properties.size(); ++p)
+                        {
+                            const PlyProperty &property = face.properties[p];
+                            if (!property.isList)
+                            {
+                                offset += PlyTypeSize(property.type);
+                                continue;
+                            }
+                            if (static_cast<size_t>(DecodePlyValue(item + offset, property.countType, swap)) != listCounts[p])
+                            {
+                                same = false;
+                                return;
+                            }
+                            offset += PlyTypeSize(property.countType) + listCounts[p] * PlyTypeSize(property.type);
+                        }
+                    } });
+                fixed = same;
+            }
+            if (fixed)
+            {
+                const size_t perFace = (corners - 2) * 3;
+                const size_t indexSize = PlyTypeSize(indexType);
+                model.indices.resize(faceCount * perFace);
+                parallelFor(faceTasks, threads, [&](size_t task)
+                            {
+                    const size_t last = std::min(faceCount, (task + 1) * ItemsPerTask);
+                    std::vector<uint32_t> polygon(corners);
+                    for (size_t f = task * ItemsPerTask; f < last; ++f)
+                    {
+                        const unsigned char *items = faces + f * faceStride + indexOffset;
+                        for (size_t k = 0; k < corners; ++k)
+                            polygon[k] = readIndex(items + k * indexSize);
+                        uint32_t *out = &model.indices[f * perFace];
+                        for (size_t k = 2; k < corners; ++k, out += 3)
+                        {
+                            out[0] = polygon[0];
+                            out[1] = polygon[k - 1];
+                            out[2] = polygon[k];
+                        }
+                    } });
+                return true;
+            }
+
+            // polygons of varying sizes: one pass in file order
+            std::vector<uint32_t> polygon;
+            const unsigned char *cursor = faces;
+            for (size_t f = 0; f < faceCount; ++f)
+            {
+                for (size_t p = 0; p < face.properties.size(); ++p)
+                {
+                    const PlyProperty &property = face.properties[p];
+                    const size_t countSize = property.isList ? PlyTypeSize(property.countType) : 0;
+                    if (size_t(facesEnd - cursor) < countSize)
+                        return fail(error, "the file is shorter than its faces");
+                    const size_t items = property.isList ? static_cast<size_t>(DecodePlyValue(cursor, property.countType, swap)) : 1;
+                    cursor += countSize;
+                    const size_t itemSize = PlyTypeSize(property.type);
+                    if (size_t(facesEnd - cursor) / itemSize < items)
+                        return fail(error, "the file is shorter than its faces");
+                    if (int(p) == indices)
+                    {
+                        polygon.resize(items);
+                        for (size_t k = 0; k < items; ++k)
+                            polygon[k] = readIndex(cursor + k * itemSize);
+                        addFan(polygon.data(), items, model.indices);
+                    }
+                    cursor += items * itemSize;
+                }
+            }
+            return true;
+        }
+
+        bool plyAscii(const PlyHeader &header, const PlyLayout &layout, const char *data, const char *end, int threads,
+                      MeshModel &model, Bounds &bounds, std::string *error)
+        {
+            const PlyElement &vertex = header.elements[0];
+            if (vertex.properties.size() > MaxAsciiProperties)
+                return fail(error, "too many vertex properties");
+            const PlyElement *face = header.elements.size() > 1 && header.elements[1].name == "face" ? &header.elements[1] : nullptr;
+            int indices = -1;
+            if (face && face->count > 0 && !indexProperty(*face, indices, error))
+                return false;
+            const uint64_t vertexCount = vertex.count, faceEnd = vertex.count + (face ? face->count : 0);
+
+            // line number of each chunk start, from the newlines before it
+            const std::vector<const char *> cuts = lineChunks(data, end, threads);
+            const size_t chunks = cuts.size() - 1;
+            std::vector<uint64_t> firstLine(chunks + 1, 0);
+            parallelFor(chunks, threads, [&](size_t c)
+                        { firstLine[c + 1] = static_cast<uint64_t>(std::count(cuts[c], cuts[c + 1], '\n')); });
+            for (size_t c = 0; c < chunks; ++c)
+                firstLine[c + 1] += firstLine[c];
+            const bool lastLineOpen = end > data && end[-1] != '\n';
+            if (firstLine[chunks] + (lastLineOpen ? 1 : 0) < faceEnd)
+                return fail(error, "the file has fewer lines than vertices and faces");
+
+            struct Chunk
+            {
+                std::vector<uint32_t> triangles;
+                Bounds bounds;
+                std::string error;
+            };
+            std::vector<Chunk> results(chunks);
+            auto value = [](const void *context, int property)
+            { return static_cast<const double *>(context)[property]; };
+
+            parallelFor(chunks, threads, [&](size_t c)
+                        {
+                Chunk &chunk = results[c];
+                double values[MaxAsciiProperties];
+                std::vector<uint32_t> polygon;
+                const char *cursor = cuts[c], *line, *lineEnd;
+                for (uint64_t number = firstLine[c]; number < faceEnd && nextLine(cursor, cuts[c + 1], line, lineEnd); ++number)
+                {
+                    if (number < vertexCount)
+                    {
+                        for (size_t p = 0; p < vertex.properties.size(); ++p)
+                        {
+                            if (!ParseAsciiNumber(line, lineEnd, values[p]))
+                            {
+                                chunk.error = "bad vertex on line " + std::to_string(number + 1) + " of the data";
+                                return;
+                            }
+                        }
+                        storeVertex(model, static_cast<size_t>(number), vertex, layout, value, values, chunk.bounds);
+                        continue;
+                    }
+                    for (size_t p = 0; p < face->properties.size(); ++p)
+                    {
+                        double v;
+                        bool parsed = ParseAsciiNumber(line, lineEnd, v);
+                        if (parsed && face->properties[p].isList)
+                        {
+                            polygon.resize(static_cast<size_t>(v));
+                            for (size_t k = 0; k < polygon.size() && parsed; ++k)
+                            {
+                                parsed = ParseAsciiNumber(line, lineEnd, v);
+                                polygon[k] = static_cast<uint32_t>(v);
+                            }
+                            if (parsed && int(p) == indices)
+                                addFan(polygon.data(), polygon.size(), chunk.triangles);
+                        }
+                        if (!parsed)
+                        {
+                            chunk.error = "bad face on line " + std::to_string(number + 1) + " of the data";
+                            return;
+                        }
+                    }
+                } });
+
+            size_t triangles = 0;
+            for (const Chunk &chunk : results)
+            {
+                if (!chunk.error.empty())
+                    return fail(error, chunk.error);
+                triangles += chunk.triangles.size();
+                bounds.add(chunk.bounds);
+            }
+            model.indices.reserve(triangles);
+            for (const Chunk &chunk : results)
+                model.indices.insert(model.indices.end(), chunk.triangles.begin(), chunk.triangles.end());
+            return true;
+        }
+
+        bool loadPly(const std::string &path, MeshModel &model, Bounds &bounds, int threads, std::string *error)
+        {
+            PlyHeader header;
+            std::FILE *file = std::fopen(path.c_str(), "rb");
+            if (!file)
+                return fail(error, "cannot open " + path);
+            const bool parsed = ReadPlyHeader(file, header, error);
+            std::fclose(file);
+            if (!parsed)
+                return false;
+            if (header.elements.empty() || header.elements[0].name != "vertex")
+                return fail(error, "the first element of " + path + " is not vertex");
+
+            const PlyElement &vertex = header.elements[0];
+            PlyLayout layout;
+            FindPlyVertexProperties(vertex, layout.position, layout.color, layout.normal);
+            if (layout.position[0] < 0 || layout.position[1] < 0 || layout.position[2] < 0)
+                return fail(error, path + " has no x, y, z vertex properties");
+            layout.hasColor = layout.color[0] >= 0 && layout.color[1] >= 0 && layout.color[2] >= 0;
+            layout.hasNormal = layout.normal[0] >= 0 && layout.normal[1] >= 0 && layout.normal[2] >= 0;
+
+            MappedFile map;
+            if (!map.open(path, error))
+                return false;
+            if (header.dataOffset > map.size())
+                return fail(error, path + " is truncated");
+
+            const size_t count = static_cast<size_t>(vertex.count);
+            model.x.resize(count);
+            model.y.resize(count);
+            model.z.resize(count);
+            if (layout.hasColor)
+                model.colors.resize(count);
+            if (layout.hasNormal)
+            {
+                model.nx.resize(count);
+                model.ny.resize(count);
+                model.nz.resize(count);
+            }
+            const char *data = map.data() + header.dataOffset, *end = map.data() + map.size();
+            std::string message;
+            const bool loaded = header.format == PlyHeader::Format::Ascii
+                                    ? plyAscii(header, layout, data, end, threads, model, bounds, &message)
+                                    : plyBinary(header, layout, data, end, threads, model, bounds, &message);
+            return loaded || fail(error, message + " in " + path);
+        }
+
+        // --- OBJ ---
+
+        // materials of an MTL file, appended: name and diffuse texture path
+        void readMaterials(const fs::path &path, std::vector<std::string> &names, std::vector<std::string> &textures)
+        {
+            MappedFile map;
+            if (!map.open(path.string()))
+                return;
+            const char *cursor = map.data(), *end = map.data() + map.size(), *line, *lineEnd;
+            while (nextLine(cursor, end, line, lineEnd))
+            {
+                skipBlanks(line, lineEnd);
+                if (keyword(line, lineEnd, "newmtl"))
+                {
+                    names.push_back(restOfLine(line, lineEnd));
+                    textures.emplace_back();
+                }
+                else if (keyword(line, lineEnd, "map_Kd") && !textures.empty())
+                {
+                    // with options (-s, -o ...) the file name is the last word
+                    std::string file = restOfLine(line, lineEnd);
+                    if (!file.empty() && file[0] == '-')
+                        file = file.substr(file.find_last_of(" \t") + 1);
+                    textures.back() = file.empty() ? std::string() : (path.parent_path() / file).string();
+                }
+            }
+        }
+
+        // one line-aligned piece of an OBJ file
+        struct ObjChunk
+        {
+            std::vector<float> x, y, z;
+            std::vector<uint32_t> colors;             // up to the last vertex with a colour
+            std::vector<float> uvs;
+            std::vector<uint32_t> corners, cornerUVs; // per triangle corner, absolute (UINT32_MAX: none)
+            // negative indices: corner and index counted from the chunk's first vertex / texcoord
+            std::vector<std::pair<size_t, long>> relativeVertices, relativeUVs;
+            std::vector<int32_t> faceMaterials;       // into materials, -1: the material current at the chunk start
+            std::vector<std::string> materials, libraries;
+            int32_t lastMaterial = -1;
+            bool anyUV = false;
+            Bounds bounds;
+        };
+
+        void parseObjChunk(const char *cursor, const char *end, ObjChunk &chunk)
+        {
+            std::vector<long> faceVertices, faceUVs;
+            int32_t material = -1;
+            const char *line, *lineEnd;
+            while (nextLine(cursor, end, line, lineEnd))
+            {
+                skipBlanks(line, lineEnd);
+                if (lineEnd - line < 2)
+                    continue;
+                if (line[0] == 'v' && (line[1] == ' ' || line[1] == '\t'))
+                {
+                    double values[6];
+                    int count = 0;
+                    for (line += 2; count < 6 && ParseAsciiNumber(line, lineEnd, values[count]); ++count)
+                        ;
+                    if (count < 3)
+                        continue;
+                    chunk.x.push_back(static_cast<float>(values[0]));
+                    chunk.y.push_back(static_cast<float>(values[1]));
+                    chunk.z.push_back(static_cast<float>(values[2]));
+                    chunk.bounds.add(chunk.x.back(), chunk.y.back(), chunk.z.back());
+                    if (count == 6)
+                    {
+                        // colours after the position, in [0, 1]
+                        chunk.colors.resize(chunk.x.size() - 1, 0xFFFFFFFFu);
+                        chunk.colors.push_back(packColor(PlyColorChannel(values[3], PlyType::Float64), PlyColorChannel(values[4], PlyType::Float64),
+                                                         PlyColorChannel(values[5], PlyType::Float64)));
+                    }
+                }
+                else if (line[0] == 'v' && line[1] == 't' && lineEnd - line > 2 && (line[2] == ' ' || line[2] == '\t'))
+                {
+                    double u = 0, v = 0;
+                    line += 3;
+                    ParseAsciiNumber(line, lineEnd, u);
+                    ParseAsciiNumber(line, lineEnd, v);
+                    chunk.uvs.push_back(static_cast<float>(u));
+                    chunk.uvs.push_back(static_cast<float>(v));
+                }
+                else if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t'))
+                {
+                    // v, v/vt, v//vn or v/vt/vn; negative indices count back from the last vertex
+                    faceVertices.clear();
+                    faceUVs.clear();
+                    line += 2;
+                    long v;
+                    while (parseInteger(line, lineEnd, v))
+                    {
+                        long vt = 0, vn;
+                        if (line < lineEnd && *line == '/')
+                        {
+                            ++line;
+                            parseInteger(line, lineEnd, vt);
+                            if (line < lineEnd && *line == '/')
+                            {
+                                ++line;
+                                parseInteger(line, lineEnd, vn);
+                            }
+                        }
+                        faceVertices.push_back(v);
+                        faceUVs.push_back(vt);
+                    }
+                    for (size_t i = 2; i < faceVertices.size(); ++i)
+                    {
+                        for (const size_t k : {size_t(0), i - 1, i})
+                        {
+                            const size_t corner = chunk.corners.size();
+                            const long vi = faceVertices[k], ti = faceUVs[k];
+                            chunk.corners.push_back(vi > 0 ? static_cast<uint32_t>(vi - 1) : UINT32_MAX);
+                            if (vi < 0)
+                                chunk.relativeVertices.emplace_back(corner, static_cast<long>(chunk.x.size()) + vi);
+                            chunk.cornerUVs.push_back(ti > 0 ? static_cast<uint32_t>(ti - 1) : UINT32_MAX);
+                            if (ti < 0)
+                                chunk.relativeUVs.emplace_back(corner, static_cast<long>(chunk.uvs.size() / 2) + ti);
+                            chunk.anyUV |= ti != 0;
+                        }
+                        chunk.faceMaterials.push_back(material);
+                    }
+                }
+                else if (keyword(line, lineEnd, "usemtl"))
+                {
+                    const std::string name = restOfLine(line, lineEnd);
+                    const size_t index = std::find(chunk.materials.begin(), chunk.materials.end(), name) - chunk.materials.begin();
+                    if (index == chunk.materials.size())
+                        chunk.materials.push_back(name);
+                    chunk.lastMaterial = material = static_cast<int32_t>(index);
+                }
+                else if (keyword(line, lineEnd, "mtllib"))
+                {
+                    chunk.libraries.push_back(restOfLine(line, lineEnd));
+                }
+            }
+        }
+
+        bool loadObj(const std::string &path, MeshModel &model, Bounds &bounds, int threads, std::string *error)
+        {
+            MappedFile map;
+            if (!map.open(path, error))
+                return false;
+            const std::vector<const char *> cuts = lineChunks(map.data(), map.data() + map.size(), threads);
+            const size_t chunkCount = cuts.size() - 1;
+            std::vector<ObjChunk> chunks(chunkCount);
+            parallelFor(chunkCount, threads, [&](size_t c)
+                        { parseObjChunk(cuts[c], cuts[c + 1], chunks[c]); });
+
+            // materials: those of the libraries in file order, then names only used
+            std::vector<std::string> materialNames;
+            for (const ObjChunk &chunk : chunks)
+                for (const std::string &library : chunk.libraries)
+                    readMaterials(fs::path(path).parent_path() / library, materialNames, model.textures);
+            auto materialIndex = [&](const std::string &name)
+            {
+                const size_t index = std::find(materialNames.begin(), materialNames.end(), name) - materialNames.begin();
+                if (index == materialNames.size())
+                {
+                    materialNames.push_back(name);
+                    model.textures.emplace_back();
+                }
+                return static_cast<uint16_t>(std::min<size_t>(index, std::numeric_limits<uint16_t>::max()));
+            };
+
+            // where each chunk goes in the joined arrays, and the material current at its start
+            std::vector<size_t> vertexOffset(chunkCount + 1, 0), uvOffset(chunkCount + 1, 0), cornerOffset(chunkCount + 1, 0);
+            std::vector<std::vector<uint16_t>> chunkMaterials(chunkCount);
+            std::vector<uint16_t> startMaterial(chunkCount, 0);
+            bool anyColor = false, anyUV = false;
+            uint16_t current = 0;
+            for (size_t c = 0; c < chunkCount; ++c)
+            {
+                const ObjChunk &chunk = chunks[c];
+                vertexOffset[c + 1] = vertexOffset[c] + chunk.x.size();
+                uvOffset[c + 1] = uvOffset[c] + chunk.uvs.size() / 2;
+                cornerOffset[c + 1] = cornerOffset[c] + chunk.corners.size();
+                anyColor |= !chunk.colors.empty();
+                anyUV |= chunk.anyUV;
+                startMaterial[c] = current;
+                for (const std::string &name : chunk.materials)
+                    chunkMaterials[c].push_back(materialIndex(name));
+                if (chunk.lastMaterial >= 0)
+                    current = chunkMaterials[c][chunk.lastMaterial];
+                bounds.add(chunk.bounds);
+            }
+            std::vector<float> uvs;
+            uvs.reserve(uvOffset[chunkCount] * 2);
+            for (const ObjChunk &chunk : chunks)
+                uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+
+            const size_t vertices = vertexOffset[chunkCount], corners = cornerOffset[chunkCount];
+            model.x.resize(vertices);
+            model.y.resize(vertices);
+            model.z.resize(vertices);
+            if (anyColor)
+                model.colors.assign(vertices, 0xFFFFFFFFu);
+            model.indices.resize(corners);
+            if (anyUV)
+            {
+                model.texcoords.resize(corners * 2);
+                model.faceMaterials.resize(corners / 3);
+            }
+            parallelFor(chunkCount, threads, [&](size_t c)
+                        {
+                ObjChunk &chunk = chunks[c];
+                const size_t v0 = vertexOffset[c], k0 = cornerOffset[c];
+                std::copy(chunk.x.begin(), chunk.x.end(), model.x.begin() + v0);
+                std::copy(chunk.y.begin(), chunk.y.end(), model.y.begin() + v0);
+                std::copy(chunk.z.begin(), chunk.z.end(), model.z.begin() + v0);
+                std::copy(chunk.colors.begin(), chunk.colors.end(), model.colors.begin() + v0);
+                auto absolute = [](size_t offset, long relative)
+                { return long(offset) + relative >= 0 ? static_cast<uint32_t>(long(offset) + relative) : UINT32_MAX; };
+                for (const auto &relative : chunk.relativeVertices)
+                    chunk.corners[relative.first] = absolute(v0, relative.second);
+                for (const auto &relative : chunk.relativeUVs)
+                    chunk.cornerUVs[relative.first] = absolute(uvOffset[c], relative.second);
+                std::copy(chunk.corners.begin(), chunk.corners.end(), model.indices.begin() + k0);
+                if (!anyUV)
+                    return;
+                for (size_t k = 0; k < chunk.cornerUVs.size(); ++k)
+                {
+                    const uint32_t t = chunk.cornerUVs[k];
+                    const bool valid = t < uvs.size() / 2;
+                    model.texcoords[(k0 + k) * 2] = valid ? uvs[size_t(t) * 2] : 0.f;
+                    model.texcoords[(k0 + k) * 2 + 1] = valid ? uvs[size_t(t) * 2 + 1] : 0.f;
+                }
+                for (size_t f = 0; f < chunk.faceMaterials.size(); ++f)
+                {
+                    const int32_t local = chunk.faceMaterials[f];
+                    model.faceMaterials[k0 / 3 + f] = local < 0 ? startMaterial[c] : chunkMaterials[c][local];
+                } });
+            return true;
+        }
+    }
+
+    // Area-weighted face normals summed per vertex. Each task owns a range of vertices and adds the faces
+    // touching it, so no two tasks write the same vertex; reading all the indices per task is cheap.
+    void ComputeVertexNormals(MeshModel &model, int threads)
+    {
+        if (threads <= 0)
+            threads = ThreadBudget::limit();
+        const size_t vertices = model.vertexCount(), faces = model.faceCount();
+        model.nx.assign(vertices, 0.f);
+        model.ny.assign(vertices, 0.f);
+        model.nz.assign(vertices, 0.f);
+        const size_t tasks = std::max<size_t>(1, std::min<size_t>(size_t(threads), vertices / ItemsPerTask + 1));
+        parallelFor(tasks, threads, [&](size_t task)
+                    {
+            const uint32_t first = static_cast<uint32_t>(vertices * task / tasks), last = static_cast<uint32_t>(vertices * (task + 1) / tasks);
+            auto mine = [&](uint32_t v)
+            { return v >= first && v < last; };
+            for (size_t f = 0; f < faces; ++f)
+            {
+                const uint32_t *i = &model.indices[f * 3];
+                if (!mine(i[0]) && !mine(i[1]) && !mine(i[2]))
+                    continue;
+                const float e1[3] = {model.x[i[1]] - model.x[i[0]], model.y[i[1]] - model.y[i[0]], model.z[i[1]] - model.z[i[0]]};
+                const float e2[3] = {model.x[i[2]] - model.x[i[0]], model.y[i[2]] - model.y[i[0]], model.z[i[2]] - model.z[i[0]]};
+                const float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (!mine(i[k]))
+                        continue;
+                    model.nx[i[k]] += n[0];
+                    model.ny[i[k]] += n[1];
+                    model.nz[i[k]] += n[2];
+                }
+            }
+            for (uint32_t v = first; v < last; ++v)
+            {
+                const float length = std::sqrt(model.nx[v] * model.nx[v] + model.ny[v] * model.ny[v] + model.nz[v] * model.nz[v]);
+                if (length > 0)
+                {
+                    model.nx[v] /= length;
+                    model.ny[v] /= length;
+                    model.nz[v] /= length;
+                }
+            } });
+    }
+
+    bool LoadMeshModel(const std::string &path, MeshModel &model, std::string *error, int threads)
+    {
+        model = MeshModel();
+        if (threads <= 0)
+            threads = ThreadBudget::limit();
+        std::string extension = fs::path(path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        Bounds bounds;
+        bool loaded;
+        if (extension == ".obj")
+            loaded = loadObj(path, model, bounds, threads, error);
+        else if (extension == ".ply")
+            loaded = loadPly(path, model, bounds, threads, error);
+        else
+            return fail(error, "unsupported model format " + extension);
+        if (!loaded)
+            return false;
+        if (model.x.empty())
+            return fail(error, path + " has no vertices");
+
+        // faces pointing past the vertices would be read out of bounds by the renderer
+        const size_t vertices = model.vertexCount();
+        if (std::any_of(model.indices.begin(), model.indices.end(), [vertices](uint32_t i)
+                        { return i >= vertices; }))
+            return fail(error, path + " has faces with invalid vertex indices");
+
+        std::copy(bounds.min, bounds.min + 3, model.min);
+        std::copy(bounds.max, bounds.max + 3, model.max);
+        if (model.nx.empty() && !model.indices.empty())
+            ComputeVertexNormals(model, threads);
+        return true;
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// Loading of the models shown by the viewer and read by the conversion
+// tools: Wavefront OBJ with its MTL textures (the textured_mesh.obj written
+// by the texture stage) and PLY meshes or point clouds, ASCII or binary.
+//
+// The file is memory mapped and parsed in parallel chunks straight into one
+// array per vertex attribute (structure of arrays). Binary PLY vertices and
+// faces of a fixed size are split by index; text (ASCII PLY, OBJ) is cut at
+// line boundaries and the chunks are joined in file order. Bounds are taken
+// while decoding the vertices; vertex normals come from the file, or for a
+// mesh from its faces. Polygons are split into triangle fans.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VoxelForge
+{
+    struct MeshModel
+    {
+        std::vector<float> x, y, z;            // vertex positions
+        std::vector<float> nx, ny, nz;         // unit vertex normals, empty for a cloud without normals
+        std::vector<uint32_t> colors;          // per vertex 0xAARRGGBB, empty = no colours
+        std::vector<uint32_t> indices;         // 3 per face, empty = point cloud
+        std::vector<float> texcoords;          // u, v of each face corner (6 per face), empty = untextured
+        std::vector<uint16_t> faceMaterials;   // material of each face, with texcoords
+        std::vector<std::string> textures;     // diffuse image of each material, "" = none
+        double min[3] = {0, 0, 0};             // bounds of the vertices
+        double max[3] = {0, 0, 0};
+
+        size_t vertexCount() const { return x.size(); }
+        size_t faceCount() const { return indices.size() / 3; }
+    };
+
+    // .obj or .ply by extension; threads <= 0: ThreadBudget::limit(). error says why it failed
+    bool LoadMeshModel(const std::string &path, MeshModel &model, std::string *error = nullptr, int threads = 0);
+
+    // Area-weighted vertex normals of the faces (replaces nx, ny, nz); threads <= 0: ThreadBudget::limit()
+    void ComputeVertexNormals(MeshModel &model, int threads = 0);
+}
@@ -0,0 +1,480 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// CPU viewer of the 3D models page: point clouds and meshes
+
+#include "modelviewer.h"
+#include "model_io.hpp"
+#include "thread_budget.hpp"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QMetaObject>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QRunnable>
+#include <QWheelEvent>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+    const QColor Background(16, 14, 26);
+    const QColor MessageColor("#9b7dff");
+    constexpr double Pi = 3.14159265358979323846;
+    constexpr double FieldOfView = 50.0 * Pi / 180.0;
+    constexpr double MaxPitch = 1.5;
+    constexpr int MaxPendingNodes = 16;
+    constexpr uint64_t MinPointBudget = 250000;
+    constexpr uint64_t MaxPointBudget = 20000000;
+    constexpr uint64_t PointBudgetPerThread = 750000;
+    constexpr size_t SmallCloud = 200000; // drawn with larger points
+    constexpr double SlowFrameMs = 40;
+    constexpr double FastFrameMs = 20;
+
+    QString countText(double count)
+    {
+        if (count >= 1e6)
+            return QString::number(count / 1e6, 'f', 1) + " M";
+        if (count >= 1e3)
+            return QString::number(count / 1e3, 'f', 1) + " k";
+        return QString::number(count);
+    }
+}
+
+struct LoadedModel
+{
+    QString path;
+    VoxelForge::MeshModel mesh;                   // faces and vertices of a mesh
+    std::vector<VoxelForge::PlyPoint> points;     // cloud without LOD, shuffled so any prefix is a uniform sample
+    std::vector<QImage> images;                   // RGB32, pixels of textures
+    std::vector<VoxelForge::RasterTexture> textures;
+    bool hasLod = false;
+    VoxelForge::PointLod lod;
+    double min[3] = {0, 0, 0};
+    double max[3] = {0, 0, 0};
+};
+
+class ModelLoadTask : public QRunnable
+{
+public:
+    ModelLoadTask(ModelViewer *viewer, quint64 generation, const QString &path)
+        : viewer(viewer), generation(generation), path(path) {}
+
+    void run() override
+    {
+        // the parallel parse shares the budget with a running stage
+        const VoxelForge::ThreadLease lease(VoxelForge::ThreadBudget::share(2));
+        auto loaded = std::make_shared<LoadedModel>();
+        loaded->path = path;
+        QString error;
+        if (!load(*loaded, error, lease.count()))
+            loaded.reset();
+        ModelViewer *target = viewer;
+        const quint64 id = generation;
+        QMetaObject::invokeMethod(viewer, [target, id, loaded, error]
+                                  { target->modelReady(id, loaded, error); }, Qt::QueuedConnection);
+    }
+
+private:
+    bool load(LoadedModel &loaded, QString &error, int threads)
+    {
+        const std::string file = QFile::encodeName(path).toStdString();
+
+        // the LOD of a cloud, unless the cloud was written after it
+        if (QFileInfo(path).suffix().compare("ply", Qt::CaseInsensitive) == 0)
+        {
+            const std::string lodDir = VoxelForge::LodDirectoryFor(file);
+            const QFileInfo hierarchy(QFile::decodeName(lodDir.c_str()) + "/hierarchy.bin");
+            if (hierarchy.exists() && hierarchy.lastModified() >= QFileInfo(path).lastModified() &&
+                VoxelForge::ReadPointLod(lodDir, loaded.lod) && !loaded.lod.nodes.empty())
+            {
+                loaded.hasLod = true;
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    loaded.min[axis] = loaded.lod.header.cubeMin[axis];
+                    loaded.max[axis] = loaded.lod.header.cubeMin[axis] + loaded.lod.header.cubeSize;
+                }
+                return true;
+            }
+        }
+
+        std::string message;
+        VoxelForge::MeshModel &mesh = loaded.mesh;
+        if (!VoxelForge::LoadMeshModel(file, mesh, &message, threads))
+        {
+            error = QString::fromStdString(message);
+            return false;
+        }
+        std::copy(mesh.min, mesh.min + 3, loaded.min);
+        std::copy(mesh.max, mesh.max + 3, loaded.max);
+
+        if (mesh.indices.empty())
+        {
+            const size_t count = mesh.vertexCount();
+            loaded.points.resize(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                VoxelForge::PlyPoint &p = loaded.points[i];
+                p.x = mesh.x[i];
+                p.y = mesh.y[i];
+                p.z = mesh.z[i];
+                const uint32_t rgb = mesh.colors.empty() ? 0xFFFFFFFFu : mesh.colors[i];
+                p.r = static_cast<uint8_t>(rgb >> 16);
+                p.g = static_cast<uint8_t>(rgb >> 8);
+                p.b = static_cast<uint8_t>(rgb);
+                p.a = 255;
+            }
+            std::shuffle(loaded.points.begin(), loaded.points.end(), std::mt19937(1915));
+            mesh = VoxelForge::MeshModel();
+            return true;
+        }
+
+        // textures decoded here, off the GUI thread
+        for (const std::string &texture : mesh.textures)
+        {
+            QImage image;
+            if (!texture.empty())
+                image = QImage(QFile::decodeName(texture.c_str())).convertToFormat(QImage::Format_RGB32);
+            loaded.images.push_back(image);
+        }
+        for (const QImage &image : loaded.images)
+        {
+            VoxelForge::RasterTexture texture;
+            if (!image.isNull())
+            {
+                texture.width = image.width();
+                texture.height = image.height();
+                texture.pixels = reinterpret_cast<const uint32_t *>(image.constBits());
+            }
+            loaded.textures.push_back(texture);
+        }
+        return true;
+    }
+
+    ModelViewer *viewer;
+    quint64 generation;
+    QString path;
+};
+
+class LodNodeTask : public QRunnable
+{
+public:
+    LodNodeTask(ModelViewer *viewer, quint64 generation, std::shared_ptr<const LoadedModel> model, uint32_t node)
+        : viewer(viewer), generation(generation), model(std::move(model)), node(node) {}
+
+    void run() override
+    {
+        const VoxelForge::ThreadLease lease(1);
+        std::vector<VoxelForge::PlyPoint> points;
+        VoxelForge::ReadLodNodePoints(model->lod, model->lod.nodes[node], points);
+        ModelViewer *target = viewer;
+        const quint64 id = generation;
+        const uint32_t index = node;
+        QMetaObject::invokeMethod(viewer, [target, id, index, points = std::move(points)]() mutable
+                                  { target->nodeReady(id, index, std::move(points)); }, Qt::QueuedConnection);
+    }
+
+private:
+    ModelViewer *viewer;
+    quint64 generation;
+    std::shared_ptr<const LoadedModel> model;
+    uint32_t node;
+};
+
+ModelViewer::ModelViewer(QWidget *parent)
+    : QWidget(parent), message("No model loaded\n\nSelect a model from the list and click 'Open Model'")
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    // node reads are I/O, two keep the disk busy (a single one on a 1-thread budget)
+    pool.setMaxThreadCount(qMin(2, VoxelForge::ThreadBudget::limit()));
+}
+
+ModelViewer::~ModelViewer()
+{
+    ++generation;
+    pool.clear();
+    pool.waitForDone();
+}
+
+void ModelViewer::openModel(const QString &path)
+{
+    clearModel();
+    loadingPath = path;
+    message = "Loading " + QFileInfo(path).fileName() + " ...";
+    // the budget may have changed on the Settings page
+    rasterizer.setThreads(0);
+    pool.start(new ModelLoadTask(this, generation, path));
+    update();
+}
+
+void ModelViewer::clearModel()
+{
+    ++generation;
+    pool.clear();
+    model.reset();
+    nodes.clear();
+    pendingNodes.clear();
+    cachedPoints = 0;
+    loadingPath.clear();
+    message = "No model loaded";
+    update();
+}
+
+void ModelViewer::modelReady(quint64 id, std::shared_ptr<const LoadedModel> loaded, const QString &error)
+{
+    if (id != generation)
+        return;
+    const QString path = loadingPath;
+    loadingPath.clear();
+    if (!loaded)
+    {
+        message = "Cannot display " + QFileInfo(path).fileName() + "\n\n" + error;
+        update();
+        emit modelLoaded(path, false, error);
+        return;
+    }
+    model = std::move(loaded);
+    const uint64_t threads = static_cast<uint64_t>(VoxelForge::ThreadBudget::limit());
+    pointBudget = std::min(MaxPointBudget, std::max<uint64_t>(MinPointBudget * 4, threads * PointBudgetPerThread));
+    frameModel();
+    update();
+    emit modelLoaded(path, true, QString());
+}
+
+void ModelViewer::nodeReady(quint64 id, uint32_t node, std::vector<VoxelForge::PlyPoint> points)
+{
+    if (id != generation)
+        return;
+    pendingNodes.erase(node);
+    // a node that could not be read stays empty instead of being requested again
+    cachedPoints += points.size();
+    CachedNode &cached = nodes[node];
+    cached.points = std::move(points);
+    cached.lastFrame = frame;
+    update();
+}
+
+void ModelViewer::frameModel()
+{
+    if (!model)
+        return;
+    double extent2 = 0;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        target[axis] = (model->min[axis] + model->max[axis]) / 2;
+        extent2 += (model->max[axis] - model->min[axis]) * (model->max[axis] - model->min[axis]);
+    }
+    radius = std::max(1e-6, std::sqrt(extent2) / 2);
+    distance = radius / std::sin(FieldOfView / 2) * 1.05;
+    // from behind the first camera of the reconstruction, a bit above
+    yaw = Pi;
+    pitch = 0.35;
+}
+
+void ModelViewer::makeView(VoxelForge::RasterView &view, double &focalPixels) const
+{
+    const double offset[3] = {std::cos(pitch) * std::sin(yaw), -std::sin(pitch), std::cos(pitch) * std::cos(yaw)};
+    for (int axis = 0; axis < 3; ++axis)
+        view.eye[axis] = target[axis] + distance * offset[axis];
+    const double up[3] = {0, -1, 0};
+    const double nearPlane = std::max(distance * 0.01, radius * 1e-6);
+    const double farPlane = distance + radius * 4;
+    VoxelForge::MakeViewProjection(view.eye, target, up, FieldOfView, double(std::max(1, width())) / std::max(1, height()),
+                                   nearPlane, farPlane, view.viewProj);
+    focalPixels = std::max(1, height()) / 2.0 / std::tan(FieldOfView / 2);
+}
+
+void ModelViewer::streamNodes(const VoxelForge::RasterView &view, double focalPixels, std::vector<VoxelForge::PointSpan> &spans)
+{
+    VoxelForge::LodView lodView;
+    std::copy(view.viewProj, view.viewProj + 16, lodView.viewProj);
+    std::copy(view.eye, view.eye + 3, lodView.eye);
+    lodView.focalPixels = focalPixels;
+    lodView.pointBudget = pointBudget;
+    const std::vector<uint32_t> selection = VoxelForge::SelectLodNodes(model->lod, lodView);
+
+    // coarsest first: the parents of a missing node are drawn until it arrives
+    for (const uint32_t index : selection)
+    {
+        const auto cached = nodes.find(index);
+        if (cached != nodes.end())
+        {
+            cached->second.lastFrame = frame;
+            spans.push_back({cached->second.points.data(), cached->second.points.size()});
+            framePoints += cached->second.points.size();
+            ++frameNodes;
+        }
+        else if (pendingNodes.size() < MaxPendingNodes && pendingNodes.insert(index).second)
+        {
+            pool.start(new LodNodeTask(this, generation, model, index));
+        }
+    }
+    evictNodes();
+}
+
+void ModelViewer::evictNodes()
+{
+    // nodes out of the view go first, least recently drawn first
+    if (cachedPoints <= pointBudget * 3)
+        return;
+    std::vector<std::pair<quint64, uint32_t>> unused;
+    for (const auto &entry : nodes)
+        if (entry.second.lastFrame != frame)
+            unused.emplace_back(entry.second.lastFrame, entry.first);
+    std::sort(unused.begin(), unused.end());
+    for (const auto &entry : unused)
+    {
+        if (cachedPoints <= pointBudget * 2)
+            break;
+        const auto node = nodes.find(entry.second);
+        cachedPoints -= node->second.points.size();
+        nodes.erase(node);
+    }
+}
+
+void ModelViewer::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    if (!model)
+    {
+        painter.fillRect(rect(), Background);
+        painter.setPen(MessageColor);
+        QFont font = painter.font();
+        font.setPixelSize(16);
+        painter.setFont(font);
+        painter.drawText(rect().adjusted(20, 20, -20, -20), Qt::AlignCenter | Qt::TextWordWrap, message);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    if (rasterizer.width() != width() || rasterizer.height() != height())
+        rasterizer.resize(width(), height());
+    rasterizer.clear(Background.rgb());
+    VoxelForge::RasterView view;
+    double focalPixels;
+    makeView(view, focalPixels);
+    ++frame;
+    framePoints = 0;
+    frameNodes = 0;
+
+    bool budgetLimited = false;
+    QString stats;
+    if (model->hasLod)
+    {
+        std::vector<VoxelForge::PointSpan> spans;
+        streamNodes(view, focalPixels, spans);
+        rasterizer.drawPoints(view, spans, model->lod.header.points < SmallCloud ? 3 : 2);
+        budgetLimited = framePoints >= pointBudget * 9 / 10;
+        stats = countText(double(framePoints)) + " of " + countText(double(model->lod.header.points)) + " points, " +
+                QString::number(frameNodes) + " nodes" +
+                (pendingNodes.empty() ? QString() : QString(" (%1 loading)").arg(pendingNodes.size()));
+    }
+    else if (!model->points.empty())
+    {
+        framePoints = std::min<uint64_t>(model->points.size(), pointBudget);
+        rasterizer.drawPoints(view, {{model->points.data(), static_cast<size_t>(framePoints)}}, model->points.size() < SmallCloud ? 3 : 2);
+        budgetLimited = framePoints < model->points.size();
+        stats = countText(double(framePoints)) + " of " + countText(double(model->points.size())) + " points";
+    }
+    else
+    {
+        const VoxelForge::MeshModel &mesh = model->mesh;
+        VoxelForge::RasterMesh raster;
+        raster.x = mesh.x.data();
+        raster.y = mesh.y.data();
+        raster.z = mesh.z.data();
+        if (!mesh.nx.empty())
+        {
+            raster.nx = mesh.nx.data();
+            raster.ny = mesh.ny.data();
+            raster.nz = mesh.nz.data();
+        }
+        raster.vertexCount = mesh.vertexCount();
+        raster.indices = mesh.indices.data();
+        raster.faceCount = mesh.faceCount();
+        raster.colors = mesh.colors.empty() ? nullptr : mesh.colors.data();
+        raster.texcoords = mesh.texcoords.empty() ? nullptr : mesh.texcoords.data();
+        raster.faceTextures = mesh.faceMaterials.empty() ? nullptr : mesh.faceMaterials.data();
+        raster.textures = model->textures.data();
+        raster.textureCount = model->textures.size();
+        rasterizer.drawMesh(view, raster);
+        stats = countText(double(mesh.faceCount())) + " faces" + (model->textures.empty() ? QString() : QString(", textured"));
+    }
+
+    const QImage image(reinterpret_cast<const uchar *>(rasterizer.pixels()), rasterizer.width(), rasterizer.height(), QImage::Format_RGB32);
+    painter.drawImage(0, 0, image);
+    lastFrameMs = timer.nsecsElapsed() / 1e6;
+
+    painter.setPen(QColor(234, 234, 234));
+    painter.drawText(rect().adjusted(10, 8, -10, -8), Qt::AlignLeft | Qt::AlignBottom,
+                     QFileInfo(model->path).fileName() + "   " + stats + "   " + QString::number(lastFrameMs, 'f', 0) + " ms");
+
+    // fewer points when frames get slow, more while they are fast and the budget cuts detail
+    if (lastFrameMs > SlowFrameMs)
+    {
+        pointBudget = std::max(MinPointBudget, pointBudget * 4 / 5);
+    }
+    else if (lastFrameMs < FastFrameMs && budgetLimited && pointBudget < MaxPointBudget)
+    {
+        pointBudget = std::min(MaxPointBudget, pointBudget * 5 / 4);
+        update();
+    }
+}
+
+void ModelViewer::mousePressEvent(QMouseEvent *event)
+{
+    lastMouse = event->pos();
+    dragButton = event->button();
+}
+
+void ModelViewer::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!model || dragButton == Qt::NoButton)
+        return;
+    const QPoint delta = event->pos() - lastMouse;
+    lastMouse = event->pos();
+    if (dragButton == Qt::LeftButton)
+    {
+        yaw -= delta.x() * 0.008;
+        pitch = std::max(-MaxPitch, std::min(MaxPitch, pitch + delta.y() * 0.008));
+    }
+    else
+    {
+        // the point under the cursor follows it (at the depth of the target)
+        const double offset[3] = {std::cos(pitch) * std::sin(yaw), -std::sin(pitch), std::cos(pitch) * std::cos(yaw)};
+        const double up[3] = {0, -1, 0};
+        double right[3] = {-offset[1] * up[2] + offset[2] * up[1], -offset[2] * up[0] + offset[0] * up[2], -offset[0] * up[1] + offset[1] * up[0]};
+        const double length = std::sqrt(right[0] * right[0] + right[1] * right[1] + right[2] * right[2]);
+        for (double &value : right)
+            value /= length;
+        const double cameraUp[3] = {right[1] * -offset[2] - right[2] * -offset[1], right[2] * -offset[0] - right[0] * -offset[2],
+                                    right[0] * -offset[1] - right[1] * -offset[0]};
+        const double scale = 2 * distance * std::tan(FieldOfView / 2) / std::max(1, height());
+        for (int axis = 0; axis < 3; ++axis)
+            target[axis] += (-right[axis] * delta.x() + cameraUp[axis] * delta.y()) * scale;
+    }
+    update();
+}
+
+void ModelViewer::mouseReleaseEvent(QMouseEvent *)
+{
+    dragButton = Qt::NoButton;
+}
+
+void ModelViewer::mouseDoubleClickEvent(QMouseEvent *)
+{
+    frameModel();
+    update();
+}
+
+void ModelViewer::wheelEvent(QWheelEvent *event)
+{
+    if (!model)
+        return;
+    distance = std::max(radius * 1e-4, distance * std::pow(0.85, event->angleDelta().y() / 120.0));
+    update();
+}
@@ -0,0 +1,99 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// CPU viewer of the 3D models page: point clouds and meshes
+
+#ifndef MODELVIEWER_H
+#define MODELVIEWER_H
+
+#include "point_lod.hpp"
+#include "soft_raster.hpp"
+
+#include <QPoint>
+#include <QString>
+#include <QThreadPool>
+#include <QWidget>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct LoadedModel;
+
+// Draws a model with the software rasterizer (soft_raster.hpp), so it needs
+// no GPU. Meshes and clouds without a LOD are loaded whole in the background.
+// A cloud with a point LOD folder (point_lod.hpp) streams its octree nodes:
+// each frame selects the nodes the view needs by their point spacing on
+// screen, draws those already loaded and requests the rest coarsest first,
+// so the cloud shows at once and sharpens as nodes arrive. The point budget
+// of a frame adapts to keep the frame time interactive.
+//
+// Left drag orbits, right or middle drag pans, the wheel zooms and a double
+// click frames the whole model.
+class ModelViewer : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ModelViewer(QWidget *parent = nullptr);
+    ~ModelViewer() override;
+
+    // Loads in the background; modelLoaded tells when it is shown or why it failed
+    void openModel(const QString &path);
+    void clearModel();
+
+signals:
+    void modelLoaded(const QString &path, bool ok, const QString &error);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+
+private:
+    friend class ModelLoadTask;
+    friend class LodNodeTask;
+
+    struct CachedNode
+    {
+        std::vector<VoxelForge::PlyPoint> points;
+        quint64 lastFrame = 0;
+    };
+
+    void modelReady(quint64 generation, std::shared_ptr<const LoadedModel> loaded, const QString &error);
+    void nodeReady(quint64 generation, uint32_t node, std::vector<VoxelForge::PlyPoint> points);
+    void frameModel();
+    void makeView(VoxelForge::RasterView &view, double &focalPixels) const;
+    // spans of the LOD nodes to draw; requests the missing ones
+    void streamNodes(const VoxelForge::RasterView &view, double focalPixels, std::vector<VoxelForge::PointSpan> &spans);
+    void evictNodes();
+
+    VoxelForge::SoftRasterizer rasterizer;
+    QThreadPool pool;
+    quint64 generation = 0;
+    QString loadingPath;
+    QString message;
+    std::shared_ptr<const LoadedModel> model;
+
+    // LOD streaming
+    std::unordered_map<uint32_t, CachedNode> nodes;
+    std::unordered_set<uint32_t> pendingNodes;
+    size_t cachedPoints = 0;
+    quint64 frame = 0;
+    uint64_t pointBudget = 0;
+    uint64_t framePoints = 0;
+    size_t frameNodes = 0;
+
+    // orbit camera around target; the model's y axis points down (openMVG keeps the first camera's axes)
+    double target[3] = {0, 0, 0};
+    double distance = 1;
+    double yaw = 0;
+    double pitch = 0;
+    double radius = 1;
+    QPoint lastMouse;
+    Qt::MouseButton dragButton = Qt::NoButton;
+    double lastFrameMs = 0;
+};
+
+#endif // MODELVIEWER_H
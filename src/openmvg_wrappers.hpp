@@ -1,5 +1,6 @@
 #pragma once // helps prevent multiple inclusions into same src code
 
+#include <atomic>
 #include <string>
 #include <functional>
 
@@ -8,11 +9,22 @@ namespace OpenMVG_Wrappers
 
     using LogCallback = std::function<void(const std::string&)>;
 
+    // fraction in [0, 1] of the current step ("- Matching -", ...); throttled, may be called from worker threads
+    using ProgressCallback = std::function<void(double fraction, const std::string &step)>;
+
+    // Every Run* takes an optional progress callback and cancel flag after the log callback.
+    // When *cancel becomes true the wrapper stops after the item in progress (one image, one
+    // image pair, ...) and returns false without writing partial results.
+    // A Run* with iNumThreads uses that many threads, 0 = the thread count of the caller's lease
+    // (StageThreads in thread_budget.hpp).
+
     bool RunImageListing(
         const std::string &sImageDir,
         const std::string &sOutputDir,
         const std::string &sSensorDb = "",
         LogCallback logCallback = nullptr,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool> *cancel = nullptr,
         // optional (read docs bro :)) https://openmvg.readthedocs.io/en/latest/software/SfM/SfMInit_ImageListing/#:~:text=Required%20parameters%3A
         double focal_pixels = -1.0,
         const std::string &sKmatrix = "",
@@ -28,6 +40,8 @@ namespace OpenMVG_Wrappers
         std::string sSfM_Data_Filename,
         std::string sOutDir = "",
         LogCallback logCallback = nullptr,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool> *cancel = nullptr,
 
         // optional
         std::string sImage_Describer_Method = "SIFT_ANATOMY", // its free version :) SIFT is non-free and  vcpkg does not support non-free modules
@@ -41,6 +55,8 @@ namespace OpenMVG_Wrappers
         std::string sSfM_Data_Filename,
         std::string sOutputMatchesFilename,
         LogCallback logCallback = nullptr,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool> *cancel = nullptr,
         // optional
         float fDistRatio = 0.8f,
         std::string sPredefinedPairList = "",
@@ -48,7 +64,11 @@ namespace OpenMVG_Wrappers
         bool bForce = false,
         unsigned int ui_max_cache_size = 0,
         unsigned int ui_preemptive_feature_count = 0,
-        double preemptive_matching_percentage_threshold = 0.08
+        double preemptive_matching_percentage_threshold = 0.08,
+        bool bExportReports = true, // RunExportMatchesReports(..., "Putative") once matching is done
+        // with ui_max_cache_size == 0: regions budget, above it the pairs are matched in tiles through
+        // a Regions_Provider_Cache (regions_budget.hpp); 0 = half the physical memory
+        unsigned int ui_memory_budget_mb = 0
     );
 
     bool RunGeometricFilter(
@@ -56,6 +76,8 @@ namespace OpenMVG_Wrappers
         std::string sPutativeMatchesFilename,
         std::string sFilteredMatchesFilename,
         LogCallback logCallback = nullptr,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool> *cancel = nullptr,
         // optional
         std::string sInputPairsFilename = "",
         std::string sOutputPairsFilename = "",
@@ -63,6 +85,134 @@ namespace OpenMVG_Wrappers
         bool bForce = false,
         bool bGuided_matching = false,
         int imax_iteration = 2048,
-        unsigned int ui_max_cache_size = 0
+        unsigned int ui_max_cache_size = 0,
+        bool bExportReports = true, // RunExportMatchesReports(..., "Geometric") once filtering is done
+        unsigned int ui_memory_budget_mb = 0 // as in RunComputeMatches
+    );
+
+    // View graph statistics, <Name>AdjacencyMatrix.svg and <name>_matches graphviz files
+    // next to the matches file (sReportName: "Putative", "Geometric")
+    bool RunExportMatchesReports(
+        std::string sSfM_Data_Filename,
+        std::string sMatchesFilename,
+        std::string sReportName,
+        LogCallback logCallback = nullptr
+    );
+
+    bool RunGlobalSfM(
+        std::string sSfM_Data_Filename,
+        std::string sMatchesDir,
+        std::string sOutDir,
+        LogCallback logCallback = nullptr,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool> *cancel = nullptr,
+        // optional
+        std::string sMatchesFilename = "", // defaults to <sMatchesDir>/matches.f.bin
+        std::string sIntrinsic_refinement_options = "ADJUST_ALL",
+        int iRotationAveragingMethod = 2,    // ROTATION_AVERAGING_L2
+        int iTranslationAveragingMethod = 3, // TRANSLATION_AVERAGING_SOFTL1
+        bool b_use_motion_priors = false
+    );
+
+    // OpenMVS scene (scene.mvs) of a reconstruction: pinhole platforms, calibrated views and the
+    // landmarks seen by two of them. The images are undistorted into sUndistortedDir in parallel;
+    // an image whose source and camera model did not change since the last export is kept
+    bool RunExportToMVS(
+        std::string sSfM_Data_Filename,   // reconstruction/sfm_data.bin
+        std::string sOutSceneFile,
+        std::string sUndistortedDir,
+        LogCallback logCallback = nullptr,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool> *cancel = nullptr,
+        // optional
+        int iNumThreads = 0
+    );
+
+    struct DensifyOptions
+    {
+        unsigned resolutionLevel = 1;   // depth maps of images scaled down 2^level times
+        unsigned maxResolution = 2560;  // largest side of a depth map, after the level
+        unsigned minResolution = 640;   // smallest side of a depth map
+        unsigned numViews = 8;          // neighbour views per depth map, 0 = all
+        unsigned minViewsFuse = 2;      // depth maps agreeing on a point to keep it
+        // depth-map estimation and fusion; above it the scene is densified in overlapping spatial
+        // chunks (spatial_partition.hpp), 0 = half the physical memory
+        unsigned memoryBudgetMB = 0;
+    };
+
+    // OpenMVS DenseReconstruction of scene.mvs (RunExportToMVS) in-process. Depth maps are written
+    // to sWorkingDir as they are computed and reused by a rerun (bForce discards them)
+    bool RunDensify(
+        std::string sSceneFile,
+        std::string sWorkingDir,
+        std::string sOutDenseScene, // scene with the dense point cloud, input of the mesh stages
+        std::string sOutDensePly,
+        LogCallback logCallback = nullptr,
+        ProgressCallback progressCallback = nullptr, // per view (depth maps on disk)
+        const std::atomic<bool> *cancel = nullptr,   // OpenMVS has no cancel hook: stops after the running chunk
+        // optional
+        DensifyOptions options = DensifyOptions(),
+        bool bForce = false,
+        int iNumThreads = 0
+    );
+
+    struct MeshOptions
+    {
+        float minPointDistance = 2.5f; // reconstruct: dense points closer than this (pixels) in a view are merged
+        unsigned smoothSteps = 2;      // reconstruct: smoothing passes of the cleaned mesh
+        unsigned refineResolutionLevel = 1; // refine: images scaled down 2^level times
+        unsigned refineMaxViews = 8;        // refine: views per vertex, 0 = all
+        unsigned refineScales = 2;          // refine: coarse to fine passes
+        unsigned textureResolutionLevel = 0; // texture: images scaled down 2^level times
+        unsigned minResolution = 640;        // refine / texture: smallest side of a scaled image
+        // reconstruct: tetrahedralization of the dense points; above it the cloud is meshed in spatial
+        // chunks (spatial_partition.hpp) welded at their seams, 0 = half the physical memory
+        unsigned memoryBudgetMB = 0;
+    };
+
+    // Surface of the dense point cloud (Delaunay tetrahedralization + graph cut), cleaned.
+    // The mesh is written with its scene; RunRefineMesh and RunTextureMesh read both
+    bool RunReconstructMesh(
+        std::string sDenseScene,     // dense/scene_dense.mvs (RunDensify)
+        std::string sDensePly,       // dense/scene_dense.ply, streamed when the cloud is meshed in chunks
+        std::string sWorkingDir,
+        std::string sOutMeshScene,
+        std::string sOutMeshPly,
+        LogCallback logCallback = nullptr,
+        ProgressCallback progressCallback = nullptr, // per step: OpenMVS reports nothing inside one
+        const std::atomic<bool> *cancel = nullptr,   // checked between steps
+        // optional
+        MeshOptions options = MeshOptions(),
+        int iNumThreads = 0
+    );
+
+    // Photometric refinement of the mesh of RunReconstructMesh against the undistorted images
+    bool RunRefineMesh(
+        std::string sMeshScene,
+        std::string sMeshPly,
+        std::string sWorkingDir,
+        std::string sOutMeshScene,
+        std::string sOutMeshPly,
+        LogCallback logCallback = nullptr,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool> *cancel = nullptr,
+        // optional
+        MeshOptions options = MeshOptions(),
+        int iNumThreads = 0
+    );
+
+    // Texture atlas of the refined mesh; sOutModel (.obj: with its .mtl and texture images
+    // next to it, or .ply) is the model shown by the 3D models page
+    bool RunTextureMesh(
+        std::string sMeshScene,
+        std::string sMeshPly,
+        std::string sWorkingDir,
+        std::string sOutModel,
+        LogCallback logCallback = nullptr,
+        ProgressCallback progressCallback = nullptr,
+        const std::atomic<bool> *cancel = nullptr,
+        // optional
+        MeshOptions options = MeshOptions(),
+        int iNumThreads = 0
     );
 }
@@ -0,0 +1,28 @@
+#include "openmvs_session.hpp"
+
+// OpenMVS
+#include <openmvs/MVS.h>
+
+#undef D2R
+#undef R2D
+
+#include <filesystem>
+
+namespace OpenMVG_Wrappers
+{
+    namespace
+    {
+        std::mutex mvsLock;
+        std::once_flag mvsInitialized;
+    }
+
+    std::unique_lock<std::mutex> LockOpenMVS(const std::string &sWorkingDir)
+    {
+        std::unique_lock<std::mutex> guard(mvsLock);
+        std::call_once(mvsInitialized, []
+                       { MVS::Initialize(_T("Voxel-Forge"), 0, 0); });
+        WORKING_FOLDER = std::filesystem::absolute(sWorkingDir).lexically_normal().generic_string() + "/";
+        INIT_WORKING_FOLDER;
+        return guard;
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// OpenMVS keeps its options (OPTDENSE, ...) and its working folder in process
+// globals. The OpenMVS stages (densify, mesh reconstruction, refinement and
+// texturing) hold this lock while they use them, so they run one at a time.
+//
+// Image paths of a scene are resolved against the working folder: the stages
+// keep their working folders side by side in output/ (dense/, mesh/) so the
+// relative paths OpenMVS saves stay valid for the next stage.
+
+#include <mutex>
+#include <string>
+
+namespace OpenMVG_Wrappers
+{
+    // Initializes OpenMVS (once per process), takes the lock and points WORKING_FOLDER at
+    // sWorkingDir (an existing folder, made absolute)
+    std::unique_lock<std::mutex> LockOpenMVS(const std::string &sWorkingDir);
+}
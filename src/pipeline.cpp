@@ -0,0 +1,426 @@
+#include "pipeline.hpp"
+#include "stage_graph.hpp"
+#include "telemetry.hpp"
+#include "thread_budget.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <mutex>
+
+namespace VoxelForge
+{
+    const char *StageName(Stage stage)
+    {
+        switch (stage)
+        {
+        case Stage::ImageListing: return "ImageListing";
+        case Stage::ComputeFeatures: return "ComputeFeatures";
+        case Stage::ComputeMatches: return "ComputeMatches";
+        case Stage::GeometricFilter: return "GeometricFilter";
+        case Stage::GlobalSfM: return "GlobalSfM";
+        case Stage::ExportToMVS: return "ExportToMVS";
+        case Stage::Densify: return "Densify";
+        case Stage::ReconstructMesh: return "ReconstructMesh";
+        case Stage::RefineMesh: return "RefineMesh";
+        case Stage::TextureMesh: return "TextureMesh";
+        case Stage::MeshLod: return "MeshLod";
+        }
+        return "";
+    }
+
+    bool StageFromName(const std::string &name, Stage &stage)
+    {
+        for (int i = 0; i <= static_cast<int>(Pipeline::LastStage); ++i)
+        {
+            if (name == StageName(Stage(i)))
+            {
+                stage = Stage(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string DefaultSensorDatabase()
+    {
+        if (const char *fromEnv = std::getenv("VOXELFORGE_SENSOR_DB"))
+        {
+            if (*fromEnv)
+                return fromEnv;
+        }
+#ifdef VOXELFORGE_SENSOR_DB
+        return VOXELFORGE_SENSOR_DB;
+#else
+        return std::string();
+#endif
+    }
+
+    PipelinePaths::PipelinePaths(const std::string &projectPath)
+        : images(projectPath + "/images"),
+          output(projectPath + "/output"),
+          matches(output + "/matches"),
+          reconstruction(output + "/reconstruction"),
+          sfmData(matches + "/sfm_data.json"),
+          putativeMatches(matches + "/matches.putative.bin"),
+          filteredMatches(matches + "/matches.f.bin"),
+          sfmResult(reconstruction + "/sfm_data.bin"),
+          mvsScene(output + "/scene.mvs"),
+          undistortedImages(output + "/undistorted_images"),
+          dense(output + "/dense"),
+          denseScene(dense + "/scene_dense.mvs"),
+          densePly(dense + "/scene_dense.ply"),
+          sparsePly(reconstruction + "/cloud_and_poses.ply"),
+          sparseLod(LodDirectoryFor(sparsePly)),
+          denseLod(LodDirectoryFor(densePly)),
+          mesh(output + "/mesh"),
+          meshScene(mesh + "/scene_mesh.mvs"),
+          meshPly(mesh + "/scene_mesh.ply"),
+          refinedScene(mesh + "/scene_mesh_refine.mvs"),
+          refinedPly(mesh + "/scene_mesh_refine.ply"),
+          finalModels(projectPath + "/final_3d_models"),
+          texturedModel(finalModels + "/textured_mesh.obj"),
+          texturedLods(finalModels + "/textured_mesh_lod"),
+          runReport(output + "/run_report.json"),
+          runTrace(output + "/run_trace.json"),
+          stamps(output + "/.stamps")
+    {
+    }
+
+    Pipeline::Pipeline(const PipelineConfig &config)
+        : cfg(config), dirs(config.projectPath), cancelRequest(false)
+    {
+        if (cfg.sensorDatabase.empty())
+            cfg.sensorDatabase = DefaultSensorDatabase();
+        if (cfg.lastStage > LastStage)
+            cfg.lastStage = LastStage;
+    }
+
+    bool Pipeline::run(const PipelineCallbacks &callbacks)
+    {
+        // steps may log from two threads at once (report exports overlap the next stage)
+        std::mutex logLock;
+        const OpenMVG_Wrappers::LogCallback logCb = [&](const std::string &msg)
+        {
+            std::lock_guard<std::mutex> guard(logLock);
+            if (callbacks.log)
+                callbacks.log(msg);
+        };
+        auto LOG = [&](const std::string &msg)
+        {
+            logCb(msg);
+        };
+
+        std::error_code ec;
+        std::filesystem::create_directories(dirs.matches, ec);
+        std::filesystem::create_directories(dirs.reconstruction, ec);
+        if (ec)
+        {
+            LOG("ERROR: Cannot create output folders in " + dirs.output + ": " + ec.message());
+            return false;
+        }
+
+        LOG("=== Starting OpenMVG/OpenMVS Pipeline ===");
+        LOG("Project path: " + cfg.projectPath);
+        LOG("Image path: " + dirs.images);
+        LOG("Output path: " + dirs.output);
+        LOG("Sensor database: " + (cfg.sensorDatabase.empty() ? std::string("<none>") : cfg.sensorDatabase));
+
+        // the Run* wrappers report their TelemetryScope to this session
+        TelemetrySession telemetry;
+        telemetry.setInfo("project", cfg.projectPath);
+        telemetry.setInfo("describer", cfg.describerMethod);
+        telemetry.setInfo("feature_preset", cfg.featurePreset);
+        telemetry.setInfo("threads", std::to_string(cfg.numThreads));
+        telemetry.setInfo("thread_budget", std::to_string(ThreadBudget::limit()) + "/" + std::to_string(ThreadBudget::available()));
+        telemetry.setInfo("matching_method", cfg.nearestMatchingMethod);
+        telemetry.setInfo("geometric_model", cfg.geometricModel);
+        telemetry.setInfo("memory_budget_mb", std::to_string(cfg.memoryBudgetMB));
+        telemetry.setInfo("last_stage", StageName(cfg.lastStage));
+        if (cfg.lastStage >= Stage::Densify)
+            telemetry.setInfo("densify", "level=" + std::to_string(cfg.densifyResolutionLevel) + ";views=" + std::to_string(cfg.densifyNumViews));
+        telemetry.install();
+
+        // Stage nodes report through the stage callbacks, the other nodes only log
+        struct StageInfo
+        {
+            Stage stage;
+            int index;
+            std::string title;
+        };
+        std::map<std::string, StageInfo> stageNodes;
+
+        auto progressOf = [&](Stage stage) -> OpenMVG_Wrappers::ProgressCallback
+        {
+            if (!callbacks.stageProgress)
+                return nullptr;
+            return [&callbacks, stage](double fraction, const std::string &step)
+            { callbacks.stageProgress(stage, fraction, step); };
+        };
+
+        StageGraph graph(dirs.stamps);
+        // run gets the thread count of the stage's lease, taken out of the process budget
+        // (OpenMP regions of the stage's thread are set to it too)
+        auto addStage = [&](Stage stage, int index, const std::string &title, StageNode node,
+                            std::function<bool(bool force, int threads)> run)
+        {
+            if (stage > cfg.lastStage)
+                return;
+            node.name = StageName(stage);
+            stageNodes[node.name] = StageInfo{stage, index, title};
+            node.run = [this, run = std::move(run)](bool force)
+            {
+                const ThreadLease threads(cfg.numThreads);
+                threads.applyToCurrentThread();
+                return run(force, threads.count());
+            };
+            graph.add(std::move(node));
+        };
+
+        const std::string features = dirs.matches + "/*.feat";
+        const std::string descriptors = dirs.matches + "/*.desc";
+        const std::string describer = dirs.matches + "/image_describer.json";
+
+        // parameters: everything that changes the outputs (thread counts and memory budget do not)
+        std::vector<std::string> listingInputs = {dirs.images};
+        if (!cfg.sensorDatabase.empty())
+            listingInputs.push_back(cfg.sensorDatabase);
+        addStage(Stage::ImageListing, 1, "Image listing",
+                 {"", listingInputs, {dirs.sfmData}, "focal=-1;camera_model=3;group=1", {}}, [&](bool, int)
+                  { return OpenMVG_Wrappers::RunImageListing(dirs.images, dirs.matches, cfg.sensorDatabase, logCb,
+                                                           progressOf(Stage::ImageListing), &cancelRequest); });
+
+        addStage(Stage::ComputeFeatures, 2, "Feature computation",
+                 {"", {dirs.sfmData}, {describer, features, descriptors},
+                  "describer=" + cfg.describerMethod + ";preset=" + cfg.featurePreset + ";upright=0", {}}, [&](bool force, int threads)
+                  { return OpenMVG_Wrappers::RunComputeFeatures(
+                        dirs.sfmData, dirs.matches, logCb, progressOf(Stage::ComputeFeatures), &cancelRequest,
+                        cfg.describerMethod, false, force, cfg.featurePreset, threads); });
+
+        addStage(Stage::ComputeMatches, 3, "Match computation",
+                 {"", {dirs.sfmData, describer, features, descriptors}, {dirs.putativeMatches},
+                  "ratio=" + std::to_string(cfg.distanceRatio) + ";method=" + cfg.nearestMatchingMethod, {}}, [&](bool force, int)
+                  { return OpenMVG_Wrappers::RunComputeMatches(
+                        dirs.sfmData, dirs.putativeMatches, logCb, progressOf(Stage::ComputeMatches), &cancelRequest,
+                        cfg.distanceRatio, "", cfg.nearestMatchingMethod, force, 0, 0, 0.08, false, cfg.memoryBudgetMB); });
+
+        addStage(Stage::GeometricFilter, 4, "Geometric filtering",
+                 {"", {dirs.sfmData, describer, features, descriptors, dirs.putativeMatches}, {dirs.filteredMatches},
+                  "model=" + cfg.geometricModel + ";guided=0;iterations=2048", {}}, [&](bool force, int)
+                  { return OpenMVG_Wrappers::RunGeometricFilter(
+                        dirs.sfmData, dirs.putativeMatches, dirs.filteredMatches, logCb,
+                        progressOf(Stage::GeometricFilter), &cancelRequest,
+                        "", "", cfg.geometricModel, force, false, 2048, 0, false, cfg.memoryBudgetMB); });
+
+        addStage(Stage::GlobalSfM, 5, "Global Structure-from-Motion reconstruction",
+                 {"", {dirs.sfmData, describer, features, dirs.filteredMatches},
+                  {dirs.sfmResult, dirs.sparsePly},
+                  "refinement=" + cfg.intrinsicRefinement + ";rotation=2;translation=3", {}}, [&](bool, int)
+                  { return OpenMVG_Wrappers::RunGlobalSfM(
+                        dirs.sfmData, dirs.matches, dirs.reconstruction, logCb,
+                        progressOf(Stage::GlobalSfM), &cancelRequest,
+                        dirs.filteredMatches, cfg.intrinsicRefinement); });
+
+        // undistorted images are part of the output: an edited one is undistorted again
+        addStage(Stage::ExportToMVS, 6, "Export to OpenMVS",
+                 {"", {dirs.sfmResult, dirs.images}, {dirs.mvsScene, dirs.undistortedImages}, "fill=black;format=jpeg95", {}}, [&](bool, int threads)
+                  { return OpenMVG_Wrappers::RunExportToMVS(
+                        dirs.sfmResult, dirs.mvsScene, dirs.undistortedImages, logCb,
+                        progressOf(Stage::ExportToMVS), &cancelRequest, threads); });
+
+        OpenMVG_Wrappers::DensifyOptions densify;
+        densify.resolutionLevel = cfg.densifyResolutionLevel;
+        densify.numViews = cfg.densifyNumViews;
+        densify.memoryBudgetMB = cfg.memoryBudgetMB;
+        addStage(Stage::Densify, 7, "Dense point cloud",
+                 {"", {dirs.mvsScene, dirs.undistortedImages}, {dirs.denseScene, dirs.densePly},
+                  "level=" + std::to_string(densify.resolutionLevel) + ";views=" + std::to_string(densify.numViews) +
+                      ";max=" + std::to_string(densify.maxResolution) + ";min=" + std::to_string(densify.minResolution) +
+                      ";fuse=" + std::to_string(densify.minViewsFuse),
+                  {}}, [&, densify](bool force, int threads)
+                  { return OpenMVG_Wrappers::RunDensify(
+                        dirs.mvsScene, dirs.dense, dirs.denseScene, dirs.densePly, logCb,
+                        progressOf(Stage::Densify), &cancelRequest, densify, force, threads); });
+
+        // one stage per OpenMVS step, each writing its mesh: a failed or cancelled texturing
+        // resumes from the refined mesh instead of reconstructing again
+        OpenMVG_Wrappers::MeshOptions mesh;
+        mesh.memoryBudgetMB = cfg.memoryBudgetMB;
+        addStage(Stage::ReconstructMesh, 8, "Mesh reconstruction",
+                 {"", {dirs.denseScene, dirs.densePly}, {dirs.meshScene, dirs.meshPly},
+                  "distance=" + std::to_string(mesh.minPointDistance) + ";smooth=" + std::to_string(mesh.smoothSteps),
+                  {}}, [&, mesh](bool, int threads)
+                  { return OpenMVG_Wrappers::RunReconstructMesh(
+                        dirs.denseScene, dirs.densePly, dirs.mesh, dirs.meshScene, dirs.meshPly, logCb,
+                        progressOf(Stage::ReconstructMesh), &cancelRequest, mesh, threads); });
+
+        addStage(Stage::RefineMesh, 9, "Mesh refinement",
+                 {"", {dirs.meshScene, dirs.meshPly, dirs.undistortedImages}, {dirs.refinedScene, dirs.refinedPly},
+                  "level=" + std::to_string(mesh.refineResolutionLevel) + ";views=" + std::to_string(mesh.refineMaxViews) +
+                      ";scales=" + std::to_string(mesh.refineScales) + ";min=" + std::to_string(mesh.minResolution),
+                  {}}, [&, mesh](bool, int threads)
+                  { return OpenMVG_Wrappers::RunRefineMesh(
+                        dirs.meshScene, dirs.meshPly, dirs.mesh, dirs.refinedScene, dirs.refinedPly, logCb,
+                        progressOf(Stage::RefineMesh), &cancelRequest, mesh, threads); });
+
+        // the texture images are named after the model by OpenMVS and only referenced by the .mtl: not tracked
+        addStage(Stage::TextureMesh, 10, "Mesh texturing",
+                 {"", {dirs.refinedScene, dirs.refinedPly, dirs.undistortedImages},
+                  {dirs.texturedModel, dirs.finalModels + "/textured_mesh.mtl"},
+                  "level=" + std::to_string(mesh.textureResolutionLevel) + ";min=" + std::to_string(mesh.minResolution),
+                  {}}, [&, mesh](bool, int threads)
+                  { return OpenMVG_Wrappers::RunTextureMesh(
+                        dirs.refinedScene, dirs.refinedPly, dirs.mesh, dirs.texturedModel, logCb,
+                        progressOf(Stage::TextureMesh), &cancelRequest, mesh, threads); });
+
+        MeshLodOptions meshLod;
+        meshLod.levels = std::max(1u, cfg.meshLodLevels);
+        meshLod.ratio = cfg.meshLodRatio;
+        meshLod.maxFaces = cfg.meshLodMaxFaces;
+        meshLod.maxTexture = cfg.meshLodMaxTexture;
+        meshLod.compression = cfg.meshLodCompression;
+        addStage(Stage::MeshLod, 11, "Mesh LODs and glTF export",
+                 {"", {dirs.texturedModel, dirs.finalModels + "/textured_mesh.mtl"}, {dirs.finalModels + "/*.glb"},
+                  "levels=" + std::to_string(meshLod.levels) + ";ratio=" + std::to_string(meshLod.ratio) +
+                      ";faces=" + std::to_string(meshLod.maxFaces) + ";min=" + std::to_string(meshLod.minFaces) +
+                      ";texture=" + std::to_string(meshLod.maxTexture) + ";quality=" + std::to_string(meshLod.jpegQuality) +
+                      ";compression=" + GltfCompressionName(meshLod.compression),
+                  {}}, [&, meshLod](bool, int threads) mutable
+                  {
+                      meshLod.threads = threads;
+                      TelemetryScope lodTelemetry("MeshLod");
+                      const OpenMVG_Wrappers::ProgressCallback progress = progressOf(Stage::MeshLod);
+                      MeshLodStats stats;
+                      std::string error;
+                      if (!BuildMeshLods(dirs.texturedModel, dirs.texturedLods, meshLod, &stats, &error, [&](double fraction)
+                                         { if (progress) progress(fraction, "Decimating and packing textures"); }, &cancelRequest))
+                      {
+                          if (!cancelRequest)
+                              LOG("ERROR: Cannot build the mesh LODs of " + dirs.texturedModel + ": " + error);
+                          return false;
+                      }
+                      for (size_t level = 0; level < stats.faces.size(); ++level)
+                      {
+                          LOG("Mesh LOD " + std::to_string(level) + ": " + std::to_string(stats.faces[level]) + " faces, " +
+                              std::to_string(stats.textureSize[level]) + " px atlas, " + MeshLodPath(dirs.texturedLods, static_cast<uint32_t>(level)));
+                          lodTelemetry.count("lod" + std::to_string(level) + "_faces", static_cast<double>(stats.faces[level]));
+                      }
+                      lodTelemetry.succeed();
+                      return true;
+                  });
+
+        // view graph reports: off the critical path, they run next to the following stage
+        // on a single thread of the budget (only when the stage writing their matches runs)
+        if (cfg.lastStage >= Stage::ComputeMatches)
+            graph.add({"PutativeMatchesReport", {dirs.sfmData, dirs.putativeMatches},
+                       {dirs.matches + "/PutativeAdjacencyMatrix.svg"}, "", {}, [&](bool)
+                       {
+                           const ThreadLease threads(1);
+                           return OpenMVG_Wrappers::RunExportMatchesReports(dirs.sfmData, dirs.putativeMatches, "Putative", logCb);
+                       },
+                       true});
+        if (cfg.lastStage >= Stage::GeometricFilter)
+            graph.add({"GeometricMatchesReport", {dirs.sfmData, dirs.filteredMatches},
+                       {dirs.matches + "/GeometricAdjacencyMatrix.svg"}, "", {}, [&](bool)
+                       {
+                           const ThreadLease threads(1);
+                           return OpenMVG_Wrappers::RunExportMatchesReports(dirs.sfmData, dirs.filteredMatches, "Geometric", logCb);
+                       },
+                       true});
+
+        // LOD octrees of the point clouds for the viewer, next to the following stage on half the budget
+        auto addPointLod = [&](const std::string &name, const std::string &ply, const std::string &lod, Stage source)
+        {
+            if (cfg.lodMaxNodePoints == 0 || source > cfg.lastStage)
+                return;
+            LodOptions options;
+            options.maxNodePoints = cfg.lodMaxNodePoints;
+            options.maxDepth = cfg.lodMaxDepth;
+            if (cfg.memoryBudgetMB > 0)
+                options.memoryBudgetMB = std::max(64u, cfg.memoryBudgetMB / 4);
+            graph.add({name, {ply}, {lod},
+                       "node_points=" + std::to_string(options.maxNodePoints) + ";depth=" + std::to_string(options.maxDepth) +
+                           ";grid=" + std::to_string(options.sampleGrid),
+                       {}, [&, name, ply, lod, options](bool) mutable
+                       {
+                           const ThreadLease threads(ThreadBudget::share(2));
+                           options.threads = threads.count();
+                           TelemetryScope lodTelemetry(name);
+                           LodStats stats;
+                           std::string error;
+                           if (!BuildPointLod(ply, lod, options, &stats, &error, nullptr, &cancelRequest))
+                           {
+                               if (!cancelRequest)
+                                   LOG("WARNING: Cannot build the point LOD of " + ply + ": " + error);
+                               return false;
+                           }
+                           char elapsed[32];
+                           std::snprintf(elapsed, sizeof(elapsed), "%.1f", stats.seconds);
+                           LOG("Point LOD: " + std::to_string(stats.points) + " points in " + std::to_string(stats.nodes) +
+                               " nodes, depth " + std::to_string(stats.depth) + ", " + lod + " (" + elapsed + " s)");
+                           lodTelemetry.count("points", static_cast<double>(stats.points));
+                           lodTelemetry.count("nodes", static_cast<double>(stats.nodes));
+                           lodTelemetry.succeed();
+                           return true;
+                       },
+                       true});
+        };
+        addPointLod("SparsePointLod", dirs.sparsePly, dirs.sparseLod, Stage::GlobalSfM);
+        addPointLod("DensePointLod", dirs.densePly, dirs.denseLod, Stage::Densify);
+
+        StageGraphCallbacks graphCallbacks;
+        graphCallbacks.log = logCb;
+        graphCallbacks.nodeStarted = [&](const StageNode &node)
+        {
+            auto it = stageNodes.find(node.name);
+            if (it == stageNodes.end())
+                return;
+            const StageInfo &info = it->second;
+            if (callbacks.stageStarted)
+                callbacks.stageStarted(info.stage, info.index, stageCount());
+            LOG("\n[Stage " + std::to_string(info.index) + "/" + std::to_string(stageCount()) + "] " + info.title + "...");
+        };
+        graphCallbacks.nodeFinished = [&](const StageNode &node, StageNodeResult result, double seconds)
+        {
+            const bool success = result == StageNodeResult::Done || result == StageNodeResult::UpToDate;
+            auto it = stageNodes.find(node.name);
+            if (it == stageNodes.end())
+            {
+                if (!success)
+                    LOG("WARNING: " + node.name + " failed");
+                return;
+            }
+
+            const StageInfo &info = it->second;
+            if (callbacks.stageFinished)
+                callbacks.stageFinished(info.stage, success, seconds);
+
+            const std::string prefix = "[Stage " + std::to_string(info.index) + "/" + std::to_string(stageCount()) + "] ";
+            char elapsed[32];
+            std::snprintf(elapsed, sizeof(elapsed), "%.1f", seconds);
+            if (result == StageNodeResult::UpToDate)
+                LOG(prefix + info.title + " is up to date, skipped.");
+            else if (success)
+                LOG(prefix + info.title + " completed successfully! (" + elapsed + " s)");
+            else
+                LOG("ERROR: " + info.title + " failed!");
+        };
+
+        const bool success = graph.run(graphCallbacks, cancelRequest, MaxParallelSteps);
+
+        telemetry.uninstall();
+        if (telemetry.writeReport(dirs.runReport, success) && telemetry.writeChromeTrace(dirs.runTrace))
+            LOG("Run report: " + dirs.runReport + " (timeline: " + dirs.runTrace + ")");
+        else
+            LOG("WARNING: Cannot write the run report to " + dirs.output);
+
+        if (success)
+            LOG("\n=== Pipeline completed successfully! ===");
+        else if (cancelRequest)
+            LOG("\nPipeline cancelled by user.");
+        return success;
+    }
+}
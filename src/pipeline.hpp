@@ -0,0 +1,155 @@
+#pragma once
+
+// Qt-free entry point of the reconstruction engine (voxelforge_core).
+// The GUI controller, voxel-forge-cli and the benchmarks all drive the
+// OpenMVG_Wrappers through this class.
+
+#include "mesh_lod.hpp"
+#include "openmvg_wrappers.hpp"
+#include "point_lod.hpp"
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+namespace VoxelForge
+{
+    enum class Stage
+    {
+        ImageListing,
+        ComputeFeatures,
+        ComputeMatches,
+        GeometricFilter,
+        GlobalSfM,
+        ExportToMVS,
+        Densify,
+        ReconstructMesh,
+        RefineMesh,
+        TextureMesh,
+        MeshLod
+    };
+
+    const char *StageName(Stage stage);
+    // inverse of StageName, false for an unknown name
+    bool StageFromName(const std::string &name, Stage &stage);
+
+    // VOXELFORGE_SENSOR_DB env var, else the database shipped with the vcpkg openMVG build
+    std::string DefaultSensorDatabase();
+
+    struct PipelineConfig
+    {
+        std::string projectPath;      // expects <projectPath>/images, writes <projectPath>/output
+        std::string sensorDatabase;   // empty = DefaultSensorDatabase()
+
+        // features
+        std::string describerMethod = "SIFT_ANATOMY";
+        std::string featurePreset = "NORMAL";
+        int numThreads = 0; // per stage, 0 = what is left of the ThreadBudget (thread_budget.hpp)
+
+        // matching / filtering
+        float distanceRatio = 0.8f;
+        std::string nearestMatchingMethod = "AUTO";
+        std::string geometricModel = "f";
+        // regions kept in RAM by matching / filtering, above it they run in tiles (regions_budget.hpp);
+        // also the budget of densify and mesh reconstruction, above it they run in spatial chunks;
+        // 0 = half the physical memory
+        unsigned int memoryBudgetMB = 0;
+
+        // sfm
+        std::string intrinsicRefinement = "ADJUST_ALL";
+
+        // densify (OpenMVS)
+        unsigned int densifyResolutionLevel = 1; // images scaled down 2^level times for the depth maps
+        unsigned int densifyNumViews = 8;        // neighbour views per depth map, 0 = all
+
+        // LOD octrees of the sparse and dense clouds (point_lod.hpp), 0 = not built
+        unsigned int lodMaxNodePoints = 20000;
+        unsigned int lodMaxDepth = 16;
+
+        // glTF LODs of the textured model (mesh_lod.hpp)
+        unsigned int meshLodLevels = 4;          // files, at least 1
+        float meshLodRatio = 0.25f;              // faces of a level / faces of the level before
+        unsigned int meshLodMaxFaces = 1000000;  // faces of the first level, 0 = all
+        unsigned int meshLodMaxTexture = 4096;   // largest atlas side
+        GltfCompression meshLodCompression = GltfCompression::Meshopt;
+
+        // run() stops after this stage (at most Pipeline::LastStage)
+        Stage lastStage = Stage::ExportToMVS;
+    };
+
+    struct PipelineCallbacks
+    {
+        OpenMVG_Wrappers::LogCallback log;
+        // index is 1-based out of count
+        std::function<void(Stage stage, int index, int count)> stageStarted;
+        std::function<void(Stage stage, bool success, double seconds)> stageFinished;
+        // fraction of the running stage in [0, 1] and its current step, throttled
+        // (see callback_progress.hpp); called from worker threads
+        std::function<void(Stage stage, double fraction, const std::string &step)> stageProgress;
+    };
+
+    // Output layout of a project
+    struct PipelinePaths
+    {
+        explicit PipelinePaths(const std::string &projectPath);
+
+        std::string images;
+        std::string output;
+        std::string matches;
+        std::string reconstruction;
+        std::string sfmData;          // matches/sfm_data.json
+        std::string putativeMatches;  // matches/matches.putative.bin
+        std::string filteredMatches;  // matches/matches.f.bin
+        std::string sfmResult;        // reconstruction/sfm_data.bin
+        std::string mvsScene;         // scene.mvs, input of the OpenMVS stages
+        std::string undistortedImages; // undistorted_images/, referenced by scene.mvs
+        std::string dense;            // dense/, depth maps of densify
+        std::string denseScene;       // dense/scene_dense.mvs
+        std::string densePly;         // dense/scene_dense.ply
+        std::string sparsePly;        // reconstruction/cloud_and_poses.ply
+        std::string sparseLod;        // reconstruction/cloud_and_poses.lod/ (point_lod.hpp)
+        std::string denseLod;         // dense/scene_dense.lod/
+        std::string mesh;             // mesh/, working folder of the mesh stages
+        std::string meshScene;        // mesh/scene_mesh.mvs, reconstructed mesh (+ scene_mesh.ply)
+        std::string meshPly;
+        std::string refinedScene;     // mesh/scene_mesh_refine.mvs, refined mesh (+ scene_mesh_refine.ply)
+        std::string refinedPly;
+        std::string finalModels;      // <projectPath>/final_3d_models, listed by the 3D models page
+        std::string texturedModel;    // final_3d_models/textured_mesh.obj (+ .mtl and texture images)
+        std::string texturedLods;     // final_3d_models/textured_mesh_lod, + <level>.glb (mesh_lod.hpp)
+        std::string runReport;        // run_report.json, per-stage metrics (telemetry.hpp)
+        std::string runTrace;         // run_trace.json, Chrome trace of the same run
+        std::string stamps;           // .stamps/, up-to-date checks of the steps (stage_graph.hpp)
+    };
+
+    class Pipeline
+    {
+    public:
+        static constexpr Stage LastStage = Stage::MeshLod; // last stage run() implements
+        static constexpr int MaxParallelSteps = 2; // a stage plus the report export of the previous one
+
+        explicit Pipeline(const PipelineConfig &config);
+
+        // Blocking; returns false on failure or when cancelled (see cancelled()).
+        // Stages whose inputs, parameters and outputs did not change since their
+        // last successful run are skipped. Writes paths().runReport and
+        // paths().runTrace in either case
+        bool run(const PipelineCallbacks &callbacks = PipelineCallbacks());
+
+        // Thread-safe (also from a signal handler). The running stage stops after
+        // the view / image pair it is processing and no new step starts
+        void cancel() { cancelRequest = true; }
+        bool cancelled() const { return cancelRequest; }
+
+        // stages run() goes through, ImageListing to config().lastStage
+        int stageCount() const { return static_cast<int>(cfg.lastStage) + 1; }
+
+        const PipelineConfig &config() const { return cfg; }
+        const PipelinePaths &paths() const { return dirs; }
+
+    private:
+        PipelineConfig cfg;
+        PipelinePaths dirs;
+        std::atomic<bool> cancelRequest;
+    };
+}
@@ -0,0 +1,457 @@
+#include "ply_io.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+namespace VoxelForge
+{
+    namespace
+    {
+        constexpr size_t MaxAsciiProperties = 64;
+
+        bool seekTo(std::FILE *file, uint64_t offset)
+        {
+#ifdef _WIN32
+            return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+            return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+        }
+
+        uint64_t tellOffset(std::FILE *file)
+        {
+#ifdef _WIN32
+            return static_cast<uint64_t>(_ftelli64(file));
+#else
+            return static_cast<uint64_t>(ftello(file));
+#endif
+        }
+
+        bool parseType(const std::string &name, PlyType &type)
+        {
+            static const struct
+            {
+                const char *name;
+                PlyType type;
+            } names[] = {
+                {"char", PlyType::Int8}, {"int8", PlyType::Int8}, {"uchar", PlyType::UInt8}, {"uint8", PlyType::UInt8},
+                {"short", PlyType::Int16}, {"int16", PlyType::Int16}, {"ushort", PlyType::UInt16}, {"uint16", PlyType::UInt16},
+                {"int", PlyType::Int32}, {"int32", PlyType::Int32}, {"uint", PlyType::UInt32}, {"uint32", PlyType::UInt32},
+                {"float", PlyType::Float32}, {"float32", PlyType::Float32}, {"double", PlyType::Float64}, {"float64", PlyType::Float64}};
+            for (const auto &entry : names)
+            {
+                if (name == entry.name)
+                {
+                    type = entry.type;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool fail(std::string *error, const std::string &message)
+        {
+            if (error)
+                *error = message;
+            return false;
+        }
+    }
+
+    size_t PlyTypeSize(PlyType type)
+    {
+        switch (type)
+        {
+        case PlyType::Int8:
+        case PlyType::UInt8: return 1;
+        case PlyType::Int16:
+        case PlyType::UInt16: return 2;
+        case PlyType::Int32:
+        case PlyType::UInt32:
+        case PlyType::Float32: return 4;
+        case PlyType::Float64: return 8;
+        }
+        return 0;
+    }
+
+    double DecodePlyValue(const unsigned char *data, PlyType type, bool bigEndian)
+    {
+        unsigned char bytes[8];
+        const size_t size = PlyTypeSize(type);
+        if (bigEndian)
+            std::reverse_copy(data, data + size, bytes);
+        else
+            std::memcpy(bytes, data, size);
+        switch (type)
+        {
+        case PlyType::Int8: { int8_t v; std::memcpy(&v, bytes, 1); return v; }
+        case PlyType::UInt8: return bytes[0];
+        case PlyType::Int16: { int16_t v; std::memcpy(&v, bytes, 2); return v; }
+        case PlyType::UInt16: { uint16_t v; std::memcpy(&v, bytes, 2); return v; }
+        case PlyType::Int32: { int32_t v; std::memcpy(&v, bytes, 4); return v; }
+        case PlyType::UInt32: { uint32_t v; std::memcpy(&v, bytes, 4); return v; }
+        case PlyType::Float32: { float v; std::memcpy(&v, bytes, 4); return v; }
+        case PlyType::Float64: { double v; std::memcpy(&v, bytes, 8); return v; }
+        }
+        return 0;
+    }
+
+    uint8_t PlyColorChannel(double value, PlyType type)
+    {
+        if (type == PlyType::Float32 || type == PlyType::Float64)
+            value *= 255.0;
+        else if (type == PlyType::UInt16)
+            value /= 257.0;
+        return static_cast<uint8_t>(std::min(255.0, std::max(0.0, value + 0.5)));
+    }
+
+    void FindPlyVertexProperties(const PlyElement &vertex, int position[3], int color[3], int normal[3])
+    {
+        static const char *const colorNames[3][3] = {
+            {"red", "r", "diffuse_red"}, {"green", "g", "diffuse_green"}, {"blue", "b", "diffuse_blue"}};
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            position[axis] = vertex.find(std::string(1, static_cast<char>('x' + axis)));
+            normal[axis] = vertex.find(std::string("n") + static_cast<char>('x' + axis));
+            color[axis] = -1;
+            for (const char *name : colorNames[axis])
+                if (color[axis] < 0)
+                    color[axis] = vertex.find(name);
+        }
+    }
+
+    bool ParseAsciiNumber(const char *&cursor, const char *end, double &value)
+    {
+        static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        auto digit = [](char c)
+        { return c >= '0' && c <= '9'; };
+        const char *p = cursor;
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+            ++p;
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+'))
+            negative = *p++ == '-';
+
+        // up to 19 significant digits in an integer, the rest only moves the exponent
+        uint64_t mantissa = 0;
+        int digits = 0, exponent = 0;
+        bool any = false;
+        for (; p < end && digit(*p); ++p, any = true)
+        {
+            if (digits < 19)
+                digits += (mantissa = mantissa * 10 + uint64_t(*p - '0')) != 0;
+            else
+                ++exponent;
+        }
+        if (p < end && *p == '.')
+        {
+            for (++p; p < end && digit(*p); ++p, any = true)
+            {
+                if (digits < 19)
+                {
+                    digits += (mantissa = mantissa * 10 + uint64_t(*p - '0')) != 0;
+                    --exponent;
+                }
+            }
+        }
+        if (!any)
+        {
+            auto word = [&](const char *name)
+            {
+                const size_t length = std::strlen(name);
+                if (size_t(end - p) < length)
+                    return false;
+                for (size_t i = 0; i < length; ++i)
+                    if ((p[i] | 0x20) != name[i])
+                        return false;
+                p += length;
+                return true;
+            };
+            if (word("nan"))
+                value = std::numeric_limits<double>::quiet_NaN();
+            else if (word("inf"))
+                value = negative ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+            else
+                return false;
+            while (p < end && std::isalpha(static_cast<unsigned char>(*p)))
+                ++p;
+            cursor = p;
+            return true;
+        }
+        if (p < end && (*p == 'e' || *p == 'E'))
+        {
+            const char *q = p + 1;
+            bool negativeExponent = false;
+            if (q < end && (*q == '-' || *q == '+'))
+                negativeExponent = *q++ == '-';
+            if (q < end && digit(*q))
+            {
+                int e = 0;
+                for (; q < end && digit(*q); ++q)
+                    e = std::min(e * 10 + (*q - '0'), 100000);
+                exponent += negativeExponent ? -e : e;
+                p = q;
+            }
+        }
+        // exact powers of ten keep the result correctly rounded for the usual 6 to 17 digits
+        double v = static_cast<double>(mantissa);
+        if (exponent < 0)
+            v = -exponent <= 22 ? v / powers[-exponent] : v * std::pow(10.0, exponent);
+        else if (exponent > 0)
+            v = exponent <= 22 ? v * powers[exponent] : v * std::pow(10.0, exponent);
+        value = negative ? -v : v;
+        cursor = p;
+        return true;
+    }
+
+    size_t PlyElement::stride() const
+    {
+        size_t bytes = 0;
+        for (const PlyProperty &property : properties)
+        {
+            if (property.isList)
+                return 0;
+            bytes += PlyTypeSize(property.type);
+        }
+        return bytes;
+    }
+
+    int PlyElement::find(const std::string &property) const
+    {
+        for (size_t i = 0; i < properties.size(); ++i)
+            if (properties[i].name == property)
+                return static_cast<int>(i);
+        return -1;
+    }
+
+    const PlyElement *PlyHeader::element(const std::string &name) const
+    {
+        for (const PlyElement &e : elements)
+            if (e.name == name)
+                return &e;
+        return nullptr;
+    }
+
+    bool ReadPlyHeader(std::FILE *file, PlyHeader &header, std::string *error)
+    {
+        header = PlyHeader();
+        char line[1024];
+        if (!std::fgets(line, sizeof(line), file) || std::strncmp(line, "ply", 3) != 0)
+            return fail(error, "not a PLY file");
+
+        bool hasFormat = false;
+        while (std::fgets(line, sizeof(line), file))
+        {
+            std::istringstream words(line);
+            std::string keyword;
+            words >> keyword;
+            if (keyword == "format")
+            {
+                std::string format;
+                words >> format;
+                if (format == "ascii")
+                    header.format = PlyHeader::Format::Ascii;
+                else if (format == "binary_little_endian")
+                    header.format = PlyHeader::Format::BinaryLittleEndian;
+                else if (format == "binary_big_endian")
+                    header.format = PlyHeader::Format::BinaryBigEndian;
+                else
+                    return fail(error, "unknown PLY format " + format);
+                hasFormat = true;
+            }
+            else if (keyword == "element")
+            {
+                PlyElement element;
+                if (!(words >> element.name >> element.count))
+                    return fail(error, "bad element line");
+                header.elements.push_back(element);
+            }
+            else if (keyword == "property")
+            {
+                if (header.elements.empty())
+                    return fail(error, "property before any element");
+                PlyProperty property;
+                std::string type;
+                words >> type;
+                if (type == "list")
+                {
+                    std::string countType, itemType;
+                    words >> countType >> itemType;
+                    property.isList = true;
+                    if (!parseType(countType, property.countType) || !parseType(itemType, property.type))
+                        return fail(error, "unknown list type in: " + std::string(line));
+                }
+                else if (!parseType(type, property.type))
+                {
+                    return fail(error, "unknown property type " + type);
+                }
+                words >> property.name;
+                header.elements.back().properties.push_back(property);
+            }
+            else if (keyword == "end_header")
+            {
+                if (!hasFormat)
+                    return fail(error, "no format line");
+                header.dataOffset = tellOffset(file);
+                return true;
+            }
+            // comment, obj_info: ignored
+        }
+        return fail(error, "no end_header");
+    }
+
+    PlyVertexStream::~PlyVertexStream()
+    {
+        close();
+    }
+
+    void PlyVertexStream::close()
+    {
+        if (file)
+            std::fclose(file);
+        file = nullptr;
+    }
+
+    bool PlyVertexStream::open(const std::string &path, std::string *errorMessage)
+    {
+        close();
+        error = false;
+        consumed = total = 0;
+        file = std::fopen(path.c_str(), "rb");
+        if (!file)
+            return fail(errorMessage, "cannot open " + path);
+        if (!ReadPlyHeader(file, head, errorMessage))
+        {
+            close();
+            return false;
+        }
+        if (head.elements.empty() || head.elements[0].name != "vertex")
+        {
+            close();
+            return fail(errorMessage, "the first element of " + path + " is not vertex");
+        }
+
+        const PlyElement &vertex = head.elements[0];
+        int normal[3];
+        FindPlyVertexProperties(vertex, position, colour, normal);
+        if (position[0] < 0 || position[1] < 0 || position[2] < 0)
+        {
+            close();
+            return fail(errorMessage, path + " has no x, y, z vertex properties");
+        }
+        stride = vertex.stride();
+        if (head.format == PlyHeader::Format::Ascii && vertex.properties.size() > MaxAsciiProperties)
+        {
+            close();
+            return fail(errorMessage, path + " has too many vertex properties");
+        }
+        if (head.format != PlyHeader::Format::Ascii && stride == 0)
+        {
+            close();
+            return fail(errorMessage, path + " has a list property in its vertices");
+        }
+        offsets.clear();
+        size_t offset = 0;
+        for (const PlyProperty &property : vertex.properties)
+        {
+            offsets.push_back(offset);
+            offset += PlyTypeSize(property.type);
+        }
+        total = vertex.count;
+        return true;
+    }
+
+    bool PlyVertexStream::rewind()
+    {
+        consumed = 0;
+        error = !file || !seekTo(file, head.dataOffset);
+        return !error;
+    }
+
+    bool PlyVertexStream::decodeAscii(PlyPoint &point)
+    {
+        // one vertex per line, properties in header order
+        std::string line;
+        int c;
+        while ((c = std::fgetc(file)) != EOF && c != '\n')
+            line.push_back(static_cast<char>(c));
+        if (line.empty() && c == EOF)
+            return false;
+
+        const PlyElement &vertex = head.elements[0];
+        double values[MaxAsciiProperties];
+        const size_t count = vertex.properties.size();
+        const char *cursor = line.data(), *end = line.data() + line.size();
+        for (size_t i = 0; i < count; ++i)
+            if (!ParseAsciiNumber(cursor, end, values[i]))
+                return false;
+        point.x = static_cast<float>(values[position[0]]);
+        point.y = static_cast<float>(values[position[1]]);
+        point.z = static_cast<float>(values[position[2]]);
+        point.r = hasColor() ? PlyColorChannel(values[colour[0]], vertex.properties[colour[0]].type) : 255;
+        point.g = hasColor() ? PlyColorChannel(values[colour[1]], vertex.properties[colour[1]].type) : 255;
+        point.b = hasColor() ? PlyColorChannel(values[colour[2]], vertex.properties[colour[2]].type) : 255;
+        point.a = 255;
+        return true;
+    }
+
+    size_t PlyVertexStream::read(PlyPoint *out, size_t max)
+    {
+        if (!file || error)
+            return 0;
+        const size_t wanted = static_cast<size_t>(std::min<uint64_t>(max, total - consumed));
+        if (wanted == 0)
+            return 0;
+
+        const PlyElement &vertex = head.elements[0];
+        if (head.format == PlyHeader::Format::Ascii)
+        {
+            for (size_t i = 0; i < wanted; ++i)
+            {
+                if (!decodeAscii(out[i]))
+                {
+                    error = true;
+                    consumed += i;
+                    return i;
+                }
+            }
+            consumed += wanted;
+            return wanted;
+        }
+
+        buffer.resize(wanted * stride);
+        if (std::fread(buffer.data(), stride, wanted, file) != wanted)
+        {
+            error = true;
+            return 0;
+        }
+        const bool swap = head.format == PlyHeader::Format::BinaryBigEndian;
+        const PlyType positionType[3] = {vertex.properties[position[0]].type, vertex.properties[position[1]].type,
+                                         vertex.properties[position[2]].type};
+        for (size_t i = 0; i < wanted; ++i)
+        {
+            const unsigned char *item = buffer.data() + i * stride;
+            PlyPoint &point = out[i];
+            point.x = static_cast<float>(DecodePlyValue(item + offsets[position[0]], positionType[0], swap));
+            point.y = static_cast<float>(DecodePlyValue(item + offsets[position[1]], positionType[1], swap));
+            point.z = static_cast<float>(DecodePlyValue(item + offsets[position[2]], positionType[2], swap));
+            if (hasColor())
+            {
+                point.r = PlyColorChannel(DecodePlyValue(item + offsets[colour[0]], vertex.properties[colour[0]].type, swap), vertex.properties[colour[0]].type);
+                point.g = PlyColorChannel(DecodePlyValue(item + offsets[colour[1]], vertex.properties[colour[1]].type, swap), vertex.properties[colour[1]].type);
+                point.b = PlyColorChannel(DecodePlyValue(item + offsets[colour[2]], vertex.properties[colour[2]].type, swap), vertex.properties[colour[2]].type);
+            }
+            else
+            {
+                point.r = point.g = point.b = 255;
+            }
+            point.a = 255;
+        }
+        consumed += wanted;
+        return wanted;
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+// PLY header parsing and a streaming reader of the vertex element, for the
+// point clouds of the pipeline (reconstruction/cloud_and_poses.ply written by
+// openMVG, dense/scene_dense.ply written by OpenMVS) and any other PLY.
+//
+// ASCII, binary little and big endian. The vertex element must come first
+// (as every writer of the pipeline does) and have no list property; positions
+// are read from x, y, z and colours from red, green, blue (or r, g, b,
+// diffuse_*), other properties are skipped.
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace VoxelForge
+{
+    enum class PlyType : uint8_t
+    {
+        Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64
+    };
+
+    size_t PlyTypeSize(PlyType type);
+
+    struct PlyProperty
+    {
+        std::string name;
+        PlyType type = PlyType::Float32;
+        bool isList = false;
+        PlyType countType = PlyType::UInt8; // of a list
+    };
+
+    struct PlyElement
+    {
+        std::string name;
+        uint64_t count = 0;
+        std::vector<PlyProperty> properties;
+
+        // bytes per item in a binary file, 0 if it has a list property
+        size_t stride() const;
+        // index of the property, -1 if absent
+        int find(const std::string &property) const;
+    };
+
+    struct PlyHeader
+    {
+        enum class Format
+        {
+            Ascii, BinaryLittleEndian, BinaryBigEndian
+        } format = Format::Ascii;
+        std::vector<PlyElement> elements;
+        uint64_t dataOffset = 0; // bytes from the start of the file to the first item
+
+        // nullptr if absent
+        const PlyElement *element(const std::string &name) const;
+    };
+
+    // Parses the header at the start of the file; error says why it failed
+    bool ReadPlyHeader(std::FILE *file, PlyHeader &header, std::string *error = nullptr);
+
+    // Value of one binary property
+    double DecodePlyValue(const unsigned char *data, PlyType type, bool bigEndian);
+    // 8-bit colour channel of a colour property (floating point colours are in [0, 1])
+    uint8_t PlyColorChannel(double value, PlyType type);
+    // Property indices of x, y, z, of the colours (red, green, blue or r, g, b or diffuse_*) and of nx, ny, nz; -1 if absent
+    void FindPlyVertexProperties(const PlyElement &vertex, int position[3], int color[3], int normal[3]);
+    // Next number of an ASCII file before end, whitespace skipped; independent of the C locale
+    bool ParseAsciiNumber(const char *&cursor, const char *end, double &value);
+
+    // Position and colour of a point (white when the file has no colours), 16 bytes
+    struct PlyPoint
+    {
+        float x, y, z;
+        uint8_t r, g, b, a;
+    };
+
+    class PlyVertexStream
+    {
+    public:
+        PlyVertexStream() = default;
+        ~PlyVertexStream();
+        PlyVertexStream(const PlyVertexStream &) = delete;
+        PlyVertexStream &operator=(const PlyVertexStream &) = delete;
+
+        bool open(const std::string &path, std::string *error = nullptr);
+        void close();
+
+        const PlyHeader &header() const { return head; }
+        uint64_t vertexCount() const { return total; }
+        bool hasColor() const { return colour[0] >= 0 && colour[1] >= 0 && colour[2] >= 0; }
+
+        // Up to max next vertices; 0 at the end of the vertices or on a read error (see failed())
+        size_t read(PlyPoint *out, size_t max);
+        // back to the first vertex, for another pass
+        bool rewind();
+        bool failed() const { return error; }
+
+    private:
+        bool decodeAscii(PlyPoint &point);
+
+        std::FILE *file = nullptr;
+        PlyHeader head;
+        uint64_t total = 0, consumed = 0;
+        int position[3] = {-1, -1, -1};
+        int colour[3] = {-1, -1, -1};
+        std::vector<size_t> offsets; // byte offset of each vertex property (binary)
+        size_t stride = 0;
+        std::vector<unsigned char> buffer;
+        bool error = false;
+    };
+}
@@ -0,0 +1,785 @@
+#include "point_lod.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+namespace VoxelForge
+{
+    namespace
+    {
+        constexpr size_t StreamBatch = 1 << 16;
+        constexpr size_t BucketFlushPoints = 4096;
+        constexpr uint32_t MaxCountingLevel = 7; // 128^3 counting grid
+        constexpr uint32_t MaxLevel = 20;        // Morton codes of 63 bits
+
+        uint64_t spreadBits(uint64_t v)
+        {
+            v &= 0x1FFFFF;
+            v = (v | v << 32) & 0x1F00000000FFFFull;
+            v = (v | v << 16) & 0x1F0000FF0000FFull;
+            v = (v | v << 8) & 0x100F00F00F00F00Full;
+            v = (v | v << 4) & 0x10C30C30C30C30C3ull;
+            v = (v | v << 2) & 0x1249249249249249ull;
+            return v;
+        }
+
+        // x in bit 0, y in bit 1, z in bit 2 of every triple: the low 3 bits are the octant
+        uint64_t morton(uint32_t x, uint32_t y, uint32_t z)
+        {
+            return spreadBits(x) | spreadBits(y) << 1 | spreadBits(z) << 2;
+        }
+
+        struct Cube
+        {
+            double min[3] = {0, 0, 0};
+            double size = 1;
+
+            // cell of p in the 2^level grid
+            void cell(const PlyPoint &p, uint32_t level, uint32_t &x, uint32_t &y, uint32_t &z) const
+            {
+                const double cells = double(1u << level);
+                const uint32_t last = (1u << level) - 1;
+                auto index = [&](double v, int axis)
+                {
+                    const double t = (v - min[axis]) / size * cells;
+                    return t <= 0 ? 0u : std::min(last, static_cast<uint32_t>(t));
+                };
+                x = index(p.x, 0);
+                y = index(p.y, 1);
+                z = index(p.z, 2);
+            }
+        };
+
+        struct BuildNode
+        {
+            uint8_t level = 0;
+            uint32_t x = 0, y = 0, z = 0;
+            std::vector<PlyPoint> points;
+            int children[8] = {-1, -1, -1, -1, -1, -1, -1, -1};
+        };
+
+        class Builder
+        {
+        public:
+            Builder(const LodOptions &options, const Cube &cube) : options(options), cube(cube) {}
+
+            // Subtree of the points in the node (level, x, y, z), appended to nodes; index of its root
+            int build(std::vector<PlyPoint> points, uint8_t level, uint32_t x, uint32_t y, uint32_t z, std::vector<BuildNode> &nodes) const
+            {
+                const int index = static_cast<int>(nodes.size());
+                nodes.emplace_back();
+                nodes[index].level = level;
+                nodes[index].x = x;
+                nodes[index].y = y;
+                nodes[index].z = z;
+                if (points.size() <= options.maxNodePoints || level >= options.maxDepth)
+                {
+                    nodes[index].points = std::move(points);
+                    return index;
+                }
+
+                std::vector<PlyPoint> octants[8];
+                for (const PlyPoint &p : points)
+                {
+                    uint32_t cx, cy, cz;
+                    cube.cell(p, level + 1, cx, cy, cz);
+                    octants[(cx & 1) | (cy & 1) << 1 | (cz & 1) << 2].push_back(p);
+                }
+                points = std::vector<PlyPoint>();
+                for (int o = 0; o < 8; ++o)
+                {
+                    if (octants[o].empty())
+                        continue;
+                    const int child = build(std::move(octants[o]), static_cast<uint8_t>(level + 1), 2 * x + (o & 1),
+                                            2 * y + ((o >> 1) & 1), 2 * z + ((o >> 2) & 1), nodes);
+                    nodes[index].children[o] = child;
+                }
+                sample(index, nodes);
+                return index;
+            }
+
+            // Moves the first point of every sampling cell of the node out of its children, evenly
+            // thinned to maxNodePoints
+            void sample(int index, std::vector<BuildNode> &nodes) const
+            {
+                BuildNode &node = nodes[index];
+                const uint32_t grid = std::max(1u, options.sampleGrid);
+                const uint32_t level = std::min<uint32_t>(MaxLevel, node.level + static_cast<uint32_t>(std::ceil(std::log2(double(grid)))));
+                std::unordered_set<uint64_t> taken;
+                std::vector<std::pair<int, size_t>> candidates; // (octant, point of that child)
+                for (int o = 0; o < 8; ++o)
+                {
+                    if (node.children[o] < 0)
+                        continue;
+                    const std::vector<PlyPoint> &points = nodes[node.children[o]].points;
+                    for (size_t i = 0; i < points.size(); ++i)
+                    {
+                        uint32_t cx, cy, cz;
+                        cube.cell(points[i], level, cx, cy, cz);
+                        if (taken.insert(morton(cx, cy, cz)).second)
+                            candidates.emplace_back(o, i);
+                    }
+                }
+
+                const size_t keep = std::min<size_t>(candidates.size(), options.maxNodePoints);
+                std::vector<bool> moved[8];
+                node.points.reserve(node.points.size() + keep);
+                for (size_t k = 0; k < keep; ++k)
+                {
+                    const auto &candidate = candidates[k * candidates.size() / keep];
+                    const std::vector<PlyPoint> &points = nodes[node.children[candidate.first]].points;
+                    std::vector<bool> &flags = moved[candidate.first];
+                    if (flags.empty())
+                        flags.resize(points.size(), false);
+                    flags[candidate.second] = true;
+                    node.points.push_back(points[candidate.second]);
+                }
+                for (int o = 0; o < 8; ++o)
+                {
+                    if (moved[o].empty())
+                        continue;
+                    std::vector<PlyPoint> &points = nodes[node.children[o]].points;
+                    size_t out = 0;
+                    for (size_t i = 0; i < points.size(); ++i)
+                        if (!moved[o][i])
+                            points[out++] = points[i];
+                    points.resize(out);
+                    points.shrink_to_fit();
+                }
+            }
+
+        private:
+            const LodOptions &options;
+            const Cube &cube;
+        };
+
+        // node of the final file, its points in memory or in a bucket's node file
+        struct OutNode
+        {
+            uint8_t level = 0;
+            uint32_t x = 0, y = 0, z = 0;
+            uint64_t code = 0;
+            uint32_t count = 0;
+            const std::vector<PlyPoint> *memory = nullptr;
+            int bucket = -1;
+            uint64_t fileOffset = 0; // in points
+        };
+
+        bool seekFile(std::FILE *file, uint64_t offset)
+        {
+#ifdef _WIN32
+            return _fseeki64(file, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+            return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+        }
+
+        bool writeFile(const std::string &path, const void *data, size_t bytes)
+        {
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(static_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+            return static_cast<bool>(out);
+        }
+
+        bool fail(std::string *error, const std::string &message)
+        {
+            if (error)
+                *error = message;
+            return false;
+        }
+    }
+
+    std::string LodDirectoryFor(const std::string &plyPath)
+    {
+        return (fs::path(plyPath).parent_path() / fs::path(plyPath).stem()).generic_string() + ".lod";
+    }
+
+    bool BuildPointLod(const std::string &plyPath, const std::string &outDir, const LodOptions &optionsIn,
+                       LodStats *stats, std::string *error,
+                       const std::function<void(double fraction)> &progress,
+                       const std::atomic<bool> *cancel)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        auto cancelled = [cancel]
+        { return cancel && cancel->load(std::memory_order_relaxed); };
+        auto report = [&](double fraction)
+        {
+            if (progress)
+                progress(fraction);
+        };
+
+        LodOptions options = optionsIn;
+        options.maxNodePoints = std::max(1u, options.maxNodePoints);
+        options.maxDepth = std::min(MaxLevel, options.maxDepth);
+
+        PlyVertexStream stream;
+        if (!stream.open(plyPath, error))
+            return false;
+        const uint64_t total = stream.vertexCount();
+        if (total == 0)
+            return fail(error, plyPath + " has no vertices");
+
+        //---------------------------------------
+        // Pass 1: bounding cube
+        //---------------------------------------
+        std::vector<PlyPoint> batch(StreamBatch);
+        double low[3] = {HUGE_VAL, HUGE_VAL, HUGE_VAL}, high[3] = {-HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+        uint64_t read = 0;
+        for (size_t n; (n = stream.read(batch.data(), batch.size())) > 0;)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                const float v[3] = {batch[i].x, batch[i].y, batch[i].z};
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    low[axis] = std::min(low[axis], double(v[axis]));
+                    high[axis] = std::max(high[axis], double(v[axis]));
+                }
+            }
+            read += n;
+            report(0.15 * double(read) / double(total));
+            if (cancelled())
+                return false;
+        }
+        if (stream.failed() || read != total)
+            return fail(error, "cannot read the vertices of " + plyPath);
+
+        Cube cube;
+        for (int axis = 0; axis < 3; ++axis)
+            cube.min[axis] = low[axis];
+        cube.size = std::max({high[0] - low[0], high[1] - low[1], high[2] - low[2]});
+        cube.size = cube.size > 0 ? cube.size * (1 + 1e-6) : 1;
+
+        //---------------------------------------
+        // Pass 2: counting grid, then buckets of at most the budget
+        //---------------------------------------
+        const uint64_t bucketPoints = std::max<uint64_t>(options.maxNodePoints,
+                                                         (uint64_t(std::max(1u, options.memoryBudgetMB)) << 20) / (3 * sizeof(PlyPoint)));
+        const uint32_t countingLevel = total <= bucketPoints ? 0 : std::min(MaxCountingLevel, options.maxDepth);
+        const uint32_t dim = 1u << countingLevel;
+        auto gridIndex = [dim](uint32_t x, uint32_t y, uint32_t z)
+        { return (size_t(z) * dim + y) * dim + x; };
+
+        // count of every node of levels 0..countingLevel
+        std::vector<std::vector<uint64_t>> counts(countingLevel + 1);
+        counts[countingLevel].assign(size_t(dim) * dim * dim, 0);
+        if (countingLevel > 0)
+        {
+            if (!stream.rewind())
+                return fail(error, "cannot read " + plyPath);
+            read = 0;
+            for (size_t n; (n = stream.read(batch.data(), batch.size())) > 0;)
+            {
+                for (size_t i = 0; i < n; ++i)
+                {
+                    uint32_t x, y, z;
+                    cube.cell(batch[i], countingLevel, x, y, z);
+                    ++counts[countingLevel][gridIndex(x, y, z)];
+                }
+                read += n;
+                report(0.15 + 0.15 * double(read) / double(total));
+                if (cancelled())
+                    return false;
+            }
+            if (stream.failed() || read != total)
+                return fail(error, "cannot read the vertices of " + plyPath);
+        }
+        else
+        {
+            counts[0][0] = total;
+        }
+        for (uint32_t level = countingLevel; level > 0; --level)
+        {
+            const uint32_t childDim = 1u << level, parentDim = childDim / 2;
+            counts[level - 1].assign(size_t(parentDim) * parentDim * parentDim, 0);
+            for (uint32_t z = 0; z < childDim; ++z)
+                for (uint32_t y = 0; y < childDim; ++y)
+                    for (uint32_t x = 0; x < childDim; ++x)
+                        counts[level - 1][(size_t(z / 2) * parentDim + y / 2) * parentDim + x / 2] +=
+                            counts[level][(size_t(z) * childDim + y) * childDim + x];
+        }
+
+        // top-down: a node under the bucket size (or at the counting level) is a bucket,
+        // the nodes above the buckets are built from the buckets' roots
+        struct Bucket
+        {
+            uint8_t level;
+            uint32_t x, y, z;
+        };
+        std::vector<Bucket> buckets;
+        std::vector<BuildNode> top; // nodes above the buckets, then one leaf per bucket root
+        std::vector<int> bucketTopNode;
+        std::vector<uint32_t> bucketOfCell(counts[countingLevel].size(), 0);
+        std::function<int(uint8_t, uint32_t, uint32_t, uint32_t)> plan = [&](uint8_t level, uint32_t x, uint32_t y, uint32_t z) -> int
+        {
+            const uint32_t levelDim = 1u << level;
+            const uint64_t count = counts[level][(size_t(z) * levelDim + y) * levelDim + x];
+            if (count == 0)
+                return -1;
+            const int index = static_cast<int>(top.size());
+            top.emplace_back();
+            top[index].level = level;
+            top[index].x = x;
+            top[index].y = y;
+            top[index].z = z;
+            if (count <= bucketPoints || level == countingLevel)
+            {
+                const uint32_t id = static_cast<uint32_t>(buckets.size());
+                buckets.push_back({level, x, y, z});
+                bucketTopNode.push_back(index);
+                const uint32_t span = 1u << (countingLevel - level);
+                for (uint32_t cz = z * span; cz < (z + 1) * span; ++cz)
+                    for (uint32_t cy = y * span; cy < (y + 1) * span; ++cy)
+                        for (uint32_t cx = x * span; cx < (x + 1) * span; ++cx)
+                            bucketOfCell[gridIndex(cx, cy, cz)] = id;
+                return index;
+            }
+            for (int o = 0; o < 8; ++o)
+            {
+                const int child = plan(static_cast<uint8_t>(level + 1), 2 * x + (o & 1), 2 * y + ((o >> 1) & 1), 2 * z + ((o >> 2) & 1));
+                top[index].children[o] = child;
+            }
+            return index;
+        };
+        plan(0, 0, 0, 0);
+
+        const fs::path finalDir(outDir);
+        const fs::path workDir = finalDir.string() + ".building";
+        std::error_code ec;
+        fs::remove_all(workDir, ec);
+        fs::create_directories(workDir, ec);
+        if (ec)
+            return fail(error, "cannot create " + workDir.string() + ": " + ec.message());
+        auto abandon = [&](const std::string &message)
+        {
+            std::error_code ignored;
+            fs::remove_all(workDir, ignored);
+            return message.empty() ? false : fail(error, message);
+        };
+        auto bucketFile = [&](size_t id, const char *kind)
+        { return (workDir / (std::string(kind) + "_" + std::to_string(id) + ".bin")).string(); };
+
+        //---------------------------------------
+        // Pass 3: points into their bucket files (one bucket: kept in memory)
+        //---------------------------------------
+        std::vector<PlyPoint> single;
+        if (buckets.size() == 1)
+        {
+            single.resize(static_cast<size_t>(total));
+            if (!stream.rewind() || stream.read(single.data(), single.size()) != single.size())
+                return abandon("cannot read the vertices of " + plyPath);
+            report(0.5);
+        }
+        else
+        {
+            std::vector<std::vector<PlyPoint>> pending(buckets.size());
+            auto flush = [&](size_t id)
+            {
+                std::FILE *file = std::fopen(bucketFile(id, "bucket").c_str(), "ab");
+                const bool ok = file && std::fwrite(pending[id].data(), sizeof(PlyPoint), pending[id].size(), file) == pending[id].size();
+                if (file)
+                    std::fclose(file);
+                pending[id].clear();
+                return ok;
+            };
+            if (!stream.rewind())
+                return abandon("cannot read " + plyPath);
+            read = 0;
+            for (size_t n; (n = stream.read(batch.data(), batch.size())) > 0;)
+            {
+                for (size_t i = 0; i < n; ++i)
+                {
+                    uint32_t x, y, z;
+                    cube.cell(batch[i], countingLevel, x, y, z);
+                    const uint32_t id = bucketOfCell[gridIndex(x, y, z)];
+                    pending[id].push_back(batch[i]);
+                    if (pending[id].size() >= BucketFlushPoints && !flush(id))
+                        return abandon("cannot write the buckets in " + workDir.string());
+                }
+                read += n;
+                report(0.3 + 0.2 * double(read) / double(total));
+                if (cancelled())
+                    return abandon("");
+            }
+            for (size_t id = 0; id < buckets.size(); ++id)
+                if (!pending[id].empty() && !flush(id))
+                    return abandon("cannot write the buckets in " + workDir.string());
+            if (stream.failed() || read != total)
+                return abandon("cannot read the vertices of " + plyPath);
+        }
+        stream.close();
+        counts.clear();
+        bucketOfCell = std::vector<uint32_t>();
+
+        //---------------------------------------
+        // Subtree of every bucket, in parallel; all but the root go to the bucket's node file
+        //---------------------------------------
+        const Builder builder(options, cube);
+        std::vector<std::vector<OutNode>> bucketNodes(buckets.size());
+        std::atomic<size_t> nextBucket(0), bucketsDone(0);
+        std::atomic<bool> failed(false);
+        std::mutex errorLock;
+        std::string bucketError;
+        auto buildBuckets = [&]
+        {
+            for (size_t id; !failed && !cancelled() && (id = nextBucket++) < buckets.size();)
+            {
+                std::vector<PlyPoint> points;
+                if (buckets.size() == 1)
+                {
+                    points.swap(single);
+                }
+                else
+                {
+                    const std::string path = bucketFile(id, "bucket");
+                    std::error_code sizeError;
+                    std::FILE *file = std::fopen(path.c_str(), "rb");
+                    const uint64_t bytes = file ? fs::file_size(path, sizeError) : 0;
+                    points.resize(static_cast<size_t>(bytes / sizeof(PlyPoint)));
+                    const bool ok = file && std::fread(points.data(), sizeof(PlyPoint), points.size(), file) == points.size();
+                    if (file)
+                        std::fclose(file);
+                    std::error_code ignored;
+                    fs::remove(path, ignored);
+                    if (!ok)
+                    {
+                        std::lock_guard<std::mutex> guard(errorLock);
+                        bucketError = "cannot read " + path;
+                        failed = true;
+                        return;
+                    }
+                }
+
+                std::vector<BuildNode> nodes;
+                const Bucket &bucket = buckets[id];
+                builder.build(std::move(points), bucket.level, bucket.x, bucket.y, bucket.z, nodes);
+
+                // root: kept in memory for the levels above the buckets
+                BuildNode &root = top[bucketTopNode[id]];
+                root.points = std::move(nodes[0].points);
+
+                const std::string path = bucketFile(id, "nodes");
+                std::FILE *file = nodes.size() > 1 ? std::fopen(path.c_str(), "wb") : nullptr;
+                uint64_t offset = 0;
+                bool ok = nodes.size() == 1 || file;
+                for (size_t n = 1; n < nodes.size() && ok; ++n)
+                {
+                    const BuildNode &node = nodes[n];
+                    if (node.points.empty())
+                        continue;
+                    ok = std::fwrite(node.points.data(), sizeof(PlyPoint), node.points.size(), file) == node.points.size();
+                    OutNode out;
+                    out.level = node.level;
+                    out.x = node.x;
+                    out.y = node.y;
+                    out.z = node.z;
+                    out.count = static_cast<uint32_t>(node.points.size());
+                    out.bucket = static_cast<int>(id);
+                    out.fileOffset = offset;
+                    offset += node.points.size();
+                    bucketNodes[id].push_back(out);
+                }
+                if (file)
+                    std::fclose(file);
+                if (!ok)
+                {
+                    std::lock_guard<std::mutex> guard(errorLock);
+                    bucketError = "cannot write " + path;
+                    failed = true;
+                    return;
+                }
+                report(0.5 + 0.4 * double(++bucketsDone) / double(buckets.size()));
+            }
+        };
+        const int threads = std::max(1, std::min<int>(options.threads > 0 ? options.threads : static_cast<int>(std::thread::hardware_concurrency()),
+                                                      static_cast<int>(buckets.size())));
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads; ++t)
+            pool.emplace_back(buildBuckets);
+        buildBuckets();
+        for (std::thread &thread : pool)
+            thread.join();
+        if (failed)
+            return abandon(bucketError);
+        if (cancelled())
+            return abandon("");
+
+        // levels above the buckets, deepest first (children are planned after their parent)
+        for (size_t i = top.size(); i-- > 0;)
+        {
+            bool inner = false;
+            for (const int child : top[i].children)
+                inner = inner || child >= 0;
+            if (inner)
+                builder.sample(static_cast<int>(i), top);
+        }
+
+        //---------------------------------------
+        // Breadth-first order, empty nodes without descendants dropped
+        //---------------------------------------
+        std::vector<OutNode> all;
+        for (const BuildNode &node : top)
+        {
+            OutNode out;
+            out.level = node.level;
+            out.x = node.x;
+            out.y = node.y;
+            out.z = node.z;
+            out.count = static_cast<uint32_t>(node.points.size());
+            out.memory = &node.points;
+            all.push_back(out);
+        }
+        for (const auto &nodes : bucketNodes)
+            all.insert(all.end(), nodes.begin(), nodes.end());
+        for (OutNode &node : all)
+            node.code = morton(node.x, node.y, node.z);
+        auto before = [](const OutNode &a, const OutNode &b)
+        { return a.level != b.level ? a.level < b.level : a.code < b.code; };
+        std::sort(all.begin(), all.end(), before);
+
+        // children of a node: the next level's nodes whose code >> 3 is the node's code
+        auto childRange = [&](size_t i)
+        {
+            OutNode key;
+            key.level = static_cast<uint8_t>(all[i].level + 1);
+            key.code = all[i].code << 3;
+            const auto first = std::lower_bound(all.begin(), all.end(), key, before);
+            auto last = first;
+            while (last != all.end() && last->level == key.level && (last->code >> 3) == all[i].code)
+                ++last;
+            return std::make_pair(static_cast<size_t>(first - all.begin()), static_cast<size_t>(last - all.begin()));
+        };
+        std::vector<bool> kept(all.size(), false);
+        for (size_t i = all.size(); i-- > 0;)
+        {
+            kept[i] = all[i].count > 0;
+            const auto children = childRange(i);
+            for (size_t c = children.first; c < children.second && !kept[i]; ++c)
+                kept[i] = kept[c];
+        }
+        std::vector<OutNode> ordered;
+        for (size_t i = 0; i < all.size(); ++i)
+            if (kept[i])
+                ordered.push_back(all[i]);
+        all.swap(ordered);
+
+        //---------------------------------------
+        // points.bin, hierarchy.bin, metadata.json
+        //---------------------------------------
+        std::vector<LodNodeRecord> records(all.size());
+        uint64_t firstPoint = 0;
+        uint32_t depth = 0;
+        {
+            std::FILE *points = std::fopen((workDir / "points.bin").string().c_str(), "wb");
+            if (!points)
+                return abandon("cannot write " + (workDir / "points.bin").string());
+            std::vector<std::FILE *> nodeFiles(buckets.size(), nullptr);
+            std::vector<PlyPoint> copy;
+            bool ok = true;
+            for (size_t i = 0; i < all.size() && ok; ++i)
+            {
+                const OutNode &node = all[i];
+                LodNodeRecord &record = records[i];
+                std::memset(&record, 0, sizeof(record));
+                record.firstPoint = firstPoint;
+                record.pointCount = node.count;
+                record.x = node.x;
+                record.y = node.y;
+                record.z = node.z;
+                record.level = node.level;
+                const auto children = childRange(i);
+                if (children.first < children.second)
+                    record.firstChild = static_cast<uint32_t>(children.first);
+                for (size_t c = children.first; c < children.second; ++c)
+                    record.childMask |= static_cast<uint8_t>(1u << (all[c].code & 7));
+                depth = std::max<uint32_t>(depth, node.level);
+
+                if (node.memory)
+                {
+                    ok = std::fwrite(node.memory->data(), sizeof(PlyPoint), node.count, points) == node.count;
+                }
+                else if (node.count > 0)
+                {
+                    std::FILE *&source = nodeFiles[node.bucket];
+                    if (!source)
+                        source = std::fopen(bucketFile(node.bucket, "nodes").c_str(), "rb");
+                    copy.resize(node.count);
+                    ok = source && seekFile(source, node.fileOffset * sizeof(PlyPoint)) &&
+                         std::fread(copy.data(), sizeof(PlyPoint), node.count, source) == node.count &&
+                         std::fwrite(copy.data(), sizeof(PlyPoint), node.count, points) == node.count;
+                }
+                firstPoint += node.count;
+                if (i % 1024 == 0)
+                    report(0.9 + 0.1 * double(i) / double(all.size()));
+            }
+            for (std::FILE *file : nodeFiles)
+                if (file)
+                    std::fclose(file);
+            ok = std::fclose(points) == 0 && ok;
+            if (!ok)
+                return abandon("cannot write " + (workDir / "points.bin").string());
+        }
+        if (cancelled())
+            return abandon("");
+        for (size_t id = 0; id < buckets.size(); ++id)
+            fs::remove(bucketFile(id, "nodes"), ec);
+
+        LodFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "VFLOD01", 8);
+        for (int axis = 0; axis < 3; ++axis)
+            header.cubeMin[axis] = cube.min[axis];
+        header.cubeSize = cube.size;
+        header.points = firstPoint;
+        header.nodes = static_cast<uint32_t>(records.size());
+        header.sampleGrid = options.sampleGrid;
+        header.maxNodePoints = options.maxNodePoints;
+        header.depth = depth;
+        std::vector<char> hierarchy(sizeof(header) + records.size() * sizeof(LodNodeRecord));
+        std::memcpy(hierarchy.data(), &header, sizeof(header));
+        std::memcpy(hierarchy.data() + sizeof(header), records.data(), records.size() * sizeof(LodNodeRecord));
+
+        char metadata[1024];
+        std::snprintf(metadata, sizeof(metadata),
+                      "{\n  \"format\": \"VFLOD01\",\n  \"points\": %llu,\n  \"nodes\": %u,\n  \"depth\": %u,\n"
+                      "  \"cube_min\": [%.17g, %.17g, %.17g],\n  \"cube_size\": %.17g,\n"
+                      "  \"sample_grid\": %u,\n  \"max_node_points\": %u,\n"
+                      "  \"point_record\": \"float32 x, y, z; uint8 r, g, b, a\",\n"
+                      "  \"node_record\": \"uint64 first_point; uint32 point_count, first_child, x, y, z; uint8 level, child_mask; uint16 reserved\"\n}\n",
+                      static_cast<unsigned long long>(header.points), header.nodes, header.depth,
+                      cube.min[0], cube.min[1], cube.min[2], cube.size, header.sampleGrid, header.maxNodePoints);
+        if (!writeFile((workDir / "hierarchy.bin").string(), hierarchy.data(), hierarchy.size()) ||
+            !writeFile((workDir / "metadata.json").string(), metadata, std::strlen(metadata)))
+            return abandon("cannot write the hierarchy in " + workDir.string());
+
+        // readers never see a half-written folder
+        fs::remove_all(finalDir, ec);
+        fs::rename(workDir, finalDir, ec);
+        if (ec)
+            return abandon("cannot move " + workDir.string() + " to " + outDir + ": " + ec.message());
+        report(1.0);
+
+        if (stats)
+        {
+            stats->points = header.points;
+            stats->nodes = header.nodes;
+            stats->depth = depth;
+            stats->buckets = static_cast<uint32_t>(buckets.size());
+            stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        return true;
+    }
+
+    void PointLod::nodeCube(const LodNodeRecord &node, double min[3], double &size) const
+    {
+        size = header.cubeSize / double(1u << node.level);
+        min[0] = header.cubeMin[0] + node.x * size;
+        min[1] = header.cubeMin[1] + node.y * size;
+        min[2] = header.cubeMin[2] + node.z * size;
+    }
+
+    bool ReadPointLod(const std::string &directory, PointLod &lod, std::string *error)
+    {
+        lod = PointLod();
+        lod.directory = directory;
+        std::ifstream in(fs::path(directory) / "hierarchy.bin", std::ios::binary);
+        if (!in.read(reinterpret_cast<char *>(&lod.header), sizeof(lod.header)) ||
+            std::memcmp(lod.header.magic, "VFLOD01", 8) != 0)
+            return fail(error, directory + " is not a point LOD folder");
+        lod.nodes.resize(lod.header.nodes);
+        if (!in.read(reinterpret_cast<char *>(lod.nodes.data()), static_cast<std::streamsize>(lod.nodes.size() * sizeof(LodNodeRecord))))
+            return fail(error, "truncated hierarchy in " + directory);
+        return true;
+    }
+
+    bool ReadLodNodePoints(const PointLod &lod, const LodNodeRecord &node, std::vector<PlyPoint> &points)
+    {
+        points.resize(node.pointCount);
+        if (node.pointCount == 0)
+            return true;
+        std::ifstream in(fs::path(lod.directory) / "points.bin", std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(node.firstPoint * sizeof(PlyPoint)));
+        return static_cast<bool>(in.read(reinterpret_cast<char *>(points.data()), static_cast<std::streamsize>(node.pointCount * sizeof(PlyPoint))));
+    }
+
+    std::vector<uint32_t> SelectLodNodes(const PointLod &lod, const LodView &view)
+    {
+        std::vector<uint32_t> selected;
+        if (lod.nodes.empty())
+            return selected;
+
+        // outside the view when all corners are beyond one clip plane
+        auto visible = [&](const double min[3], double size)
+        {
+            int outside[6] = {0, 0, 0, 0, 0, 0};
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                const double p[3] = {min[0] + (corner & 1) * size, min[1] + (corner >> 1 & 1) * size, min[2] + (corner >> 2 & 1) * size};
+                double clip[4];
+                for (int r = 0; r < 4; ++r)
+                    clip[r] = view.viewProj[r * 4] * p[0] + view.viewProj[r * 4 + 1] * p[1] + view.viewProj[r * 4 + 2] * p[2] + view.viewProj[r * 4 + 3];
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    outside[axis * 2] += clip[axis] < -clip[3];
+                    outside[axis * 2 + 1] += clip[axis] > clip[3];
+                }
+            }
+            return std::find(outside, outside + 6, 8) == outside + 6;
+        };
+        // point spacing of the node in pixels, at its closest point to the eye
+        auto screenSpacing = [&](const double min[3], double size)
+        {
+            double distance2 = 0;
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                const double d = std::max({min[axis] - view.eye[axis], 0.0, view.eye[axis] - (min[axis] + size)});
+                distance2 += d * d;
+            }
+            const double spacing = size / std::max(1u, lod.header.sampleGrid);
+            return spacing * view.focalPixels / std::max(std::sqrt(distance2), spacing * 1e-3);
+        };
+
+        std::priority_queue<std::pair<double, uint32_t>> queue;
+        double min[3], size;
+        lod.nodeCube(lod.nodes[0], min, size);
+        if (visible(min, size))
+            queue.emplace(screenSpacing(min, size), 0);
+        uint64_t points = 0;
+        while (!queue.empty())
+        {
+            const auto [spacing, index] = queue.top();
+            queue.pop();
+            const LodNodeRecord &node = lod.nodes[index];
+            if (!selected.empty() && points + node.pointCount > view.pointBudget)
+                break;
+            selected.push_back(index);
+            points += node.pointCount;
+            if (spacing <= view.spacingPixels || node.firstChild == 0)
+                continue;
+            for (uint32_t octant = 0, child = node.firstChild; octant < 8; ++octant)
+            {
+                if (!(node.childMask >> octant & 1))
+                    continue;
+                if (child < lod.nodes.size())
+                {
+                    lod.nodeCube(lod.nodes[child], min, size);
+                    if (visible(min, size))
+                        queue.emplace(screenSpacing(min, size), child);
+                }
+                ++child;
+            }
+        }
+        return selected;
+    }
+}
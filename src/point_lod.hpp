@@ -0,0 +1,114 @@
+#pragma once
+
+// Level-of-detail octree of a point cloud (the "<cloud>.lod" folder next to
+// the sparse and dense PLY outputs), so viewers load only the nodes they need.
+//
+// The root covers the cubic bounding box of the cloud and every node splits
+// into eight octants. Leaves keep their points. An inner node keeps a sample
+// of its subtree: at most one point per cell of a sampleGrid^3 grid over the
+// node, moved up from its children. Each point is stored once, and a node
+// plus its ancestors give the cloud at that node's resolution.
+//
+// The build streams the PLY three times (bounds, a counting grid, then a
+// split into bucket files of at most the memory budget). Each bucket's
+// subtree is built in memory, several in parallel, and the levels above the
+// buckets are sampled from their roots. Clouds larger than RAM build in
+// bounded memory.
+//
+// Files of the folder (little endian):
+//   hierarchy.bin  LodFileHeader, then LodNodeRecord per node in breadth-first
+//                  order (by level, then Morton code of the cell)
+//   points.bin     PlyPoint records (16 bytes); a node's points are contiguous
+//   metadata.json  the header fields for other tools
+
+#include "ply_io.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace VoxelForge
+{
+    struct LodOptions
+    {
+        uint32_t maxNodePoints = 20000; // points of a leaf, and most samples an inner node keeps
+        uint32_t sampleGrid = 128;      // sampling cells per axis of a node: spacing = node size / sampleGrid
+        uint32_t maxDepth = 16;         // deepest level (leaves there may exceed maxNodePoints), at most 20
+        uint32_t memoryBudgetMB = 1024; // points in memory at once; the cloud is split into buckets under it
+        int threads = 0;                // buckets built in parallel, 0 = one per core
+    };
+
+    struct LodStats
+    {
+        uint64_t points = 0;
+        uint64_t nodes = 0;
+        uint32_t depth = 0;   // deepest level
+        uint32_t buckets = 0; // parts built separately (1: in memory at once)
+        double seconds = 0;
+    };
+
+    // Builds outDir (replaced when it exists, written next to it first) from the vertices of plyPath.
+    // progress gets the fraction done; after *cancel becomes true the build stops and writes nothing
+    bool BuildPointLod(const std::string &plyPath, const std::string &outDir, const LodOptions &options,
+                       LodStats *stats = nullptr, std::string *error = nullptr,
+                       const std::function<void(double fraction)> &progress = nullptr,
+                       const std::atomic<bool> *cancel = nullptr);
+
+#pragma pack(push, 1)
+    struct LodFileHeader // 64 bytes
+    {
+        char magic[8];        // "VFLOD01"
+        double cubeMin[3];    // root cube
+        double cubeSize;
+        uint64_t points;
+        uint32_t nodes;
+        uint32_t sampleGrid;  // spacing of a node at level l: cubeSize / 2^l / sampleGrid
+        uint32_t maxNodePoints;
+        uint32_t depth;
+    };
+
+    struct LodNodeRecord // 32 bytes
+    {
+        uint64_t firstPoint; // index of its first point in points.bin
+        uint32_t pointCount;
+        uint32_t firstChild; // index of its first child (children are consecutive, by octant), 0 = leaf
+        uint32_t x, y, z;    // cell of the node in the 2^level grid of the root cube
+        uint8_t level;
+        uint8_t childMask;   // bit i: child in octant i = x bit + 2 * y bit + 4 * z bit
+        uint16_t reserved;
+    };
+#pragma pack(pop)
+
+    struct PointLod
+    {
+        std::string directory;
+        LodFileHeader header{};
+        std::vector<LodNodeRecord> nodes;
+
+        // bounding cube of a node
+        void nodeCube(const LodNodeRecord &node, double min[3], double &size) const;
+    };
+
+    // hierarchy.bin of a .lod folder
+    bool ReadPointLod(const std::string &directory, PointLod &lod, std::string *error = nullptr);
+    // the points of one node from points.bin
+    bool ReadLodNodePoints(const PointLod &lod, const LodNodeRecord &node, std::vector<PlyPoint> &points);
+
+    struct LodView
+    {
+        double viewProj[16];          // row major, clip = viewProj * (x, y, z, 1) (soft_raster.hpp)
+        double eye[3];
+        double focalPixels = 1000;    // pixels per unit at distance 1: viewport height / 2 / tan(fovY / 2)
+        double spacingPixels = 1.5;   // nodes are refined until their point spacing on screen is below this
+        uint64_t pointBudget = 3000000;
+    };
+
+    // Visible nodes showing the cloud at the resolution of the view, within the point budget: the nodes of the
+    // largest point spacing on screen first. A node is listed after its parent, so any prefix is a coarser view
+    std::vector<uint32_t> SelectLodNodes(const PointLod &lod, const LodView &view);
+
+    // "<cloud>.lod" next to "<cloud>.ply"
+    std::string LodDirectoryFor(const std::string &plyPath);
+}
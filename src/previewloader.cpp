@@ -0,0 +1,152 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// Asynchronous image preview decoding for the image manager
+
+#include "previewloader.h"
+#include "thread_budget.hpp"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QMetaObject>
+#include <QMutexLocker>
+#include <QRunnable>
+
+class PreviewTask : public QRunnable
+{
+public:
+    PreviewTask(PreviewLoader *loader, const QString &imagePath, const QSize &targetSize,
+                quint64 requestId, bool isPrefetch)
+        : loader(loader), imagePath(imagePath), targetSize(targetSize),
+          requestId(requestId), isPrefetch(isPrefetch) {}
+
+    void run() override
+    {
+        // the user already clicked something else
+        if (!isPrefetch && loader->currentRequest != requestId)
+            return;
+        const VoxelForge::ThreadLease lease(1); // the decode's thread, out of the pipeline's budget
+
+        const QString key = PreviewLoader::cacheKey(imagePath, targetSize);
+        QImage image;
+        if (!loader->cached(key, image))
+        {
+            // decode at (close to) label resolution instead of full size
+            QImageReader reader(imagePath);
+            reader.setAutoTransform(true);
+            const QSize fullSize = reader.size();
+            if (fullSize.isValid())
+                reader.setScaledSize(fullSize.scaled(targetSize, Qt::KeepAspectRatio));
+            image = reader.read();
+
+            if (!image.isNull())
+                loader->store(key, image);
+        }
+
+        if (isPrefetch || loader->currentRequest != requestId)
+            return;
+
+        emit loader->previewReady(imagePath, image);
+        if (image.isNull())
+        {
+            PreviewLoader *target = loader;
+            const quint64 id = requestId;
+            QMetaObject::invokeMethod(loader, [target, id]
+                                      { target->decodeFailed(id); }, Qt::QueuedConnection);
+        }
+    }
+
+private:
+    PreviewLoader *loader;
+    QString imagePath;
+    QSize targetSize;
+    quint64 requestId;
+    bool isPrefetch;
+};
+
+PreviewLoader::PreviewLoader(QObject *parent)
+    : QObject(parent), currentRequest(0)
+{
+    // one for the current preview, one for prefetching (a single one on a 1-thread budget)
+    pool.setMaxThreadCount(qMin(2, VoxelForge::ThreadBudget::limit()));
+    cache.setMaxCost(64 * 1024 * 1024);
+}
+
+PreviewLoader::~PreviewLoader()
+{
+    cancel();
+    pool.waitForDone();
+}
+
+void PreviewLoader::cancel()
+{
+    ++currentRequest;
+    currentKey.clear();
+    pool.clear();
+}
+
+void PreviewLoader::request(const QString &imagePath, const QSize &targetSize)
+{
+    const QString key = cacheKey(imagePath, targetSize);
+    if (key == currentKey)
+        return; // already shown or on its way (click + current-changed)
+
+    const quint64 id = ++currentRequest;
+    currentKey = key;
+
+    // whatever is still queued (stale previews, old prefetches) is not needed any more
+    pool.clear();
+
+    QImage image;
+    if (cached(key, image))
+    {
+        emit previewReady(imagePath, image);
+        return;
+    }
+
+    PreviewTask *task = new PreviewTask(this, imagePath, targetSize, id, false);
+    task->setAutoDelete(true);
+    pool.start(task, 1);
+}
+
+void PreviewLoader::prefetch(const QStringList &imagePaths, const QSize &targetSize)
+{
+    for (const QString &path : imagePaths)
+    {
+        QImage image;
+        if (path.isEmpty() || cached(cacheKey(path, targetSize), image))
+            continue;
+
+        PreviewTask *task = new PreviewTask(this, path, targetSize, 0, true);
+        task->setAutoDelete(true);
+        pool.start(task, 0);
+    }
+}
+
+QString PreviewLoader::cacheKey(const QString &imagePath, const QSize &targetSize)
+{
+    const qint64 modified = QFileInfo(imagePath).lastModified().toMSecsSinceEpoch();
+    return imagePath + QString("|%1|%2x%3").arg(modified).arg(targetSize.width()).arg(targetSize.height());
+}
+
+bool PreviewLoader::cached(const QString &key, QImage &image)
+{
+    QMutexLocker lock(&cacheMutex);
+    if (QImage *hit = cache.object(key))
+    {
+        image = *hit;
+        return true;
+    }
+    return false;
+}
+
+void PreviewLoader::store(const QString &key, const QImage &image)
+{
+    QMutexLocker lock(&cacheMutex);
+    cache.insert(key, new QImage(image), static_cast<int>(image.sizeInBytes()));
+}
+
+void PreviewLoader::decodeFailed(quint64 requestId)
+{
+    if (currentRequest == requestId)
+        currentKey.clear();
+}
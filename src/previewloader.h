@@ -0,0 +1,59 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// Asynchronous image preview decoding for the image manager
+
+#ifndef PREVIEWLOADER_H
+#define PREVIEWLOADER_H
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+
+// Decodes previews straight to the label resolution on a small worker pool.
+// Only the latest request() is delivered: queued older requests are dropped
+// and ones already decoding are discarded when they finish. Neighbours of the
+// selection can be prefetched into a small cache so stepping through the list
+// shows them instantly.
+class PreviewLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PreviewLoader(QObject *parent = nullptr);
+    ~PreviewLoader() override;
+
+    // Supersedes any earlier request; previewReady is emitted (queued) when done
+    void request(const QString &imagePath, const QSize &targetSize);
+    // Decode into the cache at low priority, no signal
+    void prefetch(const QStringList &imagePaths, const QSize &targetSize);
+    // Forget the current request (preview cleared); nothing is delivered for it
+    void cancel();
+
+signals:
+    // image is null if the file could not be decoded
+    void previewReady(const QString &imagePath, const QImage &image);
+
+private:
+    friend class PreviewTask;
+
+    // path + modification time + size: a replaced file is decoded again
+    static QString cacheKey(const QString &imagePath, const QSize &targetSize);
+    bool cached(const QString &key, QImage &image);
+    void store(const QString &key, const QImage &image);
+    // GUI thread: the decode of requestId failed, a new request for it is not dropped
+    void decodeFailed(quint64 requestId);
+
+    QThreadPool pool;
+    std::atomic<quint64> currentRequest;
+    QString currentKey;
+
+    QMutex cacheMutex;
+    QCache<QString, QImage> cache;
+};
+
+#endif // PREVIEWLOADER_H
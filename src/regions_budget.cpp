@@ -0,0 +1,281 @@
+#include "regions_budget.hpp"
+
+#include "openMVG/third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace OpenMVG_Wrappers
+{
+    namespace
+    {
+        // in-memory feature: SIOPointFeature (x, y, scale, orientation)
+        constexpr uint64_t FeatureBytes = 4 * sizeof(float);
+
+        // matcher working copies of the regions (cascade hashing codes, zero-mean descriptors, ANN indexes)
+        constexpr uint64_t MatcherOverhead = 2;
+
+        // Reverse Cuthill-McKee order of the pair graph: breadth-first from a lowest degree view,
+        // neighbours by increasing degree, reversed. Connected views get close ranks
+        std::map<openMVG::IndexT, size_t> localityRanks(const std::vector<openMVG::Pair> &pairs)
+        {
+            std::map<openMVG::IndexT, std::vector<openMVG::IndexT>> adjacency;
+            for (const openMVG::Pair &pair : pairs)
+            {
+                adjacency[pair.first].push_back(pair.second);
+                adjacency[pair.second].push_back(pair.first);
+            }
+            auto byDegree = [&](openMVG::IndexT a, openMVG::IndexT b)
+            {
+                const size_t da = adjacency[a].size(), db = adjacency[b].size();
+                return da != db ? da < db : a < b;
+            };
+            for (auto &node : adjacency)
+                std::sort(node.second.begin(), node.second.end(), byDegree);
+
+            std::vector<openMVG::IndexT> seeds;
+            seeds.reserve(adjacency.size());
+            for (const auto &node : adjacency)
+                seeds.push_back(node.first);
+            std::sort(seeds.begin(), seeds.end(), byDegree);
+
+            std::vector<openMVG::IndexT> order;
+            order.reserve(adjacency.size());
+            std::set<openMVG::IndexT> visited;
+            for (const openMVG::IndexT seed : seeds) // one breadth-first pass per connected component
+            {
+                if (!visited.insert(seed).second)
+                    continue;
+                size_t head = order.size();
+                order.push_back(seed);
+                while (head < order.size())
+                {
+                    for (const openMVG::IndexT next : adjacency[order[head++]])
+                    {
+                        if (visited.insert(next).second)
+                            order.push_back(next);
+                    }
+                }
+            }
+
+            std::map<openMVG::IndexT, size_t> rank;
+            for (size_t i = 0; i < order.size(); ++i)
+                rank[order[order.size() - 1 - i]] = i;
+            return rank;
+        }
+
+        // pairs grouped by (row, column) block, tiles ordered as described in the header
+        std::vector<std::vector<openMVG::Pair>> pairTiles(const std::vector<openMVG::Pair> &pairs, unsigned int blockSize)
+        {
+            std::map<openMVG::IndexT, size_t> rank = localityRanks(pairs);
+
+            std::map<std::pair<size_t, size_t>, std::vector<openMVG::Pair>> tiles;
+            for (const openMVG::Pair &pair : pairs)
+            {
+                const size_t a = rank[pair.first] / blockSize, b = rank[pair.second] / blockSize;
+                tiles[{std::min(a, b), std::max(a, b)}].push_back(pair);
+            }
+
+            // even rows left to right, odd rows right to left: the turn often reuses the last column block
+            const size_t blocks = (rank.size() + blockSize - 1) / blockSize;
+            std::vector<std::vector<openMVG::Pair>> ordered;
+            for (size_t row = 0; row < blocks; ++row)
+            {
+                for (size_t step = 0; step < blocks - row; ++step)
+                {
+                    const size_t column = row % 2 == 0 ? row + step : blocks - 1 - step;
+                    auto tile = tiles.find({row, column});
+                    if (tile != tiles.end())
+                        ordered.push_back(std::move(tile->second));
+                }
+            }
+            return ordered;
+        }
+    }
+
+    RegionsFootprint EstimateRegionsFootprint(const openMVG::sfm::SfM_Data &sfm_data, const std::string &sMatchesDir)
+    {
+        RegionsFootprint footprint;
+        for (const auto &view_it : sfm_data.GetViews())
+        {
+            const std::string sDesc = stlplus::create_filespec(
+                sMatchesDir, stlplus::basename_part(view_it.second->s_Img_path), "desc");
+
+            // binary descriptors file: size_t count, then the raw descriptors
+            std::ifstream file(sDesc, std::ios::binary | std::ios::ate);
+            if (!file)
+                continue;
+            const uint64_t fileBytes = static_cast<uint64_t>(file.tellg());
+            uint64_t count = 0;
+            file.seekg(0);
+            if (fileBytes < sizeof(std::size_t) || !file.read(reinterpret_cast<char *>(&count), sizeof(std::size_t)))
+                continue;
+
+            const uint64_t bytes = (fileBytes - sizeof(std::size_t)) + count * FeatureBytes;
+            footprint.viewBytes[view_it.first] = bytes;
+            footprint.totalBytes += bytes;
+            footprint.largestBytes = std::max(footprint.largestBytes, bytes);
+        }
+        return footprint;
+    }
+
+    uint64_t DefaultRegionsBudgetBytes()
+    {
+#ifdef _WIN32
+        MEMORYSTATUSEX status;
+        status.dwLength = sizeof(status);
+        if (GlobalMemoryStatusEx(&status))
+            return status.ullTotalPhys / 2;
+#else
+        const long pages = sysconf(_SC_PHYS_PAGES);
+        const long pageSize = sysconf(_SC_PAGE_SIZE);
+        if (pages > 0 && pageSize > 0)
+            return static_cast<uint64_t>(pages) * static_cast<uint64_t>(pageSize) / 2;
+#endif
+        return uint64_t(4) << 30;
+    }
+
+    RegionsPlan PlanRegionsMemory(const RegionsFootprint &footprint, uint64_t budgetBytes)
+    {
+        RegionsPlan plan;
+        if (budgetBytes == 0 || footprint.largestBytes == 0 ||
+            footprint.totalBytes * MatcherOverhead <= budgetBytes)
+            return plan;
+
+        // sized on the largest view so any tile fits; a tile needs the views of two blocks
+        const uint64_t views = budgetBytes / (footprint.largestBytes * MatcherOverhead);
+        plan.cacheSize = static_cast<unsigned int>(std::max<uint64_t>(2, std::min<uint64_t>(views, footprint.viewBytes.size())));
+        plan.blockSize = std::max(1u, plan.cacheSize / 2);
+        return plan;
+    }
+
+    std::vector<openMVG::Pair_Set> BlockedPairTiles(const openMVG::Pair_Set &pairs, unsigned int blockSize)
+    {
+        std::vector<openMVG::Pair_Set> result;
+        if (blockSize == 0)
+        {
+            result.push_back(pairs);
+            return result;
+        }
+
+        for (const auto &tile : pairTiles(std::vector<openMVG::Pair>(pairs.begin(), pairs.end()), blockSize))
+            result.emplace_back(tile.begin(), tile.end());
+        return result;
+    }
+
+    std::vector<openMVG::matching::PairWiseMatches> BlockedMatchTiles(const openMVG::matching::PairWiseMatches &matches, unsigned int blockSize)
+    {
+        std::vector<openMVG::matching::PairWiseMatches> result;
+        if (blockSize == 0)
+        {
+            result.push_back(matches);
+            return result;
+        }
+
+        std::vector<openMVG::Pair> keys;
+        keys.reserve(matches.size());
+        for (const auto &pair_it : matches)
+            keys.push_back(pair_it.first);
+        for (const auto &tile : pairTiles(keys, blockSize))
+        {
+            openMVG::matching::PairWiseMatches tileMatches;
+            for (const openMVG::Pair &pair : tile)
+                tileMatches.insert(*matches.find(pair));
+            result.push_back(std::move(tileMatches));
+        }
+        return result;
+    }
+
+    CountedRegionsCache::CountedRegionsCache(unsigned int maxCacheSize)
+        : openMVG::sfm::Regions_Provider_Cache(maxCacheSize), capacity(std::max(1u, maxCacheSize))
+    {
+    }
+
+    bool CountedRegionsCache::load(const openMVG::sfm::SfM_Data &sfm_data,
+                                   const std::string &feat_directory,
+                                   std::unique_ptr<openMVG::features::Regions> &region_type,
+                                   openMVG::system::ProgressInterface *progress)
+    {
+        // the base keeps the regions type (IsScalar(), Type_id(), ...) and checks the files
+        if (!openMVG::sfm::Regions_Provider_Cache::load(sfm_data, feat_directory, region_type, progress))
+            return false;
+
+        regionType.reset(region_type->EmptyClone());
+        for (const auto &view_it : sfm_data.GetViews())
+        {
+            const std::string basename = stlplus::basename_part(view_it.second->s_Img_path);
+            files[view_it.first] = {stlplus::create_filespec(feat_directory, basename, "feat"),
+                                    stlplus::create_filespec(feat_directory, basename, "desc")};
+        }
+        return true;
+    }
+
+    std::shared_ptr<openMVG::features::Regions> CountedRegionsCache::get(const openMVG::IndexT x) const
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        ++stats.requests;
+
+        for (;;)
+        {
+            const auto entry = entries.find(x);
+            if (entry != entries.end())
+            {
+                recent.splice(recent.begin(), recent, entry->second.second);
+                return entry->second.first;
+            }
+            if (loading.count(x) == 0)
+                break;
+            loaded.wait(guard);
+        }
+
+        const auto file = files.find(x);
+        if (file == files.end() || !regionType)
+            return nullptr;
+
+        // other views are served (and read) meanwhile; the ones asking for x wait above
+        loading.insert(x);
+        guard.unlock();
+        std::shared_ptr<openMVG::features::Regions> regions(regionType->EmptyClone());
+        const bool ok = regions->Load(file->second.first, file->second.second);
+        guard.lock();
+        loading.erase(x);
+        loaded.notify_all();
+        if (!ok)
+            return nullptr;
+
+        ++stats.loads;
+        if (!loadedOnce.insert(x).second)
+            ++stats.reloads;
+
+        // evicted regions stay alive while a matcher thread still holds them
+        recent.push_front(x);
+        entries[x] = {regions, recent.begin()};
+        while (entries.size() > capacity)
+        {
+            entries.erase(recent.back());
+            recent.pop_back();
+        }
+        return regions;
+    }
+
+    CountedRegionsCache::Counters CountedRegionsCache::counters() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return stats;
+    }
+
+    std::string CountedRegionsCache::summary() const
+    {
+        const Counters c = counters();
+        const uint64_t hitPercent = c.requests > 0 ? (c.requests - c.loads) * 100 / c.requests : 0;
+        return std::to_string(c.loads) + " disk reads for " + std::to_string(c.loads - c.reloads) + " views (" +
+               std::to_string(c.reloads) + " reloads), hit rate " + std::to_string(hitPercent) + "%";
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+// Memory budget of the regions (features + descriptors) held in RAM by
+// ComputeMatches and GeometricFilter.
+//
+// The footprint is estimated from the .desc files before anything is loaded
+// (feature count from their header, raw descriptor bytes). When it exceeds the
+// budget the stages switch to a regions cache and process the pairs tile by
+// tile: a tile holds the pairs (I, J) of one block of views by another block,
+// so only the views of the current tile are needed, and tiles are visited in
+// serpentine order so consecutive tiles share a block (cache hits).
+//
+// Views are ranked by graph locality before blocking (reverse Cuthill-McKee
+// on the pair graph): for sparse pair lists (sequential or retrieval pairs)
+// the pairs then gather near the diagonal of the pair matrix and cover few
+// tiles. Exhaustive pairs are unaffected.
+
+#include "openMVG/features/regions.hpp"
+#include "openMVG/matching/indMatch.hpp"
+#include "openMVG/sfm/pipelines/sfm_regions_provider_cache.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/types.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace OpenMVG_Wrappers
+{
+    struct RegionsFootprint
+    {
+        std::map<openMVG::IndexT, uint64_t> viewBytes; // by view id, views without regions files are left out
+        uint64_t totalBytes = 0;
+        uint64_t largestBytes = 0;
+    };
+
+    // Regions files as written by RunComputeFeatures (<sMatchesDir>/<image basename>.desc)
+    RegionsFootprint EstimateRegionsFootprint(const openMVG::sfm::SfM_Data &sfm_data, const std::string &sMatchesDir);
+
+    // Half the physical memory (the rest is left to the OS, the matches and the other steps)
+    uint64_t DefaultRegionsBudgetBytes();
+
+    struct RegionsPlan
+    {
+        unsigned int cacheSize = 0; // views kept by the regions cache, 0 = all regions in RAM
+        unsigned int blockSize = 0; // views per tile side, 0 = no tiling
+    };
+
+    // budgetBytes covers the regions and the matcher working copies of them
+    RegionsPlan PlanRegionsMemory(const RegionsFootprint &footprint, uint64_t budgetBytes);
+
+    // Pairs grouped in blockSize x blockSize tiles of the pair matrix (views ranked by locality),
+    // serpentine order: a row of tiles keeps its row block, the next row starts where the last ended
+    std::vector<openMVG::Pair_Set> BlockedPairTiles(const openMVG::Pair_Set &pairs, unsigned int blockSize);
+
+    // Same tiling for the pairs of a matches container
+    std::vector<openMVG::matching::PairWiseMatches> BlockedMatchTiles(const openMVG::matching::PairWiseMatches &matches, unsigned int blockSize);
+
+    // Regions_Provider_Cache with least-recently-used eviction that counts how often
+    // regions are read from disk, to report the cache efficiency of the pair order
+    class CountedRegionsCache : public openMVG::sfm::Regions_Provider_Cache
+    {
+    public:
+        explicit CountedRegionsCache(unsigned int maxCacheSize);
+
+        bool load(const openMVG::sfm::SfM_Data &sfm_data,
+                  const std::string &feat_directory,
+                  std::unique_ptr<openMVG::features::Regions> &region_type,
+                  openMVG::system::ProgressInterface *progress = nullptr) override;
+
+        std::shared_ptr<openMVG::features::Regions> get(const openMVG::IndexT x) const override;
+
+        struct Counters
+        {
+            uint64_t requests = 0;
+            uint64_t loads = 0;   // reads from disk
+            uint64_t reloads = 0; // reads of views evicted before
+        };
+        Counters counters() const;
+        // "<loads> disk reads for <views> views (<reloads> reloads), hit rate <n>%"
+        std::string summary() const;
+
+    private:
+        const unsigned int capacity;
+        std::unique_ptr<openMVG::features::Regions> regionType;
+        std::map<openMVG::IndexT, std::pair<std::string, std::string>> files; // .feat, .desc
+
+        // held for the bookkeeping only, not while regions are read from disk
+        mutable std::mutex lock;
+        mutable std::condition_variable loaded;
+        mutable std::set<openMVG::IndexT> loading; // read by some thread right now, others wait for it
+        mutable std::list<openMVG::IndexT> recent; // most recently used first
+        mutable std::map<openMVG::IndexT, std::pair<std::shared_ptr<openMVG::features::Regions>, std::list<openMVG::IndexT>::iterator>> entries;
+        mutable std::set<openMVG::IndexT> loadedOnce;
+        mutable Counters stats;
+    };
+}
@@ -0,0 +1,457 @@
+#include "soft_raster.hpp"
+#include "thread_budget.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace VoxelForge
+{
+    namespace
+    {
+        constexpr size_t PointsPerTask = 65536;
+        constexpr size_t FacesPerTask = 16384;
+        constexpr uint32_t ClipFlag = 0x80000000u; // in a face bin: crosses the near plane, clipped by every band
+
+        struct ClipVertex
+        {
+            double x, y, z, w;
+            float u, v;
+            float r, g, b;
+        };
+
+        // attributes divided by w, for perspective-correct interpolation
+        struct ScreenVertex
+        {
+            float x, y, z, invW;
+            float u, v;
+            float r, g, b;
+        };
+
+        struct FaceTarget
+        {
+            uint32_t *color;
+            float *depth;
+            int width, height;
+            int rowBegin, rowEnd;
+            const RasterTexture *texture; // nullptr: colours
+            float shade;
+        };
+
+        void transform(const double m[16], double x, double y, double z, double clip[4])
+        {
+            for (int r = 0; r < 4; ++r)
+                clip[r] = m[r * 4] * x + m[r * 4 + 1] * y + m[r * 4 + 2] * z + m[r * 4 + 3];
+        }
+
+        uint32_t packColor(float r, float g, float b)
+        {
+            auto channel = [](float value)
+            { return static_cast<uint32_t>(std::min(255.f, std::max(0.f, value + 0.5f))); };
+            return 0xFF000000u | channel(r) << 16 | channel(g) << 8 | channel(b);
+        }
+
+        uint32_t sample(const RasterTexture &texture, float u, float v)
+        {
+            u -= std::floor(u);
+            v -= std::floor(v);
+            const int x = std::min(texture.width - 1, static_cast<int>(u * texture.width));
+            const int y = std::min(texture.height - 1, static_cast<int>((1.f - v) * texture.height));
+            return texture.pixels[static_cast<size_t>(y) * texture.width + x] | 0xFF000000u;
+        }
+
+        ScreenVertex toScreen(const ClipVertex &c, int width, int height)
+        {
+            const double invW = 1.0 / c.w;
+            ScreenVertex s;
+            s.x = static_cast<float>((c.x * invW * 0.5 + 0.5) * width);
+            s.y = static_cast<float>((0.5 - c.y * invW * 0.5) * height);
+            s.z = static_cast<float>(c.z * invW);
+            s.invW = static_cast<float>(invW);
+            s.u = static_cast<float>(c.u * invW);
+            s.v = static_cast<float>(c.v * invW);
+            s.r = static_cast<float>(c.r * invW);
+            s.g = static_cast<float>(c.g * invW);
+            s.b = static_cast<float>(c.b * invW);
+            return s;
+        }
+
+        // edge function: positive when p is left of a -> b (screen y down)
+        float edge(const ScreenVertex &a, const ScreenVertex &b, float px, float py)
+        {
+            return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+        }
+
+        // pixel centres inside the triangle, in the rows of the target band
+        void fillTriangle(ScreenVertex a, ScreenVertex b, ScreenVertex c, const FaceTarget &t)
+        {
+            float area = edge(a, b, c.x, c.y);
+            if (std::fabs(area) < 1e-12f)
+                return;
+            if (area < 0)
+            {
+                std::swap(b, c);
+                area = -area;
+            }
+            const int minX = std::max(0, static_cast<int>(std::floor(std::min({a.x, b.x, c.x}))));
+            const int maxX = std::min(t.width - 1, static_cast<int>(std::ceil(std::max({a.x, b.x, c.x}))));
+            const int minY = std::max(t.rowBegin, static_cast<int>(std::floor(std::min({a.y, b.y, c.y}))));
+            const int maxY = std::min(t.rowEnd - 1, static_cast<int>(std::ceil(std::max({a.y, b.y, c.y}))));
+            if (minX > maxX || minY > maxY)
+                return;
+
+            const float invArea = 1.f / area;
+            // per pixel step of the edge functions along x
+            const float step0 = -(c.y - b.y), step1 = -(a.y - c.y), step2 = -(b.y - a.y);
+            for (int y = minY; y <= maxY; ++y)
+            {
+                const float px = minX + 0.5f, py = y + 0.5f;
+                float w0 = edge(b, c, px, py), w1 = edge(c, a, px, py), w2 = edge(a, b, px, py);
+                const size_t row = static_cast<size_t>(y) * t.width;
+                for (int x = minX; x <= maxX; ++x, w0 += step0, w1 += step1, w2 += step2)
+                {
+                    if (w0 < 0 || w1 < 0 || w2 < 0)
+                        continue;
+                    const float l0 = w0 * invArea, l1 = w1 * invArea, l2 = w2 * invArea;
+                    const float z = l0 * a.z + l1 * b.z + l2 * c.z;
+                    const size_t index = row + x;
+                    if (z >= t.depth[index] || z > 1.f)
+                        continue;
+                    t.depth[index] = z;
+                    const float w = 1.f / (l0 * a.invW + l1 * b.invW + l2 * c.invW);
+                    if (t.texture)
+                    {
+                        t.color[index] = sample(*t.texture, (l0 * a.u + l1 * b.u + l2 * c.u) * w, (l0 * a.v + l1 * b.v + l2 * c.v) * w);
+                    }
+                    else
+                    {
+                        const float s = t.shade * w;
+                        t.color[index] = packColor((l0 * a.r + l1 * b.r + l2 * c.r) * s, (l0 * a.g + l1 * b.g + l2 * c.g) * s,
+                                                   (l0 * a.b + l1 * b.b + l2 * c.b) * s);
+                    }
+                }
+            }
+        }
+
+        // the part of the triangle in front of the near plane (z >= -w): a triangle or a quad
+        size_t clipNear(const ClipVertex in[3], ClipVertex out[4])
+        {
+            size_t count = 0;
+            for (int i = 0; i < 3; ++i)
+            {
+                const ClipVertex &p = in[i], &q = in[(i + 1) % 3];
+                const double dp = p.z + p.w, dq = q.z + q.w;
+                if (dp >= 0)
+                    out[count++] = p;
+                if ((dp >= 0) != (dq >= 0))
+                {
+                    const double t = dp / (dp - dq);
+                    const float tf = static_cast<float>(t);
+                    ClipVertex m;
+                    m.x = p.x + (q.x - p.x) * t;
+                    m.y = p.y + (q.y - p.y) * t;
+                    m.z = p.z + (q.z - p.z) * t;
+                    m.w = p.w + (q.w - p.w) * t;
+                    m.u = p.u + (q.u - p.u) * tf;
+                    m.v = p.v + (q.v - p.v) * tf;
+                    m.r = p.r + (q.r - p.r) * tf;
+                    m.g = p.g + (q.g - p.g) * tf;
+                    m.b = p.b + (q.b - p.b) * tf;
+                    out[count++] = m;
+                }
+            }
+            return count;
+        }
+    }
+
+    void MakeViewProjection(const double eye[3], const double target[3], const double up[3], double fovY, double aspect,
+                            double nearPlane, double farPlane, double viewProj[16])
+    {
+        auto normalize = [](double v[3])
+        {
+            const double length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+            if (length > 0)
+                for (int i = 0; i < 3; ++i)
+                    v[i] /= length;
+        };
+        double f[3] = {target[0] - eye[0], target[1] - eye[1], target[2] - eye[2]};
+        normalize(f);
+        double s[3] = {f[1] * up[2] - f[2] * up[1], f[2] * up[0] - f[0] * up[2], f[0] * up[1] - f[1] * up[0]};
+        normalize(s);
+        const double u[3] = {s[1] * f[2] - s[2] * f[1], s[2] * f[0] - s[0] * f[2], s[0] * f[1] - s[1] * f[0]};
+
+        const double view[16] = {
+            s[0], s[1], s[2], -(s[0] * eye[0] + s[1] * eye[1] + s[2] * eye[2]),
+            u[0], u[1], u[2], -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]),
+            -f[0], -f[1], -f[2], f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2],
+            0, 0, 0, 1};
+        const double focal = 1.0 / std::tan(fovY / 2);
+        const double projection[16] = {
+            focal / aspect, 0, 0, 0,
+            0, focal, 0, 0,
+            0, 0, (farPlane + nearPlane) / (nearPlane - farPlane), 2 * farPlane * nearPlane / (nearPlane - farPlane),
+            0, 0, -1, 0};
+        for (int r = 0; r < 4; ++r)
+            for (int c = 0; c < 4; ++c)
+            {
+                double sum = 0;
+                for (int k = 0; k < 4; ++k)
+                    sum += projection[r * 4 + k] * view[k * 4 + c];
+                viewProj[r * 4 + c] = sum;
+            }
+    }
+
+    SoftRasterizer::SoftRasterizer(int threads)
+    {
+        setThreads(threads);
+    }
+
+    void SoftRasterizer::setThreads(int count)
+    {
+        threads = count > 0 ? count : ThreadBudget::limit();
+        resize(w, h);
+    }
+
+    void SoftRasterizer::resize(int width, int height)
+    {
+        w = std::max(0, std::min(width, 65535));
+        h = std::max(0, std::min(height, 65535));
+        color.assign(static_cast<size_t>(w) * h, 0xFF000000u);
+        depth.assign(static_cast<size_t>(w) * h, 1.f);
+        // a few bands per thread so uneven bands still keep every thread busy
+        bands = std::max(1, std::min(h, threads * 4));
+        bandHeight = std::max(1, (h + bands - 1) / bands);
+        bands = std::max(1, (h + bandHeight - 1) / bandHeight);
+    }
+
+    void SoftRasterizer::clear(uint32_t background)
+    {
+        std::fill(color.begin(), color.end(), background);
+        std::fill(depth.begin(), depth.end(), 1.f);
+    }
+
+    template <typename Task>
+    void SoftRasterizer::parallel(int tasks, const Task &task) const
+    {
+        const int workers = std::min(threads, tasks);
+        if (workers <= 1)
+        {
+            for (int i = 0; i < tasks; ++i)
+                task(i);
+            return;
+        }
+        std::atomic<int> next{0};
+        auto worker = [&]
+        {
+            for (int i; (i = next.fetch_add(1)) < tasks;)
+                task(i);
+        };
+        std::vector<std::thread> pool;
+        for (int t = 1; t < workers; ++t)
+            pool.emplace_back(worker);
+        worker();
+        for (std::thread &thread : pool)
+            thread.join();
+    }
+
+    void SoftRasterizer::drawPoints(const RasterView &view, const std::vector<PointSpan> &spans, int pointSize)
+    {
+        size_t total = 0;
+        for (const PointSpan &span : spans)
+            total += span.count;
+        if (total == 0 || w == 0 || h == 0)
+            return;
+        pointSize = std::max(1, pointSize);
+        const int before = (pointSize - 1) / 2;
+
+        const int producers = static_cast<int>(std::min<size_t>(threads * 4, (total + PointsPerTask - 1) / PointsPerTask));
+        pointBins.resize(static_cast<size_t>(producers) * bands);
+        for (auto &bin : pointBins)
+            bin.clear();
+
+        parallel(producers, [&](int task)
+                 {
+            size_t offset = total * task / producers;
+            size_t remaining = total * (task + 1) / producers - offset;
+            size_t s = 0;
+            while (offset >= spans[s].count)
+                offset -= spans[s++].count;
+            std::vector<PointFragment> *bins = &pointBins[static_cast<size_t>(task) * bands];
+            for (; remaining > 0; ++s, offset = 0)
+            {
+                const size_t n = std::min(spans[s].count - offset, remaining);
+                remaining -= n;
+                const PlyPoint *points = spans[s].points + offset;
+                for (size_t i = 0; i < n; ++i)
+                {
+                    const PlyPoint &p = points[i];
+                    double clip[4];
+                    transform(view.viewProj, p.x, p.y, p.z, clip);
+                    if (clip[3] <= 0 || clip[2] < -clip[3] || clip[2] > clip[3])
+                        continue;
+                    const double invW = 1.0 / clip[3];
+                    const double sx = (clip[0] * invW * 0.5 + 0.5) * w, sy = (0.5 - clip[1] * invW * 0.5) * h;
+                    if (sx < 0 || sy < 0 || sx >= w || sy >= h)
+                        continue;
+                    const PointFragment fragment = {static_cast<uint16_t>(sx), static_cast<uint16_t>(sy), static_cast<float>(clip[2] * invW),
+                                                    0xFF000000u | uint32_t(p.r) << 16 | uint32_t(p.g) << 8 | p.b};
+                    const int top = std::max(0, int(fragment.y) - before), bottom = std::min(h - 1, top + pointSize - 1);
+                    for (int band = bandOf(top); band <= bandOf(bottom); ++band)
+                        bins[band].push_back(fragment);
+                }
+            } });
+
+        parallel(bands, [&](int band)
+                 {
+            const int rowBegin = band * bandHeight, rowEnd = std::min(h, rowBegin + bandHeight);
+            for (int producer = 0; producer < producers; ++producer)
+            {
+                for (const PointFragment &fragment : pointBins[static_cast<size_t>(producer) * bands + band])
+                {
+                    const int x0 = std::max(0, int(fragment.x) - before), x1 = std::min(w, x0 + pointSize);
+                    const int y0 = std::max(rowBegin, int(fragment.y) - before), y1 = std::min(rowEnd, int(fragment.y) - before + pointSize);
+                    for (int y = y0; y < y1; ++y)
+                    {
+                        const size_t row = static_cast<size_t>(y) * w;
+                        for (int x = x0; x < x1; ++x)
+                        {
+                            if (fragment.depth < depth[row + x])
+                            {
+                                depth[row + x] = fragment.depth;
+                                color[row + x] = fragment.color;
+                            }
+                        }
+                    }
+                }
+            } });
+    }
+
+    void SoftRasterizer::drawMesh(const RasterView &view, const RasterMesh &mesh)
+    {
+        if (!mesh.x || !mesh.y || !mesh.z || !mesh.indices || mesh.faceCount == 0 || w == 0 || h == 0)
+            return;
+        const size_t faceCount = std::min<size_t>(mesh.faceCount, ClipFlag - 1);
+
+        // vertices to clip space once, faces share them
+        clipPositions.resize(mesh.vertexCount * 4);
+        const int vertexTasks = static_cast<int>(std::min<size_t>(threads * 4, (mesh.vertexCount + PointsPerTask - 1) / PointsPerTask));
+        parallel(vertexTasks, [&](int task)
+                 {
+            const size_t end = mesh.vertexCount * (task + 1) / vertexTasks;
+            for (size_t v = mesh.vertexCount * task / vertexTasks; v < end; ++v)
+            {
+                double clip[4];
+                transform(view.viewProj, mesh.x[v], mesh.y[v], mesh.z[v], clip);
+                for (int k = 0; k < 4; ++k)
+                    clipPositions[v * 4 + k] = static_cast<float>(clip[k]);
+            } });
+
+        const int producers = static_cast<int>(std::min<size_t>(threads * 4, (faceCount + FacesPerTask - 1) / FacesPerTask));
+        faceBins.resize(static_cast<size_t>(producers) * bands);
+        for (auto &bin : faceBins)
+            bin.clear();
+
+        parallel(producers, [&](int task)
+                 {
+            std::vector<uint32_t> *bins = &faceBins[static_cast<size_t>(task) * bands];
+            const size_t end = faceCount * (task + 1) / producers;
+            for (size_t f = faceCount * task / producers; f < end; ++f)
+            {
+                const uint32_t *index = mesh.indices + f * 3;
+                if (index[0] >= mesh.vertexCount || index[1] >= mesh.vertexCount || index[2] >= mesh.vertexCount)
+                    continue;
+                const float *c[3] = {&clipPositions[index[0] * 4], &clipPositions[index[1] * 4], &clipPositions[index[2] * 4]};
+                // entirely outside one side of the view volume
+                bool outside = false;
+                for (int axis = 0; axis < 3 && !outside; ++axis)
+                {
+                    outside = (c[0][axis] < -c[0][3] && c[1][axis] < -c[1][3] && c[2][axis] < -c[2][3]) ||
+                              (c[0][axis] > c[0][3] && c[1][axis] > c[1][3] && c[2][axis] > c[2][3]);
+                }
+                if (outside)
+                    continue;
+                if (c[0][2] < -c[0][3] || c[1][2] < -c[1][3] || c[2][2] < -c[2][3])
+                {
+                    for (int band = 0; band < bands; ++band)
+                        bins[band].push_back(static_cast<uint32_t>(f) | ClipFlag);
+                    continue;
+                }
+                float minY = INFINITY, maxY = -INFINITY;
+                for (int k = 0; k < 3; ++k)
+                {
+                    const float y = (0.5f - c[k][1] / c[k][3] * 0.5f) * h;
+                    minY = std::min(minY, y);
+                    maxY = std::max(maxY, y);
+                }
+                const int top = std::max(0, static_cast<int>(std::floor(minY))), bottom = std::min(h - 1, static_cast<int>(std::ceil(maxY)));
+                for (int band = bandOf(top); band <= bandOf(bottom); ++band)
+                    bins[band].push_back(static_cast<uint32_t>(f));
+            } });
+
+        parallel(bands, [&](int band)
+                 {
+            FaceTarget target = {color.data(), depth.data(), w, h, band * bandHeight, std::min(h, (band + 1) * bandHeight), nullptr, 1.f};
+            for (int producer = 0; producer < producers; ++producer)
+            {
+                for (const uint32_t entry : faceBins[static_cast<size_t>(producer) * bands + band])
+                {
+                    const size_t f = entry & ~ClipFlag;
+                    const uint32_t *index = mesh.indices + f * 3;
+                    const size_t textureIndex = mesh.faceTextures ? mesh.faceTextures[f] : 0;
+                    const bool textured = mesh.texcoords && textureIndex < mesh.textureCount && mesh.textures[textureIndex].pixels &&
+                                          mesh.textures[textureIndex].width > 0 && mesh.textures[textureIndex].height > 0;
+                    target.texture = textured ? &mesh.textures[textureIndex] : nullptr;
+
+                    // headlight: surfaces facing the eye are brightest
+                    auto headlight = [&](const double n[3], uint32_t at)
+                    {
+                        const double d[3] = {view.eye[0] - mesh.x[at], view.eye[1] - mesh.y[at], view.eye[2] - mesh.z[at]};
+                        const double lengths = std::sqrt((n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * (d[0] * d[0] + d[1] * d[1] + d[2] * d[2]));
+                        const double cosine = lengths > 0 ? std::fabs(n[0] * d[0] + n[1] * d[1] + n[2] * d[2]) / lengths : 1.0;
+                        return static_cast<float>(0.35 + 0.65 * cosine);
+                    };
+                    const bool smooth = !textured && mesh.nx && mesh.ny && mesh.nz;
+                    target.shade = 1.f;
+                    if (!textured && !smooth)
+                    {
+                        const uint32_t i0 = index[0], i1 = index[1], i2 = index[2];
+                        const double e1[3] = {mesh.x[i1] - mesh.x[i0], mesh.y[i1] - mesh.y[i0], mesh.z[i1] - mesh.z[i0]};
+                        const double e2[3] = {mesh.x[i2] - mesh.x[i0], mesh.y[i2] - mesh.y[i0], mesh.z[i2] - mesh.z[i0]};
+                        const double n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+                        target.shade = headlight(n, i0);
+                    }
+
+                    ClipVertex corners[3];
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        const float *clip = &clipPositions[index[k] * 4];
+                        ClipVertex &v = corners[k];
+                        v.x = clip[0];
+                        v.y = clip[1];
+                        v.z = clip[2];
+                        v.w = clip[3];
+                        v.u = textured ? mesh.texcoords[f * 6 + k * 2] : 0.f;
+                        v.v = textured ? mesh.texcoords[f * 6 + k * 2 + 1] : 0.f;
+                        const uint32_t rgb = mesh.colors ? mesh.colors[index[k]] : mesh.baseColor;
+                        // vertex normals: the shade of each corner is interpolated with its colour
+                        const double n[3] = {smooth ? mesh.nx[index[k]] : 0.0, smooth ? mesh.ny[index[k]] : 0.0, smooth ? mesh.nz[index[k]] : 0.0};
+                        const float shade = smooth ? headlight(n, index[k]) : 1.f;
+                        v.r = shade * static_cast<float>(rgb >> 16 & 0xFF);
+                        v.g = shade * static_cast<float>(rgb >> 8 & 0xFF);
+                        v.b = shade * static_cast<float>(rgb & 0xFF);
+                    }
+
+                    if (!(entry & ClipFlag))
+                    {
+                        fillTriangle(toScreen(corners[0], w, h), toScreen(corners[1], w, h), toScreen(corners[2], w, h), target);
+                        continue;
+                    }
+                    ClipVertex clipped[4];
+                    const size_t count = clipNear(corners, clipped);
+                    for (size_t k = 2; k < count; ++k)
+                        fillTriangle(toScreen(clipped[0], w, h), toScreen(clipped[k - 1], w, h), toScreen(clipped[k], w, h), target);
+                }
+            } });
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+// Multithreaded software rasterizer for the model viewer: points and
+// triangle meshes into a colour + depth buffer, on the CPU only, so models
+// display on machines without a GPU or OpenGL driver.
+//
+// Each draw runs in two passes on the worker threads. The primitives are
+// split between the threads, projected and binned by horizontal screen
+// band; then every band is rasterized by one thread, so no two threads
+// write the same pixel and no locks are needed.
+//
+// Matrices are row major: clip = viewProj * (x, y, z, 1), OpenGL clip space
+// (visible for -w <= x, y, z <= w, smaller depth is closer).
+
+#include "ply_io.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VoxelForge
+{
+    // viewProj of a camera at eye looking at target; fovY in radians, aspect = width / height
+    void MakeViewProjection(const double eye[3], const double target[3], const double up[3], double fovY, double aspect,
+                            double nearPlane, double farPlane, double viewProj[16]);
+
+    struct RasterView
+    {
+        double viewProj[16];
+        double eye[3]; // faces are lit from the eye
+    };
+
+    // Pixels 0xAARRGGBB (QImage::Format_RGB32 / ARGB32), rows top to bottom
+    struct RasterTexture
+    {
+        int width = 0;
+        int height = 0;
+        const uint32_t *pixels = nullptr;
+    };
+
+    struct RasterMesh
+    {
+        const float *x = nullptr, *y = nullptr, *z = nullptr;    // vertex positions
+        const float *nx = nullptr, *ny = nullptr, *nz = nullptr; // unit vertex normals, nullptr = flat shading
+        size_t vertexCount = 0;
+        const uint32_t *indices = nullptr;       // 3 per face
+        size_t faceCount = 0;
+        const uint32_t *colors = nullptr;        // per vertex 0xAARRGGBB, nullptr = baseColor
+        const float *texcoords = nullptr;        // u, v of each face corner (6 per face), origin bottom left
+        const uint16_t *faceTextures = nullptr;  // texture of each face, nullptr = textures[0]
+        const RasterTexture *textures = nullptr;
+        size_t textureCount = 0;
+        uint32_t baseColor = 0xFFC8C8C8;
+    };
+
+    struct PointSpan
+    {
+        const PlyPoint *points = nullptr;
+        size_t count = 0;
+    };
+
+    class SoftRasterizer
+    {
+    public:
+        // threads <= 0: ThreadBudget::limit()
+        explicit SoftRasterizer(int threads = 0);
+
+        void setThreads(int threads);
+        void resize(int width, int height);
+        void clear(uint32_t background);
+
+        // square points of pointSize pixels, coloured by the point
+        void drawPoints(const RasterView &view, const std::vector<PointSpan> &spans, int pointSize = 1);
+        // triangles clipped at the near plane, both sides drawn; untextured faces are shaded,
+        // smoothly with vertex normals
+        void drawMesh(const RasterView &view, const RasterMesh &mesh);
+
+        int width() const { return w; }
+        int height() const { return h; }
+        const uint32_t *pixels() const { return color.data(); }
+
+    private:
+        struct PointFragment
+        {
+            uint16_t x, y;
+            float depth;
+            uint32_t color;
+        };
+
+        template <typename Task>
+        void parallel(int tasks, const Task &task) const;
+        int bandOf(int y) const { return y / bandHeight; }
+
+        int threads = 1;
+        int w = 0, h = 0;
+        int bands = 1, bandHeight = 1;
+        std::vector<uint32_t> color;
+        std::vector<float> depth;
+
+        // scratch kept between frames: [producer thread * bands + band]
+        std::vector<std::vector<PointFragment>> pointBins;
+        std::vector<std::vector<uint32_t>> faceBins;
+        std::vector<float> clipPositions; // x, y, z, w per vertex
+    };
+}
@@ -0,0 +1,108 @@
+#include "spatial_partition.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace VoxelForge
+{
+    namespace
+    {
+        constexpr double Infinity = std::numeric_limits<double>::infinity();
+
+        struct SplitContext
+        {
+            const std::vector<Point3> &points;
+            const std::function<bool(const std::vector<uint32_t> &)> &fits;
+            double overlapFraction;
+            size_t minPoints;
+            std::vector<SpatialCell> &cells;
+        };
+
+        void addCell(const SplitContext &context, std::vector<uint32_t> indices, const SpatialBox &bounds,
+                     const Point3 &low, const Point3 &high)
+        {
+            SpatialCell cell;
+            cell.bounds = bounds;
+            cell.overlap = bounds;
+            if (!indices.empty())
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    const double margin = context.overlapFraction * (high[axis] - low[axis]);
+                    cell.overlap.low[axis] -= margin; // infinite sides stay infinite
+                    cell.overlap.high[axis] += margin;
+                }
+            }
+            cell.points = std::move(indices);
+            context.cells.push_back(std::move(cell));
+        }
+
+        void split(const SplitContext &context, std::vector<uint32_t> indices, const SpatialBox &bounds)
+        {
+            Point3 low = {Infinity, Infinity, Infinity}, high = {-Infinity, -Infinity, -Infinity};
+            for (const uint32_t index : indices)
+            {
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    low[axis] = std::min(low[axis], context.points[index][axis]);
+                    high[axis] = std::max(high[axis], context.points[index][axis]);
+                }
+            }
+            if (indices.size() < context.minPoints || context.fits(indices))
+            {
+                addCell(context, std::move(indices), bounds, low, high);
+                return;
+            }
+
+            int widest = 0;
+            for (int axis = 1; axis < 3; ++axis)
+                if (high[axis] - low[axis] > high[widest] - low[widest])
+                    widest = axis;
+
+            const auto middle = indices.begin() + static_cast<std::ptrdiff_t>(indices.size() / 2);
+            std::nth_element(indices.begin(), middle, indices.end(), [&](uint32_t a, uint32_t b)
+                             { return context.points[a][widest] < context.points[b][widest]; });
+            const double median = context.points[*middle][widest];
+
+            // points at the median go to the upper cell, or to the lower one when the median is also
+            // the smallest value (many equal coordinates)
+            double boundary = median;
+            auto lowEnd = std::partition(indices.begin(), indices.end(), [&](uint32_t index)
+                                         { return context.points[index][widest] < boundary; });
+            if (lowEnd == indices.begin())
+            {
+                boundary = std::nextafter(median, Infinity);
+                lowEnd = std::partition(indices.begin(), indices.end(), [&](uint32_t index)
+                                        { return context.points[index][widest] < boundary; });
+            }
+            if (lowEnd == indices.end())
+            {
+                addCell(context, std::move(indices), bounds, low, high);
+                return;
+            }
+
+            SpatialBox lowBox = bounds, highBox = bounds;
+            lowBox.high[widest] = boundary;
+            highBox.low[widest] = boundary;
+            std::vector<uint32_t> upper(lowEnd, indices.end());
+            indices.erase(lowEnd, indices.end());
+            split(context, std::move(indices), lowBox);
+            split(context, std::move(upper), highBox);
+        }
+    }
+
+    std::vector<SpatialCell> PartitionSpace(const std::vector<Point3> &points,
+                                            const std::function<bool(const std::vector<uint32_t> &points)> &fits,
+                                            double overlapFraction, size_t minPoints)
+    {
+        std::vector<uint32_t> all(points.size());
+        for (uint32_t i = 0; i < all.size(); ++i)
+            all[i] = i;
+
+        std::vector<SpatialCell> cells;
+        const SplitContext context{points, fits, overlapFraction, std::max<size_t>(2, minPoints), cells};
+        split(context, std::move(all), SpatialBox{{-Infinity, -Infinity, -Infinity}, {Infinity, Infinity, Infinity}});
+        return cells;
+    }
+}
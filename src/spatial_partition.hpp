@@ -0,0 +1,50 @@
+#pragma once
+
+// Spatial partition of a point set for the out-of-core OpenMVS stages
+// (densify and mesh reconstruction in chunks).
+//
+// The space is split recursively at the median of the points along the
+// widest axis of their bounding box, so dense areas get small cells and
+// sparse ones large cells, until the caller accepts a cell (views, points or
+// bytes under its budget). Cells are half-open boxes tiling the whole space,
+// the outer ones reaching infinity: every point is owned by exactly one cell.
+//
+// A chunk works on its cell grown by an overlap margin, so the results near
+// its sides have context, and keeps only the results inside its cell. That
+// is how the seams between chunks are handled: each side of a seam is
+// produced by one chunk.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace VoxelForge
+{
+    using Point3 = std::array<double, 3>;
+
+    struct SpatialBox
+    {
+        Point3 low, high; // [low, high) per axis, +-infinity on the outer sides
+
+        bool contains(const Point3 &p) const
+        {
+            return p[0] >= low[0] && p[0] < high[0] && p[1] >= low[1] && p[1] < high[1] &&
+                   p[2] >= low[2] && p[2] < high[2];
+        }
+    };
+
+    struct SpatialCell
+    {
+        SpatialBox bounds;            // owned space
+        SpatialBox overlap;           // bounds grown by the overlap fraction of the extent of its points
+        std::vector<uint32_t> points; // indices of the owned points
+    };
+
+    // fits(points): whether a cell of these points is small enough to process at once.
+    // A cell of fewer than minPoints points, or whose points cannot be separated, is kept as is
+    std::vector<SpatialCell> PartitionSpace(const std::vector<Point3> &points,
+                                            const std::function<bool(const std::vector<uint32_t> &points)> &fits,
+                                            double overlapFraction = 0.1, size_t minPoints = 64);
+}
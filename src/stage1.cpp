@@ -1,4 +1,6 @@
 #include <openmvg_wrappers.hpp>
+#include "callback_progress.hpp"
+#include "telemetry.hpp"
 
 // code implementation taken from openMVG/src/software/SfM/main_SfMInit_ImageListing.cpp
 // repo
@@ -133,6 +135,8 @@ namespace OpenMVG_Wrappers
         const std::string &sOutputDir,
         const std::string &sSensorDb,
         LogCallback logCallback,
+        ProgressCallback progressCallback,
+        const std::atomic<bool> *cancel,
         // optional
         double focal_pixels,
         const std::string &sKmatrix,
@@ -164,6 +168,8 @@ namespace OpenMVG_Wrappers
                 logCallback("WARNING: " + msg);
         };
 
+        VoxelForge::TelemetryScope telemetry("ImageListing");
+
         std::pair<bool, Vec3> prior_w_info(false, Vec3());
 
         // Expected properties for each image
@@ -230,12 +236,18 @@ namespace OpenMVG_Wrappers
         Views &views = sfm_data.views;
         Intrinsics &intrinsics = sfm_data.intrinsics;
 
-        system::LoggerProgress my_progress_bar(vec_image.size(), "- Listing images -");
+        CallbackProgress my_progress_bar(progressCallback, cancel, vec_image.size(), "- Listing images -");
         std::ostringstream error_report_stream;
         for (std::vector<std::string>::const_iterator iter_image = vec_image.begin();
              iter_image != vec_image.end();
              ++iter_image, ++my_progress_bar)
         {
+            if (my_progress_bar.hasBeenCanceled())
+            {
+                LOG("Image listing cancelled.");
+                return false;
+            }
+
             // Read meta data to fill camera parameter (w,h,focal,ppx,ppy) fields.
             width = height = ppx = ppy = focal = -1.0;
 
@@ -425,6 +437,11 @@ namespace OpenMVG_Wrappers
             "listed #File(s): " + std::to_string(vec_image.size()) + "\n"
             "usable #File(s) listed in sfm_data: " + std::to_string(sfm_data.GetViews().size()) + "\n"
             "usable #Intrinsic(s) listed in sfm_data: " + std::to_string(sfm_data.GetIntrinsics().size()));
+
+        telemetry.count("files", static_cast<double>(vec_image.size()));
+        telemetry.count("views", static_cast<double>(sfm_data.GetViews().size()));
+        telemetry.count("intrinsics", static_cast<double>(sfm_data.GetIntrinsics().size()));
+        telemetry.succeed();
         return true;
     }
 }
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "openmvg_wrappers.hpp"
+#include "openmvs_session.hpp"
+#include "telemetry.hpp"
+#include "thread_budget.hpp"
+
+// code implementation taken from openMVS/apps/TextureMesh/TextureMesh.cpp (in-process)
+
+// OpenMVS
+#include <openmvs/MVS.h>
+
+#undef D2R
+#undef R2D
+
+#include "openMVG/system/logger.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace OpenMVG_Wrappers
+{
+    bool RunTextureMesh(
+        std::string sMeshScene,
+        std::string sMeshPly,
+        std::string sWorkingDir,
+        std::string sOutModel,
+        LogCallback logCallback,
+        ProgressCallback progressCallback,
+        const std::atomic<bool> *cancel,
+        // optional
+        MeshOptions options,
+        int iNumThreads)
+    {
+        // Helper for logging to both console and GUI
+        auto LOG = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_INFO << msg;
+            if (logCallback)
+                logCallback(msg);
+        };
+
+        auto LOG_ERROR = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_ERROR << msg;
+            if (logCallback)
+                logCallback("ERROR: " + msg);
+        };
+
+        auto PROGRESS = [&](double fraction, const std::string &step)
+        {
+            if (progressCallback)
+                progressCallback(fraction, step);
+        };
+
+        VoxelForge::TelemetryScope telemetry("TextureMesh");
+        auto cancelled = [cancel]
+        { return cancel && cancel->load(std::memory_order_relaxed); };
+
+        std::error_code ec;
+        fs::create_directories(sWorkingDir, ec);
+        if (!ec)
+            fs::create_directories(fs::path(sOutModel).parent_path(), ec);
+        if (ec)
+        {
+            LOG_ERROR("Cannot create the output directories of " + sOutModel + ": " + ec.message());
+            return false;
+        }
+
+        const int nb_thread = StageThreads(iNumThreads);
+
+        const std::unique_lock<std::mutex> mvsGuard = LockOpenMVS(sWorkingDir);
+        openMVG::system::Timer timer;
+
+        PROGRESS(0.0, "- Loading -");
+        MVS::Scene scene(static_cast<unsigned>(nb_thread));
+        if (!scene.Load(sMeshScene))
+        {
+            LOG_ERROR("The mesh scene \"" + sMeshScene + "\" cannot be read.");
+            return false;
+        }
+        if (scene.mesh.IsEmpty() && !scene.mesh.Load(sMeshPly))
+        {
+            LOG_ERROR("The mesh \"" + sMeshPly + "\" cannot be read.");
+            return false;
+        }
+        LOG("Texturing " + std::to_string(scene.mesh.faces.GetSize()) + " faces from " +
+            std::to_string(scene.images.GetSize()) + " images, " + std::to_string(nb_thread) + " threads.");
+
+        if (cancelled())
+            return false;
+        try
+        {
+            // view selection per face (graph cut), global and local seam leveling, atlas packing
+            PROGRESS(0.05, "- Texturing -");
+            if (!scene.TextureMesh(options.textureResolutionLevel, options.minResolution))
+            {
+                LOG_ERROR("Mesh texturing failed.");
+                return false;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR(std::string("Mesh texturing failed: ") + e.what());
+            return false;
+        }
+        if (cancelled())
+            return false;
+
+        // an .obj is written with its .mtl and the texture images next to it
+        PROGRESS(0.95, "- Saving -");
+        if (!scene.mesh.Save(sOutModel))
+        {
+            LOG_ERROR("Cannot save the textured model to " + sOutModel);
+            return false;
+        }
+        LOG("Textured model saved to " + sOutModel + " in (s): " + std::to_string(timer.elapsed()));
+
+        telemetry.count("images", static_cast<double>(scene.images.GetSize()));
+        telemetry.count("faces", static_cast<double>(scene.mesh.faces.GetSize()));
+        telemetry.succeed();
+        return true;
+    }
+}
@@ -1,4 +1,7 @@
 #include "openmvg_wrappers.hpp"
+#include "callback_progress.hpp"
+#include "telemetry.hpp"
+#include "thread_budget.hpp"
 
 #include <cereal/archives/json.hpp>
 
@@ -52,6 +55,8 @@ namespace OpenMVG_Wrappers
         std::string sSfM_Data_Filename,
         std::string sOutDir,
         LogCallback logCallback,
+        ProgressCallback progressCallback,
+        const std::atomic<bool> *cancel,
         // optional
         std::string sImage_Describer_Method,
         bool bUpRight,
@@ -75,6 +80,8 @@ namespace OpenMVG_Wrappers
                 logCallback("ERROR: " + msg);
         };
 
+        VoxelForge::TelemetryScope telemetry("ComputeFeatures");
+
         if (sOutDir.empty())
         {
             LOG_ERROR("\nIt is an invalid output directory");
@@ -181,23 +188,14 @@ namespace OpenMVG_Wrappers
             system::Timer timer;
             Image<unsigned char> imageGray;
 
-            system::LoggerProgress my_progress_bar(sfm_data.GetViews().size(), "- EXTRACT FEATURES -");
+            CallbackProgress my_progress_bar(progressCallback, cancel, sfm_data.GetViews().size(), "- EXTRACT FEATURES -");
 
             // Use a boolean to track if we must stop feature extraction
             std::atomic<bool> preemptive_exit(false);
+            std::atomic<size_t> computed_views(0), computed_features(0);
 #ifdef OPENMVG_USE_OPENMP
-            const unsigned int nb_max_thread = omp_get_max_threads();
-
-            if (iNumThreads > 0)
-            {
-                omp_set_num_threads(iNumThreads);
-            }
-            else
-            {
-                omp_set_num_threads(nb_max_thread);
-            }
-
-#pragma omp parallel for schedule(dynamic) if (iNumThreads > 0) private(imageGray)
+            const int nb_thread = StageThreads(iNumThreads);
+#pragma omp parallel for schedule(dynamic) num_threads(nb_thread) private(imageGray)
 #endif
             for (int i = 0; i < static_cast<int>(sfm_data.views.size()); ++i)
             {
@@ -209,6 +207,10 @@ namespace OpenMVG_Wrappers
                     sFeat = stlplus::create_filespec(sOutDir, stlplus::basename_part(sView_filename), "feat"),
                     sDesc = stlplus::create_filespec(sOutDir, stlplus::basename_part(sView_filename), "desc");
 
+                // stop at the next view once cancelled; the views done so far are kept (complete files only)
+                if (my_progress_bar.hasBeenCanceled())
+                    preemptive_exit = true;
+
                 // If features or descriptors file are missing, compute them
                 if (!preemptive_exit && (bForce || !stlplus::file_exists(sFeat) || !stlplus::file_exists(sDesc)))
                 {
@@ -266,11 +268,26 @@ namespace OpenMVG_Wrappers
                         preemptive_exit = true;
                         continue;
                     }
+                    if (regions)
+                    {
+                        ++computed_views;
+                        computed_features += regions->RegionCount();
+                    }
                 }
                 ++my_progress_bar;
             }
+            if (my_progress_bar.hasBeenCanceled())
+            {
+                LOG("Feature extraction cancelled after " + std::to_string(computed_views) + " new view(s).");
+                return false;
+            }
             LOG("Task done in (s): " + std::to_string(timer.elapsed()));
+
+            telemetry.count("views", static_cast<double>(sfm_data.views.size()));
+            telemetry.count("views_computed", static_cast<double>(computed_views));
+            telemetry.count("features", static_cast<double>(computed_features)); // of the computed views only
         }
+        telemetry.succeed();
         return true;
     }
 }
\ No newline at end of file
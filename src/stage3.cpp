@@ -1,5 +1,8 @@
 
 #include "openmvg_wrappers.hpp"
+#include "callback_progress.hpp"
+#include "regions_budget.hpp"
+#include "telemetry.hpp"
 
 // code implementation taken from openMVG/src/software/SfM/main_ComputeMatches.cpp
 // repo
@@ -8,7 +11,6 @@
 #include "openMVG/graph/graph_stats.hpp"
 #include "openMVG/matching/indMatch.hpp"
 #include "openMVG/matching/indMatch_utils.hpp"
-#include "openMVG/matching/pairwiseAdjacencyDisplay.hpp"
 #include "openMVG/matching_image_collection/Cascade_Hashing_Matcher_Regions.hpp"
 #include "openMVG/matching_image_collection/Matcher_Regions.hpp"
 #include "openMVG/matching_image_collection/Pair_Builder.hpp"
@@ -23,10 +25,12 @@
 
 #include "openMVG/third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
 #include <string>
+#include <vector>
 
 using namespace openMVG;
 using namespace openMVG::matching;
@@ -39,6 +43,8 @@ namespace OpenMVG_Wrappers
         std::string sSfM_Data_Filename,
         std::string sOutputMatchesFilename,
         LogCallback logCallback,
+        ProgressCallback progressCallback,
+        const std::atomic<bool> *cancel,
         // optional
         float fDistRatio,
         std::string sPredefinedPairList,
@@ -46,7 +52,9 @@ namespace OpenMVG_Wrappers
         bool bForce,
         unsigned int ui_max_cache_size,
         unsigned int ui_preemptive_feature_count,
-        double preemptive_matching_percentage_threshold)
+        double preemptive_matching_percentage_threshold,
+        bool bExportReports,
+        unsigned int ui_memory_budget_mb)
     {
         // Helper for logging to both console and GUI
         auto LOG = [&](const std::string &msg)
@@ -70,6 +78,8 @@ namespace OpenMVG_Wrappers
                 logCallback("WARNING: " + msg);
         };
 
+        VoxelForge::TelemetryScope telemetry("ComputeMatches");
+
         if (sOutputMatchesFilename.empty())
         {
             LOG_ERROR("No output file set.");
@@ -112,17 +122,44 @@ namespace OpenMVG_Wrappers
         //    - Keep correspondences only if NearestNeighbor ratio is ok
         //---------------------------------------
 
+        // Without an explicit cache size, keep the regions within the memory budget
+        RegionsPlan memoryPlan;
+        if (ui_max_cache_size == 0 && ui_preemptive_feature_count == 0)
+        {
+            const uint64_t budget = ui_memory_budget_mb > 0 ? uint64_t(ui_memory_budget_mb) << 20 : DefaultRegionsBudgetBytes();
+            const RegionsFootprint footprint = EstimateRegionsFootprint(sfm_data, sMatchesDirectory);
+            memoryPlan = PlanRegionsMemory(footprint, budget);
+            telemetry.count("regions_estimate_mb", static_cast<double>(footprint.totalBytes >> 20));
+            if (memoryPlan.cacheSize > 0)
+            {
+                LOG("Regions need ~" + std::to_string(footprint.totalBytes >> 20) + " MB, over the " +
+                    std::to_string(budget >> 20) + " MB budget: caching " + std::to_string(memoryPlan.cacheSize) +
+                    " views, matching in tiles of " + std::to_string(memoryPlan.blockSize) + " x " +
+                    std::to_string(memoryPlan.blockSize) + " views");
+                telemetry.count("regions_cache_views", memoryPlan.cacheSize);
+            }
+        }
+
+        else if (ui_max_cache_size > 0 && ui_preemptive_feature_count == 0)
+        {
+            // explicit cache size: same tiling, sized on it
+            memoryPlan.cacheSize = ui_max_cache_size;
+            memoryPlan.blockSize = std::max(1u, ui_max_cache_size / 2);
+        }
+
         // Load the corresponding view regions
         std::shared_ptr<Regions_Provider> regions_provider;
-        if (ui_max_cache_size == 0)
+        std::shared_ptr<CountedRegionsCache> regions_cache;
+        if (memoryPlan.cacheSize == 0)
         {
             // Default regions provider (load & store all regions in memory)
             regions_provider = std::make_shared<Regions_Provider>();
         }
         else
         {
-            // Cached regions provider (load & store regions on demand)
-            regions_provider = std::make_shared<Regions_Provider_Cache>(ui_max_cache_size);
+            // Cached regions provider (load & store regions on demand, counts the disk reads)
+            regions_cache = std::make_shared<CountedRegionsCache>(memoryPlan.cacheSize);
+            regions_provider = regions_cache;
         }
         // If we use pre-emptive matching, we load less regions:
         if (ui_preemptive_feature_count > 0)
@@ -130,13 +167,21 @@ namespace OpenMVG_Wrappers
             regions_provider = std::make_shared<Preemptive_Regions_Provider>(ui_preemptive_feature_count);
         }
 
-        // Show the progress on the command line:
-        system::LoggerProgress progress;
+        // Show the progress on the command line and in the callback:
+        CallbackProgress progress(progressCallback, cancel);
 
-        if (!regions_provider->load(sfm_data, sMatchesDirectory, regions_type, &progress))
         {
-            LOG_ERROR("Cannot load view regions from: " + sMatchesDirectory + ".");
-            return false;
+            VoxelForge::TelemetryScope loadTelemetry("ComputeMatches/LoadRegions");
+            if (!regions_provider->load(sfm_data, sMatchesDirectory, regions_type, &progress) || progress.hasBeenCanceled())
+            {
+                if (progress.hasBeenCanceled())
+                    LOG("Match computation cancelled.");
+                else
+                    LOG_ERROR("Cannot load view regions from: " + sMatchesDirectory + ".");
+                return false;
+            }
+            loadTelemetry.count("views", static_cast<double>(sfm_data.GetViews().size()));
+            loadTelemetry.succeed();
         }
 
         PairWiseMatches map_PutativeMatches;
@@ -247,8 +292,47 @@ namespace OpenMVG_Wrappers
                     return false;
                 }
                 LOG("Running matching on #pairs: " + std::to_string(pairs.size()));
+                telemetry.count("pairs", static_cast<double>(pairs.size()));
                 // Photometric matching of putative pairs
-                collectionMatcher->Match(regions_provider, pairs, map_PutativeMatches, &progress);
+                {
+                    VoxelForge::TelemetryScope matchTelemetry("ComputeMatches/Match");
+                    if (memoryPlan.blockSize == 0)
+                    {
+                        collectionMatcher->Match(regions_provider, pairs, map_PutativeMatches, &progress);
+                    }
+                    else
+                    {
+                        // one tile at a time: only the views of the tile have to be in the cache
+                        const std::vector<Pair_Set> tiles = BlockedPairTiles(pairs, memoryPlan.blockSize);
+                        size_t matchedPairs = 0;
+                        for (const Pair_Set &tile : tiles)
+                        {
+                            CallbackProgress tileProgress(
+                                SubrangeProgress(progressCallback, matchedPairs, tile.size(), pairs.size()), cancel);
+                            PairWiseMatches tileMatches;
+                            collectionMatcher->Match(regions_provider, tile, tileMatches, &tileProgress);
+                            if (tileProgress.hasBeenCanceled())
+                                break;
+                            map_PutativeMatches.insert(tileMatches.begin(), tileMatches.end());
+                            matchedPairs += tile.size();
+                        }
+                        matchTelemetry.count("tiles", static_cast<double>(tiles.size()));
+                    }
+                    if (progress.hasBeenCanceled())
+                    {
+                        // partial matches must not be saved: the next run would load them as complete
+                        LOG("Match computation cancelled.");
+                        return false;
+                    }
+                    if (regions_cache)
+                    {
+                        LOG("Regions cache: " + regions_cache->summary());
+                        matchTelemetry.count("regions_loads", static_cast<double>(regions_cache->counters().loads));
+                        matchTelemetry.count("regions_reloads", static_cast<double>(regions_cache->counters().reloads));
+                    }
+                    matchTelemetry.count("pairs", static_cast<double>(pairs.size()));
+                    matchTelemetry.succeed();
+                }
 
                 if (ui_preemptive_feature_count > 0) // Preemptive filter
                 {
@@ -294,23 +378,17 @@ namespace OpenMVG_Wrappers
 
         LOG("#Putative pairs: " + std::to_string(map_PutativeMatches.size()));
 
-        // -- export Putative View Graph statistics
-        graph::getGraphStatistics(sfm_data.GetViews().size(), getPairs(map_PutativeMatches));
+        size_t putativeMatchCount = 0;
+        for (const auto &pairwisematches_it : map_PutativeMatches)
+            putativeMatchCount += pairwisematches_it.second.size();
+        telemetry.count("views", static_cast<double>(sfm_data.GetViews().size()));
+        telemetry.count("putative_pairs", static_cast<double>(map_PutativeMatches.size()));
+        telemetry.count("putative_matches", static_cast<double>(putativeMatchCount));
 
-        //-- export putative matches Adjacency matrix
-        PairWiseMatchingToAdjacencyMatrixSVG(vec_fileNames.size(),
-                                             map_PutativeMatches,
-                                             stlplus::create_filespec(sMatchesDirectory, "PutativeAdjacencyMatrix", "svg"));
-        //-- export view pair graph once putative graph matches has been computed
-        {
-            std::set<IndexT> set_ViewIds;
-            std::transform(sfm_data.GetViews().begin(), sfm_data.GetViews().end(), std::inserter(set_ViewIds, set_ViewIds.begin()), stl::RetrieveKey());
-            graph::indexedGraph putativeGraph(set_ViewIds, getPairs(map_PutativeMatches));
-            graph::exportToGraphvizData(
-                stlplus::create_filespec(sMatchesDirectory, "putative_matches"),
-                putativeGraph);
-        }
+        if (bExportReports && !RunExportMatchesReports(sSfM_Data_Filename, sOutputMatchesFilename, "Putative", logCallback))
+            return false;
 
+        telemetry.succeed();
         return true;
     }
 }
@@ -1,4 +1,7 @@
 #include "openmvg_wrappers.hpp"
+#include "callback_progress.hpp"
+#include "regions_budget.hpp"
+#include "telemetry.hpp"
 
 // code implementation taken from openMVG/src/software/SfM/main_GeometricFilter.cpp
 // repo
@@ -10,12 +13,6 @@
 #include "openMVG/graph/graph_stats.hpp"
 #include "openMVG/matching/indMatch.hpp"
 #include "openMVG/matching/indMatch_utils.hpp"
-// Forward declaration to avoid duplicate symbol with stage3.cpp
-namespace openMVG { namespace matching { 
-    void PairWiseMatchingToAdjacencyMatrixSVG(const size_t NbImages,
-                                              const PairWiseMatches & matches,
-                                              const std::string & sOutName);
-}}
 #include "openMVG/matching_image_collection/Cascade_Hashing_Matcher_Regions.hpp"
 #include "openMVG/matching_image_collection/E_ACRobust.hpp"
 #include "openMVG/matching_image_collection/E_ACRobust_Angular.hpp"
@@ -35,11 +32,13 @@ namespace openMVG { namespace matching {
 
 #include "openMVG/third_party/stlplus3/filesystemSimplified/file_system.hpp"
 
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <locale>
 #include <memory>
 #include <string>
+#include <vector>
 
 using namespace openMVG;
 using namespace openMVG::matching;
@@ -64,6 +63,8 @@ namespace OpenMVG_Wrappers
         std::string sPutativeMatchesFilename,
         std::string sFilteredMatchesFilename,
         LogCallback logCallback,
+        ProgressCallback progressCallback,
+        const std::atomic<bool> *cancel,
         // optional
         std::string sInputPairsFilename,
         std::string sOutputPairsFilename,
@@ -71,7 +72,9 @@ namespace OpenMVG_Wrappers
         bool bForce,
         bool bGuided_matching,
         int imax_iteration,
-        unsigned int ui_max_cache_size)
+        unsigned int ui_max_cache_size,
+        bool bExportReports,
+        unsigned int ui_memory_budget_mb)
     {
         // Helper for logging to both console and GUI
         auto LOG = [&](const std::string &msg)
@@ -88,6 +91,8 @@ namespace OpenMVG_Wrappers
                 logCallback("ERROR: " + msg);
         };
 
+        VoxelForge::TelemetryScope telemetry("GeometricFilter");
+
         if (sFilteredMatchesFilename.empty())
         {
             LOG_ERROR("It is an invalid output file");
@@ -170,25 +175,55 @@ namespace OpenMVG_Wrappers
         //    - Keep correspondences only if NearestNeighbor ratio is ok
         //---------------------------------------
 
+        // Without an explicit cache size, keep the regions within the memory budget
+        RegionsPlan memoryPlan;
+        if (ui_max_cache_size == 0)
+        {
+            const uint64_t budget = ui_memory_budget_mb > 0 ? uint64_t(ui_memory_budget_mb) << 20 : DefaultRegionsBudgetBytes();
+            const RegionsFootprint footprint = EstimateRegionsFootprint(sfm_data, sMatchesDirectory);
+            memoryPlan = PlanRegionsMemory(footprint, budget);
+            telemetry.count("regions_estimate_mb", static_cast<double>(footprint.totalBytes >> 20));
+            if (memoryPlan.cacheSize > 0)
+            {
+                LOG("Regions need ~" + std::to_string(footprint.totalBytes >> 20) + " MB, over the " +
+                    std::to_string(budget >> 20) + " MB budget: caching " + std::to_string(memoryPlan.cacheSize) +
+                    " views, filtering in tiles of " + std::to_string(memoryPlan.blockSize) + " x " +
+                    std::to_string(memoryPlan.blockSize) + " views");
+                telemetry.count("regions_cache_views", memoryPlan.cacheSize);
+            }
+        }
+
+        else if (ui_max_cache_size > 0)
+        {
+            // explicit cache size: same tiling, sized on it
+            memoryPlan.cacheSize = ui_max_cache_size;
+            memoryPlan.blockSize = std::max(1u, ui_max_cache_size / 2);
+        }
+
         // Load the corresponding view regions
         std::shared_ptr<Regions_Provider> regions_provider;
-        if (ui_max_cache_size == 0)
+        std::shared_ptr<CountedRegionsCache> regions_cache;
+        if (memoryPlan.cacheSize == 0)
         {
             // Default regions provider (load & store all regions in memory)
             regions_provider = std::make_shared<Regions_Provider>();
         }
         else
         {
-            // Cached regions provider (load & store regions on demand)
-            regions_provider = std::make_shared<Regions_Provider_Cache>(ui_max_cache_size);
+            // Cached regions provider (load & store regions on demand, counts the disk reads)
+            regions_cache = std::make_shared<CountedRegionsCache>(memoryPlan.cacheSize);
+            regions_provider = regions_cache;
         }
 
-        // Show the progress on the command line:
-        system::LoggerProgress progress;
+        // Show the progress on the command line and in the callback:
+        CallbackProgress progress(progressCallback, cancel);
 
-        if (!regions_provider->load(sfm_data, sMatchesDirectory, regions_type, &progress))
+        if (!regions_provider->load(sfm_data, sMatchesDirectory, regions_type, &progress) || progress.hasBeenCanceled())
         {
-            LOG_ERROR("Invalid regions.");
+            if (progress.hasBeenCanceled())
+                LOG("Geometric filtering cancelled.");
+            else
+                LOG_ERROR("Invalid regions.");
             return false;
         }
 
@@ -220,56 +255,103 @@ namespace OpenMVG_Wrappers
         //    - Use an upper bound for the a contrario estimated threshold
         //---------------------------------------
 
-        // Wrap in a scope to ensure filter_ptr is destroyed before regions_provider
+        // Wrap in a scope to ensure the filters are destroyed before regions_provider
         {
-            std::unique_ptr<ImageCollectionGeometricFilter> filter_ptr(
-                new ImageCollectionGeometricFilter(&sfm_data, regions_provider));
+            system::Timer timer;
+            const double d_distance_ratio = 0.6;
 
-            if (!filter_ptr)
+            // Robust estimation on a set of putative pairs (all of them, or one tile of the pair matrix)
+            auto filterPairs = [&](const PairWiseMatches &putativeMatches, system::ProgressInterface *filterProgress)
             {
-                LOG_ERROR("Failed to create geometric filter");
-                return false;
-            }
+                std::unique_ptr<ImageCollectionGeometricFilter> filter_ptr(
+                    new ImageCollectionGeometricFilter(&sfm_data, regions_provider));
 
-            system::Timer timer;
-            const double d_distance_ratio = 0.6;
+                switch (eGeometricModelToCompute)
+                {
+                case HOMOGRAPHY_MATRIX:
+                {
+                    const bool bGeometric_only_guided_matching = true;
+                    filter_ptr->Robust_model_estimation(
+                        GeometricFilter_HMatrix_AC(4.0, imax_iteration),
+                        putativeMatches,
+                        bGuided_matching,
+                        bGeometric_only_guided_matching ? -1.0 : d_distance_ratio,
+                        filterProgress);
+                }
+                break;
+                case FUNDAMENTAL_MATRIX:
+                {
+                    filter_ptr->Robust_model_estimation(
+                        GeometricFilter_FMatrix_AC(4.0, imax_iteration),
+                        putativeMatches,
+                        bGuided_matching,
+                        d_distance_ratio,
+                        filterProgress);
+                }
+                break;
+                case ESSENTIAL_MATRIX:
+                {
+                    filter_ptr->Robust_model_estimation(
+                        GeometricFilter_EMatrix_AC(4.0, imax_iteration),
+                        putativeMatches,
+                        bGuided_matching,
+                        d_distance_ratio,
+                        filterProgress);
+                }
+                break;
+                case ESSENTIAL_MATRIX_ANGULAR:
+                {
+                    filter_ptr->Robust_model_estimation(
+                        GeometricFilter_ESphericalMatrix_AC_Angular<false>(4.0, imax_iteration),
+                        putativeMatches, bGuided_matching, d_distance_ratio, filterProgress);
+                }
+                break;
+                case ESSENTIAL_MATRIX_UPRIGHT:
+                {
+                    filter_ptr->Robust_model_estimation(
+                        GeometricFilter_ESphericalMatrix_AC_Angular<true>(4.0, imax_iteration),
+                        putativeMatches, bGuided_matching, d_distance_ratio, filterProgress);
+                }
+                break;
+                case ESSENTIAL_MATRIX_ORTHO:
+                {
+                    filter_ptr->Robust_model_estimation(
+                        GeometricFilter_EOMatrix_RA(2.0, imax_iteration),
+                        putativeMatches,
+                        bGuided_matching,
+                        d_distance_ratio,
+                        filterProgress);
+                }
+                break;
+                }
+                return filter_ptr->Get_geometric_matches();
+            };
 
             PairWiseMatches map_GeometricMatches;
-            switch (eGeometricModelToCompute)
+            if (memoryPlan.blockSize == 0)
             {
-            case HOMOGRAPHY_MATRIX:
-            {
-                const bool bGeometric_only_guided_matching = true;
-                filter_ptr->Robust_model_estimation(
-                    GeometricFilter_HMatrix_AC(4.0, imax_iteration),
-                    map_PutativeMatches,
-                    bGuided_matching,
-                    bGeometric_only_guided_matching ? -1.0 : d_distance_ratio,
-                    &progress);
-                map_GeometricMatches = filter_ptr->Get_geometric_matches();
+                map_GeometricMatches = filterPairs(map_PutativeMatches, &progress);
             }
-            break;
-            case FUNDAMENTAL_MATRIX:
+            else
             {
-                filter_ptr->Robust_model_estimation(
-                    GeometricFilter_FMatrix_AC(4.0, imax_iteration),
-                    map_PutativeMatches,
-                    bGuided_matching,
-                    d_distance_ratio,
-                    &progress);
-                map_GeometricMatches = filter_ptr->Get_geometric_matches();
+                // one tile at a time: only the views of the tile have to be in the cache
+                const std::vector<PairWiseMatches> tiles = BlockedMatchTiles(map_PutativeMatches, memoryPlan.blockSize);
+                size_t filteredPairs = 0;
+                for (const PairWiseMatches &tile : tiles)
+                {
+                    CallbackProgress tileProgress(
+                        SubrangeProgress(progressCallback, filteredPairs, tile.size(), map_PutativeMatches.size()), cancel);
+                    const PairWiseMatches tileMatches = filterPairs(tile, &tileProgress);
+                    if (tileProgress.hasBeenCanceled())
+                        break;
+                    map_GeometricMatches.insert(tileMatches.begin(), tileMatches.end());
+                    filteredPairs += tile.size();
+                }
+                telemetry.count("tiles", static_cast<double>(tiles.size()));
             }
-            break;
-            case ESSENTIAL_MATRIX:
-            {
-                filter_ptr->Robust_model_estimation(
-                    GeometricFilter_EMatrix_AC(4.0, imax_iteration),
-                    map_PutativeMatches,
-                    bGuided_matching,
-                    d_distance_ratio,
-                    &progress);
-                map_GeometricMatches = filter_ptr->Get_geometric_matches();
 
+            if (eGeometricModelToCompute == ESSENTIAL_MATRIX)
+            {
                 //-- Perform an additional check to remove pairs with poor overlap
                 std::vector<PairWiseMatches::key_type> vec_toRemove;
                 for (const auto &pairwisematches_it : map_GeometricMatches)
@@ -289,36 +371,30 @@ namespace OpenMVG_Wrappers
                     map_GeometricMatches.erase(pair_to_remove_it);
                 }
             }
-            break;
-            case ESSENTIAL_MATRIX_ANGULAR:
-            {
-                filter_ptr->Robust_model_estimation(
-                    GeometricFilter_ESphericalMatrix_AC_Angular<false>(4.0, imax_iteration),
-                    map_PutativeMatches, bGuided_matching, d_distance_ratio, &progress);
-                map_GeometricMatches = filter_ptr->Get_geometric_matches();
-            }
-            break;
-            case ESSENTIAL_MATRIX_UPRIGHT:
+
+            if (progress.hasBeenCanceled())
             {
-                filter_ptr->Robust_model_estimation(
-                    GeometricFilter_ESphericalMatrix_AC_Angular<true>(4.0, imax_iteration),
-                    map_PutativeMatches, bGuided_matching, d_distance_ratio, &progress);
-                map_GeometricMatches = filter_ptr->Get_geometric_matches();
+                LOG("Geometric filtering cancelled.");
+                return false;
             }
-            break;
-            case ESSENTIAL_MATRIX_ORTHO:
+            if (regions_cache)
             {
-                filter_ptr->Robust_model_estimation(
-                    GeometricFilter_EOMatrix_RA(2.0, imax_iteration),
-                    map_PutativeMatches,
-                    bGuided_matching,
-                    d_distance_ratio,
-                    &progress);
-                map_GeometricMatches = filter_ptr->Get_geometric_matches();
-            }
-            break;
+                LOG("Regions cache: " + regions_cache->summary());
+                telemetry.count("regions_loads", static_cast<double>(regions_cache->counters().loads));
+                telemetry.count("regions_reloads", static_cast<double>(regions_cache->counters().reloads));
             }
 
+            size_t putativeMatchCount = 0, inlierCount = 0;
+            for (const auto &pairwisematches_it : map_PutativeMatches)
+                putativeMatchCount += pairwisematches_it.second.size();
+            for (const auto &pairwisematches_it : map_GeometricMatches)
+                inlierCount += pairwisematches_it.second.size();
+            telemetry.count("views", static_cast<double>(sfm_data.GetViews().size()));
+            telemetry.count("putative_pairs", static_cast<double>(map_PutativeMatches.size()));
+            telemetry.count("putative_matches", static_cast<double>(putativeMatchCount));
+            telemetry.count("geometric_pairs", static_cast<double>(map_GeometricMatches.size()));
+            telemetry.count("inliers", static_cast<double>(inlierCount));
+
             //---------------------------------------
             //-- Export geometric filtered matches
             //---------------------------------------
@@ -328,30 +404,13 @@ namespace OpenMVG_Wrappers
                 return false;
             }
 
-            // -- export Geometric View Graph statistics
-            graph::getGraphStatistics(sfm_data.GetViews().size(), getPairs(map_GeometricMatches));
-
             LOG("Task done in (s): " + std::to_string(timer.elapsed()));
 
-            //-- export Adjacency matrix
-            LOG("\n Export Adjacency Matrix of the pairwise's geometric matches");
-
-            PairWiseMatchingToAdjacencyMatrixSVG(sfm_data.GetViews().size(),
-                                                 map_GeometricMatches,
-                                                 stlplus::create_filespec(sMatchesDirectory, "GeometricAdjacencyMatrix", "svg"));
+            if (bExportReports && !RunExportMatchesReports(sSfM_Data_Filename, sFilteredMatchesFilename, "Geometric", logCallback))
+                return false;
 
             const Pair_Set outputPairs = getPairs(map_GeometricMatches);
 
-            //-- export view pair graph once geometric filter have been done
-            {
-                std::set<IndexT> set_ViewIds;
-                std::transform(sfm_data.GetViews().begin(), sfm_data.GetViews().end(), std::inserter(set_ViewIds, set_ViewIds.begin()), stl::RetrieveKey());
-                graph::indexedGraph putativeGraph(set_ViewIds, outputPairs);
-                graph::exportToGraphvizData(
-                    stlplus::create_filespec(sMatchesDirectory, "geometric_matches"),
-                    putativeGraph);
-            }
-
             // Write pairs
             if (!sOutputPairsFilename.empty())
             {
@@ -364,6 +423,7 @@ namespace OpenMVG_Wrappers
             }
         } // End of filter_ptr scope - filter destroyed here before regions_provider
         
+        telemetry.succeed();
         return true;
     }
 }
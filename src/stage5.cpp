@@ -0,0 +1,221 @@
+#include "openmvg_wrappers.hpp"
+#include "callback_progress.hpp"
+#include "telemetry.hpp"
+
+// code implementation taken from openMVG/src/software/SfM/main_SfM.cpp
+// repo (global engine only)
+
+#include "openMVG/cameras/Cameras_Common_command_line_helper.hpp"
+#include "openMVG/features/feature.hpp"
+#include "openMVG/sfm/pipelines/global/GlobalSfM_rotation_averaging.hpp"
+#include "openMVG/sfm/pipelines/global/GlobalSfM_translation_averaging.hpp"
+#include "openMVG/sfm/pipelines/global/sfm_global_engine_relative_motions.hpp"
+#include "openMVG/sfm/pipelines/sfm_features_provider.hpp"
+#include "openMVG/sfm/pipelines/sfm_matches_provider.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/sfm/sfm_report.hpp"
+#include "openMVG/system/loggerprogress.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include "openMVG/third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::sfm;
+
+namespace OpenMVG_Wrappers
+{
+    bool RunGlobalSfM(
+        std::string sSfM_Data_Filename,
+        std::string sMatchesDir,
+        std::string sOutDir,
+        LogCallback logCallback,
+        ProgressCallback progressCallback,
+        const std::atomic<bool> *cancel,
+        // optional
+        std::string sMatchesFilename,
+        std::string sIntrinsic_refinement_options,
+        int iRotationAveragingMethod,
+        int iTranslationAveragingMethod,
+        bool b_use_motion_priors)
+    {
+        // Helper for logging to both console and GUI
+        auto LOG = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_INFO << msg;
+            if (logCallback)
+                logCallback(msg);
+        };
+
+        auto LOG_ERROR = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_ERROR << msg;
+            if (logCallback)
+                logCallback("ERROR: " + msg);
+        };
+
+        VoxelForge::TelemetryScope telemetry("GlobalSfM");
+
+        if (sMatchesDir.empty() || !stlplus::is_folder(sMatchesDir))
+        {
+            LOG_ERROR("It is an invalid matches directory");
+            return false;
+        }
+        if (sOutDir.empty())
+        {
+            LOG_ERROR("It is an invalid output directory");
+            return false;
+        }
+        if (sMatchesFilename.empty())
+            sMatchesFilename = stlplus::create_filespec(sMatchesDir, "matches.f.bin");
+
+        if (iRotationAveragingMethod < ROTATION_AVERAGING_L1 ||
+            iRotationAveragingMethod > ROTATION_AVERAGING_L2)
+        {
+            LOG_ERROR("Rotation averaging method is invalid");
+            return false;
+        }
+        if (iTranslationAveragingMethod < TRANSLATION_AVERAGING_L1 ||
+            iTranslationAveragingMethod > TRANSLATION_AVERAGING_SOFTL1)
+        {
+            LOG_ERROR("Translation averaging method is invalid");
+            return false;
+        }
+
+        const Intrinsic_Parameter_Type intrinsic_refinement_options =
+            StringTo_Intrinsic_Parameter_Type(sIntrinsic_refinement_options);
+        if (intrinsic_refinement_options == static_cast<Intrinsic_Parameter_Type>(0))
+        {
+            LOG_ERROR("Invalid input for the intrinsic refinement options");
+            return false;
+        }
+
+        if (!stlplus::folder_exists(sOutDir) && !stlplus::folder_create(sOutDir))
+        {
+            LOG_ERROR("Cannot create the output directory");
+            return false;
+        }
+
+        //---------------------------------------
+        // Load input SfM_Data scene (views & intrinsics)
+        //---------------------------------------
+        SfM_Data sfm_data;
+        if (!Load(sfm_data, sSfM_Data_Filename, ESfM_Data(VIEWS | INTRINSICS)))
+        {
+            LOG_ERROR("The input SfM_Data file \"" + sSfM_Data_Filename + "\" cannot be read.");
+            return false;
+        }
+
+        // Init the regions_type from the image describer file (used for image regions extraction)
+        using namespace openMVG::features;
+        const std::string sImage_describer = stlplus::create_filespec(sMatchesDir, "image_describer", "json");
+        std::unique_ptr<Regions> regions_type = Init_region_type_from_file(sImage_describer);
+        if (!regions_type)
+        {
+            LOG_ERROR("Invalid: " + sImage_describer + " regions type file.");
+            return false;
+        }
+
+        // Features reading
+        std::shared_ptr<Features_Provider> feats_provider = std::make_shared<Features_Provider>();
+        CallbackProgress progress(progressCallback, cancel);
+        if (!feats_provider->load(sfm_data, sMatchesDir, regions_type, &progress) || progress.hasBeenCanceled())
+        {
+            if (progress.hasBeenCanceled())
+                LOG("Global SfM cancelled.");
+            else
+                LOG_ERROR("Cannot load view corresponding features in directory: " + sMatchesDir + ".");
+            return false;
+        }
+
+        // Matches reading
+        std::shared_ptr<Matches_Provider> matches_provider = std::make_shared<Matches_Provider>();
+        if (!matches_provider->load(sfm_data, sMatchesFilename))
+        {
+            LOG_ERROR("Cannot load the match file: " + sMatchesFilename + ".");
+            return false;
+        }
+
+        //---------------------------------------
+        // Global SfM reconstruction process
+        //---------------------------------------
+        system::Timer timer;
+        GlobalSfMReconstructionEngine_RelativeMotions sfmEngine(
+            sfm_data,
+            sOutDir,
+            stlplus::create_filespec(sOutDir, "Reconstruction_Report.html"));
+
+        // Configure the features_provider & the matches_provider
+        sfmEngine.SetFeaturesProvider(feats_provider.get());
+        sfmEngine.SetMatchesProvider(matches_provider.get());
+
+        // Configure reconstruction parameters
+        sfmEngine.Set_Intrinsics_Refinement_Type(intrinsic_refinement_options);
+        sfmEngine.Set_Use_Motion_Prior(b_use_motion_priors);
+
+        // Configure motion averaging method
+        sfmEngine.SetRotationAveragingMethod(ERotationAveragingMethod(iRotationAveragingMethod));
+        sfmEngine.SetTranslationAveragingMethod(ETranslationAveragingMethod(iTranslationAveragingMethod));
+
+        // the global engine has no progress/cancel hook: cancelling waits for Process() to return
+        if (progress.hasBeenCanceled())
+        {
+            LOG("Global SfM cancelled.");
+            return false;
+        }
+        progress.Restart(1, "- Global SfM -");
+        {
+            VoxelForge::TelemetryScope processTelemetry("GlobalSfM/Process");
+            if (!sfmEngine.Process())
+            {
+                LOG_ERROR("Global reconstruction failed.");
+                return false;
+            }
+            processTelemetry.succeed();
+        }
+        ++progress;
+        if (progress.hasBeenCanceled())
+        {
+            LOG("Global SfM cancelled.");
+            return false;
+        }
+
+        LOG("Total Ac-Global-Sfm took (s): " + std::to_string(timer.elapsed()));
+
+        LOG("...Generating SfM_Report.html");
+        Generate_SfM_Report(sfmEngine.Get_SfM_Data(),
+                            stlplus::create_filespec(sOutDir, "SfMReconstruction_Report.html"));
+
+        //-- Export to disk computed scene (data & visualizable results)
+        LOG("...Export SfM_Data to disk.");
+        if (!Save(sfmEngine.Get_SfM_Data(),
+                  stlplus::create_filespec(sOutDir, "sfm_data", ".bin"),
+                  ESfM_Data(ALL)))
+        {
+            LOG_ERROR("Cannot save the reconstructed scene in: " + sOutDir);
+            return false;
+        }
+
+        Save(sfmEngine.Get_SfM_Data(),
+             stlplus::create_filespec(sOutDir, "cloud_and_poses", ".ply"),
+             ESfM_Data(ALL));
+
+        LOG("Reconstructed " + std::to_string(sfmEngine.Get_SfM_Data().GetPoses().size()) + " poses and " +
+            std::to_string(sfmEngine.Get_SfM_Data().GetLandmarks().size()) + " landmarks.");
+
+        size_t observationCount = 0;
+        for (const auto &landmark : sfmEngine.Get_SfM_Data().GetLandmarks())
+            observationCount += landmark.second.obs.size();
+        telemetry.count("views", static_cast<double>(sfm_data.GetViews().size()));
+        telemetry.count("poses", static_cast<double>(sfmEngine.Get_SfM_Data().GetPoses().size()));
+        telemetry.count("landmarks", static_cast<double>(sfmEngine.Get_SfM_Data().GetLandmarks().size()));
+        telemetry.count("observations", static_cast<double>(observationCount));
+        telemetry.succeed();
+        return true;
+    }
+}
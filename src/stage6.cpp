@@ -0,0 +1,342 @@
+#include "openmvg_wrappers.hpp"
+#include "callback_progress.hpp"
+#include "content_hash.hpp"
+#include "telemetry.hpp"
+#include "thread_budget.hpp"
+#include "undistort_engine.hpp"
+
+// code implementation taken from openMVG/src/software/SfM/export/main_openMVG2openMVS.cpp
+// (the scene is written in-process, no openMVG_main_openMVG2openMVS run)
+
+#include "openMVG/cameras/Camera_Pinhole.hpp"
+#include "openMVG/sfm/sfm_data.hpp"
+#include "openMVG/sfm/sfm_data_io.hpp"
+#include "openMVG/system/logger.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include "openMVG/third_party/stlplus3/filesystemSimplified/file_system.hpp"
+
+#define _USE_EIGEN
+#include <openmvs/MVS/Interface.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace openMVG;
+using namespace openMVG::cameras;
+using namespace openMVG::sfm;
+
+namespace OpenMVG_Wrappers
+{
+    namespace
+    {
+        // "<key> <image name>" per undistorted image, next to the images
+        const char *UndistortKeysFile = "undistort_keys.txt";
+
+        std::map<std::string, uint64_t> readUndistortKeys(const std::string &path)
+        {
+            std::map<std::string, uint64_t> keys;
+            std::ifstream in(path);
+            std::string line;
+            while (std::getline(in, line))
+            {
+                const size_t space = line.find(' ');
+                if (space != std::string::npos)
+                    keys[line.substr(space + 1)] = std::strtoull(line.substr(0, space).c_str(), nullptr, 16);
+            }
+            return keys;
+        }
+
+        bool writeUndistortKeys(const std::string &path, const std::map<std::string, uint64_t> &keys)
+        {
+            {
+                std::ofstream out(path + ".tmp", std::ios::trunc);
+                for (const auto &key : keys)
+                    out << VoxelForge::HexHash(key.second) << ' ' << key.first << '\n';
+                if (!out)
+                    return false;
+            }
+            return std::rename((path + ".tmp").c_str(), path.c_str()) == 0;
+        }
+
+        // What an undistorted image depends on: the source pixels, the camera model and the output format
+        uint64_t undistortKey(const std::string &sSourceImage, const IntrinsicBase *cam)
+        {
+            const uint64_t content = VoxelForge::HashFileContents(sSourceImage);
+            if (content == 0)
+                return 0;
+
+            VoxelForge::ContentHasher hasher;
+            hasher.update(content);
+            hasher.update(CameraModelKey(cam));
+            hasher.update(std::string("jpeg95"));
+            return hasher.digest() | 1;
+        }
+
+        // undistorted images are JPEG (undistort_engine.hpp), named after the source file with its extension
+        // (IMG_1.png.jpg), so IMG_1.png and IMG_1.jpg do not share an output file or a key
+        std::string undistortedName(const View *view)
+        {
+            return stlplus::filename_part(view->s_Img_path) + ".jpg";
+        }
+    }
+
+    bool RunExportToMVS(
+        std::string sSfM_Data_Filename,
+        std::string sOutSceneFile,
+        std::string sUndistortedDir,
+        LogCallback logCallback,
+        ProgressCallback progressCallback,
+        const std::atomic<bool> *cancel,
+        // optional
+        int iNumThreads)
+    {
+        // Helper for logging to both console and GUI
+        auto LOG = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_INFO << msg;
+            if (logCallback)
+                logCallback(msg);
+        };
+
+        auto LOG_ERROR = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_ERROR << msg;
+            if (logCallback)
+                logCallback("ERROR: " + msg);
+        };
+
+        VoxelForge::TelemetryScope telemetry("ExportToMVS");
+
+        if (sOutSceneFile.empty() || sUndistortedDir.empty())
+        {
+            LOG_ERROR("Invalid output scene file or undistorted images directory");
+            return false;
+        }
+        if (!stlplus::folder_exists(sUndistortedDir) && !stlplus::folder_create(sUndistortedDir))
+        {
+            LOG_ERROR("Cannot create the undistorted images directory: " + sUndistortedDir);
+            return false;
+        }
+
+        SfM_Data sfm_data;
+        if (!Load(sfm_data, sSfM_Data_Filename, ESfM_Data(ALL)))
+        {
+            LOG_ERROR("The input SfM_Data file \"" + sSfM_Data_Filename + "\" cannot be read.");
+            return false;
+        }
+
+        // image names of the scene are relative to its folder
+        const std::string sOutSceneDir = stlplus::folder_part(sOutSceneFile);
+        const std::string sOutImagesDir = stlplus::folder_to_relative_path(
+            sOutSceneDir.empty() ? std::string(".") : sOutSceneDir, sUndistortedDir);
+
+        //---------------------------------------
+        // Platforms (one per pinhole intrinsic)
+        //---------------------------------------
+        _INTERFACE_NAMESPACE::Interface scene;
+        std::map<IndexT, uint32_t> map_intrinsic, map_view;
+        for (const auto &intrinsic : sfm_data.GetIntrinsics())
+        {
+            if (!isPinhole(intrinsic.second->getType()))
+                continue;
+            const Pinhole_Intrinsic *cam = dynamic_cast<const Pinhole_Intrinsic *>(intrinsic.second.get());
+            map_intrinsic[intrinsic.first] = static_cast<uint32_t>(scene.platforms.size());
+
+            _INTERFACE_NAMESPACE::Interface::Platform platform;
+            _INTERFACE_NAMESPACE::Interface::Platform::Camera camera;
+            camera.width = cam->w();
+            camera.height = cam->h();
+            camera.K = cam->K();
+            // the camera is the platform
+            camera.R = Mat3::Identity();
+            camera.C = Vec3::Zero();
+            platform.cameras.push_back(camera);
+            scene.platforms.push_back(platform);
+        }
+
+        //---------------------------------------
+        // Images and poses (calibrated views only)
+        //---------------------------------------
+        std::vector<const View *> exportedViews;
+        scene.images.reserve(sfm_data.GetViews().size());
+        for (const auto &view : sfm_data.GetViews())
+        {
+            if (!sfm_data.IsPoseAndIntrinsicDefined(view.second.get()) ||
+                map_intrinsic.count(view.second->id_intrinsic) == 0)
+                continue;
+
+            map_view[view.first] = static_cast<uint32_t>(scene.images.size());
+
+            _INTERFACE_NAMESPACE::Interface::Image image;
+            image.name = stlplus::create_filespec(sOutImagesDir, undistortedName(view.second.get()));
+            image.platformID = map_intrinsic.at(view.second->id_intrinsic);
+            _INTERFACE_NAMESPACE::Interface::Platform &platform = scene.platforms[image.platformID];
+            image.cameraID = 0;
+            image.poseID = static_cast<uint32_t>(platform.poses.size());
+            image.ID = map_view[view.first];
+
+            _INTERFACE_NAMESPACE::Interface::Platform::Pose pose;
+            const geometry::Pose3 poseMVG(sfm_data.GetPoseOrDie(view.second.get()));
+            pose.R = poseMVG.rotation();
+            pose.C = poseMVG.center();
+            platform.poses.push_back(pose);
+
+            scene.images.emplace_back(image);
+            exportedViews.push_back(view.second.get());
+        }
+        if (exportedViews.empty())
+        {
+            LOG_ERROR("The reconstruction has no calibrated pinhole view to export.");
+            return false;
+        }
+        LOG("Exporting " + std::to_string(exportedViews.size()) + " of " +
+            std::to_string(sfm_data.GetViews().size()) + " views.");
+
+        //---------------------------------------
+        // Undistorted images: skipped when the source image and the camera model did
+        // not change since the previous export (keys in <sUndistortedDir>/undistort_keys.txt)
+        //---------------------------------------
+        system::Timer timer;
+        const std::string sKeysFile = stlplus::create_filespec(sUndistortedDir, UndistortKeysFile);
+        const std::map<std::string, uint64_t> previousKeys = readUndistortKeys(sKeysFile);
+        std::vector<uint64_t> keys(exportedViews.size(), 0);
+
+        CallbackProgress progress(progressCallback, cancel, exportedViews.size(), "- Undistorting images -");
+        std::atomic<bool> bOk(true);
+        std::atomic<size_t> reused(0);
+        const int nb_thread = StageThreads(iNumThreads);
+
+        // keys of the sources (reads every image once, in parallel); unchanged images are kept
+        std::vector<uint64_t> sourceKeys(exportedViews.size(), 0);
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(nb_thread)
+#endif
+        for (int i = 0; i < static_cast<int>(exportedViews.size()); ++i)
+        {
+            if (!bOk || progress.hasBeenCanceled())
+                continue;
+
+            const View *view = exportedViews[i];
+            const std::string sSourceImage = stlplus::create_filespec(sfm_data.s_root_path, view->s_Img_path);
+            sourceKeys[i] = undistortKey(sSourceImage, sfm_data.GetIntrinsics().at(view->id_intrinsic).get());
+            if (sourceKeys[i] == 0)
+            {
+                LOG_ERROR("Cannot read image: " + sSourceImage);
+                bOk = false;
+                continue;
+            }
+
+            const auto previous = previousKeys.find(undistortedName(view));
+            if (previous != previousKeys.end() && previous->second == sourceKeys[i] &&
+                stlplus::file_exists(stlplus::create_filespec(sUndistortedDir, undistortedName(view))))
+            {
+                keys[i] = sourceKeys[i];
+                ++reused;
+                ++progress;
+            }
+        }
+
+        // the others through the undistortion engine: one remap table per camera model
+        std::vector<UndistortJob> jobs;
+        std::vector<size_t> jobViews;
+        for (size_t i = 0; i < exportedViews.size() && bOk; ++i)
+        {
+            if (keys[i] != 0)
+                continue;
+            const View *view = exportedViews[i];
+            jobs.push_back({stlplus::create_filespec(sfm_data.s_root_path, view->s_Img_path),
+                            stlplus::create_filespec(sUndistortedDir, undistortedName(view)),
+                            sfm_data.GetIntrinsics().at(view->id_intrinsic).get()});
+            jobViews.push_back(i);
+        }
+
+        UndistortEngine engine(nb_thread);
+        if (bOk && !jobs.empty() && !progress.hasBeenCanceled())
+        {
+            // stop at the next image once cancelled; the images done so far keep their key
+            bOk = engine.run(jobs, [&](size_t index, bool ok)
+                             {
+                if (ok)
+                    keys[jobViews[index]] = sourceKeys[jobViews[index]];
+                else
+                    LOG_ERROR("Cannot undistort " + jobs[index].sourceImage + " into " + jobs[index].outputImage);
+                ++progress; }, cancel) || progress.hasBeenCanceled();
+        }
+        const size_t undistorted = engine.stats().images;
+
+        // also after a failure or a cancel, so the next export resumes from the images already done
+        {
+            std::map<std::string, uint64_t> doneKeys;
+            for (size_t i = 0; i < exportedViews.size(); ++i)
+            {
+                if (keys[i] != 0)
+                    doneKeys[undistortedName(exportedViews[i])] = keys[i];
+            }
+            if (!writeUndistortKeys(sKeysFile, doneKeys))
+                LOG("WARNING: Cannot write " + sKeysFile + ", the next export undistorts every image again.");
+        }
+
+        if (progress.hasBeenCanceled())
+        {
+            LOG("Export to OpenMVS cancelled after " + std::to_string(undistorted) + " undistorted image(s).");
+            return false;
+        }
+        if (!bOk)
+        {
+            LOG_ERROR("Image undistortion failed (check file permissions or disk space).");
+            return false;
+        }
+        LOG("Undistorted " + std::to_string(undistorted) + " image(s) with " + std::to_string(engine.stats().tables) +
+            " remap table(s), " + std::to_string(reused) + " unchanged since the last export, in (s): " +
+            std::to_string(timer.elapsed()));
+
+        //---------------------------------------
+        // Structure (landmarks seen by at least two exported views)
+        //---------------------------------------
+        scene.vertices.reserve(sfm_data.GetLandmarks().size());
+        for (const auto &vertex : sfm_data.GetLandmarks())
+        {
+            const Landmark &landmark = vertex.second;
+            _INTERFACE_NAMESPACE::Interface::Vertex vert;
+            for (const auto &observation : landmark.obs)
+            {
+                const auto it = map_view.find(observation.first);
+                if (it == map_view.end())
+                    continue;
+                _INTERFACE_NAMESPACE::Interface::Vertex::View view;
+                view.imageID = it->second;
+                view.confidence = 0;
+                vert.views.push_back(view);
+            }
+            if (vert.views.size() < 2)
+                continue;
+            vert.X = landmark.X.cast<float>();
+            scene.vertices.push_back(vert);
+        }
+
+        progress.Restart(1, "- Writing scene -");
+        if (!_INTERFACE_NAMESPACE::ARCHIVE::SerializeSave(scene, sOutSceneFile))
+        {
+            LOG_ERROR("Cannot write the OpenMVS scene: " + sOutSceneFile);
+            return false;
+        }
+        ++progress;
+
+        LOG("OpenMVS scene saved to " + sOutSceneFile + " (" + std::to_string(scene.images.size()) + " images, " +
+            std::to_string(scene.vertices.size()) + " landmarks).");
+
+        telemetry.count("views", static_cast<double>(exportedViews.size()));
+        telemetry.count("images_undistorted", static_cast<double>(undistorted));
+        telemetry.count("images_reused", static_cast<double>(reused));
+        telemetry.count("remap_tables", static_cast<double>(engine.stats().tables));
+        telemetry.count("landmarks", static_cast<double>(scene.vertices.size()));
+        telemetry.succeed();
+        return true;
+    }
+}
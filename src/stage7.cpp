@@ -0,0 +1,434 @@
+#include "openmvg_wrappers.hpp"
+#include "openmvs_session.hpp"
+#include "regions_budget.hpp"
+#include "spatial_partition.hpp"
+#include "telemetry.hpp"
+#include "thread_budget.hpp"
+
+// code implementation taken from openMVS/apps/DensifyPointCloud/DensifyPointCloud.cpp
+// (in-process, scene split in spatial chunks when it does not fit the memory budget)
+
+// OpenMVS
+#include <openmvs/MVS.h>
+
+#undef D2R
+#undef R2D
+
+#include <openmvs/MVS/Interface.h>
+
+#include "openMVG/system/logger.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace OpenMVG_Wrappers
+{
+    namespace
+    {
+        // bytes per depth-map pixel: estimation working set of one view (depth, normal, confidence,
+        // gray image + one gray image per neighbour view) and fusion (maps of every view of a chunk + points)
+        constexpr uint64_t EstimationBytesPerPixel = 24;
+        constexpr uint64_t NeighbourBytesPerPixel = 4;
+        constexpr uint64_t FusionBytesPerPixel = 32;
+
+        // depth-map size of an image as OpenMVS scales it (resolution level, then max / min resolution)
+        uint64_t depthMapPixels(uint32_t width, uint32_t height, const DensifyOptions &options)
+        {
+            const double largest = std::max(1u, std::max(width, height));
+            double side = largest / double(1u << std::min(options.resolutionLevel, 8u));
+            if (options.maxResolution > 0)
+                side = std::min(side, double(options.maxResolution));
+            side = std::min(largest, std::max(side, double(options.minResolution)));
+            const double scale = side / largest;
+            return static_cast<uint64_t>(double(width) * scale * double(height) * scale);
+        }
+
+        // observations of a view inside a cell for the view to take part in its chunk: the cell is in
+        // the view's frustum and in front of it, not one stray match
+        constexpr uint32_t MinCellObservations = 8;
+
+        struct DensifyChunk
+        {
+            VoxelForge::SpatialBox bounds;  // fused points kept by this chunk
+            std::vector<uint32_t> images;   // views observing the cell
+            std::vector<uint32_t> vertices; // landmarks inside the overlap box
+        };
+
+        // Views with at least MinCellObservations observations of the given landmarks, by ID
+        std::vector<uint32_t> observingViews(const _INTERFACE_NAMESPACE::Interface &scene, const std::vector<uint32_t> &landmarks)
+        {
+            std::map<uint32_t, uint32_t> observations;
+            for (const uint32_t landmark : landmarks)
+                for (const auto &view : scene.vertices[landmark].views)
+                    ++observations[view.imageID];
+            std::vector<uint32_t> views;
+            for (const auto &view : observations)
+                if (view.second >= MinCellObservations)
+                    views.push_back(view.first);
+            return views;
+        }
+
+        // Sub-scene of the chunk's images (scene indices remapped, IDs kept: depth-map files are named by ID
+        // and shared by the chunks) and its landmarks seen by two of them
+        _INTERFACE_NAMESPACE::Interface chunkScene(const _INTERFACE_NAMESPACE::Interface &scene, const DensifyChunk &chunk)
+        {
+            _INTERFACE_NAMESPACE::Interface sub;
+            sub.platforms = scene.platforms;
+            std::map<uint32_t, uint32_t> local;
+            for (const uint32_t image : chunk.images)
+            {
+                local[image] = static_cast<uint32_t>(sub.images.size());
+                sub.images.push_back(scene.images[image]);
+            }
+            for (const uint32_t v : chunk.vertices)
+            {
+                const auto &vertex = scene.vertices[v];
+                _INTERFACE_NAMESPACE::Interface::Vertex subVertex;
+                subVertex.X = vertex.X;
+                for (const auto &view : vertex.views)
+                {
+                    const auto it = local.find(view.imageID);
+                    if (it == local.end())
+                        continue;
+                    auto subView = view;
+                    subView.imageID = it->second;
+                    subVertex.views.push_back(subView);
+                }
+                if (subVertex.views.size() >= 2)
+                    sub.vertices.push_back(subVertex);
+            }
+            return sub;
+        }
+
+        // Number of depth maps written so far (per-view progress: OpenMVS has no progress callback)
+        size_t countDepthMaps(const std::string &sWorkingDir)
+        {
+            size_t count = 0;
+            std::error_code ec;
+            for (fs::directory_iterator it(sWorkingDir, ec), end; !ec && it != end; it.increment(ec))
+            {
+                const std::string name = it->path().filename().string();
+                if (name.compare(0, 5, "depth") == 0 && it->path().extension() == ".dmap")
+                    ++count;
+            }
+            return count;
+        }
+    }
+
+    bool RunDensify(
+        std::string sSceneFile,
+        std::string sWorkingDir,
+        std::string sOutDenseScene,
+        std::string sOutDensePly,
+        LogCallback logCallback,
+        ProgressCallback progressCallback,
+        const std::atomic<bool> *cancel,
+        // optional
+        DensifyOptions options,
+        bool bForce,
+        int iNumThreads)
+    {
+        // Helper for logging to both console and GUI
+        auto LOG = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_INFO << msg;
+            if (logCallback)
+                logCallback(msg);
+        };
+
+        auto LOG_ERROR = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_ERROR << msg;
+            if (logCallback)
+                logCallback("ERROR: " + msg);
+        };
+
+        VoxelForge::TelemetryScope telemetry("Densify");
+        auto cancelled = [cancel]
+        { return cancel && cancel->load(std::memory_order_relaxed); };
+
+        std::error_code ec;
+        fs::create_directories(sWorkingDir, ec);
+        if (ec)
+        {
+            LOG_ERROR("Cannot create the dense working directory " + sWorkingDir + ": " + ec.message());
+            return false;
+        }
+        sWorkingDir = fs::absolute(sWorkingDir).lexically_normal().generic_string();
+
+        // depth maps of another scene or other options must not be fused
+        if (bForce)
+        {
+            for (fs::directory_iterator it(sWorkingDir, ec), end; !ec && it != end; it.increment(ec))
+                if (it->path().extension() == ".dmap")
+                    fs::remove(it->path(), ec);
+        }
+
+        _INTERFACE_NAMESPACE::Interface scene;
+        if (!_INTERFACE_NAMESPACE::ARCHIVE::SerializeLoad(scene, sSceneFile) || scene.images.empty())
+        {
+            LOG_ERROR("The OpenMVS scene \"" + sSceneFile + "\" cannot be read.");
+            return false;
+        }
+
+        // image paths are resolved against WORKING_FOLDER by OpenMVS: make them absolute
+        const fs::path sceneDir = fs::absolute(sSceneFile).parent_path();
+        for (auto &image : scene.images)
+            image.name = (sceneDir / image.name).lexically_normal().generic_string();
+
+        const int nb_thread = StageThreads(iNumThreads);
+
+        //---------------------------------------
+        // Chunks: spatial cells observed by as many views as the memory budget allows to fuse at once
+        //---------------------------------------
+        uint64_t largestPixels = 0;
+        for (const auto &platform : scene.platforms)
+            for (const auto &camera : platform.cameras)
+                largestPixels = std::max(largestPixels, depthMapPixels(camera.width, camera.height, options));
+        largestPixels = std::max<uint64_t>(1, largestPixels);
+
+        const uint64_t budget = options.memoryBudgetMB > 0 ? uint64_t(options.memoryBudgetMB) << 20 : DefaultRegionsBudgetBytes();
+        const uint64_t estimation = uint64_t(nb_thread) * largestPixels *
+                                    (EstimationBytesPerPixel + NeighbourBytesPerPixel * std::max(1u, options.numViews));
+        const uint64_t fusionViews = budget > estimation ? (budget - estimation) / (largestPixels * FusionBytesPerPixel) : 0;
+        // the overlap margin brings in more views than the cell itself: keep room for them
+        const size_t maxChunkViews = static_cast<size_t>(std::max<uint64_t>(8, fusionViews * 2 / 3));
+
+        // the space of the landmarks is split where they are dense until the views observing a cell fit;
+        // a chunk densifies its cell grown by an overlap margin and keeps the points inside the cell
+        std::vector<VoxelForge::Point3> landmarks(scene.vertices.size());
+        for (size_t i = 0; i < scene.vertices.size(); ++i)
+            landmarks[i] = {scene.vertices[i].X.x, scene.vertices[i].X.y, scene.vertices[i].X.z};
+
+        std::vector<DensifyChunk> chunks;
+        std::vector<uint32_t> allViews(scene.images.size());
+        for (uint32_t i = 0; i < allViews.size(); ++i)
+            allViews[i] = i;
+        if (allViews.size() <= maxChunkViews)
+        {
+            DensifyChunk everything;
+            everything.bounds = {{-HUGE_VAL, -HUGE_VAL, -HUGE_VAL}, {HUGE_VAL, HUGE_VAL, HUGE_VAL}};
+            everything.images = allViews;
+            everything.vertices.resize(scene.vertices.size());
+            for (uint32_t i = 0; i < everything.vertices.size(); ++i)
+                everything.vertices[i] = i;
+            chunks.push_back(std::move(everything));
+        }
+        else
+        {
+            const std::vector<VoxelForge::SpatialCell> cells = VoxelForge::PartitionSpace(
+                landmarks, [&](const std::vector<uint32_t> &cellLandmarks)
+                { return observingViews(scene, cellLandmarks).size() <= maxChunkViews; },
+                0.1, 4 * MinCellObservations);
+            for (const VoxelForge::SpatialCell &cell : cells)
+            {
+                DensifyChunk chunk;
+                chunk.bounds = cell.bounds;
+                for (uint32_t i = 0; i < landmarks.size(); ++i)
+                    if (cell.overlap.contains(landmarks[i]))
+                        chunk.vertices.push_back(i);
+                chunk.images = observingViews(scene, chunk.vertices);
+                if (chunk.images.size() >= 2)
+                    chunks.push_back(std::move(chunk));
+            }
+            if (chunks.empty())
+            {
+                LOG_ERROR("No part of the scene is observed by two views.");
+                return false;
+            }
+        }
+        LOG("Densifying " + std::to_string(scene.images.size()) + " views in " + std::to_string(chunks.size()) +
+            " chunk(s), " + std::to_string(nb_thread) + " threads, memory budget " + std::to_string(budget >> 20) + " MB.");
+
+        const std::unique_lock<std::mutex> mvsGuard = LockOpenMVS(sWorkingDir);
+
+        OPTDENSE::init();
+        OPTDENSE::nResolutionLevel = options.resolutionLevel;
+        OPTDENSE::nMaxResolution = options.maxResolution;
+        OPTDENSE::nMinResolution = options.minResolution;
+        OPTDENSE::nNumViews = options.numViews;
+        OPTDENSE::nMinViewsFuse = options.minViewsFuse;
+        OPTDENSE::nEstimateColors = 2;  // colours from the views (final)
+        OPTDENSE::nEstimateNormals = 2; // normals from the depth maps (final)
+        OPTDENSE::update();
+
+        //---------------------------------------
+        // Depth maps and fusion per chunk; the depth maps stream to disk (depth<ID>.dmap) and
+        // are reused by the following chunks and by a rerun after a cancel
+        //---------------------------------------
+        openMVG::system::Timer timer;
+        const size_t totalViews = scene.images.size();
+        std::atomic<size_t> chunksDone(0);
+        std::mutex progressLock;
+        std::condition_variable progressWake;
+        bool densifyDone = false;
+        std::string step = "- Depth maps -";
+        std::thread progressPoller([&]
+                                   {
+            if (!progressCallback)
+                return;
+            std::unique_lock<std::mutex> guard(progressLock);
+            while (!progressWake.wait_for(guard, std::chrono::milliseconds(500), [&]
+                                          { return densifyDone; }))
+            {
+                const size_t depthMaps = std::min(totalViews, countDepthMaps(sWorkingDir));
+                progressCallback(0.85 * double(depthMaps) / double(totalViews) +
+                                     0.15 * double(chunksDone) / double(chunks.size()),
+                                 step);
+            } });
+        auto stopPoller = [&]
+        {
+            {
+                std::lock_guard<std::mutex> guard(progressLock);
+                densifyDone = true;
+            }
+            progressWake.notify_all();
+            progressPoller.join();
+        };
+
+        MVS::PointCloud merged;
+        std::unique_ptr<MVS::Scene> single;
+        bool bOk = true;
+        // exceptions of OpenMVS (allocation failures, ...) must not leave the poller running
+        try
+        {
+            for (size_t c = 0; c < chunks.size() && bOk; ++c)
+            {
+                // OpenMVS has no cancel hook: the running chunk completes
+                if (cancelled())
+                    break;
+                {
+                    std::lock_guard<std::mutex> guard(progressLock);
+                    step = "- Depth maps, chunk " + std::to_string(c + 1) + "/" + std::to_string(chunks.size()) + " -";
+                }
+
+                char chunkName[32];
+                std::snprintf(chunkName, sizeof(chunkName), "chunk_%04zu.mvs", c);
+                const std::string sChunkFile = sWorkingDir + "/" + chunkName;
+                if (!_INTERFACE_NAMESPACE::ARCHIVE::SerializeSave(chunkScene(scene, chunks[c]), sChunkFile))
+                {
+                    LOG_ERROR("Cannot write " + sChunkFile);
+                    bOk = false;
+                    break;
+                }
+
+                auto chunkMvs = std::make_unique<MVS::Scene>(static_cast<unsigned>(nb_thread));
+                if (!chunkMvs->Load(sChunkFile))
+                {
+                    LOG_ERROR("OpenMVS cannot load " + sChunkFile);
+                    bOk = false;
+                    break;
+                }
+                {
+                    VoxelForge::TelemetryScope chunkTelemetry("Densify/Chunk");
+                    if (!chunkMvs->DenseReconstruction())
+                    {
+                        LOG_ERROR("Dense reconstruction of chunk " + std::to_string(c + 1) + " failed.");
+                        bOk = false;
+                        break;
+                    }
+                    chunkTelemetry.count("views", static_cast<double>(chunks[c].images.size()));
+                    chunkTelemetry.count("points", static_cast<double>(chunkMvs->pointcloud.points.GetSize()));
+                    chunkTelemetry.succeed();
+                }
+                LOG("Chunk " + std::to_string(c + 1) + "/" + std::to_string(chunks.size()) + ": " +
+                    std::to_string(chunkMvs->pointcloud.points.GetSize()) + " points from " +
+                    std::to_string(chunks[c].images.size()) + " views.");
+
+                if (chunks.size() == 1)
+                {
+                    single = std::move(chunkMvs);
+                }
+                else
+                {
+                    // a point belongs to the chunk owning its position, so overlapping chunks do not duplicate it
+                    const MVS::PointCloud &cloud = chunkMvs->pointcloud;
+                    for (size_t p = 0; p < cloud.points.GetSize(); ++p)
+                    {
+                        const MVS::PointCloud::Point &X = cloud.points[p];
+                        if (!chunks[c].bounds.contains({X.x, X.y, X.z}))
+                            continue;
+                        const MVS::PointCloud::ViewArr &views = cloud.pointViews[p];
+                        merged.points.Insert(cloud.points[p]);
+                        MVS::PointCloud::ViewArr &globalViews = merged.pointViews.AddEmpty();
+                        for (size_t v = 0; v < views.GetSize(); ++v)
+                            globalViews.Insert(chunks[c].images[views[v]]);
+                        if (!cloud.pointWeights.IsEmpty())
+                            merged.pointWeights.Insert(cloud.pointWeights[p]);
+                        if (!cloud.normals.IsEmpty())
+                            merged.normals.Insert(cloud.normals[p]);
+                        if (!cloud.colors.IsEmpty())
+                            merged.colors.Insert(cloud.colors[p]);
+                    }
+                }
+                std::error_code removeError;
+                fs::remove(sChunkFile, removeError);
+                ++chunksDone;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR(std::string("Dense reconstruction failed: ") + e.what());
+            bOk = false;
+        }
+        stopPoller();
+
+        if (bOk && chunksDone < chunks.size())
+        {
+            LOG("Densify cancelled after " + std::to_string(chunksDone) + " of " + std::to_string(chunks.size()) +
+                " chunk(s); the depth maps on disk are reused by the next run.");
+            return false;
+        }
+        if (!bOk)
+            return false;
+
+        //---------------------------------------
+        // Dense scene (images + dense point cloud) for the mesh stages
+        //---------------------------------------
+        if (!single)
+        {
+            // the whole scene without its sparse points, with the merged cloud
+            DensifyChunk everything;
+            everything.images = allViews;
+            _INTERFACE_NAMESPACE::Interface images = chunkScene(scene, everything);
+            const std::string sImagesFile = sWorkingDir + "/scene_images.mvs";
+            single = std::make_unique<MVS::Scene>(static_cast<unsigned>(nb_thread));
+            if (!_INTERFACE_NAMESPACE::ARCHIVE::SerializeSave(images, sImagesFile) || !single->Load(sImagesFile))
+            {
+                LOG_ERROR("Cannot assemble the dense scene in " + sWorkingDir);
+                return false;
+            }
+            // swapped, not copied: the merged cloud is the largest allocation of the stage
+            single->pointcloud.Swap(merged);
+            merged.Release();
+            fs::remove(sImagesFile, ec);
+        }
+
+        if (!single->Save(sOutDenseScene) || !single->pointcloud.Save(sOutDensePly))
+        {
+            LOG_ERROR("Cannot save the dense scene to " + sOutDenseScene);
+            return false;
+        }
+        LOG("Dense point cloud: " + std::to_string(single->pointcloud.points.GetSize()) + " points, saved to " +
+            sOutDensePly + " in (s): " + std::to_string(timer.elapsed()));
+
+        telemetry.count("views", static_cast<double>(totalViews));
+        telemetry.count("chunks", static_cast<double>(chunks.size()));
+        telemetry.count("points", static_cast<double>(single->pointcloud.points.GetSize()));
+        telemetry.succeed();
+        return true;
+    }
+}
@@ -0,0 +1,641 @@
+#include "openmvg_wrappers.hpp"
+#include "openmvs_session.hpp"
+#include "ply_io.hpp"
+#include "regions_budget.hpp"
+#include "spatial_partition.hpp"
+#include "telemetry.hpp"
+#include "thread_budget.hpp"
+
+// code implementation taken from openMVS/apps/ReconstructMesh/ReconstructMesh.cpp
+// (in-process, point cloud meshed in spatial chunks when it does not fit the memory budget)
+
+// OpenMVS
+#include <openmvs/MVS.h>
+
+#undef D2R
+#undef R2D
+
+#include <openmvs/MVS/Interface.h>
+
+#include "openMVG/system/logger.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace OpenMVG_Wrappers
+{
+    namespace
+    {
+        // Delaunay tetrahedralization (about 6.5 cells per vertex), graph-cut edges and visibility rays per point
+        constexpr uint64_t DelaunayBytesPerPoint = 1024;
+        constexpr uint64_t MinChunkPoints = 1000000;
+        constexpr double ChunkOverlap = 0.05;
+
+        // Platforms and images at the start of a scene archive: the cameras of the dense scene without reading its points
+        struct SceneCameras
+        {
+            std::vector<_INTERFACE_NAMESPACE::Interface::Platform> platforms;
+            std::vector<_INTERFACE_NAMESPACE::Interface::Image> images;
+
+            template <class Archive>
+            void serialize(Archive &ar, const unsigned int /*version*/)
+            {
+                ar & platforms;
+                ar & images;
+            }
+        };
+
+        // The dense scene without its points, for a cloud streamed from its PLY. Written as a scene of its own and
+        // loaded like the dense scene (image names resolved against the working folder the same way)
+        bool loadSceneCameras(const std::string &sDenseScene, const std::string &sWorkingDir, MVS::Scene &scene)
+        {
+            SceneCameras cameras;
+            if (!_INTERFACE_NAMESPACE::ARCHIVE::SerializeLoad(cameras, sDenseScene) || cameras.images.empty())
+                return false;
+            _INTERFACE_NAMESPACE::Interface cameraScene;
+            cameraScene.platforms = std::move(cameras.platforms);
+            cameraScene.images = std::move(cameras.images);
+
+            const std::string sCamerasFile = sWorkingDir + "/scene_cameras.mvs";
+            const bool ok = _INTERFACE_NAMESPACE::ARCHIVE::SerializeSave(cameraScene, sCamerasFile) && scene.Load(sCamerasFile);
+            std::error_code ec;
+            fs::remove(sCamerasFile, ec);
+            return ok;
+        }
+
+        // Point of the dense cloud as the chunked path visits it: position, indices of the images seeing it
+        // and their weights (empty if the cloud has none)
+        using DensePointVisitor = std::function<void(const MVS::PointCloud::Point &X, const uint32_t *views, size_t viewCount,
+                                                     const float *weights, size_t weightCount)>;
+
+        // Vertex properties of a dense cloud saved by OpenMVS (PointCloud::Save: binary, views in list properties)
+        struct DensePlyLayout
+        {
+            VoxelForge::PlyHeader header;
+            int position[3] = {-1, -1, -1};
+            int views = -1;   // view_indices
+            int weights = -1; // view_weights
+        };
+
+        bool readDensePlyLayout(std::FILE *file, DensePlyLayout &layout)
+        {
+            if (!VoxelForge::ReadPlyHeader(file, layout.header) || layout.header.format == VoxelForge::PlyHeader::Format::Ascii ||
+                layout.header.elements.empty() || layout.header.elements[0].name != "vertex")
+                return false;
+            const VoxelForge::PlyElement &vertex = layout.header.elements[0];
+            int colour[3], normal[3];
+            VoxelForge::FindPlyVertexProperties(vertex, layout.position, colour, normal);
+            layout.views = vertex.find("view_indices");
+            layout.weights = vertex.find("view_weights");
+            return layout.position[0] >= 0 && layout.position[1] >= 0 && layout.position[2] >= 0 &&
+                   layout.views >= 0 && vertex.properties[layout.views].isList &&
+                   (layout.weights < 0 || vertex.properties[layout.weights].isList);
+        }
+
+        // Vertex count of the dense PLY if it can be streamed with its views, else 0
+        uint64_t streamableDensePoints(const std::string &path)
+        {
+            std::FILE *file = std::fopen(path.c_str(), "rb");
+            if (!file)
+                return 0;
+            DensePlyLayout layout;
+            const bool ok = readDensePlyLayout(file, layout);
+            std::fclose(file);
+            return ok ? layout.header.elements[0].count : 0;
+        }
+
+        // One pass over the vertices of the dense PLY, without holding them
+        bool streamDensePly(const std::string &path, const DensePointVisitor &visit)
+        {
+            std::FILE *file = std::fopen(path.c_str(), "rb");
+            if (!file)
+                return false;
+            DensePlyLayout layout;
+            if (!readDensePlyLayout(file, layout))
+            {
+                std::fclose(file);
+                return false;
+            }
+            const VoxelForge::PlyElement &vertex = layout.header.elements[0];
+            const bool bigEndian = layout.header.format == VoxelForge::PlyHeader::Format::BinaryBigEndian;
+
+            // buffered reads, a vertex (lists included) is far smaller than the buffer
+            std::vector<unsigned char> buffer(size_t(1) << 20);
+            size_t begin = 0, end = 0;
+            auto take = [&](size_t bytes) -> const unsigned char *
+            {
+                if (end - begin < bytes)
+                {
+                    std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+                    end -= begin;
+                    begin = 0;
+                    end += std::fread(buffer.data() + end, 1, buffer.size() - end, file);
+                    if (end < bytes)
+                        return nullptr;
+                }
+                const unsigned char *data = buffer.data() + begin;
+                begin += bytes;
+                return data;
+            };
+
+            std::vector<uint32_t> views;
+            std::vector<float> weights;
+            bool ok = true;
+            for (uint64_t v = 0; v < vertex.count && ok; ++v)
+            {
+                float coords[3] = {0.f, 0.f, 0.f};
+                views.clear();
+                weights.clear();
+                for (size_t k = 0; k < vertex.properties.size() && ok; ++k)
+                {
+                    const VoxelForge::PlyProperty &property = vertex.properties[k];
+                    const size_t size = VoxelForge::PlyTypeSize(property.type);
+                    if (!property.isList)
+                    {
+                        const unsigned char *data = take(size);
+                        ok = data != nullptr;
+                        for (int axis = 0; axis < 3 && ok; ++axis)
+                            if (layout.position[axis] == int(k))
+                                coords[axis] = static_cast<float>(VoxelForge::DecodePlyValue(data, property.type, bigEndian));
+                        continue;
+                    }
+                    const unsigned char *countData = take(VoxelForge::PlyTypeSize(property.countType));
+                    ok = countData != nullptr;
+                    if (!ok)
+                        break;
+                    const size_t count = static_cast<size_t>(VoxelForge::DecodePlyValue(countData, property.countType, bigEndian));
+                    const unsigned char *data = take(count * size);
+                    ok = data != nullptr;
+                    for (size_t i = 0; i < count && ok; ++i)
+                    {
+                        if (int(k) == layout.views)
+                            views.push_back(static_cast<uint32_t>(VoxelForge::DecodePlyValue(data + i * size, property.type, bigEndian)));
+                        else if (int(k) == layout.weights)
+                            weights.push_back(static_cast<float>(VoxelForge::DecodePlyValue(data + i * size, property.type, bigEndian)));
+                    }
+                }
+                if (ok)
+                    visit(MVS::PointCloud::Point(coords[0], coords[1], coords[2]), views.data(), views.size(), weights.data(), weights.size());
+            }
+            std::fclose(file);
+            return ok;
+        }
+
+        // Same pass over a cloud already in memory
+        void visitPointCloud(const MVS::PointCloud &cloud, const DensePointVisitor &visit)
+        {
+            for (size_t p = 0; p < cloud.points.GetSize(); ++p)
+            {
+                const MVS::PointCloud::ViewArr &views = cloud.pointViews[p];
+                const bool weighted = !cloud.pointWeights.IsEmpty();
+                visit(cloud.points[p], views.GetData(), views.GetSize(),
+                      weighted ? cloud.pointWeights[p].GetData() : nullptr, weighted ? cloud.pointWeights[p].GetSize() : 0);
+            }
+        }
+
+        // Thinning radius of a point: minPointDistance pixels at its depth in the view seeing it at the finest resolution
+        float thinningRadius(const MVS::Scene &scene, const MVS::PointCloud::Point &X, const uint32_t *views, size_t viewCount, float minPointDistance)
+        {
+            const MVS::Point3 point(X.x, X.y, X.z);
+            double finest = std::numeric_limits<double>::max();
+            for (size_t v = 0; v < viewCount; ++v)
+            {
+                if (views[v] >= scene.images.GetSize())
+                    continue;
+                const MVS::Camera &camera = scene.images[views[v]].camera;
+                const double depth = camera.TransformPointW2C(point).z;
+                if (depth > 0)
+                    finest = std::min(finest, depth / camera.K(0, 0));
+            }
+            return finest < std::numeric_limits<double>::max() ? static_cast<float>(minPointDistance * finest) : 0.f;
+        }
+
+        // Thinning of the chunked path, once for all chunks. OpenMVS thins by minPointDistance while inserting, in an
+        // order depending on the points it is given, so two chunks would keep different points along their seam. Here a
+        // point is dropped when an already kept point lies within its radius. The points are bucketed in a grid of twice
+        // the median radius laid over the whole cloud, and each cell is compared with its neighbour cells (larger radii
+        // are thinned less), so the result depends neither on the partition nor on the threads: the cells are thinned in
+        // 27 passes, one per position modulo 3, and cells of a pass are never neighbours, so they run in parallel.
+        // Returns one flag per point
+        std::vector<uint8_t> thinPoints(const std::vector<MVS::PointCloud::Point> &points, const std::vector<float> &radius, int nb_thread)
+        {
+            const uint32_t count = static_cast<uint32_t>(points.size());
+            std::vector<uint8_t> keep(count, 1);
+
+            // median of at most a million radii, evenly spaced
+            std::vector<float> radii;
+            const uint32_t step = std::max<uint32_t>(1, count / 1000000);
+            for (uint32_t p = 0; p < count; p += step)
+                if (radius[p] > 0)
+                    radii.push_back(radius[p]);
+            if (radii.empty())
+                return keep;
+            std::nth_element(radii.begin(), radii.begin() + radii.size() / 2, radii.end());
+            double cellSize = 2.0 * radii[radii.size() / 2];
+            radii = std::vector<float>();
+
+            double low[3] = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+            double high[3] = {std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+            for (const MVS::PointCloud::Point &X : points)
+            {
+                const double coords[3] = {X.x, X.y, X.z};
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    low[axis] = std::min(low[axis], coords[axis]);
+                    high[axis] = std::max(high[axis], coords[axis]);
+                }
+            }
+            // 21 bits per axis of the cell key
+            for (int axis = 0; axis < 3; ++axis)
+                cellSize = std::max(cellSize, (high[axis] - low[axis]) / double((1 << 20) - 1));
+            constexpr int64_t CellMask = (1 << 21) - 1;
+            auto cellKey = [](int64_t x, int64_t y, int64_t z)
+            { return uint64_t(x) << 42 | uint64_t(y) << 21 | uint64_t(z); };
+
+            struct Entry
+            {
+                uint64_t key;
+                uint32_t point;
+            };
+            std::vector<Entry> order(count);
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for num_threads(nb_thread)
+#endif
+            for (int64_t p = 0; p < int64_t(count); ++p)
+            {
+                const MVS::PointCloud::Point &X = points[p];
+                order[p] = {cellKey(int64_t((X.x - low[0]) / cellSize), int64_t((X.y - low[1]) / cellSize),
+                                    int64_t((X.z - low[2]) / cellSize)),
+                            uint32_t(p)};
+            }
+            std::sort(order.begin(), order.end(), [](const Entry &a, const Entry &b)
+                      { return a.key != b.key ? a.key < b.key : a.point < b.point; });
+
+            // occupied cells in key order with their first entry in order (plus an end marker): the cells z - 1 .. z + 1
+            // of a column are consecutive keys, so their points are one range of order
+            std::vector<uint64_t> cellKeys;
+            std::vector<uint32_t> cellFirst;
+            std::vector<std::vector<uint32_t>> passes(27);
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const uint64_t key = order[i].key;
+                if (i > 0 && order[i - 1].key == key)
+                    continue;
+                passes[(key >> 42) % 3 * 9 + ((key >> 21) & CellMask) % 3 * 3 + (key & CellMask) % 3].push_back(uint32_t(cellKeys.size()));
+                cellKeys.push_back(key);
+                cellFirst.push_back(i);
+            }
+            cellFirst.push_back(count);
+            auto firstEntryFrom = [&](uint64_t key)
+            { return cellFirst[std::lower_bound(cellKeys.begin(), cellKeys.end(), key) - cellKeys.begin()]; };
+
+            std::fill(keep.begin(), keep.end(), 0);
+            for (const std::vector<uint32_t> &pass : passes)
+            {
+#ifdef OPENMVG_USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64) num_threads(nb_thread)
+#endif
+                for (int64_t c = 0; c < int64_t(pass.size()); ++c)
+                {
+                    // the cell and its neighbours: thinned by an earlier pass, by this one (the cell itself) or not yet
+                    const uint32_t cell = pass[c];
+                    const uint64_t key = cellKeys[cell];
+                    const int64_t x = int64_t(key >> 42), y = int64_t(key >> 21) & CellMask, z = int64_t(key) & CellMask;
+                    std::pair<uint32_t, uint32_t> neighbours[9];
+                    int neighbourCount = 0;
+                    for (int64_t dx = -1; dx <= 1; ++dx)
+                        for (int64_t dy = -1; dy <= 1; ++dy)
+                        {
+                            if (x + dx < 0 || y + dy < 0 || x + dx > CellMask || y + dy > CellMask)
+                                continue;
+                            const uint32_t first = firstEntryFrom(cellKey(x + dx, y + dy, std::max<int64_t>(z - 1, 0)));
+                            const uint32_t last = firstEntryFrom(cellKey(x + dx, y + dy, std::min(z + 1, CellMask)) + 1);
+                            if (first < last)
+                                neighbours[neighbourCount++] = {first, last};
+                        }
+
+                    for (uint32_t i = cellFirst[cell]; i < cellFirst[cell + 1]; ++i)
+                    {
+                        const uint32_t p = order[i].point;
+                        const double r = radius[p];
+                        const MVS::PointCloud::Point &X = points[p];
+                        bool near = false;
+                        for (int n = 0; n < neighbourCount && !near && r > 0; ++n)
+                            for (uint32_t j = neighbours[n].first; j < neighbours[n].second && !near; ++j)
+                            {
+                                const uint32_t q = order[j].point;
+                                if (!keep[q])
+                                    continue;
+                                const MVS::PointCloud::Point &Y = points[q];
+                                const double dx = double(X.x) - Y.x, dy = double(X.y) - Y.y, dz = double(X.z) - Y.z;
+                                near = dx * dx + dy * dy + dz * dz < r * r;
+                            }
+                        keep[p] = !near;
+                    }
+                }
+            }
+            return keep;
+        }
+
+        // the chunks are meshed without OpenMVS' thinning, so mesh vertices are points of the thinned cloud:
+        // a point meshed by two chunks has the same coordinates in both
+        struct VertexKey
+        {
+            uint32_t bits[3];
+            bool operator==(const VertexKey &other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+        };
+        struct VertexKeyHash
+        {
+            size_t operator()(const VertexKey &key) const
+            {
+                return std::hash<uint64_t>()((uint64_t(key.bits[0]) << 32 | key.bits[1]) ^ (uint64_t(key.bits[2]) * 0x9E3779B97F4A7C15ull));
+            }
+        };
+        using WeldMap = std::unordered_map<VertexKey, uint32_t, VertexKeyHash>;
+
+        // Faces of a chunk mesh whose centroid lies in the chunk's cell, appended to merged. Vertices shared with
+        // the neighbour chunks are welded, so each side of a seam comes from one chunk and the two sides meet at
+        // the points both chunks meshed. Where their surfaces differ near the seam small gaps are left to the
+        // hole closing of the cleaning passes
+        void appendCellFaces(const MVS::Mesh &chunkMesh, const VoxelForge::SpatialBox &cell, MVS::Mesh &merged, WeldMap &welded)
+        {
+            std::vector<uint32_t> remap(chunkMesh.vertices.GetSize(), UINT32_MAX);
+            auto vertexOf = [&](uint32_t v)
+            {
+                if (remap[v] == UINT32_MAX)
+                {
+                    const MVS::Mesh::Vertex &X = chunkMesh.vertices[v];
+                    VertexKey key;
+                    std::memcpy(&key.bits[0], &X.x, sizeof(float));
+                    std::memcpy(&key.bits[1], &X.y, sizeof(float));
+                    std::memcpy(&key.bits[2], &X.z, sizeof(float));
+                    const auto inserted = welded.emplace(key, static_cast<uint32_t>(merged.vertices.GetSize()));
+                    if (inserted.second)
+                        merged.vertices.Insert(X);
+                    remap[v] = inserted.first->second;
+                }
+                return remap[v];
+            };
+            for (size_t f = 0; f < chunkMesh.faces.GetSize(); ++f)
+            {
+                const MVS::Mesh::Face &face = chunkMesh.faces[f];
+                const MVS::Mesh::Vertex &a = chunkMesh.vertices[face.x], &b = chunkMesh.vertices[face.y], &c = chunkMesh.vertices[face.z];
+                const VoxelForge::Point3 centroid = {(double(a.x) + b.x + c.x) / 3, (double(a.y) + b.y + c.y) / 3, (double(a.z) + b.z + c.z) / 3};
+                if (cell.contains(centroid))
+                    merged.faces.Insert(MVS::Mesh::Face(vertexOf(face.x), vertexOf(face.y), vertexOf(face.z)));
+            }
+        }
+    }
+
+    bool RunReconstructMesh(
+        std::string sDenseScene,
+        std::string sDensePly,
+        std::string sWorkingDir,
+        std::string sOutMeshScene,
+        std::string sOutMeshPly,
+        LogCallback logCallback,
+        ProgressCallback progressCallback,
+        const std::atomic<bool> *cancel,
+        // optional
+        MeshOptions options,
+        int iNumThreads)
+    {
+        // Helper for logging to both console and GUI
+        auto LOG = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_INFO << msg;
+            if (logCallback)
+                logCallback(msg);
+        };
+
+        auto LOG_ERROR = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_ERROR << msg;
+            if (logCallback)
+                logCallback("ERROR: " + msg);
+        };
+
+        auto PROGRESS = [&](double fraction, const std::string &step)
+        {
+            if (progressCallback)
+                progressCallback(fraction, step);
+        };
+
+        VoxelForge::TelemetryScope telemetry("ReconstructMesh");
+        auto cancelled = [cancel]
+        { return cancel && cancel->load(std::memory_order_relaxed); };
+
+        std::error_code ec;
+        fs::create_directories(sWorkingDir, ec);
+        if (ec)
+        {
+            LOG_ERROR("Cannot create the mesh working directory " + sWorkingDir + ": " + ec.message());
+            return false;
+        }
+
+        const int nb_thread = StageThreads(iNumThreads);
+
+        const std::unique_lock<std::mutex> mvsGuard = LockOpenMVS(sWorkingDir);
+        openMVG::system::Timer timer;
+        WeldMap welded;
+
+        // the tetrahedralization of every point has to fit the memory budget, else the cloud is meshed in chunks
+        const uint64_t budget = options.memoryBudgetMB > 0 ? uint64_t(options.memoryBudgetMB) << 20 : DefaultRegionsBudgetBytes();
+        const size_t maxChunkPoints = static_cast<size_t>(std::max<uint64_t>(MinChunkPoints, budget / DelaunayBytesPerPoint));
+
+        // A cloud meshed in chunks is streamed from the dense PLY (OpenMVS writes the views of the points there too):
+        // only the cameras of the dense scene are loaded. Without views in the PLY the whole scene is loaded
+        PROGRESS(0.0, "- Loading -");
+        const uint64_t plyPoints = streamableDensePoints(sDensePly);
+        const bool streamed = plyPoints > maxChunkPoints;
+        MVS::Scene scene(static_cast<unsigned>(nb_thread));
+        if (streamed ? !loadSceneCameras(sDenseScene, sWorkingDir, scene)
+                     : (!scene.Load(sDenseScene) || scene.pointcloud.IsEmpty()))
+        {
+            LOG_ERROR("The dense scene \"" + sDenseScene + "\" cannot be read or has no point cloud.");
+            return false;
+        }
+        const size_t points = streamed ? static_cast<size_t>(plyPoints) : scene.pointcloud.points.GetSize();
+        auto visitDensePoints = [&](const DensePointVisitor &visit)
+        {
+            if (!streamed)
+            {
+                visitPointCloud(scene.pointcloud, visit);
+                return true;
+            }
+            return streamDensePly(sDensePly, visit);
+        };
+
+        std::vector<VoxelForge::SpatialCell> cells;
+        // chunked: the points left by the thinning, with their views and weights (viewStart: first view of each point)
+        std::vector<MVS::PointCloud::Point> meshed;
+        std::vector<uint32_t> viewStart, viewIds;
+        std::vector<float> viewWeights;
+        bool weighted = false;
+        if (points > maxChunkPoints)
+        {
+            // first pass: positions and thinning radii, the views are read again for the kept points only
+            PROGRESS(0.0, "- Thinning -");
+            std::vector<MVS::PointCloud::Point> cloud;
+            std::vector<float> radius;
+            cloud.reserve(points);
+            radius.reserve(points);
+            bool readOk = visitDensePoints([&](const MVS::PointCloud::Point &X, const uint32_t *views, size_t viewCount, const float *, size_t weightCount)
+                                           {
+                                               cloud.push_back(X);
+                                               radius.push_back(options.minPointDistance > 0 ? thinningRadius(scene, X, views, viewCount, options.minPointDistance) : 0.f);
+                                               weighted = weighted || weightCount > 0; });
+            if (!readOk || cloud.size() != points)
+            {
+                LOG_ERROR("Cannot read the dense point cloud " + (streamed ? sDensePly : sDenseScene));
+                return false;
+            }
+            std::vector<uint8_t> keep = thinPoints(cloud, radius, nb_thread);
+            radius = std::vector<float>();
+            for (size_t p = 0; p < cloud.size(); ++p)
+                if (keep[p])
+                    meshed.push_back(cloud[p]);
+            cloud = std::vector<MVS::PointCloud::Point>();
+            if (cancelled())
+                return false;
+
+            size_t p = 0;
+            viewStart.reserve(meshed.size() + 1);
+            readOk = visitDensePoints([&](const MVS::PointCloud::Point &, const uint32_t *views, size_t viewCount, const float *weights, size_t weightCount)
+                                      {
+                                          if (p >= keep.size() || !keep[p++])
+                                              return;
+                                          viewStart.push_back(static_cast<uint32_t>(viewIds.size()));
+                                          viewIds.insert(viewIds.end(), views, views + viewCount);
+                                          if (weighted)
+                                          {
+                                              viewWeights.insert(viewWeights.end(), weights, weights + std::min(weightCount, viewCount));
+                                              viewWeights.resize(viewIds.size(), 0.f);
+                                          } });
+            viewStart.push_back(static_cast<uint32_t>(viewIds.size()));
+            if (!readOk || viewStart.size() != meshed.size() + 1)
+            {
+                LOG_ERROR("Cannot read the dense point cloud " + (streamed ? sDensePly : sDenseScene));
+                return false;
+            }
+            // the chunks are built from the arrays above
+            scene.pointcloud.Release();
+
+            std::vector<VoxelForge::Point3> positions(meshed.size());
+            for (size_t i = 0; i < meshed.size(); ++i)
+                positions[i] = {meshed[i].x, meshed[i].y, meshed[i].z};
+            // the overlap margin (5% of the extent on each side) adds about a third to a cell
+            cells = VoxelForge::PartitionSpace(positions, [&](const std::vector<uint32_t> &cellPoints)
+                                               { return cellPoints.size() + cellPoints.size() / 3 <= maxChunkPoints; },
+                                               ChunkOverlap);
+        }
+        LOG("Reconstructing the surface of " + std::to_string(points) + " points" +
+            (cells.empty() ? std::string() : " (" + std::to_string(meshed.size()) + " after thinning) in " + std::to_string(cells.size()) + " chunks") + ", " +
+            std::to_string(nb_thread) + " threads.");
+
+        // OpenMVS has no cancel hook: checked between the steps
+        try
+        {
+            if (cancelled())
+                return false;
+            if (cells.empty())
+            {
+                PROGRESS(0.1, "- Delaunay -");
+                if (!scene.ReconstructMesh(options.minPointDistance, false))
+                {
+                    LOG_ERROR("Mesh reconstruction failed.");
+                    return false;
+                }
+            }
+            for (size_t c = 0; c < cells.size(); ++c)
+            {
+                if (cancelled())
+                    return false;
+                PROGRESS(0.1 + 0.6 * double(c) / double(cells.size()),
+                         "- Chunk " + std::to_string(c + 1) + "/" + std::to_string(cells.size()) + " -");
+
+                // the points of the cell grown by the overlap, with the cameras to carve free space
+                MVS::Scene chunk(static_cast<unsigned>(nb_thread));
+                chunk.platforms = scene.platforms;
+                chunk.images = scene.images;
+                for (size_t i = 0; i < meshed.size(); ++i)
+                {
+                    const MVS::PointCloud::Point &X = meshed[i];
+                    if (!cells[c].overlap.contains({X.x, X.y, X.z}))
+                        continue;
+                    chunk.pointcloud.points.Insert(X);
+                    MVS::PointCloud::ViewArr &views = chunk.pointcloud.pointViews.AddEmpty();
+                    for (uint32_t v = viewStart[i]; v < viewStart[i + 1]; ++v)
+                        views.Insert(viewIds[v]);
+                    if (weighted)
+                    {
+                        MVS::PointCloud::WeightArr &weights = chunk.pointcloud.pointWeights.AddEmpty();
+                        for (uint32_t v = viewStart[i]; v < viewStart[i + 1]; ++v)
+                            weights.Insert(viewWeights[v]);
+                    }
+                }
+                // already thinned: every point is inserted, so the chunks share the vertices along their seams
+                if (!chunk.ReconstructMesh(0.f, false))
+                {
+                    LOG_ERROR("Mesh reconstruction of chunk " + std::to_string(c + 1) + " failed.");
+                    return false;
+                }
+                appendCellFaces(chunk.mesh, cells[c].bounds, scene.mesh, welded);
+            }
+            welded = WeldMap();
+            meshed = std::vector<MVS::PointCloud::Point>();
+            viewStart = std::vector<uint32_t>();
+            viewIds = std::vector<uint32_t>();
+            viewWeights = std::vector<float>();
+
+            if (cancelled())
+                return false;
+            // same passes as the ReconstructMesh app: spurious faces, spikes, holes and smoothing, then the final clean;
+            // on the merged mesh they also close the small gaps left along the chunk seams
+            PROGRESS(0.7, "- Cleaning -");
+            scene.mesh.Clean(1.f, 20.f, true, 30, options.smoothSteps, 0.f, false);
+            scene.mesh.Clean(1.f, 0.f, true, 30, 0, 0.f, false);
+            scene.mesh.Clean(1.f, 0.f, false, 0, 0, 0.f, true);
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR(std::string("Mesh reconstruction failed: ") + e.what());
+            return false;
+        }
+        if (scene.mesh.IsEmpty())
+        {
+            LOG_ERROR("Mesh reconstruction produced no faces.");
+            return false;
+        }
+
+        // the next stages work on the mesh and the images only
+        PROGRESS(0.9, "- Saving -");
+        scene.pointcloud.Release();
+        if (!scene.Save(sOutMeshScene) || !scene.mesh.Save(sOutMeshPly))
+        {
+            LOG_ERROR("Cannot save the mesh to " + sOutMeshScene);
+            return false;
+        }
+        LOG("Mesh: " + std::to_string(scene.mesh.vertices.GetSize()) + " vertices, " +
+            std::to_string(scene.mesh.faces.GetSize()) + " faces, saved to " + sOutMeshPly +
+            " in (s): " + std::to_string(timer.elapsed()));
+
+        telemetry.count("points", static_cast<double>(points));
+        telemetry.count("chunks", static_cast<double>(std::max<size_t>(1, cells.size())));
+        telemetry.count("vertices", static_cast<double>(scene.mesh.vertices.GetSize()));
+        telemetry.count("faces", static_cast<double>(scene.mesh.faces.GetSize()));
+        telemetry.succeed();
+        return true;
+    }
+}
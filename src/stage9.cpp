@@ -0,0 +1,129 @@
+#include "openmvg_wrappers.hpp"
+#include "openmvs_session.hpp"
+#include "telemetry.hpp"
+#include "thread_budget.hpp"
+
+// code implementation taken from openMVS/apps/RefineMesh/RefineMesh.cpp (in-process)
+
+// OpenMVS
+#include <openmvs/MVS.h>
+
+#undef D2R
+#undef R2D
+
+#include "openMVG/system/logger.hpp"
+#include "openMVG/system/timer.hpp"
+
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+namespace OpenMVG_Wrappers
+{
+    bool RunRefineMesh(
+        std::string sMeshScene,
+        std::string sMeshPly,
+        std::string sWorkingDir,
+        std::string sOutMeshScene,
+        std::string sOutMeshPly,
+        LogCallback logCallback,
+        ProgressCallback progressCallback,
+        const std::atomic<bool> *cancel,
+        // optional
+        MeshOptions options,
+        int iNumThreads)
+    {
+        // Helper for logging to both console and GUI
+        auto LOG = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_INFO << msg;
+            if (logCallback)
+                logCallback(msg);
+        };
+
+        auto LOG_ERROR = [&](const std::string &msg)
+        {
+            OPENMVG_LOG_ERROR << msg;
+            if (logCallback)
+                logCallback("ERROR: " + msg);
+        };
+
+        auto PROGRESS = [&](double fraction, const std::string &step)
+        {
+            if (progressCallback)
+                progressCallback(fraction, step);
+        };
+
+        VoxelForge::TelemetryScope telemetry("RefineMesh");
+        auto cancelled = [cancel]
+        { return cancel && cancel->load(std::memory_order_relaxed); };
+
+        std::error_code ec;
+        fs::create_directories(sWorkingDir, ec);
+        if (ec)
+        {
+            LOG_ERROR("Cannot create the mesh working directory " + sWorkingDir + ": " + ec.message());
+            return false;
+        }
+
+        const int nb_thread = StageThreads(iNumThreads);
+
+        const std::unique_lock<std::mutex> mvsGuard = LockOpenMVS(sWorkingDir);
+        openMVG::system::Timer timer;
+
+        PROGRESS(0.0, "- Loading -");
+        MVS::Scene scene(static_cast<unsigned>(nb_thread));
+        if (!scene.Load(sMeshScene))
+        {
+            LOG_ERROR("The mesh scene \"" + sMeshScene + "\" cannot be read.");
+            return false;
+        }
+        // scenes saved in the interface format reference the mesh instead of embedding it
+        if (scene.mesh.IsEmpty() && !scene.mesh.Load(sMeshPly))
+        {
+            LOG_ERROR("The mesh \"" + sMeshPly + "\" cannot be read.");
+            return false;
+        }
+        const size_t facesIn = scene.mesh.faces.GetSize();
+        LOG("Refining " + std::to_string(facesIn) + " faces against " + std::to_string(scene.images.GetSize()) +
+            " images, " + std::to_string(nb_thread) + " threads.");
+
+        if (cancelled())
+            return false;
+        try
+        {
+            // RefineMesh app defaults besides the options: no decimation, close holes up to 30 edges,
+            // ensure edge size, max face area 32 px, scale step 0.55, regularity 0.2, rigidity 0.9, gradient step 45.05
+            PROGRESS(0.05, "- Refining -");
+            if (!scene.RefineMesh(options.refineResolutionLevel, options.minResolution, options.refineMaxViews,
+                                  0.f, 30, 1, 32, options.refineScales, 0.55f, 0, 0.2f, 0.9f, 45.05f))
+            {
+                LOG_ERROR("Mesh refinement failed.");
+                return false;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            LOG_ERROR(std::string("Mesh refinement failed: ") + e.what());
+            return false;
+        }
+        if (cancelled())
+            return false;
+
+        PROGRESS(0.95, "- Saving -");
+        if (!scene.Save(sOutMeshScene) || !scene.mesh.Save(sOutMeshPly))
+        {
+            LOG_ERROR("Cannot save the refined mesh to " + sOutMeshScene);
+            return false;
+        }
+        LOG("Refined mesh: " + std::to_string(scene.mesh.vertices.GetSize()) + " vertices, " +
+            std::to_string(scene.mesh.faces.GetSize()) + " faces, saved to " + sOutMeshPly +
+            " in (s): " + std::to_string(timer.elapsed()));
+
+        telemetry.count("images", static_cast<double>(scene.images.GetSize()));
+        telemetry.count("faces", static_cast<double>(scene.mesh.faces.GetSize()));
+        telemetry.succeed();
+        return true;
+    }
+}
@@ -0,0 +1,410 @@
+#include "stage_graph.hpp"
+#include "content_hash.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace VoxelForge
+{
+    namespace
+    {
+        std::string normalized(const std::string &path)
+        {
+            return fs::path(path).lexically_normal().generic_string();
+        }
+
+        std::string stampPath(const std::string &stampDir, const StageNode &node)
+        {
+            return stampDir + "/" + node.name + ".stamp";
+        }
+
+        std::string pendingPath(const std::string &stampDir, const StageNode &node)
+        {
+            return stampDir + "/" + node.name + ".pending";
+        }
+
+        // key + "<hash> <output>" lines; false if there is no stamp
+        bool readStamp(const std::string &path, uint64_t &key, std::map<std::string, uint64_t> &outputs)
+        {
+            std::ifstream in(path);
+            std::string line;
+            if (!std::getline(in, line) || line.compare(0, 4, "key ") != 0)
+                return false;
+            key = std::strtoull(line.c_str() + 4, nullptr, 16);
+            while (std::getline(in, line))
+            {
+                const size_t space = line.find(' ');
+                if (space != std::string::npos)
+                    outputs[line.substr(space + 1)] = std::strtoull(line.substr(0, space).c_str(), nullptr, 16);
+            }
+            return true;
+        }
+    }
+
+    StageGraph::StageGraph(const std::string &stampDir)
+        : stampDir(stampDir)
+    {
+    }
+
+    void StageGraph::add(StageNode node)
+    {
+        nodes.push_back(std::move(node));
+    }
+
+    StageNodeResult StageGraph::result(const std::string &name) const
+    {
+        for (size_t i = 0; i < nodes.size() && i < results.size(); ++i)
+            if (nodes[i].name == name)
+                return results[i];
+        return StageNodeResult::NotRun;
+    }
+
+    // ---- content hashes ----
+
+    void StageGraph::loadHashCache()
+    {
+        std::lock_guard<std::mutex> guard(cacheLock);
+        hashCache.clear();
+        std::ifstream in(stampDir + "/file_hashes.tsv");
+        std::string line;
+        while (std::getline(in, line))
+        {
+            // hash \t size \t mtime \t path (path last: it may contain anything but newlines)
+            std::istringstream fields(line);
+            std::string hash, size, mtime, path;
+            if (std::getline(fields, hash, '\t') && std::getline(fields, size, '\t') &&
+                std::getline(fields, mtime, '\t') && std::getline(fields, path))
+                hashCache[path] = CachedHash{std::strtoull(size.c_str(), nullptr, 10),
+                                             std::strtoll(mtime.c_str(), nullptr, 10),
+                                             std::strtoull(hash.c_str(), nullptr, 16)};
+        }
+        cacheDirty = false;
+    }
+
+    void StageGraph::saveHashCache()
+    {
+        std::lock_guard<std::mutex> guard(cacheLock);
+        if (!cacheDirty)
+            return;
+
+        std::error_code ec;
+        const std::string path = stampDir + "/file_hashes.tsv";
+        {
+            std::ofstream out(path + ".tmp", std::ios::trunc);
+            for (const auto &entry : hashCache)
+            {
+                if (!fs::exists(entry.first, ec))
+                    continue; // forget deleted files
+                out << HexHash(entry.second.hash) << '\t' << entry.second.size << '\t' << entry.second.mtime << '\t'
+                    << entry.first << '\n';
+            }
+        }
+        fs::rename(path + ".tmp", path, ec);
+        cacheDirty = false;
+    }
+
+    uint64_t StageGraph::hashFile(const std::string &path)
+    {
+        std::error_code ec;
+        const uint64_t size = fs::file_size(path, ec);
+        if (ec)
+            return 0;
+        const int64_t mtime = static_cast<int64_t>(fs::last_write_time(path, ec).time_since_epoch().count());
+
+        {
+            std::lock_guard<std::mutex> guard(cacheLock);
+            auto it = hashCache.find(path);
+            if (it != hashCache.end() && it->second.size == size && it->second.mtime == mtime)
+                return it->second.hash;
+        }
+
+        const uint64_t hash = HashFileContents(path);
+        if (hash == 0)
+            return 0;
+
+        std::lock_guard<std::mutex> guard(cacheLock);
+        hashCache[path] = CachedHash{size, mtime, hash};
+        cacheDirty = true;
+        return hash;
+    }
+
+    uint64_t StageGraph::hashPath(const std::string &spec)
+    {
+        std::error_code ec;
+        std::string dir = spec;
+        std::string extension;
+        const size_t star = spec.rfind("/*");
+        if (star != std::string::npos && star + 2 <= spec.size())
+        {
+            dir = spec.substr(0, star);
+            extension = spec.substr(star + 2); // "dir/*.feat" -> ".feat", "dir/*" -> ""
+        }
+        else if (fs::is_regular_file(spec, ec))
+            return hashFile(spec);
+        else if (!fs::is_directory(spec, ec))
+            return 0;
+
+        std::vector<std::string> files;
+        const bool recursive = dir == spec;
+        if (recursive)
+        {
+            for (fs::recursive_directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+                if (it->is_regular_file(ec))
+                    files.push_back(it->path().generic_string());
+        }
+        else
+        {
+            for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec))
+                if (it->is_regular_file(ec) && (extension.empty() || it->path().extension() == extension))
+                    files.push_back(it->path().generic_string());
+        }
+        std::sort(files.begin(), files.end());
+
+        ContentHasher hasher;
+        hasher.update(static_cast<uint64_t>(files.size()));
+        for (const std::string &file : files)
+        {
+            hasher.update(fs::path(file).lexically_relative(dir).generic_string());
+            hasher.update(hashFile(file));
+        }
+        return hasher.digest() | 1;
+    }
+
+    // ---- stamps ----
+
+    uint64_t StageGraph::nodeKey(const StageNode &node)
+    {
+        ContentHasher hasher;
+        hasher.update(node.parameters);
+        for (const std::string &input : node.inputs)
+        {
+            hasher.update(normalized(input));
+            hasher.update(hashPath(input));
+        }
+        return hasher.digest();
+    }
+
+    bool StageGraph::upToDate(const StageNode &node, uint64_t key)
+    {
+        uint64_t stampKey = 0;
+        std::map<std::string, uint64_t> stampOutputs;
+        if (!readStamp(stampPath(stampDir, node), stampKey, stampOutputs) || stampKey != key)
+            return false;
+
+        for (const std::string &output : node.outputs)
+        {
+            auto it = stampOutputs.find(normalized(output));
+            if (it == stampOutputs.end() || it->second != hashPath(output))
+                return false;
+        }
+        return true;
+    }
+
+    bool StageGraph::writePending(const StageNode &node, uint64_t key)
+    {
+        const std::string path = pendingPath(stampDir, node);
+        {
+            std::ofstream out(path + ".tmp", std::ios::trunc);
+            out << "key " << HexHash(key) << '\n';
+            if (!out)
+                return false;
+        }
+        std::error_code ec;
+        fs::rename(path + ".tmp", path, ec);
+        return !ec;
+    }
+
+    bool StageGraph::writeStamp(const StageNode &node, uint64_t key)
+    {
+        const std::string path = stampPath(stampDir, node);
+        {
+            std::ofstream out(path + ".tmp", std::ios::trunc);
+            out << "key " << HexHash(key) << '\n';
+            for (const std::string &output : node.outputs)
+                out << HexHash(hashPath(output)) << ' ' << normalized(output) << '\n';
+            if (!out)
+                return false;
+        }
+        std::error_code ec;
+        fs::rename(path + ".tmp", path, ec);
+        return !ec;
+    }
+
+    // ---- scheduling ----
+
+    bool StageGraph::run(const StageGraphCallbacks &callbacks, const std::atomic<bool> &cancel, int maxParallel)
+    {
+        auto LOG = [&](const std::string &msg)
+        {
+            if (callbacks.log)
+                callbacks.log(msg);
+        };
+
+        const size_t count = nodes.size();
+        results.assign(count, StageNodeResult::NotRun);
+
+        // edges: producer of each input, plus the explicit `after` names
+        std::map<std::string, size_t> producer;
+        for (size_t i = 0; i < count; ++i)
+            for (const std::string &output : nodes[i].outputs)
+                producer[normalized(output)] = i;
+
+        std::vector<std::vector<size_t>> dependencies(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (const std::string &input : nodes[i].inputs)
+            {
+                auto it = producer.find(normalized(input));
+                if (it != producer.end() && it->second != i)
+                    dependencies[i].push_back(it->second);
+            }
+            for (const std::string &name : nodes[i].after)
+            {
+                auto it = std::find_if(nodes.begin(), nodes.end(), [&](const StageNode &n) { return n.name == name; });
+                if (it == nodes.end())
+                {
+                    LOG("ERROR: " + nodes[i].name + " depends on unknown step " + name);
+                    return false;
+                }
+                dependencies[i].push_back(static_cast<size_t>(it - nodes.begin()));
+            }
+        }
+
+        // reject cycles up front (they would just never become ready)
+        {
+            std::vector<int> pending(count, 0);
+            std::vector<size_t> ready;
+            for (size_t i = 0; i < count; ++i)
+                if ((pending[i] = static_cast<int>(dependencies[i].size())) == 0)
+                    ready.push_back(i);
+            size_t ordered = 0;
+            while (!ready.empty())
+            {
+                const size_t done = ready.back();
+                ready.pop_back();
+                ++ordered;
+                for (size_t i = 0; i < count; ++i)
+                    for (size_t dependency : dependencies[i])
+                        if (dependency == done && --pending[i] == 0)
+                            ready.push_back(i);
+            }
+            if (ordered != count)
+            {
+                LOG("ERROR: The pipeline steps have a dependency cycle");
+                return false;
+            }
+        }
+
+        std::error_code ec;
+        fs::create_directories(stampDir, ec);
+        loadHashCache();
+
+        enum class State { Waiting, Running, Finished };
+        std::vector<State> state(count, State::Waiting);
+        std::mutex lock;
+        std::condition_variable finishedOne;
+        int running = 0;
+        bool failed = false;
+        std::vector<std::thread> workers;
+
+        auto execute = [&](size_t index)
+        {
+            const StageNode &node = nodes[index];
+            if (callbacks.nodeStarted)
+                callbacks.nodeStarted(node);
+
+            const auto start = std::chrono::steady_clock::now();
+            StageNodeResult result = StageNodeResult::Failed;
+            try
+            {
+                const uint64_t key = nodeKey(node);
+                if (upToDate(node, key))
+                    result = StageNodeResult::UpToDate;
+                else
+                {
+                    // a stamp or an unfinished run with another key means the inputs or parameters
+                    // changed: partial results of the other configuration must not be reused
+                    uint64_t stampKey = 0, pendingKey = 0;
+                    std::map<std::string, uint64_t> stampOutputs, pendingOutputs;
+                    const bool force =
+                        (readStamp(stampPath(stampDir, node), stampKey, stampOutputs) && stampKey != key) ||
+                        (readStamp(pendingPath(stampDir, node), pendingKey, pendingOutputs) && pendingKey != key);
+
+                    // until the run succeeds its outputs belong to this key; without the pending
+                    // file the old stamp stays, its key still forces the next run if this one stops
+                    std::error_code removeError;
+                    if (writePending(node, key))
+                        fs::remove(stampPath(stampDir, node), removeError);
+                    if (node.run(force))
+                    {
+                        result = StageNodeResult::Done;
+                        if (!writeStamp(node, key))
+                            LOG("WARNING: Cannot write the stamp of " + node.name + "; it will run again next time");
+                        fs::remove(pendingPath(stampDir, node), removeError);
+                    }
+                }
+            }
+            catch (const std::exception &e)
+            {
+                LOG("ERROR: " + node.name + ": " + e.what());
+                result = StageNodeResult::Failed;
+            }
+
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (callbacks.nodeFinished)
+                callbacks.nodeFinished(node, result, seconds);
+
+            std::lock_guard<std::mutex> guard(lock);
+            results[index] = result;
+            state[index] = State::Finished;
+            failed = failed || (result == StageNodeResult::Failed && !node.optional);
+            --running;
+            finishedOne.notify_all();
+        };
+
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            for (;;)
+            {
+                if (!failed && !cancel)
+                {
+                    for (size_t i = 0; i < count && running < std::max(1, maxParallel); ++i)
+                    {
+                        if (state[i] != State::Waiting)
+                            continue;
+                        const bool ready = std::all_of(dependencies[i].begin(), dependencies[i].end(), [&](size_t d)
+                                                       { return state[d] == State::Finished &&
+                                                                (results[d] == StageNodeResult::Done || results[d] == StageNodeResult::UpToDate); });
+                        if (!ready)
+                            continue;
+                        state[i] = State::Running;
+                        ++running;
+                        workers.emplace_back(execute, i);
+                    }
+                }
+                if (running == 0)
+                    break;
+                finishedOne.wait(guard);
+            }
+        }
+        for (std::thread &worker : workers)
+            worker.join();
+
+        saveHashCache();
+
+        if (failed || cancel)
+            return false;
+        for (size_t i = 0; i < count; ++i)
+            if (!nodes[i].optional && results[i] != StageNodeResult::Done && results[i] != StageNodeResult::UpToDate)
+                return false;
+        return true;
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+// Dependency graph of pipeline steps with content-hash memoization.
+//
+// Every node declares the files it reads and writes plus a string of its
+// parameters. Edges are inferred: a node depends on the nodes producing its
+// inputs (and on the names listed in `after`). After a successful run the
+// node stores a stamp in <stampDir>/<name>.stamp:
+//   key = hash(parameters, content hash of every input)
+//   the content hash of every output
+// On the next run a node whose key and outputs still match is skipped.
+// While a node runs, <stampDir>/<name>.pending holds the key it runs with:
+// a node that failed or was cancelled is forced on its next run if that key
+// (or the one of its last stamp) differs, so partial outputs of another
+// configuration are not reused.
+//
+// Paths may be files, folders (all files below them) or "dir/*.ext" (files
+// of dir with that extension). Content hashes are cached by size + mtime in
+// <stampDir>/file_hashes.tsv, so unchanged files are read once.
+
+#include "openmvg_wrappers.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace VoxelForge
+{
+    struct StageNode
+    {
+        std::string name;                 // unique, used for the stamp file
+        std::vector<std::string> inputs;
+        std::vector<std::string> outputs;
+        std::string parameters;           // anything that changes the outputs
+        std::vector<std::string> after;   // extra dependencies by node name
+
+        // force: the node was stale (changed inputs/parameters), cached partial results must not be reused
+        std::function<bool(bool force)> run;
+
+        // a failed optional node does not fail the run (its dependents are still skipped)
+        bool optional = false;
+    };
+
+    enum class StageNodeResult
+    {
+        Done,
+        UpToDate,   // skipped, outputs match the stamp
+        Failed,
+        NotRun      // a dependency failed or the run was cancelled
+    };
+
+    struct StageGraphCallbacks
+    {
+        OpenMVG_Wrappers::LogCallback log;
+        // may be called from worker threads, for nodes running concurrently
+        std::function<void(const StageNode &node)> nodeStarted;
+        std::function<void(const StageNode &node, StageNodeResult result, double seconds)> nodeFinished;
+    };
+
+    class StageGraph
+    {
+    public:
+        explicit StageGraph(const std::string &stampDir);
+
+        void add(StageNode node);
+
+        // Runs every node once its dependencies are done, up to maxParallel at a time.
+        // Returns false if a required node failed or did not run, the graph has a cycle or cancel became true
+        bool run(const StageGraphCallbacks &callbacks, const std::atomic<bool> &cancel, int maxParallel = 2);
+
+        StageNodeResult result(const std::string &name) const;
+
+        // 64-bit content hash of a path as described above (0 if it does not exist)
+        uint64_t hashPath(const std::string &path);
+
+    private:
+        struct CachedHash
+        {
+            uint64_t size;
+            int64_t mtime;
+            uint64_t hash;
+        };
+
+        bool upToDate(const StageNode &node, uint64_t key);
+        uint64_t nodeKey(const StageNode &node);
+        bool writePending(const StageNode &node, uint64_t key);
+        bool writeStamp(const StageNode &node, uint64_t key);
+        uint64_t hashFile(const std::string &path);
+        void loadHashCache();
+        void saveHashCache();
+
+        std::string stampDir;
+        std::vector<StageNode> nodes;
+        std::vector<StageNodeResult> results;
+
+        std::mutex cacheLock;
+        std::map<std::string, CachedHash> hashCache;
+        bool cacheDirty = false;
+    };
+}
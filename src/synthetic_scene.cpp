@@ -0,0 +1,646 @@
+#include "synthetic_scene.hpp"
+
+#include "openMVG/image/image_container.hpp"
+#include "openMVG/image/image_io.hpp"
+#include "openMVG/image/pixel_types.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <utility>
+
+namespace VoxelForge
+{
+    namespace
+    {
+        using Vec3 = std::array<double, 3>;
+
+        const double kPi = 3.14159265358979323846;
+        const double kCellSize = 10.0;      // m, one building at most per cell
+        const double kMaxBuilding = 24.0;   // m
+        const double kMaxDistance = 600.0;  // m, rays stop here (sky)
+        const double kEarthRadius = 6378137.0;
+
+        Vec3 operator+(const Vec3 &a, const Vec3 &b) { return {a[0] + b[0], a[1] + b[1], a[2] + b[2]}; }
+        Vec3 operator-(const Vec3 &a, const Vec3 &b) { return {a[0] - b[0], a[1] - b[1], a[2] - b[2]}; }
+        Vec3 operator*(double s, const Vec3 &a) { return {s * a[0], s * a[1], s * a[2]}; }
+        double dot(const Vec3 &a, const Vec3 &b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+        Vec3 cross(const Vec3 &a, const Vec3 &b)
+        {
+            return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+        }
+        Vec3 normalized(const Vec3 &a) { return (1.0 / std::sqrt(dot(a, a))) * a; }
+
+        // integer hash -> [0, 1)
+        double hash01(int x, int y, unsigned int seed)
+        {
+            uint32_t h = static_cast<uint32_t>(x) * 374761393u + static_cast<uint32_t>(y) * 668265263u + seed * 2246822519u;
+            h = (h ^ (h >> 13)) * 1274126177u;
+            h ^= h >> 16;
+            return (h & 0xffffff) / double(0x1000000);
+        }
+
+        double valueNoise(double x, double y, unsigned int seed)
+        {
+            const int ix = static_cast<int>(std::floor(x));
+            const int iy = static_cast<int>(std::floor(y));
+            double fx = x - ix, fy = y - iy;
+            fx = fx * fx * (3 - 2 * fx);
+            fy = fy * fy * (3 - 2 * fy);
+            const double a = hash01(ix, iy, seed), b = hash01(ix + 1, iy, seed);
+            const double c = hash01(ix, iy + 1, seed), d = hash01(ix + 1, iy + 1, seed);
+            return (a + (b - a) * fx) + ((c + (d - c) * fx) - (a + (b - a) * fx)) * fy;
+        }
+
+        // multi-octave noise plus sparse dark blobs: plenty of corners/blobs for the describers
+        double texture(double u, double v, unsigned int seed)
+        {
+            double value = 0, amplitude = 0.5, frequency = 1.5;
+            for (int octave = 0; octave < 5; ++octave)
+            {
+                value += amplitude * valueNoise(u * frequency, v * frequency, seed + octave * 101);
+                amplitude *= 0.5;
+                frequency *= 2.1;
+            }
+
+            const double cell = 0.35;
+            const int cx = static_cast<int>(std::floor(u / cell));
+            const int cy = static_cast<int>(std::floor(v / cell));
+            if (hash01(cx, cy, seed ^ 0x5bd1e995u) < 0.3)
+            {
+                const double px = (cx + 0.2 + 0.6 * hash01(cx, cy, seed + 7)) * cell;
+                const double py = (cy + 0.2 + 0.6 * hash01(cx, cy, seed + 13)) * cell;
+                const double r = 0.04 + 0.06 * hash01(cx, cy, seed + 17);
+                if ((u - px) * (u - px) + (v - py) * (v - py) < r * r)
+                    value *= 0.25;
+            }
+            return std::min(1.0, std::max(0.0, value));
+        }
+
+        struct Building
+        {
+            bool present = false;
+            Vec3 min, max;
+            Vec3 tint;
+        };
+
+        int floorMod(int a, int b) { return ((a % b) + b) % b; }
+
+        Building buildingAt(int i, int j, unsigned int seed)
+        {
+            Building b;
+            if (floorMod(i, 4) == 0 || floorMod(j, 4) == 0 || hash01(i, j, seed + 1) < 0.2)
+                return b; // street or empty lot
+
+            const double w = 3.0 + 4.5 * hash01(i, j, seed + 2);
+            const double d = 3.0 + 4.5 * hash01(i, j, seed + 3);
+            const double h = 4.0 + (kMaxBuilding - 4.0) * hash01(i, j, seed + 4);
+            const double x0 = i * kCellSize + (kCellSize - w) * hash01(i, j, seed + 5);
+            const double y0 = j * kCellSize + (kCellSize - d) * hash01(i, j, seed + 6);
+
+            b.present = true;
+            b.min = {x0, y0, 0.0};
+            b.max = {x0 + w, y0 + d, h};
+            const double hue = hash01(i, j, seed + 8);
+            b.tint = {0.75 + 0.25 * hue, 0.7 + 0.3 * (1 - hue), 0.65 + 0.2 * hash01(i, j, seed + 9)};
+            return b;
+        }
+
+        // slab test; returns the entry distance and the hit axis, or false
+        bool intersectBox(const Vec3 &origin, const Vec3 &dir, const Building &b, double &t, int &axis)
+        {
+            double tNear = 0, tFar = 1e30;
+            axis = -1;
+            for (int a = 0; a < 3; ++a)
+            {
+                if (std::abs(dir[a]) < 1e-12)
+                {
+                    if (origin[a] < b.min[a] || origin[a] > b.max[a])
+                        return false;
+                    continue;
+                }
+                double t1 = (b.min[a] - origin[a]) / dir[a];
+                double t2 = (b.max[a] - origin[a]) / dir[a];
+                if (t1 > t2)
+                    std::swap(t1, t2);
+                if (t1 > tNear)
+                {
+                    tNear = t1;
+                    axis = a;
+                }
+                tFar = std::min(tFar, t2);
+                if (tNear > tFar)
+                    return false;
+            }
+            if (axis < 0)
+                return false; // starts inside
+            t = tNear;
+            return true;
+        }
+
+        Vec3 trace(const Vec3 &origin, const Vec3 &dir, unsigned int seed)
+        {
+            const Vec3 sun = normalized({0.4, 0.3, 0.85});
+            const Vec3 sky = {0.55 + 0.2 * std::max(0.0, dir[2]), 0.65 + 0.2 * std::max(0.0, dir[2]), 0.8};
+
+            double limit = kMaxDistance;
+            double tGround = 1e30;
+            if (dir[2] < 0)
+                tGround = -origin[2] / dir[2];
+            limit = std::min(limit, tGround);
+            if (dir[2] > 0)
+                limit = origin[2] >= kMaxBuilding ? 0.0 : std::min(limit, (kMaxBuilding - origin[2]) / dir[2]);
+
+            // 2D DDA over the building cells the ray crosses
+            int ix = static_cast<int>(std::floor(origin[0] / kCellSize));
+            int iy = static_cast<int>(std::floor(origin[1] / kCellSize));
+            const int stepX = dir[0] > 0 ? 1 : -1;
+            const int stepY = dir[1] > 0 ? 1 : -1;
+            double tMaxX = 1e30, tMaxY = 1e30, tDeltaX = 1e30, tDeltaY = 1e30;
+            if (std::abs(dir[0]) > 1e-12)
+            {
+                tMaxX = ((ix + (stepX > 0 ? 1 : 0)) * kCellSize - origin[0]) / dir[0];
+                tDeltaX = kCellSize / std::abs(dir[0]);
+            }
+            if (std::abs(dir[1]) > 1e-12)
+            {
+                tMaxY = ((iy + (stepY > 0 ? 1 : 0)) * kCellSize - origin[1]) / dir[1];
+                tDeltaY = kCellSize / std::abs(dir[1]);
+            }
+
+            double tEnter = 0;
+            while (tEnter < limit)
+            {
+                const Building b = buildingAt(ix, iy, seed);
+                double t;
+                int axis;
+                if (b.present && intersectBox(origin, dir, b, t, axis) && t < limit)
+                {
+                    const Vec3 X = origin + t * dir;
+                    Vec3 normal = {0, 0, 0};
+                    normal[axis] = dir[axis] > 0 ? -1.0 : 1.0;
+
+                    double u, v;
+                    if (axis == 0)
+                        u = X[1], v = X[2];
+                    else if (axis == 1)
+                        u = X[0], v = X[2];
+                    else
+                        u = X[0], v = X[1];
+
+                    const unsigned int surfaceSeed = seed + static_cast<unsigned int>(hash01(ix, iy, seed) * 1e6) + axis * 31;
+                    const double value = texture(u, v, surfaceSeed);
+                    const double shade = 0.45 + 0.55 * std::max(0.0, dot(normal, sun));
+                    const double fog = std::exp(-t / 400.0);
+                    return fog * (value * shade) * b.tint + (1 - fog) * sky;
+                }
+
+                if (tMaxX < tMaxY)
+                {
+                    tEnter = tMaxX;
+                    tMaxX += tDeltaX;
+                    ix += stepX;
+                }
+                else
+                {
+                    tEnter = tMaxY;
+                    tMaxY += tDeltaY;
+                    iy += stepY;
+                }
+            }
+
+            if (tGround < kMaxDistance)
+            {
+                const Vec3 X = origin + tGround * dir;
+                const double value = texture(X[0], X[1], seed + 977);
+                const double shade = 0.45 + 0.55 * sun[2];
+                const double fog = std::exp(-tGround / 400.0);
+                return fog * (value * shade) * Vec3{0.7, 0.72, 0.8} + (1 - fog) * sky;
+            }
+            return sky;
+        }
+
+        // world -> camera rotation rows: right, down, forward
+        std::array<double, 9> lookAt(const Vec3 &forward, const Vec3 &up)
+        {
+            const Vec3 right = normalized(cross(forward, up));
+            const Vec3 down = cross(forward, right);
+            return {right[0], right[1], right[2], down[0], down[1], down[2], forward[0], forward[1], forward[2]};
+        }
+
+        void cameraPose(int i, const SyntheticSceneOptions &o, Vec3 &center, std::array<double, 9> &rotation)
+        {
+            const int n = o.viewCount;
+            switch (o.trajectory)
+            {
+            case SyntheticTrajectory::Orbit:
+            {
+                const bool closed = o.orbitDegrees >= 360.0;
+                const double step = o.orbitDegrees / (closed ? n : std::max(1, n - 1));
+                const double angle = (i * step - (closed ? 0.0 : o.orbitDegrees / 2)) * kPi / 180.0 - kPi / 2;
+                center = {o.orbitRadius * std::cos(angle), o.orbitRadius * std::sin(angle), o.orbitHeight};
+                rotation = lookAt(normalized(Vec3{0, 0, 8} - center), {0, 0, 1});
+                break;
+            }
+            case SyntheticTrajectory::Grid:
+            {
+                const int cols = static_cast<int>(std::ceil(std::sqrt(double(n))));
+                const int rows = (n + cols - 1) / cols;
+                const int row = i / cols;
+                int col = i % cols;
+                const bool backwards = row % 2 == 1; // serpentine flight lines
+                if (backwards)
+                    col = cols - 1 - col;
+                center = {(col - (cols - 1) / 2.0) * o.gridSpacing, (row - (rows - 1) / 2.0) * o.gridSpacing, o.gridAltitude};
+
+                const Vec3 heading = {backwards ? -1.0 : 1.0, 0, 0};
+                const double tilt = o.gridTiltDegrees * kPi / 180.0;
+                const Vec3 forward = normalized(std::cos(tilt) * Vec3{0, 0, -1} + std::sin(tilt) * heading);
+                rotation = lookAt(forward, heading); // top of the image towards the flight direction
+                break;
+            }
+            case SyntheticTrajectory::Walk:
+            {
+                // street x in [0, 10): cells with i % 4 == 0 never hold a building
+                const double y = (i - n / 2.0) * o.walkStep;
+                center = {5.0 + 1.5 * std::sin(i * 0.05), y, 1.7};
+                const double yaw = 15.0 * kPi / 180.0 * std::sin(i * 0.13);
+                rotation = lookAt(normalized(Vec3{std::sin(yaw), std::cos(yaw), -0.05}), {0, 0, 1});
+                break;
+            }
+            }
+        }
+
+        // ---- EXIF (APP1) writer: just the tags the image listing reads ----
+
+        struct TiffEntry
+        {
+            uint16_t tag;
+            uint16_t type; // 1 BYTE, 2 ASCII, 3 SHORT, 4 LONG, 5 RATIONAL
+            uint32_t count;
+            std::vector<uint8_t> data;
+        };
+
+        void put16(std::vector<uint8_t> &out, uint16_t v)
+        {
+            out.push_back(v & 0xff);
+            out.push_back(v >> 8);
+        }
+
+        void put32(std::vector<uint8_t> &out, uint32_t v)
+        {
+            for (int i = 0; i < 4; ++i)
+                out.push_back((v >> (8 * i)) & 0xff);
+        }
+
+        TiffEntry asciiEntry(uint16_t tag, const std::string &text)
+        {
+            TiffEntry e{tag, 2, static_cast<uint32_t>(text.size() + 1), std::vector<uint8_t>(text.begin(), text.end())};
+            e.data.push_back(0);
+            return e;
+        }
+
+        TiffEntry shortEntry(uint16_t tag, uint16_t value)
+        {
+            TiffEntry e{tag, 3, 1, {}};
+            put16(e.data, value);
+            return e;
+        }
+
+        TiffEntry longEntry(uint16_t tag, uint32_t value)
+        {
+            TiffEntry e{tag, 4, 1, {}};
+            put32(e.data, value);
+            return e;
+        }
+
+        TiffEntry byteEntry(uint16_t tag, const std::vector<uint8_t> &values)
+        {
+            return TiffEntry{tag, 1, static_cast<uint32_t>(values.size()), values};
+        }
+
+        TiffEntry rationalEntry(uint16_t tag, const std::vector<double> &values, uint32_t denominator)
+        {
+            TiffEntry e{tag, 5, static_cast<uint32_t>(values.size()), {}};
+            for (double v : values)
+            {
+                put32(e.data, static_cast<uint32_t>(std::llround(std::max(0.0, v) * denominator)));
+                put32(e.data, denominator);
+            }
+            return e;
+        }
+
+        size_t ifdSize(const std::vector<TiffEntry> &ifd)
+        {
+            size_t size = 2 + 12 * ifd.size() + 4;
+            for (const TiffEntry &e : ifd)
+                if (e.data.size() > 4)
+                    size += (e.data.size() + 1) & ~size_t(1);
+            return size;
+        }
+
+        void writeIfd(std::vector<uint8_t> &out, std::vector<TiffEntry> ifd)
+        {
+            std::sort(ifd.begin(), ifd.end(), [](const TiffEntry &a, const TiffEntry &b) { return a.tag < b.tag; });
+
+            const size_t ifdOffset = out.size() - 6; // offsets are relative to the TIFF header (after "Exif\0\0")
+            uint32_t dataOffset = static_cast<uint32_t>(ifdOffset + 2 + 12 * ifd.size() + 4);
+            std::vector<uint8_t> dataArea;
+
+            put16(out, static_cast<uint16_t>(ifd.size()));
+            for (const TiffEntry &e : ifd)
+            {
+                put16(out, e.tag);
+                put16(out, e.type);
+                put32(out, e.count);
+                if (e.data.size() <= 4)
+                {
+                    std::vector<uint8_t> inlineValue = e.data;
+                    inlineValue.resize(4, 0);
+                    out.insert(out.end(), inlineValue.begin(), inlineValue.end());
+                }
+                else
+                {
+                    put32(out, dataOffset + static_cast<uint32_t>(dataArea.size()));
+                    dataArea.insert(dataArea.end(), e.data.begin(), e.data.end());
+                    if (dataArea.size() % 2)
+                        dataArea.push_back(0);
+                }
+            }
+            put32(out, 0); // no next IFD
+            out.insert(out.end(), dataArea.begin(), dataArea.end());
+        }
+
+        std::vector<uint8_t> exifSegment(const SyntheticSceneOptions &o, const SyntheticView &view)
+        {
+            const double focalMm = o.focalPixels * o.sensorWidthMm / std::max(o.width, o.height);
+
+            std::vector<TiffEntry> ifd0 = {
+                asciiEntry(0x010F, SyntheticCameraMake()),
+                asciiEntry(0x0110, SyntheticCameraModel()),
+                shortEntry(0x0112, 1), // orientation
+                longEntry(0x8769, 0),  // Exif IFD pointer, patched below
+            };
+            const std::vector<TiffEntry> exif = {
+                rationalEntry(0x920A, {focalMm}, 1000), // FocalLength
+                longEntry(0xA002, static_cast<uint32_t>(o.width)),
+                longEntry(0xA003, static_cast<uint32_t>(o.height)),
+                shortEntry(0xA405, static_cast<uint16_t>(std::lround(focalMm * 36.0 / o.sensorWidthMm))),
+            };
+            std::vector<TiffEntry> gps;
+            if (o.writeGps)
+            {
+                ifd0.push_back(longEntry(0x8825, 0)); // GPS IFD pointer, patched below
+
+                auto dms = [](double degrees)
+                {
+                    degrees = std::abs(degrees);
+                    const double d = std::floor(degrees);
+                    const double m = std::floor((degrees - d) * 60.0);
+                    return std::vector<double>{d, m, ((degrees - d) * 60.0 - m) * 60.0};
+                };
+                gps = {
+                    byteEntry(0x0000, {2, 3, 0, 0}),
+                    asciiEntry(0x0001, view.gps[0] >= 0 ? "N" : "S"),
+                    rationalEntry(0x0002, dms(view.gps[0]), 10000),
+                    asciiEntry(0x0003, view.gps[1] >= 0 ? "E" : "W"),
+                    rationalEntry(0x0004, dms(view.gps[1]), 10000),
+                    byteEntry(0x0005, {static_cast<uint8_t>(view.gps[2] >= 0 ? 0 : 1)}),
+                    rationalEntry(0x0006, {std::abs(view.gps[2])}, 1000),
+                };
+            }
+
+            // layout: header | IFD0 | Exif IFD | GPS IFD
+            const uint32_t exifOffset = static_cast<uint32_t>(8 + ifdSize(ifd0));
+            const uint32_t gpsOffset = static_cast<uint32_t>(exifOffset + ifdSize(exif));
+            for (TiffEntry &e : ifd0)
+            {
+                if (e.tag == 0x8769)
+                    e = longEntry(0x8769, exifOffset);
+                else if (e.tag == 0x8825)
+                    e = longEntry(0x8825, gpsOffset);
+            }
+
+            std::vector<uint8_t> segment = {'E', 'x', 'i', 'f', 0, 0, 'I', 'I', 42, 0};
+            put32(segment, 8);
+            writeIfd(segment, ifd0);
+            writeIfd(segment, exif);
+            if (!gps.empty())
+                writeIfd(segment, gps);
+            return segment;
+        }
+
+        // Inserts the APP1 segment after SOI (and after the JFIF APP0 if present)
+        bool addExif(const std::string &jpegPath, const std::vector<uint8_t> &exif)
+        {
+            std::ifstream in(jpegPath, std::ios::binary);
+            std::vector<uint8_t> jpeg((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            in.close();
+            if (jpeg.size() < 4 || jpeg[0] != 0xFF || jpeg[1] != 0xD8 || exif.size() + 2 > 0xFFFF)
+                return false;
+
+            size_t insertAt = 2;
+            if (jpeg[2] == 0xFF && jpeg[3] == 0xE0 && jpeg.size() > 6)
+                insertAt += 2 + ((jpeg[4] << 8) | jpeg[5]);
+
+            const uint16_t length = static_cast<uint16_t>(exif.size() + 2);
+            std::vector<uint8_t> app1 = {0xFF, 0xE1, static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length & 0xff)};
+            app1.insert(app1.end(), exif.begin(), exif.end());
+            jpeg.insert(jpeg.begin() + insertAt, app1.begin(), app1.end());
+
+            std::ofstream out(jpegPath, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char *>(jpeg.data()), static_cast<std::streamsize>(jpeg.size()));
+            return static_cast<bool>(out);
+        }
+
+        bool writeGroundTruth(const std::string &path, const SyntheticSceneOptions &o, const std::vector<SyntheticView> &views)
+        {
+            FILE *f = std::fopen(path.c_str(), "w");
+            if (!f)
+                return false;
+
+            std::fprintf(f, "{\n  \"generator\": \"voxelforge synthetic_scene\",\n");
+            std::fprintf(f, "  \"trajectory\": \"%s\",\n  \"seed\": %u,\n", SyntheticTrajectoryName(o.trajectory), o.seed);
+            std::fprintf(f, "  \"convention\": \"world x=east y=north z=up (m); rotation is world->camera row major, camera x=right y=down z=forward\",\n");
+            std::fprintf(f, "  \"intrinsics\": {\"width\": %d, \"height\": %d, \"focal_pixels\": %.9g, \"principal_point\": [%.9g, %.9g], \"sensor_width_mm\": %.9g},\n",
+                         o.width, o.height, o.focalPixels, o.width / 2.0, o.height / 2.0, o.sensorWidthMm);
+            std::fprintf(f, "  \"origin\": {\"latitude\": %.10f, \"longitude\": %.10f, \"altitude\": %.4f},\n",
+                         o.originLatitude, o.originLongitude, o.originAltitude);
+            std::fprintf(f, "  \"views\": [\n");
+            for (size_t i = 0; i < views.size(); ++i)
+            {
+                const SyntheticView &v = views[i];
+                const std::array<double, 9> &R = v.rotation;
+                std::fprintf(f, "    {\"image\": \"%s\", \"center\": [%.9g, %.9g, %.9g], "
+                                "\"rotation\": [%.9g, %.9g, %.9g, %.9g, %.9g, %.9g, %.9g, %.9g, %.9g], "
+                                "\"gps\": [%.10f, %.10f, %.4f]}%s\n",
+                             std::filesystem::path(v.imagePath).filename().string().c_str(),
+                             v.center[0], v.center[1], v.center[2],
+                             R[0], R[1], R[2], R[3], R[4], R[5], R[6], R[7], R[8],
+                             v.gps[0], v.gps[1], v.gps[2], i + 1 < views.size() ? "," : "");
+            }
+            std::fprintf(f, "  ]\n}\n");
+            return std::fclose(f) == 0;
+        }
+    }
+
+    const char *SyntheticTrajectoryName(SyntheticTrajectory trajectory)
+    {
+        switch (trajectory)
+        {
+        case SyntheticTrajectory::Orbit: return "orbit";
+        case SyntheticTrajectory::Grid: return "grid";
+        case SyntheticTrajectory::Walk: return "walk";
+        }
+        return "";
+    }
+
+    bool SyntheticTrajectoryFromName(const std::string &name, SyntheticTrajectory &trajectory)
+    {
+        for (SyntheticTrajectory t : {SyntheticTrajectory::Orbit, SyntheticTrajectory::Grid, SyntheticTrajectory::Walk})
+        {
+            if (name == SyntheticTrajectoryName(t))
+            {
+                trajectory = t;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const char *SyntheticCameraMake() { return "VoxelForge"; }
+    const char *SyntheticCameraModel() { return "SyntheticCam"; }
+
+    bool GenerateSyntheticScene(
+        const std::string &projectDir,
+        const SyntheticSceneOptions &options,
+        std::vector<SyntheticView> *views,
+        OpenMVG_Wrappers::LogCallback logCallback)
+    {
+        auto LOG = [&](const std::string &msg)
+        {
+            if (logCallback)
+                logCallback(msg);
+        };
+
+        auto LOG_ERROR = [&](const std::string &msg)
+        {
+            if (logCallback)
+                logCallback("ERROR: " + msg);
+        };
+
+        if (options.viewCount < 2 || options.width < 16 || options.height < 16 ||
+            options.focalPixels <= 0 || options.sensorWidthMm <= 0)
+        {
+            LOG_ERROR("Invalid synthetic scene options");
+            return false;
+        }
+
+        const std::string imageDir = (std::filesystem::path(projectDir) / "images").string();
+        std::error_code ec;
+        std::filesystem::create_directories(imageDir, ec);
+        if (ec)
+        {
+            LOG_ERROR("Cannot create " + imageDir + ": " + ec.message());
+            return false;
+        }
+
+        // sensor database entry so RunImageListing derives the focal from EXIF like for real photos
+        {
+            const std::string dbPath = (std::filesystem::path(projectDir) / "sensor_width_database.txt").string();
+            std::ofstream db(dbPath, std::ios::trunc);
+            db << SyntheticCameraMake() << ' ' << SyntheticCameraModel() << ';' << options.sensorWidthMm << '\n';
+            if (!db)
+            {
+                LOG_ERROR("Cannot write " + dbPath);
+                return false;
+            }
+        }
+
+        std::vector<SyntheticView> rendered(options.viewCount);
+        const int threadCount = options.numThreads > 0 ? options.numThreads
+                                                       : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        const int logEvery = std::max(1, options.viewCount / 20);
+        std::atomic<int> nextView(0);
+        std::atomic<int> doneViews(0);
+        std::atomic<bool> failed(false);
+
+        auto worker = [&]()
+        {
+            openMVG::image::Image<openMVG::image::RGBColor> image(options.width, options.height);
+            for (int i = nextView++; i < options.viewCount && !failed; i = nextView++)
+            {
+                SyntheticView &view = rendered[i];
+                Vec3 center;
+                cameraPose(i, options, center, view.rotation);
+                view.center = center;
+                view.gps = {options.originLatitude + center[1] / kEarthRadius * 180.0 / kPi,
+                            options.originLongitude + center[0] / (kEarthRadius * std::cos(options.originLatitude * kPi / 180.0)) * 180.0 / kPi,
+                            options.originAltitude + center[2]};
+
+                const std::array<double, 9> &R = view.rotation;
+                const Vec3 right = {R[0], R[1], R[2]}, down = {R[3], R[4], R[5]}, forward = {R[6], R[7], R[8]};
+                const double cx = options.width / 2.0, cy = options.height / 2.0;
+                for (int y = 0; y < options.height; ++y)
+                {
+                    for (int x = 0; x < options.width; ++x)
+                    {
+                        // pixel centers at integer coordinates, principal point at the image center (openMVG pinhole)
+                        const Vec3 dir = normalized(((x - cx) / options.focalPixels) * right +
+                                                    ((y - cy) / options.focalPixels) * down + forward);
+                        const Vec3 color = trace(center, dir, options.seed);
+                        image(y, x) = openMVG::image::RGBColor(
+                            static_cast<unsigned char>(255 * std::min(1.0, color[0])),
+                            static_cast<unsigned char>(255 * std::min(1.0, color[1])),
+                            static_cast<unsigned char>(255 * std::min(1.0, color[2])));
+                    }
+                }
+
+                char name[32];
+                std::snprintf(name, sizeof(name), "synthetic_%06d.jpg", i);
+                view.imagePath = (std::filesystem::path(imageDir) / name).string();
+
+                if (!openMVG::image::WriteImage(view.imagePath.c_str(), image) ||
+                    (options.writeExif && !addExif(view.imagePath, exifSegment(options, view))))
+                {
+                    failed = true;
+                    break;
+                }
+
+                const int done = ++doneViews;
+                if (done % logEvery == 0 || done == options.viewCount)
+                    LOG("Rendered " + std::to_string(done) + "/" + std::to_string(options.viewCount) + " synthetic views");
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < threadCount; ++i)
+            threads.emplace_back(worker);
+        for (std::thread &thread : threads)
+            thread.join();
+
+        if (failed)
+        {
+            LOG_ERROR("Cannot write synthetic images to " + imageDir);
+            return false;
+        }
+
+        const std::string gtPath = (std::filesystem::path(projectDir) / "ground_truth.json").string();
+        if (!writeGroundTruth(gtPath, options, rendered))
+        {
+            LOG_ERROR("Cannot write " + gtPath);
+            return false;
+        }
+
+        LOG("Synthetic " + std::string(SyntheticTrajectoryName(options.trajectory)) + " dataset written to " + projectDir);
+        if (views)
+            *views = std::move(rendered);
+        return true;
+    }
+}
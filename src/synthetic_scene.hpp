@@ -0,0 +1,77 @@
+#pragma once
+
+// Procedural test datasets with known ground truth. The scene is an endless
+// "city": a textured ground plane with box buildings hashed per 10 m cell
+// (every 4th row/column of cells is left free as a street), ray traced on the
+// CPU, so any number of views can be rendered without storing a model.
+//
+// Output layout (a regular Voxel-Forge project):
+//   <projectDir>/images/synthetic_XXXXXX.jpg   EXIF focal (+ GPS if enabled)
+//   <projectDir>/sensor_width_database.txt     entry for the synthetic camera
+//   <projectDir>/ground_truth.json             intrinsics and every camera pose
+
+#include "openmvg_wrappers.hpp"
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace VoxelForge
+{
+    enum class SyntheticTrajectory
+    {
+        Orbit, // ring around the origin looking at it (orbitDegrees < 360 gives an arc)
+        Grid,  // aerial lawnmower grid, area grows with the view count
+        Walk   // street level walk along a street, length grows with the view count
+    };
+
+    struct SyntheticSceneOptions
+    {
+        int viewCount = 24;
+        int width = 1024;
+        int height = 768;
+        double focalPixels = 900.0;
+
+        SyntheticTrajectory trajectory = SyntheticTrajectory::Orbit;
+        double orbitRadius = 60.0;      // m
+        double orbitHeight = 35.0;      // m
+        double orbitDegrees = 360.0;
+        double gridAltitude = 60.0;     // m
+        double gridSpacing = 8.0;       // m between neighbouring shots
+        double gridTiltDegrees = 20.0;  // forward tilt from nadir
+        double walkStep = 1.5;          // m between shots
+
+        // camera metadata
+        bool writeExif = true;
+        double sensorWidthMm = 36.0;    // focal in mm = focalPixels * sensorWidthMm / max(width, height)
+        bool writeGps = false;
+        double originLatitude = 48.8584; // world origin, x = east, y = north, z = up
+        double originLongitude = 2.2945;
+        double originAltitude = 35.0;
+
+        unsigned int seed = 42;         // texture / building seed
+        int numThreads = 0;             // 0 = all cores
+    };
+
+    struct SyntheticView
+    {
+        std::string imagePath;
+        std::array<double, 9> rotation; // world -> camera, row major (openMVG convention)
+        std::array<double, 3> center;   // camera center in world coordinates (ENU, m)
+        std::array<double, 3> gps;      // latitude, longitude, altitude
+    };
+
+    const char *SyntheticTrajectoryName(SyntheticTrajectory trajectory);
+    bool SyntheticTrajectoryFromName(const std::string &name, SyntheticTrajectory &trajectory);
+
+    // Model string written to EXIF and to the sensor database of the dataset
+    const char *SyntheticCameraMake();
+    const char *SyntheticCameraModel();
+
+    // Renders the dataset into projectDir (see layout above)
+    bool GenerateSyntheticScene(
+        const std::string &projectDir,
+        const SyntheticSceneOptions &options,
+        std::vector<SyntheticView> *views = nullptr,
+        OpenMVG_Wrappers::LogCallback logCallback = nullptr);
+}
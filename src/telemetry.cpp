@@ -0,0 +1,364 @@
+#include "telemetry.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace VoxelForge
+{
+    namespace
+    {
+        std::atomic<TelemetrySession *> activeSession(nullptr);
+        thread_local int scopeDepth = 0;
+        std::atomic<int> openStageScopes(0); // outermost scopes open on any thread
+
+        std::string utcNow()
+        {
+            const std::time_t now = std::time(nullptr);
+            std::tm tm{};
+#ifdef _WIN32
+            gmtime_s(&tm, &now);
+#else
+            gmtime_r(&now, &tm);
+#endif
+            char text[32];
+            std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", &tm);
+            return text;
+        }
+
+        std::string jsonString(const std::string &value)
+        {
+            std::string out = "\"";
+            for (const char c : value)
+            {
+                switch (c)
+                {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                        out += escaped;
+                    }
+                    else
+                        out += c;
+                }
+            }
+            return out + "\"";
+        }
+
+        std::string jsonNumber(double value)
+        {
+            char text[32];
+            std::snprintf(text, sizeof(text), "%.6g", value);
+            return text;
+        }
+
+#ifdef __linux__
+        // "key: value" lines of /proc/self/{io,status}
+        bool procValue(const char *file, const std::string &key, uint64_t &value)
+        {
+            std::ifstream in(file);
+            std::string line;
+            while (std::getline(in, line))
+            {
+                if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() && line[key.size()] == ':')
+                {
+                    value = std::strtoull(line.c_str() + key.size() + 1, nullptr, 10);
+                    return true;
+                }
+            }
+            return false;
+        }
+#endif
+    }
+
+    ProcessCounters ProcessCounters::sample()
+    {
+        ProcessCounters c;
+#ifdef _WIN32
+        FILETIME created, exited, kernel, user;
+        if (GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user))
+        {
+            auto seconds = [](const FILETIME &t)
+            { return ((static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 1e-7; };
+            c.cpuSeconds = seconds(kernel) + seconds(user);
+        }
+        PROCESS_MEMORY_COUNTERS memory;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory)))
+            c.peakRssBytes = memory.PeakWorkingSetSize;
+        IO_COUNTERS io;
+        if (GetProcessIoCounters(GetCurrentProcess(), &io))
+        {
+            c.bytesRead = c.diskBytesRead = io.ReadTransferCount;
+            c.bytesWritten = c.diskBytesWritten = io.WriteTransferCount;
+        }
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+        {
+            c.cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 +
+                           usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+#ifdef __APPLE__
+            c.peakRssBytes = static_cast<uint64_t>(usage.ru_maxrss); // bytes on macOS
+#else
+            c.peakRssBytes = static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+        }
+#ifdef __linux__
+        uint64_t hwmKb = 0;
+        if (procValue("/proc/self/status", "VmHWM", hwmKb)) // resettable, unlike ru_maxrss
+            c.peakRssBytes = hwmKb * 1024;
+        procValue("/proc/self/io", "rchar", c.bytesRead);
+        procValue("/proc/self/io", "wchar", c.bytesWritten);
+        procValue("/proc/self/io", "read_bytes", c.diskBytesRead);
+        procValue("/proc/self/io", "write_bytes", c.diskBytesWritten);
+#endif
+#endif
+        return c;
+    }
+
+    bool ProcessCounters::resetPeakRss()
+    {
+#ifdef __linux__
+        std::ofstream clearRefs("/proc/self/clear_refs");
+        clearRefs << "5";
+        clearRefs.flush();
+        return static_cast<bool>(clearRefs);
+#else
+        return false;
+#endif
+    }
+
+    // ---- TelemetrySession ----
+
+    TelemetrySession::TelemetrySession()
+        : start(std::chrono::steady_clock::now()), startedUtc(utcNow())
+    {
+    }
+
+    TelemetrySession::~TelemetrySession()
+    {
+        uninstall();
+    }
+
+    void TelemetrySession::install()
+    {
+        activeSession = this;
+    }
+
+    void TelemetrySession::uninstall()
+    {
+        TelemetrySession *self = this;
+        activeSession.compare_exchange_strong(self, nullptr);
+    }
+
+    TelemetrySession *TelemetrySession::current()
+    {
+        return activeSession.load();
+    }
+
+    void TelemetrySession::setInfo(const std::string &key, const std::string &value)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (auto &entry : info)
+        {
+            if (entry.first == key)
+            {
+                entry.second = value;
+                return;
+            }
+        }
+        info.emplace_back(key, value);
+    }
+
+    void TelemetrySession::add(TelemetryRecord record)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        recs.push_back(std::move(record));
+    }
+
+    std::vector<TelemetryRecord> TelemetrySession::records() const
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        return recs;
+    }
+
+    double TelemetrySession::elapsedSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool TelemetrySession::writeReport(const std::string &path, bool success) const
+    {
+        std::vector<TelemetryRecord> sorted = records();
+        // scopes are added when they close; report them in start order
+        std::stable_sort(sorted.begin(), sorted.end(), [](const TelemetryRecord &a, const TelemetryRecord &b)
+                         { return a.startSeconds < b.startSeconds; });
+
+        std::ostringstream out;
+        out << "{\n  \"started\": " << jsonString(startedUtc) << ",\n";
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for (const auto &entry : info)
+                out << "  " << jsonString(entry.first) << ": " << jsonString(entry.second) << ",\n";
+        }
+        out << "  \"success\": " << (success ? "true" : "false") << ",\n";
+        out << "  \"wall_seconds\": " << jsonNumber(elapsedSeconds()) << ",\n";
+        uint64_t peakRss = ProcessCounters::sample().peakRssBytes; // since the last reset on Linux
+        for (const TelemetryRecord &r : sorted)
+            peakRss = std::max(peakRss, r.peakRssBytes);
+        out << "  \"peak_rss_bytes\": " << peakRss << ",\n";
+        out << "  \"stages\": [";
+
+        for (size_t i = 0; i < sorted.size(); ++i)
+        {
+            const TelemetryRecord &r = sorted[i];
+            out << (i ? ",\n" : "\n") << "    {\"name\": " << jsonString(r.name)
+                << ", \"depth\": " << r.depth
+                << ", \"success\": " << (r.success ? "true" : "false")
+                << ", \"start_seconds\": " << jsonNumber(r.startSeconds)
+                << ", \"wall_seconds\": " << jsonNumber(r.wallSeconds)
+                << ", \"cpu_seconds\": " << jsonNumber(r.cpuSeconds)
+                << ", \"cpu_utilization\": " << jsonNumber(r.wallSeconds > 0 ? r.cpuSeconds / r.wallSeconds : 0.0)
+                << ", \"peak_rss_bytes\": " << r.peakRssBytes
+                << ", \"peak_rss_scope\": " << (r.peakRssIsLocal ? "\"stage\"" : "\"process\"")
+                << ", \"bytes_read\": " << r.bytesRead
+                << ", \"bytes_written\": " << r.bytesWritten
+                << ", \"disk_bytes_read\": " << r.diskBytesRead
+                << ", \"disk_bytes_written\": " << r.diskBytesWritten
+                << ",\n     \"counters\": {";
+            for (size_t c = 0; c < r.counters.size(); ++c)
+                out << (c ? ", " : "") << jsonString(r.counters[c].first) << ": " << jsonNumber(r.counters[c].second);
+            out << "}, \"throughput_per_second\": {";
+            for (size_t c = 0; c < r.counters.size(); ++c)
+                out << (c ? ", " : "") << jsonString(r.counters[c].first) << ": "
+                    << jsonNumber(r.wallSeconds > 0 ? r.counters[c].second / r.wallSeconds : 0.0);
+            out << "}}";
+        }
+        out << "\n  ]\n}\n";
+
+        std::ofstream file(path, std::ios::trunc);
+        file << out.str();
+        return static_cast<bool>(file);
+    }
+
+    bool TelemetrySession::writeChromeTrace(const std::string &path) const
+    {
+        const std::vector<TelemetryRecord> all = records();
+
+        // Trace Event Format: complete events ("X") in microseconds, one row per thread
+        std::ostringstream out;
+        out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+        out << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"voxelforge\"}}";
+        for (const TelemetryRecord &r : all)
+        {
+            out << ",\n  {\"name\": " << jsonString(r.name) << ", \"cat\": " << (r.depth ? "\"step\"" : "\"stage\"")
+                << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << (r.threadId % 100000)
+                << ", \"ts\": " << static_cast<uint64_t>(r.startSeconds * 1e6)
+                << ", \"dur\": " << static_cast<uint64_t>(r.wallSeconds * 1e6)
+                << ", \"args\": {\"cpu_seconds\": " << jsonNumber(r.cpuSeconds)
+                << ", \"peak_rss_mb\": " << jsonNumber(r.peakRssBytes / 1048576.0)
+                << ", \"read_mb\": " << jsonNumber(r.bytesRead / 1048576.0)
+                << ", \"written_mb\": " << jsonNumber(r.bytesWritten / 1048576.0);
+            for (const auto &counter : r.counters)
+                out << ", " << jsonString(counter.first) << ": " << jsonNumber(counter.second);
+            out << "}}";
+
+            // memory track, sampled at the scope boundaries
+            if (r.depth == 0)
+                out << ",\n  {\"name\": \"peak RSS (MB)\", \"ph\": \"C\", \"pid\": 1, \"ts\": "
+                    << static_cast<uint64_t>((r.startSeconds + r.wallSeconds) * 1e6)
+                    << ", \"args\": {\"rss\": " << jsonNumber(r.peakRssBytes / 1048576.0) << "}}";
+        }
+        out << "\n]}\n";
+
+        std::ofstream file(path, std::ios::trunc);
+        file << out.str();
+        return static_cast<bool>(file);
+    }
+
+    // ---- TelemetryScope ----
+
+    TelemetryScope::TelemetryScope(const std::string &name)
+        : session(TelemetrySession::current()), ok(false)
+    {
+        rec.name = name;
+        rec.depth = scopeDepth++;
+        rec.threadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+        if (session)
+        {
+            // only an outermost scope with no other one open resets the high-water mark,
+            // nested or overlapping scopes would hide the peak of the running one
+            if (rec.depth == 0 && openStageScopes++ == 0)
+                rec.peakRssIsLocal = ProcessCounters::resetPeakRss();
+            before = ProcessCounters::sample();
+        }
+        begin = std::chrono::steady_clock::now();
+    }
+
+    TelemetryScope::~TelemetryScope()
+    {
+        const auto end = std::chrono::steady_clock::now();
+        --scopeDepth;
+        if (!session)
+            return;
+        if (rec.depth == 0)
+            --openStageScopes;
+
+        const ProcessCounters after = ProcessCounters::sample();
+        rec.success = ok;
+        rec.startSeconds = std::chrono::duration<double>(begin - session->start).count();
+        rec.wallSeconds = std::chrono::duration<double>(end - begin).count();
+        rec.cpuSeconds = after.cpuSeconds - before.cpuSeconds;
+        rec.peakRssBytes = after.peakRssBytes;
+        rec.bytesRead = after.bytesRead - before.bytesRead;
+        rec.bytesWritten = after.bytesWritten - before.bytesWritten;
+        rec.diskBytesRead = after.diskBytesRead - before.diskBytesRead;
+        rec.diskBytesWritten = after.diskBytesWritten - before.diskBytesWritten;
+        session->add(std::move(rec));
+    }
+
+    void TelemetryScope::count(const std::string &key, double value)
+    {
+        for (auto &counter : rec.counters)
+        {
+            if (counter.first == key)
+            {
+                counter.second = value;
+                return;
+            }
+        }
+        rec.counters.emplace_back(key, value);
+    }
+
+    void TelemetryScope::add(const std::string &key, double value)
+    {
+        for (auto &counter : rec.counters)
+        {
+            if (counter.first == key)
+            {
+                counter.second += value;
+                return;
+            }
+        }
+        rec.counters.emplace_back(key, value);
+    }
+}
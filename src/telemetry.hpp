@@ -0,0 +1,114 @@
+#pragma once
+
+// Per-stage metrics of a pipeline run: wall / CPU time, peak RSS, bytes read
+// and written, item counters (views, features, pairs, ...) and throughput.
+//
+// A TelemetrySession collects scopes for the whole run (Pipeline::run owns
+// one) and writes output/run_report.json plus a Chrome trace file
+// (chrome://tracing or https://ui.perfetto.dev). The Run* wrappers open a
+// TelemetryScope; without an active session a scope only does the clock reads.
+//
+// CPU time and I/O are process wide, so they describe a scope correctly as
+// long as stages do not overlap (the report exports of the stage graph do,
+// but they are small).
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace VoxelForge
+{
+    // Snapshot of the process counters (all zero where the platform lacks them)
+    struct ProcessCounters
+    {
+        double cpuSeconds = 0.0;       // user + system
+        uint64_t peakRssBytes = 0;     // high-water mark (per scope on Linux, see resetPeakRss)
+        uint64_t bytesRead = 0;        // read()/pread() volume, page cache included
+        uint64_t bytesWritten = 0;
+        uint64_t diskBytesRead = 0;    // what actually hit the storage
+        uint64_t diskBytesWritten = 0;
+
+        static ProcessCounters sample();
+
+        // Linux: resets VmHWM so the next peak is local to the scope. Returns false if unsupported
+        static bool resetPeakRss();
+    };
+
+    struct TelemetryRecord
+    {
+        std::string name;
+        int depth = 0;                 // nesting level (stage = 0)
+        uint64_t threadId = 0;
+        double startSeconds = 0.0;     // since the session start
+        double wallSeconds = 0.0;
+        double cpuSeconds = 0.0;
+        uint64_t peakRssBytes = 0;
+        bool peakRssIsLocal = false;   // false: process peak so far
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t diskBytesRead = 0;
+        uint64_t diskBytesWritten = 0;
+        bool success = true;
+        std::vector<std::pair<std::string, double>> counters; // in insertion order
+    };
+
+    class TelemetrySession
+    {
+    public:
+        TelemetrySession();
+        ~TelemetrySession(); // uninstalls itself if still current
+
+        // Scopes opened from now on (any thread) report to this session
+        void install();
+        void uninstall();
+        static TelemetrySession *current();
+
+        // Free-form run information written at the top of the report
+        void setInfo(const std::string &key, const std::string &value);
+
+        void add(TelemetryRecord record);
+        std::vector<TelemetryRecord> records() const;
+        double elapsedSeconds() const;
+
+        bool writeReport(const std::string &path, bool success) const;
+        bool writeChromeTrace(const std::string &path) const;
+
+    private:
+        friend class TelemetryScope;
+
+        const std::chrono::steady_clock::time_point start;
+        const std::string startedUtc;
+        mutable std::mutex lock;
+        std::vector<TelemetryRecord> recs;
+        std::vector<std::pair<std::string, std::string>> info;
+    };
+
+    // RAII measurement of one stage (or a part of it when nested)
+    class TelemetryScope
+    {
+    public:
+        explicit TelemetryScope(const std::string &name);
+        ~TelemetryScope();
+
+        TelemetryScope(const TelemetryScope &) = delete;
+        TelemetryScope &operator=(const TelemetryScope &) = delete;
+
+        // Sets (or, with add, accumulates) an item counter; throughput is derived in the report
+        void count(const std::string &key, double value);
+        void add(const std::string &key, double value);
+
+        // Scopes are recorded as failed unless succeed() is called before they close
+        // (wrappers call it right before their final `return true`)
+        void succeed() { ok = true; }
+
+    private:
+        TelemetrySession *session;
+        TelemetryRecord rec;
+        std::chrono::steady_clock::time_point begin;
+        ProcessCounters before;
+        bool ok;
+    };
+}
@@ -0,0 +1,225 @@
+#include "thread_budget.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#include <dirent.h>
+#endif
+
+#ifdef OPENMVG_USE_OPENMP
+#include <omp.h>
+#endif
+
+namespace VoxelForge
+{
+    namespace
+    {
+        std::mutex budgetLock;
+        int budgetLimit = 0; // 0 = not configured yet, available()
+        int budgetInUse = 0;
+
+        int configuredLimit()
+        {
+            return budgetLimit > 0 ? budgetLimit : ThreadBudget::available();
+        }
+
+#ifdef __linux__
+        // "0-7,16-23" as in /sys/devices/system/node/node*/cpulist
+        std::vector<int> parseCpuList(const std::string &list)
+        {
+            std::vector<int> cpus;
+            std::stringstream in(list);
+            std::string range;
+            while (std::getline(in, range, ','))
+            {
+                if (range.empty())
+                    continue;
+                const size_t dash = range.find('-');
+                const int first = std::atoi(range.c_str());
+                const int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+                for (int cpu = first; cpu <= last; ++cpu)
+                    cpus.push_back(cpu);
+            }
+            return cpus;
+        }
+
+        // CPUs of each NUMA node, restricted to the current affinity mask (empty nodes dropped)
+        std::vector<std::vector<int>> numaNodes(const cpu_set_t &allowed)
+        {
+            std::vector<std::pair<int, std::vector<int>>> nodes;
+            if (DIR *dir = opendir("/sys/devices/system/node"))
+            {
+                while (dirent *entry = readdir(dir))
+                {
+                    const std::string name = entry->d_name;
+                    if (name.compare(0, 4, "node") != 0 || name.size() == 4 || !std::isdigit(static_cast<unsigned char>(name[4])))
+                        continue;
+                    std::ifstream file("/sys/devices/system/node/" + name + "/cpulist");
+                    std::string list;
+                    std::getline(file, list);
+                    std::vector<int> cpus;
+                    for (const int cpu : parseCpuList(list))
+                    {
+                        if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))
+                            cpus.push_back(cpu);
+                    }
+                    if (!cpus.empty())
+                        nodes.emplace_back(std::atoi(name.c_str() + 4), std::move(cpus));
+                }
+                closedir(dir);
+            }
+            std::sort(nodes.begin(), nodes.end(), [](const auto &a, const auto &b)
+                      { return a.first < b.first; });
+
+            std::vector<std::vector<int>> result;
+            for (auto &node : nodes)
+                result.push_back(std::move(node.second));
+            return result;
+        }
+
+        bool pinToNumaNodes(int threads, std::string &summary)
+        {
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+            {
+                summary = "cannot read the CPU affinity";
+                return false;
+            }
+
+            const std::vector<std::vector<int>> nodes = numaNodes(allowed);
+            if (nodes.size() < 2)
+            {
+                summary = "single NUMA node, not pinned";
+                return true; // nothing to gain, not an error
+            }
+
+            // fewest nodes whose cores cover the budget, starting with node 0
+            cpu_set_t pinned;
+            CPU_ZERO(&pinned);
+            int cores = 0;
+            size_t used = 0;
+            while (used < nodes.size() && cores < threads)
+            {
+                for (const int cpu : nodes[used])
+                    CPU_SET(cpu, &pinned);
+                cores += static_cast<int>(nodes[used].size());
+                ++used;
+            }
+
+            // the calling thread; threads created afterwards inherit it
+            if (sched_setaffinity(0, sizeof(pinned), &pinned) != 0)
+            {
+                summary = "cannot set the CPU affinity";
+                return false;
+            }
+
+            // effective only if the OpenMP runtime did not start yet
+            setenv("OMP_PROC_BIND", "close", 0);
+            setenv("OMP_PLACES", "cores", 0);
+
+            summary = "pinned to " + std::to_string(used) + " of " + std::to_string(nodes.size()) + " NUMA nodes";
+            return true;
+        }
+#endif
+    }
+
+    bool ThreadBudget::configure(const ThreadBudgetOptions &options, std::string *message)
+    {
+        bool ok = true;
+        std::string pinning;
+        if (options.pinNumaNodes)
+        {
+#ifdef __linux__
+            ok = pinToNumaNodes(options.maxThreads > 0 ? options.maxThreads : available(), pinning);
+#else
+            ok = false;
+            pinning = "NUMA pinning is only supported on Linux";
+#endif
+        }
+
+        // after pinning: available() may have shrunk
+        const int cores = available();
+        const int threads = options.maxThreads > 0 ? std::min(options.maxThreads, cores) : cores;
+        {
+            std::lock_guard<std::mutex> guard(budgetLock);
+            budgetLimit = threads;
+        }
+
+        if (message)
+        {
+            *message = std::to_string(threads) + " of " + std::to_string(cores) + " cores";
+            if (!pinning.empty())
+                *message += ", " + pinning;
+        }
+        return ok;
+    }
+
+    int ThreadBudget::available()
+    {
+#ifdef __linux__
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+            return std::max(1, CPU_COUNT(&allowed));
+#endif
+        return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    int ThreadBudget::limit()
+    {
+        std::lock_guard<std::mutex> guard(budgetLock);
+        return configuredLimit();
+    }
+
+    int ThreadBudget::inUse()
+    {
+        std::lock_guard<std::mutex> guard(budgetLock);
+        return budgetInUse;
+    }
+
+    int ThreadBudget::share(int divisor)
+    {
+        return std::max(1, limit() / std::max(1, divisor));
+    }
+
+    ThreadLease::ThreadLease(int wanted)
+    {
+        std::lock_guard<std::mutex> guard(budgetLock);
+        const int left = std::max(1, configuredLimit() - budgetInUse);
+        granted = wanted > 0 ? std::min(wanted, left) : left;
+        budgetInUse += granted;
+    }
+
+    ThreadLease::~ThreadLease()
+    {
+        std::lock_guard<std::mutex> guard(budgetLock);
+        budgetInUse -= granted;
+    }
+
+    void ThreadLease::applyToCurrentThread() const
+    {
+#ifdef OPENMVG_USE_OPENMP
+        omp_set_num_threads(granted);
+#endif
+    }
+
+    int StageThreads(int iNumThreads)
+    {
+        if (iNumThreads > 0)
+            return iNumThreads;
+#ifdef OPENMVG_USE_OPENMP
+        return omp_get_max_threads();
+#else
+        return ThreadBudget::limit();
+#endif
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// Process-wide CPU budget. Pipeline steps, OpenMP regions and the GUI pools
+// take their threads from one limit (default: every core the process may
+// run on), so a stage overlapping a report export or the thumbnail loader
+// does not oversubscribe the machine, and users can cap the CPU use of a run.
+//
+// A step reserves threads with a ThreadLease. Leases never block: when the
+// budget is exhausted a lease still gets one thread, the step just runs
+// narrower. OpenMP thread counts are per calling thread, so the step calls
+// applyToCurrentThread() on the thread that enters the parallel regions.
+
+#include <string>
+
+namespace VoxelForge
+{
+    struct ThreadBudgetOptions
+    {
+        int maxThreads = 0;         // 0 = all cores of the process affinity mask
+        // Linux: restrict the process to the fewest NUMA nodes covering maxThreads and
+        // bind OpenMP threads to cores (OMP_PROC_BIND / OMP_PLACES unless already set)
+        bool pinNumaNodes = false;
+    };
+
+    class ThreadBudget
+    {
+    public:
+        // Call it at startup before the first worker thread: pinning is inherited, not
+        // applied to running threads. The limit can be changed later. message gets a
+        // one-line summary ("8 of 32 cores, NUMA node 0") or why pinning failed
+        static bool configure(const ThreadBudgetOptions &options, std::string *message = nullptr);
+
+        static int available();     // cores the process may run on
+        static int limit();         // configured budget, 1..available()
+        static int inUse();         // threads held by leases
+
+        // Thread count of a background pool getting 1/divisor of the budget (at least 1)
+        static int share(int divisor);
+    };
+
+    class ThreadLease
+    {
+    public:
+        // wanted <= 0: everything left in the budget
+        explicit ThreadLease(int wanted = 0);
+        ~ThreadLease();
+
+        ThreadLease(const ThreadLease &) = delete;
+        ThreadLease &operator=(const ThreadLease &) = delete;
+
+        int count() const { return granted; }
+
+        // omp_set_num_threads(count()) for the calling thread (no-op without OpenMP)
+        void applyToCurrentThread() const;
+
+    private:
+        int granted;
+    };
+
+    // Threads of a pipeline step called with iNumThreads (the Run* wrappers): iNumThreads when
+    // positive, else the OpenMP thread count of the calling thread, which the pipeline sets from
+    // the stage's lease (the budget limit without OpenMP)
+    int StageThreads(int iNumThreads);
+}
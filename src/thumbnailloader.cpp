@@ -0,0 +1,116 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// Background thumbnail service for the image manager
+
+#include "thumbnailloader.h"
+#include "thread_budget.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QThread>
+
+// One decode job. Holds the generation it was queued in, so jobs queued before
+// a cancelAll() are skipped without touching the disk.
+class ThumbnailTask : public QRunnable
+{
+public:
+    ThumbnailTask(ThumbnailLoader *loader, const QString &imagePath, int generation)
+        : loader(loader), imagePath(imagePath), generation(generation) {}
+
+    void run() override
+    {
+        if (loader->generation != generation)
+            return;
+        // held while decoding, so a stage starting meanwhile leaves this thread out
+        const VoxelForge::ThreadLease lease(1);
+
+        QFileInfo fi(imagePath);
+        const QSize target = loader->size;
+
+        // cache key: absolute path + mtime + requested size
+        QByteArray key = fi.absoluteFilePath().toUtf8();
+        key += '|' + QByteArray::number(fi.lastModified().toMSecsSinceEpoch());
+        key += '|' + QByteArray::number(target.width()) + 'x' + QByteArray::number(target.height());
+        const QString cachePath = ThumbnailLoader::cacheDirectory() + "/" +
+                                  QCryptographicHash::hash(key, QCryptographicHash::Sha1).toHex() + ".jpg";
+
+        QImage thumbnail;
+        if (QFile::exists(cachePath))
+            thumbnail.load(cachePath);
+
+        if (thumbnail.isNull())
+        {
+            // Let the codec decode straight to thumbnail size (JPEG uses DCT scaling),
+            // instead of decoding full resolution and scaling afterwards
+            QImageReader reader(imagePath);
+            reader.setAutoTransform(true);
+            const QSize fullSize = reader.size();
+            if (fullSize.isValid())
+                reader.setScaledSize(fullSize.scaled(target, Qt::KeepAspectRatio));
+            thumbnail = reader.read();
+
+            if (!thumbnail.isNull())
+            {
+                if (thumbnail.width() > target.width() || thumbnail.height() > target.height())
+                    thumbnail = thumbnail.scaled(target, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+                // write to a temp file first so a half-written thumbnail is never picked up
+                const QString tmpPath = cachePath + ".tmp";
+                if (thumbnail.save(tmpPath, "JPG", 85))
+                {
+                    QFile::remove(cachePath);
+                    QFile::rename(tmpPath, cachePath);
+                }
+            }
+        }
+
+        if (loader->generation != generation)
+            return;
+
+        emit loader->thumbnailReady(imagePath, thumbnail);
+    }
+
+private:
+    ThumbnailLoader *loader;
+    QString imagePath;
+    int generation;
+};
+
+ThumbnailLoader::ThumbnailLoader(const QSize &thumbnailSize, QObject *parent)
+    : QObject(parent), size(thumbnailSize), generation(0)
+{
+    // leave some cores for the GUI and the pipeline
+    setThreadCount(VoxelForge::ThreadBudget::share(2));
+    QDir().mkpath(cacheDirectory());
+}
+
+ThumbnailLoader::~ThumbnailLoader()
+{
+    cancelAll();
+    pool.waitForDone();
+}
+
+void ThumbnailLoader::request(const QString &imagePath, int priority)
+{
+    ThumbnailTask *task = new ThumbnailTask(this, imagePath, generation);
+    task->setAutoDelete(true);
+    pool.start(task, priority);
+}
+
+void ThumbnailLoader::cancelAll()
+{
+    ++generation;
+    pool.clear();
+}
+
+QString ThumbnailLoader::cacheDirectory()
+{
+    static const QString dir =
+        QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/Voxel-Forge/thumbnails";
+    return dir;
+}
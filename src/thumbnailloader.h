@@ -0,0 +1,52 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// Background thumbnail service for the image manager
+
+#ifndef THUMBNAILLOADER_H
+#define THUMBNAILLOADER_H
+
+#include <QObject>
+#include <QImage>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+
+// Decodes thumbnails on a worker pool and keeps them in an on-disk cache
+// keyed by image path + modification time, so re-opening a project only
+// pays the (reduced size) decode cost once per image.
+class ThumbnailLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ThumbnailLoader(const QSize &thumbnailSize, QObject *parent = nullptr);
+    ~ThumbnailLoader() override;
+
+    // Queue a thumbnail for decoding; higher priority requests are started first.
+    // thumbnailReady is emitted from a worker thread, so receivers in the GUI
+    // thread get it as a queued call.
+    void request(const QString &imagePath, int priority = 0);
+
+    // Drop every request that has not started yet (e.g. list cleared or folder changed)
+    void cancelAll();
+
+    QSize thumbnailSize() const { return size; }
+
+    // Decoding threads (half the ThreadBudget by default)
+    void setThreadCount(int count) { pool.setMaxThreadCount(qMax(1, count)); }
+
+    static QString cacheDirectory();
+
+signals:
+    // thumbnail is null when the image could not be decoded
+    void thumbnailReady(const QString &imagePath, const QImage &thumbnail);
+
+private:
+    friend class ThumbnailTask;
+
+    QThreadPool pool;
+    QSize size;
+    std::atomic<int> generation;
+};
+
+#endif // THUMBNAILLOADER_H
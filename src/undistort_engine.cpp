@@ -0,0 +1,331 @@
+#include "undistort_engine.hpp"
+#include "content_hash.hpp"
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace OpenMVG_Wrappers
+{
+    namespace
+    {
+        // Blocking queue with a capacity: producers wait while it is full, so a fast reader
+        // cannot load every image before the workers catch up
+        template <typename T>
+        class BoundedQueue
+        {
+        public:
+            explicit BoundedQueue(size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+            // false once closed
+            bool push(T item)
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                notFull.wait(guard, [&]
+                             { return closed || items.size() < capacity; });
+                if (closed)
+                    return false;
+                items.push_back(std::move(item));
+                notEmpty.notify_one();
+                return true;
+            }
+
+            // false when closed and drained
+            bool pop(T &item)
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                notEmpty.wait(guard, [&]
+                              { return closed || !items.empty(); });
+                if (items.empty())
+                    return false;
+                item = std::move(items.front());
+                items.pop_front();
+                notFull.notify_one();
+                return true;
+            }
+
+            void close()
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                closed = true;
+                notEmpty.notify_all();
+                notFull.notify_all();
+            }
+
+        private:
+            const size_t capacity;
+            std::deque<T> items;
+            std::mutex lock;
+            std::condition_variable notEmpty, notFull;
+            bool closed = false;
+        };
+
+        // fixed-point maps (CV_16SC2 integer source pixel + CV_16UC1 interpolation weights index):
+        // 6 bytes per pixel and the vectorized bilinear path of cv::remap
+        struct RemapTable
+        {
+            cv::Mat map1, map2;
+        };
+
+        std::shared_ptr<const RemapTable> buildRemapTable(const openMVG::cameras::IntrinsicBase *cam)
+        {
+            const int width = static_cast<int>(cam->w()), height = static_cast<int>(cam->h());
+            cv::Mat mapX(height, width, CV_32FC1), mapY(height, width, CV_32FC1);
+            // same sampling as openMVG's UndistortImage: output pixel -> distorted source pixel
+            cv::parallel_for_(cv::Range(0, height), [&](const cv::Range &rows)
+                              {
+                for (int y = rows.start; y < rows.end; ++y)
+                {
+                    float *rowX = mapX.ptr<float>(y), *rowY = mapY.ptr<float>(y);
+                    for (int x = 0; x < width; ++x)
+                    {
+                        const openMVG::Vec2 source = cam->get_d_pixel(openMVG::Vec2(x, y));
+                        rowX[x] = static_cast<float>(source(0));
+                        rowY[x] = static_cast<float>(source(1));
+                    }
+                } });
+
+            auto table = std::make_shared<RemapTable>();
+            cv::convertMaps(mapX, mapY, table->map1, table->map2, CV_16SC2);
+            return table;
+        }
+
+        bool isJpeg(const std::string &path)
+        {
+            const size_t dot = path.find_last_of('.');
+            if (dot == std::string::npos)
+                return false;
+            std::string extension = path.substr(dot + 1);
+            std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+                           { return static_cast<char>(std::tolower(c)); });
+            return extension == "jpg" || extension == "jpeg";
+        }
+
+        bool readFile(const std::string &path, std::vector<uchar> &bytes)
+        {
+            std::ifstream in(path, std::ios::binary | std::ios::ate);
+            if (!in)
+                return false;
+            bytes.resize(static_cast<size_t>(in.tellg()));
+            in.seekg(0);
+            return static_cast<bool>(in.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::streamsize>(bytes.size())));
+        }
+
+        bool writeFile(const std::string &path, const std::vector<uchar> &bytes)
+        {
+            const std::string temporary = path + ".tmp";
+            {
+                std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+                out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+                if (!out)
+                    return false;
+            }
+            return std::rename(temporary.c_str(), path.c_str()) == 0;
+        }
+
+        struct LoadedImage
+        {
+            size_t index = 0;
+            std::vector<uchar> bytes;
+            bool ok = false;
+        };
+    }
+
+    uint64_t CameraModelKey(const openMVG::cameras::IntrinsicBase *cam)
+    {
+        VoxelForge::ContentHasher hasher;
+        hasher.update(static_cast<uint64_t>(cam->getType()));
+        hasher.update(static_cast<uint64_t>(cam->w()));
+        hasher.update(static_cast<uint64_t>(cam->h()));
+        for (const double param : cam->getParams())
+            hasher.update(param);
+        return hasher.digest();
+    }
+
+    UndistortEngine::UndistortEngine(int threads, int jpegQuality)
+        : workers(std::max(1, threads)), quality(jpegQuality)
+    {
+    }
+
+    bool UndistortEngine::run(const std::vector<UndistortJob> &jobs,
+                              const std::function<void(size_t index, bool ok)> &done,
+                              const std::atomic<bool> *cancel)
+    {
+        auto cancelled = [cancel]
+        { return cancel && cancel->load(std::memory_order_relaxed); };
+
+        // images of one camera model next to each other: its table is built once and freed
+        // as soon as its last image is remapped, instead of every table living for the whole run
+        std::vector<uint64_t> modelKeys(jobs.size(), 0);
+        std::vector<size_t> order(jobs.size());
+        std::map<uint64_t, size_t> remainingPerModel;
+        for (size_t i = 0; i < jobs.size(); ++i)
+        {
+            order[i] = i;
+            if (jobs[i].camera->have_disto())
+            {
+                modelKeys[i] = CameraModelKey(jobs[i].camera);
+                ++remainingPerModel[modelKeys[i]];
+            }
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                         { return modelKeys[a] < modelKeys[b]; });
+
+        // the first worker needing a table builds it, the others wait for the same future
+        std::mutex tableLock;
+        std::map<uint64_t, std::shared_future<std::shared_ptr<const RemapTable>>> tables;
+        auto acquireTable = [&](size_t index)
+        {
+            std::shared_future<std::shared_ptr<const RemapTable>> table;
+            std::promise<std::shared_ptr<const RemapTable>> building;
+            bool builder = false;
+            {
+                std::lock_guard<std::mutex> guard(tableLock);
+                auto it = tables.find(modelKeys[index]);
+                if (it == tables.end())
+                {
+                    builder = true;
+                    it = tables.emplace(modelKeys[index], building.get_future().share()).first;
+                }
+                table = it->second;
+            }
+            if (builder)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                try
+                {
+                    building.set_value(buildRemapTable(jobs[index].camera));
+                }
+                catch (...)
+                {
+                    building.set_exception(std::current_exception()); // rethrown by get() in every waiting worker
+                }
+                std::lock_guard<std::mutex> guard(tableLock);
+                ++totals.tables;
+                totals.tableSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }
+            return table.get();
+        };
+        auto releaseTable = [&](size_t index)
+        {
+            std::lock_guard<std::mutex> guard(tableLock);
+            if (--remainingPerModel[modelKeys[index]] == 0)
+                tables.erase(modelKeys[index]);
+        };
+
+        const std::vector<int> encoding = {cv::IMWRITE_JPEG_QUALITY, quality, cv::IMWRITE_JPEG_OPTIMIZE, 0, cv::IMWRITE_JPEG_PROGRESSIVE, 0};
+        std::atomic<bool> stopReading(false); // after the first failure, like openMVG's exporter
+        BoundedQueue<LoadedImage> readQueue(static_cast<size_t>(workers) * 2);
+        BoundedQueue<LoadedImage> writeQueue(static_cast<size_t>(workers) * 2);
+
+        std::thread reader([&]
+                           {
+            for (const size_t index : order)
+            {
+                if (cancelled() || stopReading)
+                    break;
+                LoadedImage image;
+                image.index = index;
+                image.ok = readFile(jobs[index].sourceImage, image.bytes);
+                if (!readQueue.push(std::move(image)))
+                    break;
+            }
+            readQueue.close(); });
+
+        // decode, remap, encode; false if the image cannot be used
+        std::atomic<size_t> copied(0);
+        auto process = [&](LoadedImage &image)
+        {
+            const UndistortJob &job = jobs[image.index];
+            if (!job.camera->have_disto() && isJpeg(job.sourceImage))
+            {
+                ++copied; // the bytes go to the writer unchanged
+                return true;
+            }
+
+            // 8 bits, gray or BGR as stored, no EXIF rotation (the camera model is of the stored pixels)
+            cv::Mat pixels = cv::imdecode(image.bytes, cv::IMREAD_ANYCOLOR | cv::IMREAD_IGNORE_ORIENTATION);
+            if (pixels.empty() || pixels.cols != static_cast<int>(job.camera->w()) ||
+                pixels.rows != static_cast<int>(job.camera->h()))
+                return false;
+            if (job.camera->have_disto())
+            {
+                const std::shared_ptr<const RemapTable> table = acquireTable(image.index);
+                cv::Mat undistorted;
+                cv::remap(pixels, undistorted, table->map1, table->map2, cv::INTER_LINEAR,
+                          cv::BORDER_CONSTANT, cv::Scalar::all(0));
+                pixels = undistorted;
+            }
+            return cv::imencode(".jpg", pixels, image.bytes, encoding);
+        };
+
+        std::vector<std::thread> pool;
+        for (int w = 0; w < workers; ++w)
+        {
+            pool.emplace_back([&]
+                              {
+                LoadedImage image;
+                while (readQueue.pop(image))
+                {
+                    if (image.ok)
+                    {
+                        try
+                        {
+                            image.ok = process(image);
+                        }
+                        catch (const std::exception &)
+                        {
+                            image.ok = false; // OpenCV errors of a corrupt image, allocation failures
+                        }
+                    }
+                    if (jobs[image.index].camera->have_disto())
+                        releaseTable(image.index);
+                    if (!image.ok)
+                        image.bytes.clear();
+                    writeQueue.push(std::move(image));
+                } });
+        }
+
+        size_t written = 0, failed = 0;
+        std::thread writer([&]
+                           {
+            LoadedImage image;
+            while (writeQueue.pop(image))
+            {
+                const bool ok = image.ok && writeFile(jobs[image.index].outputImage, image.bytes);
+                if (ok)
+                    ++written;
+                else
+                {
+                    ++failed;
+                    stopReading = true;
+                }
+                if (done)
+                    done(image.index, ok);
+            } });
+
+        reader.join();
+        for (std::thread &thread : pool)
+            thread.join();
+        writeQueue.close();
+        writer.join();
+
+        totals.images += written;
+        totals.copied += copied;
+        totals.failed += failed;
+        return failed == 0 && written == jobs.size();
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// Batch image undistortion of the OpenMVS export (RunExportToMVS).
+//
+// The source pixel of every output pixel depends on the camera model only,
+// so it is computed once per distinct model (type, size and parameters: the
+// views of a grouped camera share one) and stored as a fixed-point remap
+// table. Each image is then one cv::remap with that table, whose bilinear
+// path is vectorized by OpenCV.
+//
+// Images flow through three steps connected by bounded queues: a reader
+// thread loads the files, the workers decode, remap and encode them, and a
+// writer thread stores the results. Disk reads and writes overlap with the
+// decoding, and at most a few images per worker are in memory at once.
+//
+// Results are baseline JPEG (quality 95), the format OpenMVS decodes fastest.
+// Sources without distortion that already are JPEG are copied unchanged.
+
+#include "openMVG/cameras/Camera_Intrinsics.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace OpenMVG_Wrappers
+{
+    // Identifies a camera model: views with the same key share a remap table
+    uint64_t CameraModelKey(const openMVG::cameras::IntrinsicBase *cam);
+
+    struct UndistortJob
+    {
+        std::string sourceImage;
+        std::string outputImage; // written through a temporary file, never partially
+        const openMVG::cameras::IntrinsicBase *camera = nullptr;
+    };
+
+    struct UndistortStats
+    {
+        size_t images = 0;    // written
+        size_t copied = 0;    // of which copied unchanged (no distortion, already JPEG)
+        size_t failed = 0;
+        size_t tables = 0;    // remap tables built
+        double tableSeconds = 0;
+    };
+
+    class UndistortEngine
+    {
+    public:
+        // threads: decode / remap / encode workers; the reader and the writer come on top (mostly waiting on the disk)
+        explicit UndistortEngine(int threads, int jpegQuality = 95);
+
+        // done(index, ok) is called from the writer thread once jobs[index] is written or failed;
+        // after *cancel becomes true no new image is read. Returns false if an image failed or on cancel
+        bool run(const std::vector<UndistortJob> &jobs,
+                 const std::function<void(size_t index, bool ok)> &done,
+                 const std::atomic<bool> *cancel = nullptr);
+
+        const UndistortStats &stats() const { return totals; }
+
+    private:
+        int workers;
+        int quality;
+        UndistortStats totals;
+    };
+}
@@ -0,0 +1,163 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// Pair tiling and regions cache counters (regions_budget.hpp)
+//
+// Regions files are written empty (no features): only the number of disk
+// reads matters here, not what is read.
+
+#include "regions_budget.hpp"
+
+#include "openMVG/features/regions_factory.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CHECK(condition)                                                                       \
+    do                                                                                         \
+    {                                                                                          \
+        if (!(condition))                                                                      \
+        {                                                                                      \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                                        \
+        }                                                                                      \
+    } while (0)
+
+namespace fs = std::filesystem;
+using namespace OpenMVG_Wrappers;
+
+namespace
+{
+    std::atomic<int> failures(0);
+
+    constexpr unsigned int ViewCount = 30;
+    constexpr unsigned int CacheSize = 10;
+
+    // Views 0..29 of a walk matched with the next three, ids scrambled (7 * i mod 30)
+    // so that id order says nothing about which views are matched together
+    openMVG::Pair_Set sequentialPairs()
+    {
+        openMVG::Pair_Set pairs;
+        for (unsigned int i = 0; i < ViewCount; ++i)
+        {
+            for (unsigned int j = i + 1; j <= i + 3 && j < ViewCount; ++j)
+            {
+                const openMVG::IndexT a = 7 * i % ViewCount, b = 7 * j % ViewCount;
+                pairs.insert({std::min(a, b), std::max(a, b)});
+            }
+        }
+        return pairs;
+    }
+
+    struct Project
+    {
+        fs::path dir;
+        openMVG::sfm::SfM_Data sfm_data;
+
+        Project()
+            : dir(fs::temp_directory_path() / "voxelforge_regions_budget_test")
+        {
+            fs::create_directories(dir);
+            const openMVG::features::SIFT_Regions empty;
+            for (openMVG::IndexT id = 0; id < ViewCount; ++id)
+            {
+                const std::string name = "view" + std::to_string(id);
+                sfm_data.views[id] = std::make_shared<openMVG::sfm::View>(name + ".jpg", id, 0, 0, 640, 480);
+                empty.Save((dir / (name + ".feat")).string(), (dir / (name + ".desc")).string());
+            }
+        }
+        ~Project() { fs::remove_all(dir); }
+
+        std::shared_ptr<CountedRegionsCache> cache(unsigned int size) const
+        {
+            auto regions = std::make_shared<CountedRegionsCache>(size);
+            std::unique_ptr<openMVG::features::Regions> regionType(new openMVG::features::SIFT_Regions);
+            CHECK(regions->load(sfm_data, dir.string(), regionType));
+            return regions;
+        }
+    };
+
+    // what a matcher asks for: both views of every pair, tile after tile
+    void visit(const CountedRegionsCache &regions, const std::vector<openMVG::Pair_Set> &tiles)
+    {
+        for (const openMVG::Pair_Set &tile : tiles)
+        {
+            for (const openMVG::Pair &pair : tile)
+            {
+                CHECK(regions.get(pair.first) != nullptr);
+                CHECK(regions.get(pair.second) != nullptr);
+            }
+        }
+    }
+
+    void testTilesCoverEveryPairOnce()
+    {
+        const openMVG::Pair_Set pairs = sequentialPairs();
+        openMVG::Pair_Set covered;
+        size_t count = 0;
+        for (const openMVG::Pair_Set &tile : BlockedPairTiles(pairs, CacheSize / 2))
+        {
+            covered.insert(tile.begin(), tile.end());
+            count += tile.size();
+        }
+        CHECK(covered == pairs);
+        CHECK(count == pairs.size());
+    }
+
+    // The figure of the tiled traversal: a walk with scrambled ids through a cache of a
+    // third of the views reads each view about once, in id order it keeps evicting
+    void testTiledOrderAvoidsReloads(const Project &project)
+    {
+        const openMVG::Pair_Set pairs = sequentialPairs();
+
+        const auto untiled = project.cache(CacheSize);
+        visit(*untiled, BlockedPairTiles(pairs, 0));
+        const auto tiled = project.cache(CacheSize);
+        visit(*tiled, BlockedPairTiles(pairs, CacheSize / 2));
+
+        const CountedRegionsCache::Counters a = untiled->counters(), b = tiled->counters();
+        std::printf("regions cache, %u views, %u cached: Pair_Set order %s; tiled %s\n",
+                    ViewCount, CacheSize, untiled->summary().c_str(), tiled->summary().c_str());
+        CHECK(a.requests == 2 * pairs.size() && b.requests == a.requests);
+        CHECK(b.loads - b.reloads == ViewCount);
+        CHECK(b.reloads <= 1);
+        CHECK(a.reloads >= 60);
+    }
+
+    // Disk reads run outside the cache lock; a view asked for by several threads at once is read once
+    void testConcurrentGetsReadEachViewOnce(const Project &project)
+    {
+        const auto regions = project.cache(ViewCount);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t)
+        {
+            threads.emplace_back([&regions]
+                                 {
+                                     for (openMVG::IndexT id = 0; id < ViewCount; ++id)
+                                         CHECK(regions->get(id) != nullptr); });
+        }
+        for (std::thread &thread : threads)
+            thread.join();
+
+        const CountedRegionsCache::Counters c = regions->counters();
+        CHECK(c.requests == 8 * ViewCount);
+        CHECK(c.loads == ViewCount);
+        CHECK(c.reloads == 0);
+    }
+}
+
+int main()
+{
+    const Project project;
+    testTilesCoverEveryPairOnce();
+    testTiledOrderAvoidsReloads(project);
+    testConcurrentGetsReadEachViewOnce(project);
+
+    if (failures > 0)
+        std::fprintf(stderr, "%d check(s) failed\n", failures.load());
+    return failures > 0 ? 1 : 0;
+}
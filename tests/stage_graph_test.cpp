@@ -0,0 +1,145 @@
+// Copyright Darshan Patel [Mr.Quantum_1915]:)
+// Stamps and forced reruns of the stage graph (stage_graph.hpp)
+
+#include "stage_graph.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#define CHECK(condition)                                                                       \
+    do                                                                                         \
+    {                                                                                          \
+        if (!(condition))                                                                      \
+        {                                                                                      \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++failures;                                                                        \
+        }                                                                                      \
+    } while (0)
+
+namespace fs = std::filesystem;
+using namespace VoxelForge;
+
+namespace
+{
+    int failures = 0;
+
+    // One step reading in.txt and writing out.txt, run in a fresh graph like every pipeline run
+    struct Project
+    {
+        fs::path dir;
+
+        Project()
+            : dir(fs::temp_directory_path() / "voxelforge_stage_graph_test")
+        {
+            fs::remove_all(dir);
+            fs::create_directories(dir);
+            std::ofstream(dir / "in.txt") << "input\n";
+        }
+        ~Project() { fs::remove_all(dir); }
+
+        struct Outcome
+        {
+            bool graphOk = false;
+            bool ran = false;
+            bool force = false;
+            StageNodeResult result = StageNodeResult::NotRun;
+        };
+
+        // cancelled: the step writes part of its output, then stops the run as Ctrl+C would
+        Outcome run(const std::string &parameters, bool cancelled) const
+        {
+            Outcome outcome;
+            std::atomic<bool> cancel(false);
+
+            StageNode node;
+            node.name = "step";
+            node.inputs = {(dir / "in.txt").string()};
+            node.outputs = {(dir / "out.txt").string()};
+            node.parameters = parameters;
+            node.run = [&](bool force)
+            {
+                outcome.ran = true;
+                outcome.force = force;
+                std::ofstream(dir / "out.txt", std::ios::app) << parameters << '\n';
+                if (cancelled)
+                    cancel = true;
+                return !cancelled;
+            };
+
+            StageGraph graph((dir / ".stamps").string());
+            graph.add(node);
+            outcome.graphOk = graph.run(StageGraphCallbacks(), cancel);
+            outcome.result = graph.result("step");
+            return outcome;
+        }
+
+        bool pending() const { return fs::exists(dir / ".stamps" / "step.pending"); }
+    };
+
+    void testCancelThenChangeParametersForces()
+    {
+        const Project project;
+
+        const Project::Outcome cancelled = project.run("a", true);
+        CHECK(!cancelled.graphOk && cancelled.ran && !cancelled.force);
+        CHECK(project.pending());
+
+        // out.txt holds part of an "a" run, "b" must not build on it
+        const Project::Outcome changed = project.run("b", false);
+        CHECK(changed.graphOk && changed.ran && changed.force);
+        CHECK(changed.result == StageNodeResult::Done);
+        CHECK(!project.pending());
+
+        const Project::Outcome again = project.run("b", false);
+        CHECK(again.graphOk && !again.ran);
+        CHECK(again.result == StageNodeResult::UpToDate);
+    }
+
+    // the stamp of "a" is gone once "b" starts; the unfinished "b" still forces a return to "a"
+    void testCancelThenRevertParametersForces()
+    {
+        const Project project;
+        CHECK(project.run("a", false).graphOk);
+
+        const Project::Outcome cancelled = project.run("b", true);
+        CHECK(cancelled.ran && cancelled.force);
+
+        const Project::Outcome reverted = project.run("a", false);
+        CHECK(reverted.graphOk && reverted.ran && reverted.force);
+    }
+
+    // same parameters after a cancel: partial results of that configuration may be resumed
+    void testCancelThenSameParametersResumes()
+    {
+        const Project project;
+        CHECK(!project.run("a", true).graphOk);
+
+        const Project::Outcome resumed = project.run("a", false);
+        CHECK(resumed.graphOk && resumed.ran && !resumed.force);
+        CHECK(!project.pending());
+    }
+
+    void testChangedParametersAfterSuccessForce()
+    {
+        const Project project;
+        CHECK(project.run("a", false).graphOk);
+
+        const Project::Outcome changed = project.run("b", false);
+        CHECK(changed.graphOk && changed.ran && changed.force);
+    }
+}
+
+int main()
+{
+    testCancelThenChangeParametersForces();
+    testCancelThenRevertParametersForces();
+    testCancelThenSameParametersResumes();
+    testChangedParametersAfterSuccessForce();
+
+    if (failures > 0)
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures > 0 ? 1 : 0;
+}